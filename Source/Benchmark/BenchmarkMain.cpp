@@ -0,0 +1,842 @@
+/*
+ * BenchmarkMain.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Entry point and suites of the allocator benchmark.
+ *
+ */
+
+#include "EdgeBenchmark.h"
+#include "EdgeAllocationTrace.h"
+#include "EdgeHeapAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+BEGIN_NS_EDGE
+BEGIN_NS_BENCHMARK
+
+namespace {
+
+// Write one byte so every block costs what a real first touch costs
+inline void Touch(void* ptr) {
+	if (ptr) {
+		*static_cast<volatile uint8_t*>(ptr) = 1;
+	}
+}
+
+inline size_t Scaled(const Options& options, size_t count, size_t minimum) {
+	const size_t scaled = static_cast<size_t>(static_cast<double>(count) * options.scale);
+	return scaled < minimum ? minimum : scaled;
+}
+
+inline size_t PeakUsage(const memory::IAllocator& allocator) {
+	memory::MemoryStats stats;
+	allocator.GetStats(stats);
+	return stats.peakUsage;
+}
+
+void FillResult(Result& result, uint64_t elapsedNs, size_t operations) {
+	result.operations = operations;
+	result.nsPerOp = static_cast<double>(elapsedNs) / static_cast<double>(operations);
+	result.opsPerSecond = elapsedNs ? static_cast<double>(operations) * 1e9 / static_cast<double>(elapsedNs) : 0.0;
+}
+
+// PoolAllocator behind a mutex, the baseline the concurrent pool is measured against
+class LockedPoolAllocator : public memory::IAllocator {
+public:
+	LockedPoolAllocator(size_t elementSize, size_t elementCount) : m_Pool(elementSize, elementCount) {}
+
+	void* Allocate(size_t size, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override {
+		std::lock_guard<std::mutex> lock(m_Lock);
+		return m_Pool.Allocate(size, alignment);
+	}
+
+	void* Allocate(size_t size, memory::MemoryTag tag, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override {
+		std::lock_guard<std::mutex> lock(m_Lock);
+		return m_Pool.Allocate(size, tag, alignment);
+	}
+
+	void Free(void* ptr) override {
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Pool.Free(ptr);
+	}
+
+	void Free(void* ptr, size_t size, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override {
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Pool.Free(ptr, size, alignment);
+	}
+
+	void GetStats(memory::MemoryStats& stats) const override {
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Pool.GetStats(stats);
+	}
+
+	void Reset() override {
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Pool.Reset();
+	}
+
+private:
+	mutable std::mutex m_Lock;
+	memory::PoolAllocator m_Pool;
+};
+
+//==================================================================================================
+// Throughput
+//
+// Allocate a run of same-sized blocks and free them again, single threaded. Linear allocators
+// free by Reset, which is part of the timed run.
+//==================================================================================================
+
+enum class FreeOrder {
+	Lifo,		// reverse allocation order, the friendliest case for free lists
+	Random,		// shuffled, scatters the free lists
+	Batch,		// AllocateBatch and FreeBatch
+	Sized,		// LIFO through the sized free
+};
+
+const char* FreeOrderName(FreeOrder order) {
+	switch (order) {
+	case FreeOrder::Lifo: return "lifo";
+	case FreeOrder::Random: return "random";
+	case FreeOrder::Batch: return "batch";
+	case FreeOrder::Sized: return "sized";
+	}
+	return "unknown";
+}
+
+struct ThroughputAllocator {
+	const char* name;
+	bool resetFrees;	// frees are no-ops, Reset releases the run
+	std::unique_ptr<memory::IAllocator> (*create)(size_t size, size_t count);
+};
+
+const ThroughputAllocator kThroughputAllocators[] = {
+	{ "malloc", false, [](size_t, size_t) -> std::unique_ptr<memory::IAllocator> {
+		return std::unique_ptr<memory::IAllocator>(new MallocAllocator()); } },
+	{ "global", false, [](size_t, size_t) -> std::unique_ptr<memory::IAllocator> {
+		return std::unique_ptr<memory::IAllocator>(new GlobalAllocator()); } },
+	{ "SystemAllocator", false, [](size_t, size_t) -> std::unique_ptr<memory::IAllocator> {
+		return std::unique_ptr<memory::IAllocator>(new memory::SystemAllocator()); } },
+	{ "PoolAllocator", false, [](size_t size, size_t count) -> std::unique_ptr<memory::IAllocator> {
+		return std::unique_ptr<memory::IAllocator>(new memory::PoolAllocator(size, count)); } },
+	{ "PoolChunked", false, [](size_t size, size_t count) -> std::unique_ptr<memory::IAllocator> {
+		return std::unique_ptr<memory::IAllocator>(new memory::PoolAllocator(size, count / 16 + 1,
+			memory::EDGE_DEFAULT_ALIGNMENT, memory::PoolGrowth::Chunked)); } },
+	{ "TLSFAllocator", false, [](size_t size, size_t count) -> std::unique_ptr<memory::IAllocator> {
+		return std::unique_ptr<memory::IAllocator>(new memory::TLSFAllocator(count * (size + 64) + 1024 * 1024)); } },
+	{ "LinearAllocator", true, [](size_t size, size_t count) -> std::unique_ptr<memory::IAllocator> {
+		return std::unique_ptr<memory::IAllocator>(new memory::LinearAllocator(
+			count * memory::AlignUp(size, memory::EDGE_DEFAULT_ALIGNMENT) + 4096)); } },
+};
+
+uint64_t TimeThroughputRun(memory::IAllocator& allocator, bool resetFrees, size_t size, FreeOrder order,
+	std::vector<void*>& blocks, const std::vector<uint32_t>& shuffle, size_t& failures) {
+	const size_t count = blocks.size();
+	const uint64_t start = NowNs();
+
+	if (order == FreeOrder::Batch) {
+		if (!allocator.AllocateBatch(count, size, memory::EDGE_DEFAULT_ALIGNMENT, blocks.data())) {
+			failures += count;
+			return NowNs() - start;
+		}
+		for (void* block : blocks) {
+			Touch(block);
+		}
+	}
+	else {
+		for (size_t i = 0; i < count; ++i) {
+			blocks[i] = allocator.Allocate(size);
+			if (!blocks[i]) {
+				failures++;
+			}
+			Touch(blocks[i]);
+		}
+	}
+
+	if (resetFrees) {
+		allocator.Reset();
+		return NowNs() - start;
+	}
+
+	switch (order) {
+	case FreeOrder::Lifo:
+		for (size_t i = count; i-- > 0;) {
+			allocator.Free(blocks[i]);
+		}
+		break;
+	case FreeOrder::Random:
+		for (uint32_t index : shuffle) {
+			allocator.Free(blocks[index]);
+		}
+		break;
+	case FreeOrder::Batch:
+		allocator.FreeBatch(blocks.data(), count);
+		break;
+	case FreeOrder::Sized:
+		for (size_t i = count; i-- > 0;) {
+			allocator.Free(blocks[i], size, memory::EDGE_DEFAULT_ALIGNMENT);
+		}
+		break;
+	}
+	return NowNs() - start;
+}
+
+void RunThroughput(const Options& options, Reporter& reporter) {
+	const size_t sizes[] = { 16, 64, 256, 1024, 8192 };
+	const FreeOrder orders[] = { FreeOrder::Lifo, FreeOrder::Random, FreeOrder::Batch, FreeOrder::Sized };
+	const size_t count = Scaled(options, 50000, 1000);
+	const int repeats = 5;
+
+	std::vector<void*> blocks(count);
+	std::vector<uint32_t> shuffle(count);
+	Random random(1);
+	for (size_t i = 0; i < count; ++i) {
+		shuffle[i] = static_cast<uint32_t>(i);
+	}
+	for (size_t i = count; i > 1; --i) {
+		std::swap(shuffle[i - 1], shuffle[random.Next() % i]);
+	}
+
+	for (const ThroughputAllocator& entry : kThroughputAllocators) {
+		for (size_t size : sizes) {
+			for (FreeOrder order : orders) {
+				std::unique_ptr<memory::IAllocator> allocator = entry.create(size, count);
+
+				// Best of several runs, the first one also warms up the allocator
+				uint64_t best = ~uint64_t(0);
+				size_t failures = 0;
+				for (int r = 0; r < repeats; ++r) {
+					const uint64_t elapsed = TimeThroughputRun(*allocator, entry.resetFrees, size, order, blocks, shuffle, failures);
+					best = elapsed < best ? elapsed : best;
+				}
+
+				Result result;
+				result.suite = "throughput";
+				result.allocator = entry.name;
+				result.name = std::to_string(size) + "B " + FreeOrderName(order);
+				FillResult(result, best, count * 2);
+				result.peakBytes = PeakUsage(*allocator);
+				result.failures = failures;
+				reporter.Add(result);
+			}
+		}
+	}
+}
+
+//==================================================================================================
+// Contention
+//
+// Every thread repeatedly spawns and kills a burst of objects, like particles in a frame, on one
+// shared allocator.
+//==================================================================================================
+
+uint64_t RunContentionCase(memory::IAllocator& allocator, size_t threadCount, size_t burst, size_t rounds,
+	std::atomic<size_t>& failures) {
+	std::atomic<size_t> ready(0);
+	std::atomic<bool> go(false);
+	std::vector<std::thread> threads;
+
+	for (size_t t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&allocator, &ready, &go, &failures, burst, rounds]() {
+			std::vector<void*> live(burst);
+			ready.fetch_add(1);
+			while (!go.load(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+
+			size_t failed = 0;
+			for (size_t r = 0; r < rounds; ++r) {
+				for (size_t i = 0; i < burst; ++i) {
+					live[i] = allocator.Allocate(64);
+					failed += live[i] == nullptr;
+					Touch(live[i]);
+				}
+				for (size_t i = 0; i < burst; ++i) {
+					allocator.Free(live[i]);
+				}
+			}
+			failures.fetch_add(failed);
+		});
+	}
+
+	// Start every thread at once so the first ones don't run uncontended
+	while (ready.load() != threadCount) {
+		std::this_thread::yield();
+	}
+	const uint64_t start = NowNs();
+	go.store(true, std::memory_order_release);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	return NowNs() - start;
+}
+
+void RunContention(const Options& options, Reporter& reporter) {
+	const size_t burst = 256;
+	const size_t rounds = Scaled(options, 2000, 50);
+
+	std::vector<size_t> threadCounts;
+	for (size_t threadCount = 1; threadCount <= options.maxThreads; threadCount *= 2) {
+		threadCounts.push_back(threadCount);
+	}
+	if (threadCounts.back() != options.maxThreads) {
+		threadCounts.push_back(options.maxThreads);
+	}
+
+	for (size_t threadCount : threadCounts) {
+		const size_t capacity = threadCount * burst;
+
+		struct Entry {
+			const char* name;
+			std::unique_ptr<memory::IAllocator> allocator;
+		};
+		Entry entries[] = {
+			{ "malloc", std::unique_ptr<memory::IAllocator>(new MallocAllocator()) },
+			{ "global", std::unique_ptr<memory::IAllocator>(new GlobalAllocator()) },
+			{ "LockedPool", std::unique_ptr<memory::IAllocator>(new LockedPoolAllocator(64, capacity)) },
+			{ "ConcurrentPool", std::unique_ptr<memory::IAllocator>(new memory::ConcurrentPoolAllocator(64, capacity,
+				memory::EDGE_DEFAULT_ALIGNMENT, false)) },
+			{ "ConcurrentPoolMag", std::unique_ptr<memory::IAllocator>(new memory::ConcurrentPoolAllocator(64,
+				capacity + threadCount * 32)) },
+		};
+
+		for (Entry& entry : entries) {
+			std::atomic<size_t> failures(0);
+			const uint64_t elapsed = RunContentionCase(*entry.allocator, threadCount, burst, rounds, failures);
+
+			Result result;
+			result.suite = "contention";
+			result.allocator = entry.name;
+			result.name = "64B burst " + std::to_string(burst);
+			result.threads = threadCount;
+			FillResult(result, elapsed * threadCount, threadCount * burst * rounds * 2);
+			result.opsPerSecond *= static_cast<double>(threadCount);
+			result.failures = failures.load();
+			reporter.Add(result);
+		}
+	}
+}
+
+//==================================================================================================
+// Frame Replay
+//
+// A synthetic game-like trace: hundreds of transient blocks per frame that die at the end of it,
+// a few dozen that live for a handful of frames, and the odd large block that lives for seconds.
+// With --trace a recorded allocation trace is replayed instead. Every allocator replays the same
+// trace, the latency columns are frame times.
+//==================================================================================================
+
+struct ReplayEvent {
+	uint32_t id;
+	uint32_t size;		// 0 frees the block
+	bool transient;		// dies before the frame ends
+};
+
+struct Trace {
+	std::vector<ReplayEvent> events;
+	std::vector<size_t> frameEnds;
+	uint32_t blockCount;
+	size_t peakLiveBytes;
+	size_t peakFrameBytes;	// transient bytes of the busiest frame
+};
+
+// Fills in the peaks once the events are final
+void MeasureTrace(Trace& trace) {
+	std::vector<uint32_t> sizes(trace.blockCount, 0);
+	size_t liveBytes = 0;
+	size_t frameBytes = 0;
+	size_t event = 0;
+	trace.peakLiveBytes = 0;
+	trace.peakFrameBytes = 0;
+
+	for (size_t frameEnd : trace.frameEnds) {
+		frameBytes = 0;
+		for (; event < frameEnd; ++event) {
+			const ReplayEvent& current = trace.events[event];
+			if (current.size) {
+				sizes[current.id] = current.size;
+				liveBytes += current.size;
+				if (current.transient) {
+					frameBytes += memory::AlignUp(current.size, memory::EDGE_DEFAULT_ALIGNMENT);
+				}
+			}
+			else {
+				liveBytes -= sizes[current.id];
+			}
+			trace.peakLiveBytes = liveBytes > trace.peakLiveBytes ? liveBytes : trace.peakLiveBytes;
+		}
+		trace.peakFrameBytes = frameBytes > trace.peakFrameBytes ? frameBytes : trace.peakFrameBytes;
+	}
+}
+
+Trace BuildTrace(size_t frames) {
+	Trace trace;
+	trace.blockCount = 0;
+	Random random(42);
+
+	const size_t maxLifetime = 300;
+	std::vector<std::vector<uint32_t>> dueAt(frames + maxLifetime + 1);
+	std::vector<uint32_t> transient;
+
+	for (size_t frame = 0; frame < frames; ++frame) {
+		for (uint32_t id : dueAt[frame]) {
+			trace.events.push_back({ id, 0, false });
+		}
+
+		transient.clear();
+		const size_t transientCount = random.Range(200, 800);
+		const size_t mediumCount = random.Range(20, 60);
+		for (size_t i = 0; i < transientCount + mediumCount; ++i) {
+			// Interleave the two kinds the way gameplay code would
+			const uint32_t id = trace.blockCount++;
+			if (random.Range(0, transientCount + mediumCount - 1) < transientCount) {
+				trace.events.push_back({ id, static_cast<uint32_t>(random.LogRange(16, 512)), true });
+				transient.push_back(id);
+			}
+			else {
+				trace.events.push_back({ id, static_cast<uint32_t>(random.LogRange(64, 4096)), false });
+				dueAt[frame + random.Range(2, 30)].push_back(id);
+			}
+		}
+
+		if (random.Range(0, 1) == 0) {
+			const uint32_t id = trace.blockCount++;
+			trace.events.push_back({ id, static_cast<uint32_t>(random.LogRange(4096, 65536)), false });
+			dueAt[frame + random.Range(100, maxLifetime)].push_back(id);
+		}
+
+		// Transient blocks die in no particular order
+		for (size_t i = transient.size(); i > 1; --i) {
+			std::swap(transient[i - 1], transient[random.Next() % i]);
+		}
+		for (uint32_t id : transient) {
+			trace.events.push_back({ id, 0, true });
+		}
+		trace.frameEnds.push_back(trace.events.size());
+	}
+
+	// Tear down whatever is still alive as one last frame
+	for (size_t frame = frames; frame < dueAt.size(); ++frame) {
+		for (uint32_t id : dueAt[frame]) {
+			trace.events.push_back({ id, 0, false });
+		}
+	}
+	trace.frameEnds.push_back(trace.events.size());
+	MeasureTrace(trace);
+	return trace;
+}
+
+// Converts a recording into a replay trace. Addresses become block ids, and a block freed in the
+// frame it was allocated in counts as transient. Frees of blocks allocated before the part the
+// ring kept are dropped, blocks still live at the end are freed in one last frame. Recordings
+// without frame markers are cut into frames of a fixed event count. Alignment is not replayed,
+// the malloc baseline only has the default one.
+bool LoadTrace(const char* path, Trace& trace) {
+	memory::TraceReader reader;
+	if (!reader.Open(path)) {
+		printf("Failed to read allocation trace %s\n", path);
+		return false;
+	}
+
+	const size_t eventsPerFrame = 1000;
+	bool hasFrames = false;
+	for (size_t i = 0; i < reader.GetEventCount() && !hasFrames; ++i) {
+		hasFrames = reader.GetEvent(i).type == memory::TraceEventType::Frame;
+	}
+
+	trace.events.clear();
+	trace.frameEnds.clear();
+	trace.blockCount = 0;
+	std::unordered_map<uint64_t, uint32_t> live;	// address to block id
+	std::vector<size_t> allocationEvents;			// block id to its allocation in trace.events
+	std::vector<size_t> allocationFrames;
+
+	auto release = [&](uint32_t id) {
+		const bool transient = allocationFrames[id] == trace.frameEnds.size();
+		trace.events[allocationEvents[id]].transient = transient;
+		trace.events.push_back({ id, 0, transient });
+	};
+
+	auto releaseAll = [&]() {
+		// Sorted so every run frees in the same order
+		std::vector<uint32_t> ids;
+		ids.reserve(live.size());
+		for (const auto& entry : live) {
+			ids.push_back(entry.second);
+		}
+		std::sort(ids.begin(), ids.end());
+		for (uint32_t id : ids) {
+			release(id);
+		}
+		live.clear();
+	};
+
+	size_t frameStart = 0;
+	for (size_t i = 0; i < reader.GetEventCount(); ++i) {
+		const memory::TraceEvent& event = reader.GetEvent(i);
+		switch (event.type) {
+		case memory::TraceEventType::Allocate: {
+			if (event.size == 0 || event.size == memory::TraceEvent::SIZE_OVERFLOW) {
+				break;
+			}
+			auto existing = live.find(event.address);
+			if (existing != live.end()) {
+				// The free fell outside the recording, keep the replay balanced
+				release(existing->second);
+				live.erase(existing);
+			}
+			const uint32_t id = trace.blockCount++;
+			live[event.address] = id;
+			allocationEvents.push_back(trace.events.size());
+			allocationFrames.push_back(trace.frameEnds.size());
+			trace.events.push_back({ id, event.size, false });
+			break;
+		}
+		case memory::TraceEventType::Free: {
+			auto existing = live.find(event.address);
+			if (existing != live.end()) {
+				release(existing->second);
+				live.erase(existing);
+			}
+			break;
+		}
+		case memory::TraceEventType::Frame:
+			trace.frameEnds.push_back(trace.events.size());
+			frameStart = trace.events.size();
+			break;
+		case memory::TraceEventType::Reset:
+			releaseAll();
+			break;
+		}
+
+		if (!hasFrames && trace.events.size() - frameStart >= eventsPerFrame) {
+			trace.frameEnds.push_back(trace.events.size());
+			frameStart = trace.events.size();
+		}
+	}
+
+	releaseAll();
+	trace.frameEnds.push_back(trace.events.size());
+	MeasureTrace(trace);
+	return true;
+}
+
+// Replays the trace on allocator, transient blocks go to frameAllocator when there is one
+void ReplayTrace(const Trace& trace, memory::IAllocator& allocator, memory::FrameAllocator* frameAllocator,
+	Result& result) {
+	std::vector<void*> blocks(trace.blockCount, nullptr);
+	std::vector<uint32_t> frameTimes;
+	frameTimes.reserve(trace.frameEnds.size());
+
+	size_t event = 0;
+	uint64_t total = 0;
+	for (size_t frameEnd : trace.frameEnds) {
+		const uint64_t start = NowNs();
+		if (frameAllocator) {
+			frameAllocator->BeginFrame();
+		}
+
+		for (; event < frameEnd; ++event) {
+			const ReplayEvent& current = trace.events[event];
+			memory::IAllocator& target = frameAllocator && current.transient ? *frameAllocator : allocator;
+			if (current.size) {
+				void* block = target.Allocate(current.size);
+				result.failures += block == nullptr;
+				Touch(block);
+				blocks[current.id] = block;
+			}
+			else {
+				target.Free(blocks[current.id]);
+				blocks[current.id] = nullptr;
+			}
+		}
+
+		const uint64_t elapsed = NowNs() - start;
+		frameTimes.push_back(static_cast<uint32_t>(elapsed));
+		total += elapsed;
+	}
+
+	FillResult(result, total, trace.events.size());
+	result.latency = ComputePercentiles(frameTimes);
+	result.peakBytes = PeakUsage(allocator);
+}
+
+void RunReplay(const Options& options, Reporter& reporter) {
+	Trace trace;
+	if (options.tracePath) {
+		if (!LoadTrace(options.tracePath, trace)) {
+			return;
+		}
+	}
+	else {
+		trace = BuildTrace(Scaled(options, 600, 60));
+	}
+	const char* source = options.tracePath ? " recorded" : " frames";
+
+	auto run = [&](const char* name, memory::IAllocator& allocator, memory::FrameAllocator* frameAllocator) {
+		Result result;
+		result.suite = "replay";
+		result.allocator = name;
+		result.name = std::to_string(trace.frameEnds.size()) + source;
+		ReplayTrace(trace, allocator, frameAllocator, result);
+		reporter.Add(result);
+	};
+
+	{
+		MallocAllocator allocator;
+		run("malloc", allocator, nullptr);
+	}
+	{
+		GlobalAllocator allocator;
+		run("global", allocator, nullptr);
+	}
+	{
+		memory::SystemAllocator allocator;
+		run("SystemAllocator", allocator, nullptr);
+	}
+	{
+		// Room for the live set at its peak plus slack for fragmentation
+		const size_t heapSize = trace.peakLiveBytes * 2 + 16 * 1024 * 1024;
+		memory::TLSFAllocator allocator(heapSize);
+		run("TLSFAllocator", allocator, nullptr);
+	}
+	{
+		// Transient blocks never need a free, the frame buffer is recycled two frames later
+		GlobalAllocator allocator;
+		const size_t frameSize = trace.peakFrameBytes + trace.peakFrameBytes / 4 + 64 * 1024;
+		memory::FrameAllocator frameAllocator(frameSize, 1);
+		run("global+frame", allocator, &frameAllocator);
+	}
+}
+
+//==================================================================================================
+// Fragmentation
+//
+// Random sizes with random lifetimes against a fixed heap, holding it around half full. The
+// heap's fragmentation is sampled at checkpoints to show whether it settles or keeps degrading.
+//==================================================================================================
+
+void RunFragmentation(const Options& options, Reporter& reporter) {
+	const size_t heapSize = 32 * 1024 * 1024;
+	const size_t operations = Scaled(options, 400000, 20000);
+	const size_t checkpoints[] = { operations / 10, operations / 4, operations / 2, operations };
+
+	memory::TLSFAllocator heap(heapSize);
+	Random random(7);
+
+	struct Block {
+		void* ptr;
+		size_t size;
+	};
+	std::vector<Block> live;
+	size_t liveBytes = 0;
+	size_t failures = 0;
+	size_t done = 0;
+
+	for (size_t checkpoint : checkpoints) {
+		const size_t segmentStart = done;
+		const uint64_t start = NowNs();
+		for (; done < checkpoint; ++done) {
+			// Drift towards half the heap, the randomness keeps the live set churning
+			const bool allocate = live.empty() || (liveBytes < heapSize / 2 ? random.Range(0, 9) < 7 : random.Range(0, 9) < 3);
+			if (allocate) {
+				const size_t size = random.LogRange(16, 32768);
+				void* ptr = heap.Allocate(size);
+				if (!ptr) {
+					failures++;
+					continue;
+				}
+				Touch(ptr);
+				live.push_back({ ptr, size });
+				liveBytes += size;
+			}
+			else {
+				const size_t index = static_cast<size_t>(random.Next() % live.size());
+				heap.Free(live[index].ptr);
+				liveBytes -= live[index].size;
+				live[index] = live.back();
+				live.pop_back();
+			}
+		}
+		const uint64_t elapsed = NowNs() - start;
+
+		memory::MemoryStats stats;
+		heap.GetStats(stats);
+
+		Result result;
+		result.suite = "fragmentation";
+		result.allocator = "TLSFAllocator";
+		result.name = "after " + std::to_string(done) + " ops";
+		FillResult(result, elapsed, done - segmentStart);
+		result.peakBytes = stats.peakUsage;
+		result.fragmentation = stats.GetFragmentation();
+		result.failures = failures;
+		reporter.Add(result);
+	}
+
+	for (const Block& block : live) {
+		heap.Free(block.ptr);
+	}
+}
+
+//==================================================================================================
+// Tail Latency
+//
+// Every operation of a mixed workload is timed on its own, allocations and frees are reported
+// separately. The timer overhead is subtracted from each sample.
+//==================================================================================================
+
+void MeasureLatency(const char* name, memory::IAllocator& allocator, size_t minSize, size_t maxSize,
+	size_t operations, Reporter& reporter) {
+	const size_t slotCount = 4096;
+	const uint64_t overhead = GetTimerOverheadNs();
+	std::vector<void*> slots(slotCount, nullptr);
+	std::vector<uint32_t> allocationTimes;
+	std::vector<uint32_t> freeTimes;
+	allocationTimes.reserve(operations);
+	freeTimes.reserve(operations);
+	Random random(99);
+	size_t failures = 0;
+	uint64_t allocationTotal = 0;
+	uint64_t freeTotal = 0;
+
+	for (size_t i = 0; i < operations; ++i) {
+		void*& slot = slots[random.Next() % slotCount];
+		if (!slot) {
+			const size_t size = random.LogRange(minSize, maxSize);
+			const uint64_t start = NowNs();
+			slot = allocator.Allocate(size);
+			const uint64_t elapsed = NowNs() - start;
+			failures += slot == nullptr;
+			Touch(slot);
+
+			const uint64_t sample = elapsed > overhead ? elapsed - overhead : 0;
+			allocationTimes.push_back(static_cast<uint32_t>(sample));
+			allocationTotal += sample;
+		}
+		else {
+			const uint64_t start = NowNs();
+			allocator.Free(slot);
+			const uint64_t elapsed = NowNs() - start;
+			slot = nullptr;
+
+			const uint64_t sample = elapsed > overhead ? elapsed - overhead : 0;
+			freeTimes.push_back(static_cast<uint32_t>(sample));
+			freeTotal += sample;
+		}
+	}
+
+	for (void* slot : slots) {
+		allocator.Free(slot);
+	}
+
+	const std::string sizes = std::to_string(minSize) + "-" + std::to_string(maxSize) + "B ";
+
+	Result allocation;
+	allocation.suite = "latency";
+	allocation.allocator = name;
+	allocation.name = sizes + "alloc";
+	FillResult(allocation, allocationTotal, allocationTimes.size() ? allocationTimes.size() : 1);
+	allocation.latency = ComputePercentiles(allocationTimes);
+	allocation.peakBytes = PeakUsage(allocator);
+	allocation.failures = failures;
+	reporter.Add(allocation);
+
+	Result release;
+	release.suite = "latency";
+	release.allocator = name;
+	release.name = sizes + "free";
+	FillResult(release, freeTotal, freeTimes.size() ? freeTimes.size() : 1);
+	release.latency = ComputePercentiles(freeTimes);
+	reporter.Add(release);
+}
+
+void RunLatency(const Options& options, Reporter& reporter) {
+	const size_t operations = Scaled(options, 500000, 20000);
+
+	{
+		MallocAllocator allocator;
+		MeasureLatency("malloc", allocator, 8, 1024, operations, reporter);
+	}
+	{
+		GlobalAllocator allocator;
+		MeasureLatency("global", allocator, 8, 1024, operations, reporter);
+	}
+	{
+		memory::SystemAllocator allocator;
+		MeasureLatency("SystemAllocator", allocator, 8, 1024, operations, reporter);
+	}
+	{
+		memory::TLSFAllocator allocator(16 * 1024 * 1024);
+		MeasureLatency("TLSFAllocator", allocator, 8, 1024, operations, reporter);
+	}
+	{
+		memory::PoolAllocator allocator(1024, 4096);
+		MeasureLatency("PoolAllocator", allocator, 8, 1024, operations, reporter);
+	}
+}
+
+struct Suite {
+	const char* name;
+	void (*run)(const Options& options, Reporter& reporter);
+};
+
+const Suite kSuites[] = {
+	{ "throughput", RunThroughput },
+	{ "contention", RunContention },
+	{ "replay", RunReplay },
+	{ "fragmentation", RunFragmentation },
+	{ "latency", RunLatency },
+};
+
+} // namespace
+
+int RunBenchmarks(int argc, char** argv) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		return 1;
+	}
+
+	memory::Initialize();
+#if EDGE_DEBUG || EDGE_MEMORY_TRACKING
+	printf("Warning: debug or memory tracking build, the numbers are not representative of release.\n");
+#endif
+
+	Reporter reporter;
+	reporter.PrintHeader();
+	for (const Suite& suite : kSuites) {
+		if (options.filter == nullptr || strstr(suite.name, options.filter) != nullptr) {
+			suite.run(options, reporter);
+		}
+	}
+
+	bool written = true;
+	if (options.jsonPath) {
+		written &= reporter.WriteJson(options.jsonPath);
+	}
+	if (options.csvPath) {
+		written &= reporter.WriteCsv(options.csvPath);
+	}
+
+	memory::Shutdown();
+	return written ? 0 : 1;
+}
+
+END_NS_BENCHMARK
+END_NS_EDGE
+
+int main(int argc, char** argv) {
+	return edge::benchmark::RunBenchmarks(argc, argv);
+}
@@ -0,0 +1,322 @@
+/*
+ * EdgeBenchmark.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Allocator benchmark harness.
+ *
+ */
+
+#include "EdgeBenchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+BEGIN_NS_EDGE
+BEGIN_NS_BENCHMARK
+
+//==================================================================================================
+// Baseline Allocators
+//==================================================================================================
+
+void* MallocAllocator::Allocate(size_t size, size_t alignment) {
+	return Allocate(size, memory::MemoryTag::NoTag, alignment);
+}
+
+void* MallocAllocator::Allocate(size_t size, memory::MemoryTag tag, size_t alignment) {
+	(void)tag;
+	EDGE_ASSERT(alignment <= memory::EDGE_DEFAULT_ALIGNMENT, "MallocAllocator only supports the default alignment");
+	(void)alignment;
+	return std::malloc(size);
+}
+
+void MallocAllocator::Free(void* ptr) {
+	std::free(ptr);
+}
+
+void MallocAllocator::Free(void* ptr, size_t size, size_t alignment) {
+	(void)size;
+	(void)alignment;
+	std::free(ptr);
+}
+
+void MallocAllocator::GetStats(memory::MemoryStats& stats) const {
+	stats = memory::MemoryStats();
+}
+
+void MallocAllocator::Reset() {
+}
+
+void* GlobalAllocator::Allocate(size_t size, size_t alignment) {
+	return memory::Allocate(size, alignment);
+}
+
+void* GlobalAllocator::Allocate(size_t size, memory::MemoryTag tag, size_t alignment) {
+	return memory::AllocateTagged(size, tag, alignment);
+}
+
+void GlobalAllocator::Free(void* ptr) {
+	memory::Free(ptr);
+}
+
+void GlobalAllocator::Free(void* ptr, size_t size, size_t alignment) {
+	memory::Free(ptr, size, alignment);
+}
+
+void GlobalAllocator::GetStats(memory::MemoryStats& stats) const {
+	memory::GetStats(stats);
+}
+
+void GlobalAllocator::Reset() {
+}
+
+//==================================================================================================
+// Timing
+//==================================================================================================
+
+uint64_t GetTimerOverheadNs() {
+	static uint64_t overhead = []() {
+		// Median of many back to back pairs, the minimum is too optimistic for a real sample
+		std::vector<uint32_t> samples(10000);
+		for (uint32_t& sample : samples) {
+			const uint64_t start = NowNs();
+			sample = static_cast<uint32_t>(NowNs() - start);
+		}
+		std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+		return static_cast<uint64_t>(samples[samples.size() / 2]);
+	}();
+	return overhead;
+}
+
+Percentiles ComputePercentiles(std::vector<uint32_t>& samples) {
+	Percentiles result = {};
+	if (samples.empty()) {
+		return result;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	auto at = [&samples](double fraction) {
+		size_t index = static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1) + 0.5);
+		return static_cast<double>(samples[index]);
+	};
+	result.p50 = at(0.5);
+	result.p99 = at(0.99);
+	result.p999 = at(0.999);
+	result.max = static_cast<double>(samples.back());
+	return result;
+}
+
+size_t Random::LogRange(size_t min, size_t max) {
+	const double low = std::log(static_cast<double>(min));
+	const double high = std::log(static_cast<double>(max) + 1.0);
+	const double unit = static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+	const size_t value = static_cast<size_t>(std::exp(low + (high - low) * unit));
+	return value < min ? min : (value > max ? max : value);
+}
+
+//==================================================================================================
+// Reporting
+//==================================================================================================
+
+Result::Result()
+	: threads(1), operations(0), nsPerOp(0.0), opsPerSecond(0.0), latency(), peakBytes(0),
+	fragmentation(0.0), failures(0) {
+}
+
+void Reporter::PrintHeader() const {
+	printf("%-13s %-18s %-26s %7s %10s %12s %9s %9s %9s %10s\n",
+		"suite", "allocator", "case", "threads", "ns/op", "ops/s", "p50", "p99", "p99.9", "peak KB");
+}
+
+void Reporter::Add(const Result& result) {
+	m_Results.push_back(result);
+
+	printf("%-13s %-18s %-26s %7zu %10.2f %12.0f %9.0f %9.0f %9.0f %10zu",
+		result.suite.c_str(), result.allocator.c_str(), result.name.c_str(), result.threads,
+		result.nsPerOp, result.opsPerSecond, result.latency.p50, result.latency.p99, result.latency.p999,
+		result.peakBytes / 1024);
+	if (result.fragmentation > 0.0) {
+		printf("  frag %.3f", result.fragmentation);
+	}
+	if (result.failures) {
+		printf("  failed %zu", result.failures);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+namespace {
+
+const char* BuildName() {
+#if EDGE_DEBUG
+	return "debug";
+#else
+	return "release";
+#endif
+}
+
+const char* PlatformName() {
+#if EDGE_PLATFORM_WINDOWS
+	return "windows";
+#elif EDGE_PLATFORM_MACOS
+	return "macos";
+#elif EDGE_PLATFORM_IOS
+	return "ios";
+#elif EDGE_PLATFORM_ANDROID
+	return "android";
+#else
+	return "unknown";
+#endif
+}
+
+// Names are generated by the suites, only quotes and backslashes need escaping
+void WriteJsonString(FILE* file, const std::string& value) {
+	fputc('"', file);
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			fputc('\\', file);
+		}
+		fputc(c, file);
+	}
+	fputc('"', file);
+}
+
+} // namespace
+
+bool Reporter::WriteJson(const char* path) const {
+	FILE* file = fopen(path, "w");
+	if (!file) {
+		printf("Failed to open %s for writing\n", path);
+		return false;
+	}
+
+	fprintf(file, "{\n  \"build\": \"%s\",\n  \"platform\": \"%s\",\n  \"hardwareThreads\": %u,\n  \"memoryTracking\": %s,\n  \"results\": [\n",
+		BuildName(), PlatformName(), std::thread::hardware_concurrency(), EDGE_MEMORY_TRACKING ? "true" : "false");
+
+	for (size_t i = 0; i < m_Results.size(); ++i) {
+		const Result& result = m_Results[i];
+		fputs("    {\"suite\": ", file);
+		WriteJsonString(file, result.suite);
+		fputs(", \"allocator\": ", file);
+		WriteJsonString(file, result.allocator);
+		fputs(", \"case\": ", file);
+		WriteJsonString(file, result.name);
+		fprintf(file, ", \"threads\": %zu, \"operations\": %zu, \"nsPerOp\": %.3f, \"opsPerSecond\": %.1f, "
+			"\"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f, \"peakBytes\": %zu, "
+			"\"fragmentation\": %.4f, \"failures\": %zu}%s\n",
+			result.threads, result.operations, result.nsPerOp, result.opsPerSecond,
+			result.latency.p50, result.latency.p99, result.latency.p999, result.latency.max,
+			result.peakBytes, result.fragmentation, result.failures, i + 1 < m_Results.size() ? "," : "");
+	}
+
+	fputs("  ]\n}\n", file);
+	fclose(file);
+	return true;
+}
+
+bool Reporter::WriteCsv(const char* path) const {
+	FILE* file = fopen(path, "w");
+	if (!file) {
+		printf("Failed to open %s for writing\n", path);
+		return false;
+	}
+
+	fputs("suite,allocator,case,threads,operations,nsPerOp,opsPerSecond,p50,p99,p999,max,peakBytes,fragmentation,failures\n", file);
+	for (const Result& result : m_Results) {
+		fprintf(file, "%s,%s,%s,%zu,%zu,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%zu,%.4f,%zu\n",
+			result.suite.c_str(), result.allocator.c_str(), result.name.c_str(), result.threads,
+			result.operations, result.nsPerOp, result.opsPerSecond, result.latency.p50, result.latency.p99,
+			result.latency.p999, result.latency.max, result.peakBytes, result.fragmentation, result.failures);
+	}
+
+	fclose(file);
+	return true;
+}
+
+//==================================================================================================
+// Options
+//==================================================================================================
+
+Options::Options()
+	: scale(1.0), maxThreads(0), filter(nullptr), jsonPath(nullptr), csvPath(nullptr),
+	tracePath(nullptr) {
+	maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0 || maxThreads > memory::EDGE_MAX_THREAD_SLOTS) {
+		maxThreads = memory::EDGE_MAX_THREAD_SLOTS;
+	}
+}
+
+namespace {
+
+void PrintUsage() {
+	printf("Usage: EdgeBenchmark [options]\n");
+	printf("  --quick            run every suite at a tenth of the iterations\n");
+	printf("  --scale=X          multiply every iteration count by X\n");
+	printf("  --threads=N        highest thread count for the contention suite\n");
+	printf("  --filter=NAME      only run suites whose name contains NAME\n");
+	printf("  --json=PATH        write the results as JSON\n");
+	printf("  --csv=PATH         write the results as CSV\n");
+	printf("  --trace=PATH       replay a recorded allocation trace instead of the synthetic one\n");
+	printf("Suites: throughput, contention, replay, fragmentation, latency\n");
+}
+
+// Value of --name=value, nullptr when the argument is a different option
+const char* OptionValue(const char* argument, const char* name) {
+	const size_t length = strlen(name);
+	if (strncmp(argument, name, length) == 0 && argument[length] == '=') {
+		return argument + length + 1;
+	}
+	return nullptr;
+}
+
+} // namespace
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; ++i) {
+		const char* argument = argv[i];
+		const char* value = nullptr;
+
+		if (strcmp(argument, "--quick") == 0) {
+			options.scale = 0.1;
+		}
+		else if ((value = OptionValue(argument, "--scale")) != nullptr) {
+			options.scale = atof(value);
+			if (options.scale <= 0.0) {
+				printf("--scale must be positive\n");
+				return false;
+			}
+		}
+		else if ((value = OptionValue(argument, "--threads")) != nullptr) {
+			options.maxThreads = static_cast<size_t>(atoi(value));
+			if (options.maxThreads == 0 || options.maxThreads > memory::EDGE_MAX_THREAD_SLOTS) {
+				printf("--threads must be between 1 and %zu\n", memory::EDGE_MAX_THREAD_SLOTS);
+				return false;
+			}
+		}
+		else if ((value = OptionValue(argument, "--filter")) != nullptr) {
+			options.filter = value;
+		}
+		else if ((value = OptionValue(argument, "--json")) != nullptr) {
+			options.jsonPath = value;
+		}
+		else if ((value = OptionValue(argument, "--csv")) != nullptr) {
+			options.csvPath = value;
+		}
+		else if ((value = OptionValue(argument, "--trace")) != nullptr) {
+			options.tracePath = value;
+		}
+		else {
+			PrintUsage();
+			return false;
+		}
+	}
+	return true;
+}
+
+END_NS_BENCHMARK
+END_NS_EDGE
@@ -0,0 +1,143 @@
+/*
+ * EdgeBenchmark.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Allocator benchmark harness.
+ *
+ * Responsibilities:
+ * - Put the system malloc and the global memory functions behind IAllocator,
+ * - Time runs and reduce per-operation samples to percentiles,
+ * - And collect results for the console and the machine-readable reports.
+ */
+
+#ifndef INC_EDGE_BENCHMARK_
+#define INC_EDGE_BENCHMARK_
+
+#include "EdgeMemory.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BEGIN_NS_EDGE
+BEGIN_NS_BENCHMARK
+
+// System malloc behind IAllocator, the baseline every allocator is compared against
+// Only the default alignment is supported, malloc has no portable aligned counterpart to free.
+class MallocAllocator : public memory::IAllocator {
+public:
+	void* Allocate(size_t size, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override;
+	void* Allocate(size_t size, memory::MemoryTag tag, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override;
+	void Free(void* ptr) override;
+	void Free(void* ptr, size_t size, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override;
+	void GetStats(memory::MemoryStats& stats) const override;
+	void Reset() override;
+};
+
+// Global memory functions behind IAllocator, the thread-cached path most engine code takes
+class GlobalAllocator : public memory::IAllocator {
+public:
+	void* Allocate(size_t size, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override;
+	void* Allocate(size_t size, memory::MemoryTag tag, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override;
+	void Free(void* ptr) override;
+	void Free(void* ptr, size_t size, size_t alignment = memory::EDGE_DEFAULT_ALIGNMENT) override;
+	void GetStats(memory::MemoryStats& stats) const override;
+	void Reset() override;
+};
+
+// Monotonic time in nanoseconds
+inline uint64_t NowNs() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Cost of one NowNs pair, subtracted from per-operation samples
+uint64_t GetTimerOverheadNs();
+
+struct Percentiles {
+	double p50;
+	double p99;
+	double p999;
+	double max;
+};
+
+// Sorts the samples in place, all zero for an empty set
+Percentiles ComputePercentiles(std::vector<uint32_t>& samples);
+
+// One measured case
+struct Result {
+	std::string suite;
+	std::string allocator;
+	std::string name;			// case within the suite
+	size_t threads;
+	size_t operations;
+	double nsPerOp;
+	double opsPerSecond;
+	Percentiles latency;		// nanoseconds per operation, or per frame for replays, zero when not sampled
+	size_t peakBytes;			// zero when the allocator does not report usage
+	double fragmentation;		// heap allocators only
+	size_t failures;			// allocations that returned nullptr
+
+	Result();
+};
+
+// Collects results, prints each as it lands and writes the reports at the end
+class Reporter {
+public:
+	void Add(const Result& result);
+	const std::vector<Result>& GetResults() const { return m_Results; }
+
+	void PrintHeader() const;
+	bool WriteJson(const char* path) const;
+	bool WriteCsv(const char* path) const;
+
+private:
+	std::vector<Result> m_Results;
+};
+
+// Command line options
+struct Options {
+	double scale;				// multiplies every iteration count, --quick sets 0.1
+	size_t maxThreads;
+	const char* filter;			// only suites whose name contains this, nullptr runs all
+	const char* jsonPath;
+	const char* csvPath;
+	const char* tracePath;		// recorded allocation trace for the replay suite, nullptr replays the synthetic one
+
+	Options();
+};
+
+// Command line parsing, returns false and prints usage on a bad argument or --help
+bool ParseOptions(int argc, char** argv, Options& options);
+
+// Deterministic generator, every run replays the same traces
+class Random {
+public:
+	explicit Random(uint64_t seed) : m_State(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+	uint64_t Next() {
+		m_State ^= m_State << 13;
+		m_State ^= m_State >> 7;
+		m_State ^= m_State << 17;
+		return m_State;
+	}
+
+	// Uniform in [min, max]
+	size_t Range(size_t min, size_t max) {
+		return min + static_cast<size_t>(Next() % (max - min + 1));
+	}
+
+	// Log-uniform in [min, max], small sizes are as common as they are in real heaps
+	size_t LogRange(size_t min, size_t max);
+
+private:
+	uint64_t m_State;
+};
+
+END_NS_BENCHMARK
+END_NS_EDGE
+
+#endif // INC_EDGE_BENCHMARK_
@@ -0,0 +1,421 @@
+/*
+ * EdgeAllocationTrace.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Binary allocation traces for offline allocator tuning.
+ *
+ */
+
+#include "EdgeAllocationTrace.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if EDGE_PLATFORM_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+//==================================================================================================
+// File Mapping
+//==================================================================================================
+namespace {
+
+constexpr intptr_t kNoHandle = -1;
+
+uint64_t TraceNowNs() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint8_t AlignmentLog2(size_t alignment) {
+	uint8_t shift = 0;
+	while (shift < 63 && (size_t(1) << shift) < alignment) {
+		++shift;
+	}
+	return shift;
+}
+
+// Map size bytes of path for writing, the file is created or truncated to that size
+void* MapFileForWrite(const char* path, size_t size, intptr_t& file, intptr_t& mapping) {
+	file = kNoHandle;
+	mapping = kNoHandle;
+#if EDGE_PLATFORM_WINDOWS
+	HANDLE fileHandle = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	const uint64_t size64 = static_cast<uint64_t>(size);
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFFu), nullptr);
+	if (!mappingHandle) {
+		CloseHandle(fileHandle);
+		return nullptr;
+	}
+	void* view = MapViewOfFile(mappingHandle, FILE_MAP_WRITE, 0, 0, size);
+	if (!view) {
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return nullptr;
+	}
+	file = reinterpret_cast<intptr_t>(fileHandle);
+	mapping = reinterpret_cast<intptr_t>(mappingHandle);
+	return view;
+#else
+	const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return nullptr;
+	}
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		close(fd);
+		return nullptr;
+	}
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) {
+		close(fd);
+		return nullptr;
+	}
+	file = fd;
+	return view;
+#endif
+}
+
+// Map the whole of path read-only, size receives the file size
+const void* MapFileForRead(const char* path, size_t& size, intptr_t& file, intptr_t& mapping) {
+	file = kNoHandle;
+	mapping = kNoHandle;
+	size = 0;
+#if EDGE_PLATFORM_WINDOWS
+	HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(fileHandle);
+		return nullptr;
+	}
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mappingHandle) {
+		CloseHandle(fileHandle);
+		return nullptr;
+	}
+	const void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return nullptr;
+	}
+	file = reinterpret_cast<intptr_t>(fileHandle);
+	mapping = reinterpret_cast<intptr_t>(mappingHandle);
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return view;
+#else
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return nullptr;
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) {
+		close(fd);
+		return nullptr;
+	}
+	file = fd;
+	size = static_cast<size_t>(info.st_size);
+	return view;
+#endif
+}
+
+void UnmapFile(const void* view, size_t size, intptr_t file, intptr_t mapping) {
+#if EDGE_PLATFORM_WINDOWS
+	(void)size;
+	if (view) {
+		UnmapViewOfFile(view);
+	}
+	if (mapping != kNoHandle) {
+		CloseHandle(reinterpret_cast<HANDLE>(mapping));
+	}
+	if (file != kNoHandle) {
+		CloseHandle(reinterpret_cast<HANDLE>(file));
+	}
+#else
+	(void)mapping;
+	if (view) {
+		munmap(const_cast<void*>(view), size);
+	}
+	if (file != kNoHandle) {
+		close(static_cast<int>(file));
+	}
+#endif
+}
+
+} // namespace
+
+uint32_t GetTraceSiteId(const char* file, int line) {
+	if (!file) {
+		return 0;
+	}
+
+	// Only the file name, build machines disagree on where the source tree lives
+	const char* name = file;
+	for (const char* c = file; *c; ++c) {
+		if (*c == '/' || *c == '\\') {
+			name = c + 1;
+		}
+	}
+
+	// FNV-1a over the name and the line
+	uint32_t hash = 2166136261u;
+	for (const char* c = name; *c; ++c) {
+		hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+	}
+	const uint32_t lineValue = static_cast<uint32_t>(line);
+	for (int i = 0; i < 4; ++i) {
+		hash = (hash ^ ((lineValue >> (i * 8)) & 0xFFu)) * 16777619u;
+	}
+	return hash ? hash : 1;
+}
+
+//==================================================================================================
+// AllocationTrace Implementation
+//==================================================================================================
+
+AllocationTrace::AllocationTrace()
+	: m_Header(nullptr), m_Events(nullptr), m_Capacity(0), m_StartTime(0), m_EventCount(0), m_Writers(0),
+	m_Open(false), m_MappedSize(0), m_File(kNoHandle), m_Mapping(kNoHandle) {
+}
+
+AllocationTrace::~AllocationTrace() {
+	Close();
+}
+
+bool AllocationTrace::Open(const char* path, size_t capacity) {
+	EDGE_ASSERT(!IsOpen(), "AllocationTrace is already open");
+	EDGE_ASSERT(capacity > 0, "AllocationTrace needs room for at least one event");
+	if (IsOpen() || capacity == 0) {
+		return false;
+	}
+
+	const size_t mappedSize = sizeof(TraceFileHeader) + capacity * sizeof(TraceEvent);
+	void* view = MapFileForWrite(path, mappedSize, m_File, m_Mapping);
+	if (!view) {
+		return false;
+	}
+
+	m_Header = static_cast<TraceFileHeader*>(view);
+	memset(m_Header, 0, sizeof(TraceFileHeader));
+	m_Header->magic = TraceFileHeader::TRACE_MAGIC;
+	m_Header->version = TraceFileHeader::TRACE_VERSION;
+	m_Header->eventSize = static_cast<uint16_t>(sizeof(TraceEvent));
+	m_Header->capacity = capacity;
+
+	m_Events = reinterpret_cast<TraceEvent*>(m_Header + 1);
+	m_Capacity = capacity;
+	m_MappedSize = mappedSize;
+	m_StartTime = TraceNowNs();
+	m_EventCount.store(0, std::memory_order_relaxed);
+	m_Open.store(true);
+	return true;
+}
+
+void AllocationTrace::Close() {
+	if (!m_Header) {
+		return;
+	}
+
+	// Pairs with Record, a writer either sees the trace closed or is waited for here
+	m_Open.store(false);
+	while (m_Writers.load() != 0) {
+		std::this_thread::yield();
+	}
+
+	m_Header->eventCount = m_EventCount.load(std::memory_order_relaxed);
+	UnmapFile(m_Header, m_MappedSize, m_File, m_Mapping);
+	m_Header = nullptr;
+	m_Events = nullptr;
+	m_Capacity = 0;
+	m_MappedSize = 0;
+	m_File = kNoHandle;
+	m_Mapping = kNoHandle;
+}
+
+void AllocationTrace::RecordAllocate(const void* ptr, size_t size, size_t alignment, MemoryTag tag, uint32_t siteId) {
+	Record(TraceEventType::Allocate, ptr, size, alignment, tag, siteId);
+}
+
+void AllocationTrace::RecordFree(const void* ptr, size_t size, MemoryTag tag) {
+	Record(TraceEventType::Free, ptr, size, 1, tag, 0);
+}
+
+void AllocationTrace::RecordFrame() {
+	Record(TraceEventType::Frame, nullptr, 0, 1, MemoryTag::NoTag, 0);
+}
+
+void AllocationTrace::RecordReset() {
+	Record(TraceEventType::Reset, nullptr, 0, 1, MemoryTag::NoTag, 0);
+}
+
+void AllocationTrace::Record(TraceEventType type, const void* ptr, size_t size, size_t alignment, MemoryTag tag,
+	uint32_t siteId) {
+	m_Writers.fetch_add(1);
+	if (m_Open.load()) {
+		const uint64_t index = m_EventCount.fetch_add(1, std::memory_order_relaxed);
+		TraceEvent& event = m_Events[index % m_Capacity];
+		event.timestamp = TraceNowNs() - m_StartTime;
+		event.address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr));
+		event.size = size >= TraceEvent::SIZE_OVERFLOW ? TraceEvent::SIZE_OVERFLOW : static_cast<uint32_t>(size);
+		event.siteId = siteId;
+		event.thread = static_cast<uint16_t>(GetThreadSlot());
+		event.type = type;
+		event.tag = tag;
+		event.alignmentLog2 = AlignmentLog2(alignment);
+		memset(event.reserved, 0, sizeof(event.reserved));
+	}
+	m_Writers.fetch_sub(1, std::memory_order_release);
+}
+
+//==================================================================================================
+// TracingAllocator Implementation
+//==================================================================================================
+
+TracingAllocator::TracingAllocator(IAllocator& allocator, AllocationTrace& trace)
+	: m_Allocator(allocator), m_Trace(trace) {
+}
+
+void* TracingAllocator::Allocate(size_t size, size_t alignment) {
+	return Allocate(size, MemoryTag::NoTag, alignment);
+}
+
+void* TracingAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment) {
+	void* ptr = m_Allocator.Allocate(size, tag, alignment);
+	if (ptr) {
+		m_Trace.RecordAllocate(ptr, size, alignment, tag);
+	}
+	return ptr;
+}
+
+void TracingAllocator::Free(void* ptr) {
+	if (ptr) {
+		m_Trace.RecordFree(ptr);
+		m_Allocator.Free(ptr);
+	}
+}
+
+void TracingAllocator::Free(void* ptr, size_t size, size_t alignment) {
+	if (ptr) {
+		m_Trace.RecordFree(ptr, size);
+		m_Allocator.Free(ptr, size, alignment);
+	}
+}
+
+void TracingAllocator::GetStats(MemoryStats& stats) const {
+	m_Allocator.GetStats(stats);
+}
+
+void TracingAllocator::Reset() {
+	m_Trace.RecordReset();
+	m_Allocator.Reset();
+}
+
+bool TracingAllocator::AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag) {
+	if (!m_Allocator.AllocateBatch(count, size, alignment, out, tag)) {
+		return false;
+	}
+	for (size_t i = 0; i < count; ++i) {
+		m_Trace.RecordAllocate(out[i], size, alignment, tag);
+	}
+	return true;
+}
+
+void TracingAllocator::FreeBatch(void** ptrs, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		if (ptrs[i]) {
+			m_Trace.RecordFree(ptrs[i]);
+		}
+	}
+	m_Allocator.FreeBatch(ptrs, count);
+}
+
+//==================================================================================================
+// TraceReader Implementation
+//==================================================================================================
+
+TraceReader::TraceReader()
+	: m_Events(nullptr), m_Capacity(0), m_First(0), m_Count(0), m_Dropped(0), m_Mapped(nullptr), m_MappedSize(0),
+	m_File(kNoHandle), m_Mapping(kNoHandle) {
+}
+
+TraceReader::~TraceReader() {
+	Close();
+}
+
+bool TraceReader::Open(const char* path) {
+	Close();
+
+	m_Mapped = MapFileForRead(path, m_MappedSize, m_File, m_Mapping);
+	if (!m_Mapped) {
+		return false;
+	}
+
+	const TraceFileHeader* header = static_cast<const TraceFileHeader*>(m_Mapped);
+	const bool valid = m_MappedSize >= sizeof(TraceFileHeader) &&
+		header->magic == TraceFileHeader::TRACE_MAGIC &&
+		header->version == TraceFileHeader::TRACE_VERSION &&
+		header->eventSize == sizeof(TraceEvent) &&
+		header->capacity > 0 &&
+		header->capacity <= (m_MappedSize - sizeof(TraceFileHeader)) / sizeof(TraceEvent);
+	if (!valid) {
+		Close();
+		return false;
+	}
+
+	// A full ring starts at the slot the next event would have overwritten
+	m_Events = reinterpret_cast<const TraceEvent*>(header + 1);
+	m_Capacity = header->capacity;
+	if (header->eventCount > m_Capacity) {
+		m_First = header->eventCount % m_Capacity;
+		m_Count = static_cast<size_t>(m_Capacity);
+		m_Dropped = header->eventCount - m_Capacity;
+	}
+	else {
+		m_First = 0;
+		m_Count = static_cast<size_t>(header->eventCount);
+		m_Dropped = 0;
+	}
+	return true;
+}
+
+void TraceReader::Close() {
+	if (m_Mapped) {
+		UnmapFile(m_Mapped, m_MappedSize, m_File, m_Mapping);
+	}
+	m_Events = nullptr;
+	m_Capacity = 0;
+	m_First = 0;
+	m_Count = 0;
+	m_Dropped = 0;
+	m_Mapped = nullptr;
+	m_MappedSize = 0;
+	m_File = kNoHandle;
+	m_Mapping = kNoHandle;
+}
+
+END_NS_MEMORY
+END_NS_EDGE
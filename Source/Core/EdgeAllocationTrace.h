@@ -0,0 +1,165 @@
+/*
+ * EdgeAllocationTrace.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Binary allocation traces for offline allocator tuning.
+ *
+ * Responsibilities:
+ * - Stream allocate and free events into a memory-mapped ring file,
+ * - Record the events of any IAllocator through a forwarding wrapper,
+ * - And read a finished recording back in event order for replay.
+ */
+
+#ifndef INC_EDGE_CORE_ALLOCATION_TRACE_
+#define INC_EDGE_CORE_ALLOCATION_TRACE_
+
+#include "EdgeMemory.h"
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+enum class TraceEventType : uint8_t {
+	Allocate,
+	Free,
+	Frame,		// frame boundary marker
+	Reset,		// the allocator released every block at once
+};
+
+// One event as stored in the file, 32 bytes
+struct TraceEvent {
+	uint64_t timestamp;		// nanoseconds since the recording was opened
+	uint64_t address;		// user pointer, 0 for markers
+	uint32_t size;			// 0 for a free without size, SIZE_OVERFLOW for blocks of 4GB and up
+	uint32_t siteId;		// GetTraceSiteId of the call site, 0 when unknown
+	uint16_t thread;		// GetThreadSlot of the recording thread
+	TraceEventType type;
+	MemoryTag tag;
+	uint8_t alignmentLog2;
+	uint8_t reserved[3];
+
+	static constexpr uint32_t SIZE_OVERFLOW = 0xFFFFFFFFu;
+};
+
+static_assert(sizeof(TraceEvent) == 32, "TraceEvent is part of the file format");
+
+// File layout: this header, then capacity events used as a ring
+struct TraceFileHeader {
+	uint32_t magic;			// TRACE_MAGIC
+	uint16_t version;		// TRACE_VERSION
+	uint16_t eventSize;		// sizeof(TraceEvent)
+	uint64_t capacity;		// events in the ring
+	uint64_t eventCount;	// events recorded, the ring keeps the last min(eventCount, capacity)
+	uint8_t reserved[40];
+
+	static constexpr uint32_t TRACE_MAGIC = 0x54474445u;	// "EDGT"
+	static constexpr uint16_t TRACE_VERSION = 1;
+};
+
+static_assert(sizeof(TraceFileHeader) == 64, "TraceFileHeader is part of the file format");
+
+// Stable id for a call site, the same source location hashes the same in every build
+uint32_t GetTraceSiteId(const char* file, int line);
+
+// Allocation trace recorder - appends events to a memory-mapped ring file
+// Recording is lock-free, each event claims its ring slot with one atomic increment. An allocation
+// is recorded after it succeeds and a free before the block is released, so in ring order a block
+// is always freed before its address is handed out again. Once the ring is full the oldest events
+// are overwritten. The header is completed by Close, a recording is only readable after it.
+class AllocationTrace {
+public:
+	AllocationTrace();
+	~AllocationTrace();
+
+	// Create or truncate the file and map a ring of capacity events
+	bool Open(const char* path, size_t capacity);
+	// Waits for in-flight events, then finishes the header and unmaps the file
+	void Close();
+	bool IsOpen() const { return m_Open.load(std::memory_order_relaxed); }
+
+	void RecordAllocate(const void* ptr, size_t size, size_t alignment, MemoryTag tag, uint32_t siteId = 0);
+	void RecordFree(const void* ptr, size_t size = 0, MemoryTag tag = MemoryTag::NoTag);
+	void RecordFrame();
+	void RecordReset();
+
+	// Events recorded so far, including overwritten ones
+	uint64_t GetEventCount() const { return m_EventCount.load(std::memory_order_relaxed); }
+
+	AllocationTrace(const AllocationTrace&) = delete;
+	AllocationTrace& operator=(const AllocationTrace&) = delete;
+
+private:
+	TraceFileHeader* m_Header;
+	TraceEvent* m_Events;
+	uint64_t m_Capacity;
+	uint64_t m_StartTime;
+	std::atomic<uint64_t> m_EventCount;
+	std::atomic<uint32_t> m_Writers;
+	std::atomic<bool> m_Open;
+	size_t m_MappedSize;
+	intptr_t m_File;
+	intptr_t m_Mapping;
+
+	void Record(TraceEventType type, const void* ptr, size_t size, size_t alignment, MemoryTag tag, uint32_t siteId);
+};
+
+// Forwards to another allocator and records every call into a trace
+// Batches are recorded block by block, Reset is recorded as a Reset event.
+class TracingAllocator : public IAllocator {
+public:
+	TracingAllocator(IAllocator& allocator, AllocationTrace& trace);
+
+	void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void* Allocate(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void Free(void* ptr) override;
+	void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void GetStats(MemoryStats& stats) const override;
+	void Reset() override;
+
+	bool AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag = MemoryTag::NoTag) override;
+	void FreeBatch(void** ptrs, size_t count) override;
+
+	IAllocator& GetAllocator() const { return m_Allocator; }
+
+private:
+	IAllocator& m_Allocator;
+	AllocationTrace& m_Trace;
+};
+
+// Read-only view of a finished recording, events are returned oldest first
+class TraceReader {
+public:
+	TraceReader();
+	~TraceReader();
+
+	bool Open(const char* path);
+	void Close();
+
+	size_t GetEventCount() const { return m_Count; }
+	const TraceEvent& GetEvent(size_t index) const {
+		return m_Events[(m_First + index) % m_Capacity];
+	}
+	// Events lost to ring wrap-around before the first one still held
+	uint64_t GetDroppedCount() const { return m_Dropped; }
+
+	TraceReader(const TraceReader&) = delete;
+	TraceReader& operator=(const TraceReader&) = delete;
+
+private:
+	const TraceEvent* m_Events;
+	uint64_t m_Capacity;
+	uint64_t m_First;
+	size_t m_Count;
+	uint64_t m_Dropped;
+	const void* m_Mapped;
+	size_t m_MappedSize;
+	intptr_t m_File;
+	intptr_t m_Mapping;
+};
+
+END_NS_MEMORY
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_ALLOCATION_TRACE_
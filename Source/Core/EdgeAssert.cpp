@@ -10,9 +10,14 @@
  */
 
 #include "EdgeAssert.h"
-#include <iostream>
-#include <sstream>
+#include <chrono>
+#include <condition_variable>
 #include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
 
 #if EDGE_PLATFORM_WINDOWS
 #include <Windows.h>
@@ -20,14 +25,288 @@
 
 BEGIN_NS_EDGE
 BEGIN_NS_ASSERT
+//====================
+// Report Queue
+//====================
+namespace {
+
+constexpr size_t kQueueMask = EDGE_ASSERT_QUEUE_CAPACITY - 1;
+static_assert((EDGE_ASSERT_QUEUE_CAPACITY & kQueueMask) == 0, "EDGE_ASSERT_QUEUE_CAPACITY must be a power of two");
+
+// How long the log thread sleeps between looks at the queue, producers never wake it
+constexpr std::chrono::milliseconds kDrainInterval(5);
+
+// One queued report
+// The sequence counts from the first position of the lap the record is claimed in, so zeroed
+// storage starts out empty: the lap's first position means free, one past it means written.
+struct LogRecord {
+	std::atomic<size_t> sequence;
+	const AssertInfo* info;
+	uint32_t hits;
+	AssertArgs args;
+	char strings[EDGE_ASSERT_STRING_SIZE];	// string arguments point in here
+
+	constexpr LogRecord() : sequence(0), info(nullptr), hits(0), args(), strings() {}
+};
+
+// Constant initialized, so reports can be queued from static initializers
+LogRecord g_Records[EDGE_ASSERT_QUEUE_CAPACITY];
+alignas(64) std::atomic<size_t> g_Tail(0);		// own cache line, every producer writes it
+std::atomic<uint32_t> g_Dropped(0);
+
+// Copy the text of the string arguments into storage and point them at the copies. The caller's
+// strings may be gone by the time the log thread formats the report.
+void CopyStrings(AssertArgs& args, char* storage, size_t size) {
+	size_t used = 0;
+	for (uint32_t i = 0; i < args.count; ++i) {
+		AssertArg& arg = args.values[i];
+		if (arg.type != AssertArg::Type::String || arg.s == nullptr) {
+			continue;
+		}
+
+		const char* text = arg.s;
+		arg.s = storage + used;
+		while (used + 1 < size && *text != '\0') {
+			storage[used++] = *text++;
+		}
+		if (used < size) {
+			storage[used++] = '\0';
+		}
+		else {
+			arg.s = "";
+		}
+	}
+}
+
+// Claim a position and fill its record, false when the queue is full
+bool PushRecord(const AssertInfo& info, uint32_t hits, const AssertArgs& args) {
+	size_t position = g_Tail.load(std::memory_order_relaxed);
+	for (;;) {
+		LogRecord& record = g_Records[position & kQueueMask];
+		const size_t lap = position & ~kQueueMask;
+		const size_t sequence = record.sequence.load(std::memory_order_acquire);
+
+		if (sequence == lap) {
+			if (g_Tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				record.info = &info;
+				record.hits = hits;
+				record.args = args;
+				CopyStrings(record.args, record.strings, sizeof(record.strings));
+				record.sequence.store(lap + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (static_cast<ptrdiff_t>(sequence - lap) < 0) {
+			// Still holds a report from the previous lap
+			return false;
+		}
+		else {
+			position = g_Tail.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+// Only called with the drain lock held, there is one consumer at a time. String arguments are
+// copied to strings, EDGE_ASSERT_STRING_SIZE bytes, as the record is reused once it is popped.
+bool PopRecord(size_t& head, const AssertInfo*& info, uint32_t& hits, AssertArgs& args, char* strings) {
+	LogRecord& record = g_Records[head & kQueueMask];
+	const size_t lap = head & ~kQueueMask;
+	if (record.sequence.load(std::memory_order_acquire) != lap + 1) {
+		return false;
+	}
+
+	info = record.info;
+	hits = record.hits;
+	args = record.args;
+	CopyStrings(args, strings, EDGE_ASSERT_STRING_SIZE);
+	record.sequence.store(lap + EDGE_ASSERT_QUEUE_CAPACITY, std::memory_order_release);
+	head++;
+	return true;
+}
+
+//====================
+// Formatting
+//====================
+
+// Appends to a fixed buffer, whatever doesn't fit is cut off
+struct MessageWriter {
+	char* buffer;
+	size_t size;
+	size_t length;
+
+	void Append(const char* text, size_t count) {
+		if (length + count >= size) {
+			count = size - 1 - length;
+		}
+		memcpy(buffer + length, text, count);
+		length += count;
+		buffer[length] = '\0';
+	}
+
+	void Append(const char* text) {
+		Append(text, strlen(text));
+	}
+
+	void Print(const char* format, ...) {
+		va_list arguments;
+		va_start(arguments, format);
+		const int written = vsnprintf(buffer + length, size - length, format, arguments);
+		va_end(arguments);
+		if (written > 0) {
+			length += static_cast<size_t>(written) < size - length ? static_cast<size_t>(written) : size - 1 - length;
+		}
+	}
+};
+
+int64_t ToInt(const AssertArg& arg) {
+	switch (arg.type) {
+	case AssertArg::Type::UInt:
+		return static_cast<int64_t>(arg.u);
+	case AssertArg::Type::Float:
+		return static_cast<int64_t>(arg.f);
+	case AssertArg::Type::Pointer:
+	case AssertArg::Type::String:
+		return static_cast<int64_t>(reinterpret_cast<intptr_t>(arg.p));
+	case AssertArg::Type::Int:
+	default:
+		return arg.i;
+	}
+}
+
+double ToFloat(const AssertArg& arg) {
+	switch (arg.type) {
+	case AssertArg::Type::Float:
+		return arg.f;
+	case AssertArg::Type::UInt:
+		return static_cast<double>(arg.u);
+	default:
+		return static_cast<double>(ToInt(arg));
+	}
+}
+
+// printf over the captured arguments
+// Flags, width and precision are kept, the length modifier comes from the captured type.
+// Conversions without an argument are written out as they are.
+void FormatArgs(MessageWriter& writer, const char* format, const AssertArgs& args) {
+	size_t next = 0;
+	const char* text = format;
+	while (*text) {
+		if (*text != '%') {
+			const char* end = strchr(text, '%');
+			const size_t count = end ? static_cast<size_t>(end - text) : strlen(text);
+			writer.Append(text, count);
+			text += count;
+			continue;
+		}
+
+		if (text[1] == '%') {
+			writer.Append("%", 1);
+			text += 2;
+			continue;
+		}
+
+		char spec[32];
+		size_t specLength = 0;
+		spec[specLength++] = '%';
+		const char* cursor = text + 1;
+		while (*cursor && strchr("-+ #0123456789.", *cursor) && specLength < sizeof(spec) - 4) {
+			spec[specLength++] = *cursor++;
+		}
+		while (*cursor && strchr("hlLqjzt", *cursor)) {
+			cursor++;
+		}
+
+		const char conversion = *cursor;
+		if (conversion == '\0' || next >= args.count || !strchr("diuxXocfFeEgGaAps", conversion)) {
+			const size_t count = conversion ? static_cast<size_t>(cursor - text) + 1 : strlen(text);
+			writer.Append(text, count);
+			text += count;
+			continue;
+		}
+		text = cursor + 1;
+
+		const AssertArg& arg = args.values[next++];
+		switch (conversion) {
+		case 'd':
+		case 'i':
+			memcpy(spec + specLength, "lld", 4);
+			writer.Print(spec, static_cast<long long>(ToInt(arg)));
+			break;
+		case 'c':
+			spec[specLength++] = 'c';
+			spec[specLength] = '\0';
+			writer.Print(spec, static_cast<int>(ToInt(arg)));
+			break;
+		case 'p':
+			spec[specLength++] = 'p';
+			spec[specLength] = '\0';
+			writer.Print(spec, arg.type == AssertArg::Type::Pointer || arg.type == AssertArg::Type::String ? arg.p : nullptr);
+			break;
+		case 's':
+			spec[specLength++] = 's';
+			spec[specLength] = '\0';
+			writer.Print(spec, arg.type == AssertArg::Type::String && arg.s ? arg.s : "(null)");
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			spec[specLength++] = 'l';
+			spec[specLength++] = 'l';
+			spec[specLength++] = conversion;
+			spec[specLength] = '\0';
+			writer.Print(spec, static_cast<unsigned long long>(ToInt(arg)));
+			break;
+		default:
+			spec[specLength++] = conversion;
+			spec[specLength] = '\0';
+			writer.Print(spec, ToFloat(arg));
+			break;
+		}
+	}
+}
+
+const char* GetLevelPrefix(AssertLevel level) {
+	switch (level) {
+	case AssertLevel::Fatal:
+		return "[FATAL] ";
+	case AssertLevel::Error:
+		return "[ERROR] ";
+	case AssertLevel::Warning:
+		return "[WARNING] ";
+	case AssertLevel::Info:
+	default:
+		return "[INFO] ";
+	}
+}
+
+} // namespace
+
 //====================
 // AssertHandler
 //====================
+struct AssertHandler::AsyncLog {
+	std::recursive_mutex drainLock;		// recursive, a sink that breaks flushes from inside a drain
+	std::mutex wakeLock;
+	std::condition_variable wake;
+	std::thread thread;
+	size_t head = 0;						// next position to read, under drainLock
+	bool stop = false;						// under wakeLock
+};
+
 AssertHandler& AssertHandler::Get() {
 	static AssertHandler instance;
 	return instance;
 }
 
+AssertHandler::AssertHandler() : m_SinkCount(0), m_Async(nullptr), m_Running(false) {
+}
+
+// The log itself stays alive for threads still asserting during exit
+AssertHandler::~AssertHandler() {
+	StopAsync();
+}
+
 void AssertHandler::SetCallback(AssertCallbackFn callback) {
 	m_Callback = callback;
 }
@@ -36,77 +315,186 @@ void AssertHandler::ResetCallback() {
 	m_Callback = nullptr;
 }
 
+bool AssertHandler::AddSink(AssertSinkFn sink) {
+	if (m_SinkCount >= EDGE_ASSERT_MAX_SINKS) {
+		return false;
+	}
+	m_Sinks[m_SinkCount++] = sink;
+	return true;
+}
+
+void AssertHandler::ResetSinks() {
+	for (size_t i = 0; i < m_SinkCount; ++i) {
+		m_Sinks[i] = nullptr;
+	}
+	m_SinkCount = 0;
+}
+
+void AssertHandler::StartAsync() {
+	AsyncLog* log = m_Async.load(std::memory_order_acquire);
+	if (!log) {
+		// Static storage, the log must not depend on the heap it reports for
+		alignas(AsyncLog) static uint8_t storage[sizeof(AsyncLog)];
+		log = new (storage) AsyncLog();
+		m_Async.store(log, std::memory_order_release);
+	}
+
+	if (log->thread.joinable()) {
+		return;
+	}
+
+	log->stop = false;
+	m_Running.store(true, std::memory_order_release);
+	log->thread = std::thread(&AssertHandler::LogMain, this);
+}
+
+void AssertHandler::StopAsync() {
+	AsyncLog* log = m_Async.load(std::memory_order_acquire);
+	if (!log || !log->thread.joinable()) {
+		return;
+	}
+
+	m_Running.store(false, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock(log->wakeLock);
+		log->stop = true;
+	}
+	log->wake.notify_one();
+	log->thread.join();
+
+	// Reports from threads that still saw the log running
+	Flush();
+}
+
+void AssertHandler::Flush() {
+	Drain();
+	fflush(stderr);
+}
+
 bool AssertHandler::HandleAssert(const AssertInfo& info) {
+	return Report(info, 1, AssertArgs());
+}
+
+bool AssertHandler::Report(const AssertInfo& info, uint32_t hits, const AssertArgs& args) {
 	// If a custom callback is registered, use it.
 	if (m_Callback) {
 		m_Callback(info);
-		// We will still use the default behavior for deciding whether to break
-		return DefaultHandler(info);
 	}
 
-	// Default handling behavior
-	return DefaultHandler(info);
+	// Reports that don't break are only queued, which never blocks
+	const bool shouldBreak = ShouldBreak(info.level);
+	if (!shouldBreak && m_Running.load(std::memory_order_acquire)) {
+		if (!PushRecord(info, hits, args)) {
+			g_Dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+		return false;
+	}
+
+	// Anything queued goes first so the log stays in order
+	Flush();
+	DefaultHandler(info, hits, args);
+	return shouldBreak;
 }
 
-bool AssertHandler::DefaultHandler(const AssertInfo& info) {
-	// Format and display the message
-	std::string formattedMessage = FormatAssertMessage(info);
+void AssertHandler::DefaultHandler(const AssertInfo& info, uint32_t hits, const AssertArgs& args) {
+	char buffer[EDGE_ASSERT_REPORT_SIZE];
+	FormatAssertMessage(buffer, sizeof(buffer), info, hits, args);
+	Write(info.level, buffer);
+}
 
-	// Output to standard error
-	std::cerr << formattedMessage << std::endl;
+void AssertHandler::Write(AssertLevel level, const char* text) {
+	// Writers only take turns once there is a log thread to take turns with
+	std::unique_lock<std::recursive_mutex> lock;
+	if (AsyncLog* log = m_Async.load(std::memory_order_acquire)) {
+		lock = std::unique_lock<std::recursive_mutex>(log->drainLock);
+	}
+
+	fprintf(stderr, "%s\n", text);
 
 	// Output to debug console on Windows
 #if EDGE_PLATFORM_WINDOWS && EDGE_DEBUG
-	OutputDebugStringA(formattedMessage.c_str());
+	OutputDebugStringA(text);
 	OutputDebugStringA("\n");
 #endif
 
-	// Determine if we should break based on level and build type
-	switch (info.level) {
-	case AssertLevel::Fatal:
-		return true; // Always break
+	for (size_t i = 0; i < m_SinkCount; ++i) {
+		m_Sinks[i](level, text);
+	}
+}
 
-	case AssertLevel::Error:
-		return EDGE_DEBUG; // Break in debug builds
+void AssertHandler::Drain() {
+	AsyncLog* log = m_Async.load(std::memory_order_acquire);
+	if (!log) {
+		return;
+	}
 
-	case AssertLevel::Warning:
-	case AssertLevel::Info:
-	default:
-		return false; // Don't break
+	std::lock_guard<std::recursive_mutex> lock(log->drainLock);
+	const AssertInfo* info = nullptr;
+	uint32_t hits = 0;
+	AssertArgs args;
+	char strings[EDGE_ASSERT_STRING_SIZE];
+	while (PopRecord(log->head, info, hits, args, strings)) {
+		DefaultHandler(*info, hits, args);
+	}
+
+	if (const uint32_t dropped = g_Dropped.exchange(0, std::memory_order_relaxed)) {
+		char buffer[96];
+		snprintf(buffer, sizeof(buffer), "[WARNING] Assert log was full, %u reports were dropped", dropped);
+		Write(AssertLevel::Warning, buffer);
 	}
 }
 
-std::string FormatMessage(const AssertInfo& info) {
-	std::stringstream ss;
+void AssertHandler::LogMain() {
+	AsyncLog& log = *m_Async.load(std::memory_order_acquire);
+	std::unique_lock<std::mutex> lock(log.wakeLock);
+	while (!log.stop) {
+		lock.unlock();
+		Flush();
+		lock.lock();
+		log.wake.wait_for(lock, kDrainInterval, [&log]() { return log.stop; });
+	}
+	lock.unlock();
+	Flush();
+}
 
-	// Add assertion level indicator
-	switch (info.level) {
-	case AssertLevel::Fatal:
-		ss << "[FATAL] ";
-		break;
-	case AssertLevel::Error:
-		ss << "[ERROR] ";
-		break;
-	case AssertLevel::Warning:
-		ss << "[WARNING] ";
-		break;
-	case AssertLevel::Info:
-		ss << "[INFO] ";
-		break;
+size_t FormatAssertMessage(char* buffer, size_t size, const AssertInfo& info, uint32_t hits, const AssertArgs& args) {
+	if (size == 0) {
+		return 0;
 	}
 
-	// Add base assertion information
-	ss << "Assertion Failed: " << info.condition;
+	MessageWriter writer = { buffer, size, 0 };
+	buffer[0] = '\0';
+
+	// Add assertion level indicator and base assertion information
+	writer.Append(GetLevelPrefix(info.level));
+	writer.Append("Assertion Failed: ");
+	writer.Append(info.condition);
 
 	// Add custom message
 	if (info.message && info.message[0] != '\0') {
-		ss << " (" << info.message << ")";
+		writer.Append(" (");
+		if (args.count) {
+			FormatArgs(writer, info.message, args);
+		}
+		else {
+			writer.Append(info.message);
+		}
+		writer.Append(")");
 	}
 
 	// Add file and line information
-	ss << "\n  at " << info.file << ":" << info.line;
+	writer.Print("\n  at %s:%d", info.file, info.line);
+
+	if (hits > 1) {
+		writer.Print(" (hit %u times)", hits);
+	}
+	return writer.length;
+}
 
-	return ss.str();
+std::string FormatAssertMessage(const AssertInfo& info) {
+	char buffer[EDGE_ASSERT_REPORT_SIZE];
+	const size_t length = FormatAssertMessage(buffer, sizeof(buffer), info);
+	return std::string(buffer, length);
 }
 
 void DebugBreak() {
@@ -121,4 +509,4 @@ void DebugBreak() {
 }
 
 END_NS_ASSERT
-END_NS_EDGE
\ No newline at end of file
+END_NS_EDGE
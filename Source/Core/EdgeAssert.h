@@ -12,14 +12,19 @@
  * - Support for different assertion levels and types
  * - Ability to capture file, line, and message information
  * - Configurable assertion handlers for custom behavior
+ * - Asynchronous output with per-site rate limiting, so repeated warnings stay cheap
  */
 
 #ifndef INC_EDGE_CORE_ASSERT_
 #define INC_EDGE_CORE_ASSERT_
 
 #include "EdgeCore.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <functional>
+#include <type_traits>
 
 BEGIN_NS_EDGE
 BEGIN_NS_ASSERT
@@ -27,8 +32,29 @@ BEGIN_NS_ASSERT
 // Forward declarations
 enum class AssertLevel;
 struct AssertInfo;
+struct AssertArg;
+struct AssertArgs;
+struct AssertSite;
 class AssertHandler;
 
+// Hits of one assertion site reported in full, after that only every power of two is
+constexpr uint32_t EDGE_ASSERT_REPEAT_LIMIT = 8;
+
+// Most arguments an assertion message can take
+constexpr size_t EDGE_ASSERT_MAX_ARGS = 4;
+
+// Reports the async log holds before it drops new ones, a power of two
+constexpr size_t EDGE_ASSERT_QUEUE_CAPACITY = 1024;
+
+// Longest formatted report, longer ones are cut off
+constexpr size_t EDGE_ASSERT_REPORT_SIZE = 1024;
+
+// Bytes a queued report keeps for the text of its string arguments, longer ones are cut off
+constexpr size_t EDGE_ASSERT_STRING_SIZE = 128;
+
+// Most sinks that can be added
+constexpr size_t EDGE_ASSERT_MAX_SINKS = 4;
+
 enum class AssertLevel {
 	Info,		// Info, doesn't break or do anything
 	Warning,	// Warning, continues execution
@@ -45,34 +71,158 @@ struct AssertInfo {
 	AssertLevel level;				// Severity level of the assertion
 };
 
+// Argument of an assertion message, captured by value and formatted when the report is written
+// A queued report copies its strings, up to EDGE_ASSERT_STRING_SIZE bytes between them.
+struct AssertArg {
+	enum class Type : uint8_t {
+		Int,
+		UInt,
+		Float,
+		Pointer,
+		String
+	};
+
+	Type type;
+	union {
+		int64_t i;
+		uint64_t u;
+		double f;
+		const void* p;
+		const char* s;
+	};
+
+	constexpr AssertArg() : type(Type::Int), i(0) {}
+
+	template<typename T>
+	AssertArg(T value) {
+		if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value) {
+			type = Type::String;
+			s = value;
+		}
+		else if constexpr (std::is_pointer<T>::value || std::is_null_pointer<T>::value) {
+			type = Type::Pointer;
+			p = value;
+		}
+		else if constexpr (std::is_floating_point<T>::value) {
+			type = Type::Float;
+			f = static_cast<double>(value);
+		}
+		else if constexpr (std::is_signed<T>::value || std::is_enum<T>::value) {
+			type = Type::Int;
+			i = static_cast<int64_t>(value);
+		}
+		else {
+			static_assert(std::is_integral<T>::value, "Unsupported assertion argument type");
+			type = Type::UInt;
+			u = static_cast<uint64_t>(value);
+		}
+	}
+};
+
+// Arguments of one assertion, the message is their printf format when there are any
+struct AssertArgs {
+	AssertArg values[EDGE_ASSERT_MAX_ARGS];
+	uint32_t count;
+
+	constexpr AssertArgs() : values(), count(0) {}
+
+	template<typename... Args>
+	AssertArgs(const Args&... args) : values{ AssertArg(args)... }, count(static_cast<uint32_t>(sizeof...(Args))) {
+		static_assert(sizeof...(Args) <= EDGE_ASSERT_MAX_ARGS, "Too many assertion arguments");
+	}
+};
+
+// State of one assertion site, every macro expansion has its own
+struct AssertSite {
+	std::atomic<uint32_t> hits;
+
+	constexpr AssertSite() : hits(0) {}
+};
+
 // Function type for custom assert handlers
 using AssertCallbackFn = std::function<void(const AssertInfo&)>;
 
+// Function type for log sinks, text is one formatted report without a trailing newline
+using AssertSinkFn = std::function<void(AssertLevel level, const char* text)>;
+
 // Assert handler class - allows for custom assertion behavior
+// Reports that don't break go to stderr, the debug console and the sinks. After StartAsync they
+// are queued as binary records without formatting or locking and a log thread writes them out,
+// when the queue is full they are dropped and counted. Reports that break first write out the
+// queue and then themselves on the calling thread, so the log is complete when the debugger
+// stops. Past EDGE_ASSERT_REPEAT_LIMIT hits a site that doesn't break only reports on every
+// power of two, with the hit count, and any other hit costs a load and a store.
 class AssertHandler {
 public:
 	static AssertHandler& Get();
 
-	// Register a custom handler
+	// Register a custom handler, it is called on the asserting thread for every report
 	void SetCallback(AssertCallbackFn callback);
 
 	// Reset to default handler
 	void ResetCallback();
 
-	// Handle an assertion
+	// Add an output, during startup as the sinks are read without a lock
+	// Sinks are called by one thread at a time while the log runs async.
+	bool AddSink(AssertSinkFn sink);
+	void ResetSinks();
+
+	// Move output to the log thread until StopAsync, both from the same thread
+	void StartAsync();
+	// Write out the queue and stop the log thread
+	void StopAsync();
+	// Write out everything queued so far from the calling thread
+	void Flush();
+
+	// Handle an assertion from the macros, returns true to break
+	bool HandleAssert(const AssertInfo& info, AssertSite& site, const AssertArgs& args) {
+		// Not a locked add, threads hitting the site at once can lose a count or repeat a report
+		const uint32_t hits = site.hits.load(std::memory_order_relaxed) + 1;
+		site.hits.store(hits, std::memory_order_relaxed);
+		if (!ShouldBreak(info.level) && hits > EDGE_ASSERT_REPEAT_LIMIT && (hits & (hits - 1)) != 0) {
+			return false;
+		}
+		return Report(info, hits, args);
+	}
+
+	// Handle an assertion without site state, never rate limited
 	bool HandleAssert(const AssertInfo& info);
 
+	AssertHandler(const AssertHandler&) = delete;
+	AssertHandler& operator=(const AssertHandler&) = delete;
+
 private:
-	AssertHandler() = default;
+	struct AsyncLog;
+
+	AssertHandler();
+	~AssertHandler();
+
 	AssertCallbackFn m_Callback;
+	AssertSinkFn m_Sinks[EDGE_ASSERT_MAX_SINKS];
+	size_t m_SinkCount;
+	std::atomic<AsyncLog*> m_Async;			// created by the first StartAsync, kept until exit
+	std::atomic<bool> m_Running;
 
-	// Default handler behavior
-	bool DefaultHandler(const AssertInfo& info);
+	static constexpr bool ShouldBreak(AssertLevel level) {
+		return level == AssertLevel::Fatal || (level == AssertLevel::Error && EDGE_DEBUG);
+	}
+
+	bool Report(const AssertInfo& info, uint32_t hits, const AssertArgs& args);
+
+	// Default handler behavior, writes the report to every output
+	void DefaultHandler(const AssertInfo& info, uint32_t hits, const AssertArgs& args);
+	void Write(AssertLevel level, const char* text);
+	void Drain();
+	void LogMain();
 };
 
 // Format an assertion message
 std::string FormatAssertMessage(const AssertInfo& info);
 
+// Format a report into buffer without allocating, returns its length
+// Hits above one are appended, the message is formatted with args when there are any.
+size_t FormatAssertMessage(char* buffer, size_t size, const AssertInfo& info, uint32_t hits = 1, const AssertArgs& args = AssertArgs());
+
 // Break into the debugger if available
 void DebugBreak();
 
@@ -84,17 +234,20 @@ END_NS_EDGE
 //==================================================================================================
 
 // Core assert implementation - do not use directly, use the macros below
+// The info is built at compile time and outlives the report, the queue only keeps a pointer to it.
+// Arguments after the message are its printf arguments, at most EDGE_ASSERT_MAX_ARGS.
 #define EDGE_ASSERT_IMPL(condition, level, message, ...) \
 	do { \
 		if (!(condition)) { \
-			edge::assert::AssertInfo info { \
+			static const edge::assert::AssertInfo edgeAssertInfo { \
 				#condition, \
 				message, \
 				__FILE__, \
 				__LINE__, \
 				level \
 			}; \
-			if (edge::assert::AssertHandler::Get().HandleAssert(info)) { \
+			static edge::assert::AssertSite edgeAssertSite; \
+			if (edge::assert::AssertHandler::Get().HandleAssert(edgeAssertInfo, edgeAssertSite, edge::assert::AssertArgs{ __VA_ARGS__ })) { \
 				edge::assert::DebugBreak(); \
 			} \
 		} \
@@ -122,6 +275,6 @@ END_NS_EDGE
 
 // Message - always displays a message but never breaks
 #define EDGE_ASSERT_MESSAGE(message, ...) \
-	EDGE_ASSERT_IMPL(true, edge::assert::AssertLevel::Info, message, ##__VA_ARGS__)
+	EDGE_ASSERT_IMPL(false, edge::assert::AssertLevel::Info, message, ##__VA_ARGS__)
 
 #endif // INC_EDGE_CORE_ASSERT_
\ No newline at end of file
@@ -0,0 +1,414 @@
+/*
+ * EdgeBVH.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Bounding volume hierarchy for spatial queries.
+ *
+ */
+
+#include "EdgeBVH.h"
+#include "EdgeProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cstring>
+
+BEGIN_NS_EDGE
+BEGIN_NS_GEOMETRY
+
+using namespace math;
+
+namespace {
+
+constexpr uint32_t kMaxBins = 32;
+
+// Below this depth splits are binned SAH. Past it they are median splits by count, which at least
+// halve every node, so no tree gets deeper than EDGE_BVH_MAX_DEPTH for 32-bit primitive counts.
+constexpr uint32_t kMedianDepth = EDGE_BVH_MAX_DEPTH - 32;
+
+// Run of the primitive list with the bounds of its primitives and of their centroids
+struct BuildRange {
+	uint32_t begin;
+	uint32_t end;
+	Vec4 boundsMin;
+	Vec4 boundsMax;
+	Vec4 centroidMin;
+	Vec4 centroidMax;
+
+	uint32_t GetCount() const { return end - begin; }
+};
+
+// Half the surface area, all SAH costs need
+inline float HalfArea(Vec4 min, Vec4 max) {
+	const Vec4 extent = Max(max - min, VectorZero());
+	return GetX(Dot3(extent, PermuteYZXW(extent)));
+}
+
+inline float GetComponent(Vec4 value, int axis) {
+	alignas(16) float values[4];
+	VectorStore(values, value);
+	return values[axis];
+}
+
+inline Vec4 LoadMin(const Aabb& box) { return VectorSet(box.min[0], box.min[1], box.min[2], 0.0f); }
+inline Vec4 LoadMax(const Aabb& box) { return VectorSet(box.max[0], box.max[1], box.max[2], 0.0f); }
+
+} // namespace
+
+// Shared by every node of one build, nodes are claimed from the arena with nodeCount
+struct Bvh::BuildContext {
+	const Aabb* bounds;
+	const float* centroids;			// four floats per primitive
+	uint32_t* primitives;
+	uint32_t maxLeafSize;
+	uint32_t binCount;
+	size_t parallelThreshold;
+	jobs::JobSystem* jobs;
+	jobs::JobCounter counter;
+	std::atomic<uint32_t> nodeCount;
+
+	Vec4 GetCentroid(uint32_t primitive) const { return VectorLoad(centroids + primitive * 4); }
+
+	BuildRange MakeRange(uint32_t begin, uint32_t end) const {
+		BuildRange range;
+		range.begin = begin;
+		range.end = end;
+		range.boundsMin = VectorSplat(FLT_MAX);
+		range.boundsMax = VectorSplat(-FLT_MAX);
+		range.centroidMin = VectorSplat(FLT_MAX);
+		range.centroidMax = VectorSplat(-FLT_MAX);
+
+		for (uint32_t i = begin; i < end; ++i) {
+			const uint32_t primitive = primitives[i];
+			const Vec4 centroid = GetCentroid(primitive);
+			range.boundsMin = Min(range.boundsMin, LoadMin(bounds[primitive]));
+			range.boundsMax = Max(range.boundsMax, LoadMax(bounds[primitive]));
+			range.centroidMin = Min(range.centroidMin, centroid);
+			range.centroidMax = Max(range.centroidMax, centroid);
+		}
+		return range;
+	}
+
+	// Split point of the range, always strictly inside it
+	uint32_t Split(const BuildRange& range, bool median) const {
+		uint32_t* first = primitives + range.begin;
+		uint32_t* last = primitives + range.end;
+
+		if (!median) {
+			int bestAxis = -1;
+			uint32_t bestBin = 0;
+			float bestCost = FLT_MAX;
+
+			for (int axis = 0; axis < 3; ++axis) {
+				const float low = GetComponent(range.centroidMin, axis);
+				const float extent = GetComponent(range.centroidMax, axis) - low;
+				if (!(extent > 0.0f)) {
+					continue;
+				}
+
+				uint32_t counts[kMaxBins] = {};
+				Vec4 binMin[kMaxBins];
+				Vec4 binMax[kMaxBins];
+				for (uint32_t bin = 0; bin < binCount; ++bin) {
+					binMin[bin] = VectorSplat(FLT_MAX);
+					binMax[bin] = VectorSplat(-FLT_MAX);
+				}
+
+				const float scale = static_cast<float>(binCount) / extent;
+				for (const uint32_t* it = first; it != last; ++it) {
+					const uint32_t bin = GetBin(*it, axis, low, scale);
+					++counts[bin];
+					binMin[bin] = Min(binMin[bin], LoadMin(bounds[*it]));
+					binMax[bin] = Max(binMax[bin], LoadMax(bounds[*it]));
+				}
+
+				// Right side areas from the top, then sweep the left side up against them
+				float rightArea[kMaxBins];
+				uint32_t rightCount[kMaxBins];
+				Vec4 sweepMin = VectorSplat(FLT_MAX);
+				Vec4 sweepMax = VectorSplat(-FLT_MAX);
+				uint32_t sweepCount = 0;
+				for (uint32_t bin = binCount - 1; bin > 0; --bin) {
+					sweepMin = Min(sweepMin, binMin[bin]);
+					sweepMax = Max(sweepMax, binMax[bin]);
+					sweepCount += counts[bin];
+					rightArea[bin] = HalfArea(sweepMin, sweepMax);
+					rightCount[bin] = sweepCount;
+				}
+
+				sweepMin = VectorSplat(FLT_MAX);
+				sweepMax = VectorSplat(-FLT_MAX);
+				sweepCount = 0;
+				for (uint32_t bin = 0; bin + 1 < binCount; ++bin) {
+					sweepMin = Min(sweepMin, binMin[bin]);
+					sweepMax = Max(sweepMax, binMax[bin]);
+					sweepCount += counts[bin];
+					if (sweepCount == 0 || rightCount[bin + 1] == 0) {
+						continue;
+					}
+
+					const float cost = HalfArea(sweepMin, sweepMax) * static_cast<float>(sweepCount)
+						+ rightArea[bin + 1] * static_cast<float>(rightCount[bin + 1]);
+					if (cost < bestCost) {
+						bestAxis = axis;
+						bestBin = bin;
+						bestCost = cost;
+					}
+				}
+			}
+
+			if (bestAxis >= 0) {
+				const float low = GetComponent(range.centroidMin, bestAxis);
+				const float scale = static_cast<float>(binCount) / (GetComponent(range.centroidMax, bestAxis) - low);
+				uint32_t* middle = std::partition(first, last, [this, bestAxis, bestBin, low, scale](uint32_t primitive) {
+					return GetBin(primitive, bestAxis, low, scale) <= bestBin;
+				});
+				if (middle != first && middle != last) {
+					return static_cast<uint32_t>(middle - primitives);
+				}
+			}
+		}
+
+		// Median by centroid along the widest axis, also when every centroid falls in one bin
+		const Vec4 extent = range.centroidMax - range.centroidMin;
+		int axis = GetY(extent) > GetX(extent) ? 1 : 0;
+		axis = GetZ(extent) > GetComponent(extent, axis) ? 2 : axis;
+
+		uint32_t* middle = first + range.GetCount() / 2;
+		std::nth_element(first, middle, last, [this, axis](uint32_t a, uint32_t b) {
+			return centroids[a * 4 + axis] < centroids[b * 4 + axis];
+		});
+		return static_cast<uint32_t>(middle - primitives);
+	}
+
+	uint32_t GetBin(uint32_t primitive, int axis, float low, float scale) const {
+		const float position = (centroids[primitive * 4 + axis] - low) * scale;
+		const uint32_t bin = position > 0.0f ? static_cast<uint32_t>(position) : 0;
+		return bin < binCount ? bin : binCount - 1;
+	}
+};
+
+//==================================================================================================
+// Triangles
+//==================================================================================================
+
+void ComputeTriangleBounds(const Mesh& mesh, Aabb* bounds) {
+	const size_t triangleCount = mesh.indexCount / 3;
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+		Aabb& box = bounds[triangle];
+		for (int axis = 0; axis < 3; ++axis) {
+			box.min[axis] = FLT_MAX;
+			box.max[axis] = -FLT_MAX;
+		}
+
+		for (size_t corner = 0; corner < 3; ++corner) {
+			float position[3];
+			memcpy(position, mesh.vertices + mesh.indices[triangle * 3 + corner] * mesh.vertexStride + mesh.positionOffset, sizeof(position));
+			for (int axis = 0; axis < 3; ++axis) {
+				box.min[axis] = std::min(box.min[axis], position[axis]);
+				box.max[axis] = std::max(box.max[axis], position[axis]);
+			}
+		}
+	}
+}
+
+bool IntersectRayTriangle(const Ray& ray, Vec4 a, Vec4 b, Vec4 c, float& distance) {
+	const Vec4 origin = VectorSet(ray.origin[0], ray.origin[1], ray.origin[2], 0.0f);
+	const Vec4 direction = VectorSet(ray.direction[0], ray.direction[1], ray.direction[2], 0.0f);
+	const Vec4 edge1 = b - a;
+	const Vec4 edge2 = c - a;
+
+	const Vec4 p = Cross3(direction, edge2);
+	const float determinant = GetX(Dot3(edge1, p));
+	if (std::fabs(determinant) < 1e-12f) {
+		return false;
+	}
+
+	const float inverse = 1.0f / determinant;
+	const Vec4 s = origin - a;
+	const float u = GetX(Dot3(s, p)) * inverse;
+	if (u < 0.0f || u > 1.0f) {
+		return false;
+	}
+
+	const Vec4 q = Cross3(s, edge1);
+	const float v = GetX(Dot3(direction, q)) * inverse;
+	if (v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+
+	const float t = GetX(Dot3(edge2, q)) * inverse;
+	if (t < 0.0f || t >= distance) {
+		return false;
+	}
+
+	distance = t;
+	return true;
+}
+
+//==================================================================================================
+// Bvh
+//==================================================================================================
+
+Bvh::Bvh()
+	: m_Primitives(nullptr), m_Nodes(nullptr), m_PrimitiveCount(0), m_NodeCount(0)
+	, m_Tag(memory::MemoryTag::NoTag), m_TaggedBytes(0) {
+}
+
+Bvh::~Bvh() {
+	Clear();
+}
+
+void Bvh::Clear() {
+	if (m_TaggedBytes != 0) {
+		memory::ReleaseTaggedUse(m_Tag, m_TaggedBytes);
+		m_TaggedBytes = 0;
+	}
+	m_Range.Release();
+	m_Primitives = nullptr;
+	m_Nodes = nullptr;
+	m_PrimitiveCount = 0;
+	m_NodeCount = 0;
+}
+
+// The arena holds the primitive list, room for one node per primitive, which is more than any
+// tree of nodes with two or more children needs, and the centroids. It is committed whole for
+// the build since workers claim nodes concurrently, then everything past the last node goes back.
+bool Bvh::Build(const Aabb* bounds, size_t count, jobs::JobSystem* jobs, const BvhSettings& settings, memory::MemoryTag tag) {
+	EDGE_PROFILE_SCOPE("Build BVH");
+	Clear();
+	if (count == 0) {
+		return true;
+	}
+	if (count >= BvhNode::EMPTY) {
+		EDGE_ASSERT(false, "Too many primitives for a BVH");
+		return false;
+	}
+
+	const size_t primitiveBytes = memory::AlignUp(count * sizeof(uint32_t), memory::EDGE_CACHE_LINE_SIZE);
+	const size_t nodeBytes = count * sizeof(BvhNode);
+	const size_t centroidBytes = count * 4 * sizeof(float);
+	if (!m_Range.Reserve(primitiveBytes + nodeBytes + centroidBytes) || !m_Range.Commit(primitiveBytes + nodeBytes + centroidBytes)) {
+		EDGE_ASSERT(false, "Failed to commit BVH arena");
+		m_Range.Release();
+		return false;
+	}
+
+	uint8_t* base = m_Range.GetBase();
+	m_Primitives = reinterpret_cast<uint32_t*>(base);
+	m_Nodes = reinterpret_cast<BvhNode*>(base + primitiveBytes);
+	float* centroids = reinterpret_cast<float*>(base + primitiveBytes + nodeBytes);
+	m_PrimitiveCount = count;
+
+	for (size_t i = 0; i < count; ++i) {
+		m_Primitives[i] = static_cast<uint32_t>(i);
+		VectorStore(centroids + i * 4, (LoadMin(bounds[i]) + LoadMax(bounds[i])) * 0.5f);
+	}
+
+	BuildContext context;
+	context.bounds = bounds;
+	context.centroids = centroids;
+	context.primitives = m_Primitives;
+	context.maxLeafSize = settings.maxLeafSize ? settings.maxLeafSize : 1;
+	context.binCount = std::min(std::max(settings.binCount, 2u), kMaxBins);
+	context.parallelThreshold = settings.parallelThreshold;
+	context.jobs = jobs;
+	context.nodeCount.store(1, std::memory_order_relaxed);
+
+	BuildNode(context, 0, 0, static_cast<uint32_t>(count), 0);
+	if (jobs != nullptr) {
+		jobs->Wait(context.counter);
+	}
+
+	m_NodeCount = context.nodeCount.load(std::memory_order_relaxed);
+	const size_t usedBytes = primitiveBytes + m_NodeCount * sizeof(BvhNode);
+	m_Range.Decommit(usedBytes);
+
+	m_Tag = tag;
+	m_TaggedBytes = usedBytes;
+	memory::RecordTaggedUse(m_Tag, m_TaggedBytes);
+	return true;
+}
+
+// Opens up to four children by splitting the largest one again and again, then ranges small
+// enough become leaves and the rest become nodes of their own, big ones in jobs
+void Bvh::BuildNode(BuildContext& context, uint32_t nodeIndex, uint32_t begin, uint32_t end, uint32_t depth) {
+	const bool median = depth >= kMedianDepth;
+	BuildRange children[EDGE_BVH_WIDTH];
+	uint32_t childCount = 1;
+	children[0] = context.MakeRange(begin, end);
+
+	while (childCount < EDGE_BVH_WIDTH) {
+		int largest = -1;
+		float largestSize = -1.0f;
+		for (uint32_t i = 0; i < childCount; ++i) {
+			if (children[i].GetCount() <= context.maxLeafSize) {
+				continue;
+			}
+
+			// Median splits go by count to keep the depth bound
+			const float size = median ? static_cast<float>(children[i].GetCount()) : HalfArea(children[i].boundsMin, children[i].boundsMax);
+			if (size > largestSize) {
+				largest = static_cast<int>(i);
+				largestSize = size;
+			}
+		}
+		if (largest < 0) {
+			break;
+		}
+
+		const BuildRange range = children[largest];
+		const uint32_t middle = context.Split(range, median);
+		children[largest] = context.MakeRange(range.begin, middle);
+		children[childCount++] = context.MakeRange(middle, range.end);
+	}
+
+	BvhNode& node = m_Nodes[nodeIndex];
+	for (uint32_t i = 0; i < EDGE_BVH_WIDTH; ++i) {
+		if (i >= childCount) {
+			node.minX[i] = node.minY[i] = node.minZ[i] = 0.0f;
+			node.maxX[i] = node.maxY[i] = node.maxZ[i] = 0.0f;
+			node.child[i] = BvhNode::EMPTY;
+			node.count[i] = 0;
+			continue;
+		}
+
+		const BuildRange& child = children[i];
+		alignas(16) float low[4], high[4];
+		VectorStore(low, child.boundsMin);
+		VectorStore(high, child.boundsMax);
+		node.minX[i] = low[0];
+		node.minY[i] = low[1];
+		node.minZ[i] = low[2];
+		node.maxX[i] = high[0];
+		node.maxY[i] = high[1];
+		node.maxZ[i] = high[2];
+
+		if (child.GetCount() <= context.maxLeafSize) {
+			node.child[i] = child.begin;
+			node.count[i] = child.GetCount();
+			continue;
+		}
+
+		const uint32_t childIndex = context.nodeCount.fetch_add(1, std::memory_order_relaxed);
+		node.child[i] = childIndex;
+		node.count[i] = 0;
+
+		if (context.jobs != nullptr && child.GetCount() >= context.parallelThreshold) {
+			const uint32_t childBegin = child.begin;
+			const uint32_t childEnd = child.end;
+			context.jobs->Run([this, &context, childIndex, childBegin, childEnd, depth]() {
+				BuildNode(context, childIndex, childBegin, childEnd, depth + 1);
+			}, &context.counter);
+		}
+		else {
+			BuildNode(context, childIndex, child.begin, child.end, depth + 1);
+		}
+	}
+}
+
+END_NS_GEOMETRY
+END_NS_EDGE
@@ -0,0 +1,358 @@
+/*
+ * EdgeBVH.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Bounding volume hierarchy for spatial queries.
+ *
+ * Responsibilities:
+ * - Build a four-wide tree over primitive bounds with binned SAH, in parallel on the job system,
+ * - Keep the primitive list and every node in one virtual memory arena attributed to a tag,
+ * - Answer ray, box and frustum queries testing all four children of a node at once,
+ * - And run batches of queries across the job system.
+ */
+
+#ifndef INC_EDGE_CORE_BVH_
+#define INC_EDGE_CORE_BVH_
+
+#include "EdgeCore.h"
+#include "EdgeGeometryProcessing.h"
+#include "EdgeJobSystem.h"
+#include "EdgeMath.h"
+#include "EdgeMemory.h"
+
+BEGIN_NS_EDGE
+BEGIN_NS_GEOMETRY
+
+// Children per node, one per lane of math::Vec4
+constexpr uint32_t EDGE_BVH_WIDTH = 4;
+
+// Deepest node a build creates, bounds the traversal stacks
+constexpr uint32_t EDGE_BVH_MAX_DEPTH = 64;
+
+// RayHit::primitive of a ray that hit nothing
+constexpr uint32_t EDGE_BVH_NO_HIT = ~0u;
+
+struct Aabb {
+	float min[3];
+	float max[3];
+};
+
+// The direction needn't be unit length, distances are measured in multiples of it
+struct Ray {
+	float origin[3];
+	float direction[3];
+	float maxDistance;
+};
+
+struct RayHit {
+	uint32_t primitive;
+	float distance;
+};
+
+// Planes as (normal, distance) facing inward, p is inside when dot(normal, p) + distance >= 0
+// for all six
+struct Frustum {
+	math::Vec4 planes[6];
+};
+
+// Four children in structure-of-arrays form, two cache lines
+// An inner child has count 0 and child is its node. A leaf has count primitives starting at child
+// in the primitive list. Unused slots have child EMPTY.
+struct alignas(memory::EDGE_CACHE_LINE_SIZE) BvhNode {
+	static constexpr uint32_t EMPTY = ~0u;
+
+	float minX[EDGE_BVH_WIDTH];
+	float minY[EDGE_BVH_WIDTH];
+	float minZ[EDGE_BVH_WIDTH];
+	float maxX[EDGE_BVH_WIDTH];
+	float maxY[EDGE_BVH_WIDTH];
+	float maxZ[EDGE_BVH_WIDTH];
+	uint32_t child[EDGE_BVH_WIDTH];
+	uint32_t count[EDGE_BVH_WIDTH];
+};
+
+static_assert(sizeof(BvhNode) == 2 * memory::EDGE_CACHE_LINE_SIZE, "BvhNode should stay two cache lines");
+
+struct BvhSettings {
+	uint32_t maxLeafSize;		// primitives per leaf
+	uint32_t binCount;			// SAH bins per axis, 2 to 32
+	size_t parallelThreshold;	// primitives a subtree needs to get a job of its own
+
+	BvhSettings() : maxLeafSize(4), binCount(16), parallelThreshold(4096) {}
+};
+
+// Bounds of every triangle of a mesh, for building a tree over its triangles
+void ComputeTriangleBounds(const Mesh& mesh, Aabb* bounds);
+
+// Moller-Trumbore, lowers distance and returns true for a hit in front of the origin closer than it
+bool IntersectRayTriangle(const Ray& ray, math::Vec4 a, math::Vec4 b, math::Vec4 c, float& distance);
+
+// Four-wide BVH over primitive bounds
+// Queries visit every primitive of each leaf that passes, a superset of the primitives whose own
+// bounds pass, and the callbacks do the exact tests. A built tree is read only, so any number of
+// threads may query it at once.
+class Bvh {
+public:
+	Bvh();
+	~Bvh();
+
+	// Replace the tree with one over count primitive bounds. The build runs on jobs when given,
+	// the calling thread may be a worker or not. Returns false if the arena can't be committed.
+	bool Build(const Aabb* bounds, size_t count, jobs::JobSystem* jobs = nullptr, const BvhSettings& settings = BvhSettings(),
+		memory::MemoryTag tag = memory::MemoryTag::NoTag);
+	void Clear();
+
+	size_t GetNodeCount() const { return m_NodeCount; }
+	size_t GetPrimitiveCount() const { return m_PrimitiveCount; }
+	const BvhNode* GetNodes() const { return m_Nodes; }
+	// Bytes the arena has committed
+	size_t GetMemoryUsage() const { return m_Range.GetCommittedSize(); }
+
+	// Closest hit. intersect(primitive, ray, distance) tests one primitive and for a hit closer
+	// than distance lowers it and returns true.
+	template<typename F>
+	RayHit RayCast(const Ray& ray, const F& intersect) const {
+		return TraceRay<F, false>(ray, intersect);
+	}
+
+	// Any hit within ray.maxDistance, for line of sight
+	template<typename F>
+	bool RayOccluded(const Ray& ray, const F& intersect) const {
+		return TraceRay<F, true>(ray, intersect).primitive != EDGE_BVH_NO_HIT;
+	}
+
+	// visit(primitive) for the primitives of every leaf that overlaps the box
+	template<typename F>
+	void QueryAabb(const Aabb& box, const F& visit) const {
+		const math::Vec4 boxMin[3] = { math::VectorSplat(box.min[0]), math::VectorSplat(box.min[1]), math::VectorSplat(box.min[2]) };
+		const math::Vec4 boxMax[3] = { math::VectorSplat(box.max[0]), math::VectorSplat(box.max[1]), math::VectorSplat(box.max[2]) };
+		TraverseOverlap([&boxMin, &boxMax](const BvhNode& node) { return OverlapAabb(node, boxMin, boxMax); }, visit);
+	}
+
+	// visit(primitive) for the primitives of every leaf that isn't fully outside a plane
+	template<typename F>
+	void QueryFrustum(const Frustum& frustum, const F& visit) const {
+		TraverseOverlap([&frustum](const BvhNode& node) { return OverlapFrustum(node, frustum); }, visit);
+	}
+
+	// Batches, split across jobs when given. Callbacks run concurrently, the box and frustum
+	// visitors get the query index first.
+	template<typename F>
+	void RayCast(const Ray* rays, RayHit* hits, size_t count, const F& intersect, jobs::JobSystem* jobs = nullptr) const {
+		RunBatch(count, jobs, [this, rays, hits, &intersect](size_t i) { hits[i] = RayCast(rays[i], intersect); });
+	}
+
+	template<typename F>
+	void QueryAabb(const Aabb* boxes, size_t count, const F& visit, jobs::JobSystem* jobs = nullptr) const {
+		RunBatch(count, jobs, [this, boxes, &visit](size_t i) {
+			QueryAabb(boxes[i], [i, &visit](uint32_t primitive) { visit(i, primitive); });
+		});
+	}
+
+	template<typename F>
+	void QueryFrustum(const Frustum* frustums, size_t count, const F& visit, jobs::JobSystem* jobs = nullptr) const {
+		RunBatch(count, jobs, [this, frustums, &visit](size_t i) {
+			QueryFrustum(frustums[i], [i, &visit](uint32_t primitive) { visit(i, primitive); });
+		});
+	}
+
+	Bvh(const Bvh&) = delete;
+	Bvh& operator=(const Bvh&) = delete;
+
+private:
+	struct BuildContext;
+
+	// A node pops one entry and pushes at most four
+	static constexpr uint32_t STACK_SIZE = 3 * EDGE_BVH_MAX_DEPTH + 1;
+	// Queries per batch job
+	static constexpr size_t BATCH_SIZE = 64;
+
+	memory::VirtualRange m_Range;
+	uint32_t* m_Primitives;		// primitive indices, leaves point into it
+	BvhNode* m_Nodes;			// root first
+	size_t m_PrimitiveCount;
+	size_t m_NodeCount;
+	memory::MemoryTag m_Tag;
+	size_t m_TaggedBytes;
+
+	void BuildNode(BuildContext& context, uint32_t nodeIndex, uint32_t begin, uint32_t end, uint32_t depth);
+
+	// Bit i set for the used child slots
+	static uint32_t GetChildMask(const BvhNode& node) {
+		return uint32_t(node.child[0] != BvhNode::EMPTY) | (uint32_t(node.child[1] != BvhNode::EMPTY) << 1)
+			| (uint32_t(node.child[2] != BvhNode::EMPTY) << 2) | (uint32_t(node.child[3] != BvhNode::EMPTY) << 3);
+	}
+
+	static uint32_t OverlapAabb(const BvhNode& node, const math::Vec4* boxMin, const math::Vec4* boxMax) {
+		using namespace math;
+		Vec4 inside = And(CompareLessEqual(VectorLoad(node.minX), boxMax[0]), CompareLessEqual(boxMin[0], VectorLoad(node.maxX)));
+		inside = And(inside, And(CompareLessEqual(VectorLoad(node.minY), boxMax[1]), CompareLessEqual(boxMin[1], VectorLoad(node.maxY))));
+		inside = And(inside, And(CompareLessEqual(VectorLoad(node.minZ), boxMax[2]), CompareLessEqual(boxMin[2], VectorLoad(node.maxZ))));
+		return MoveMask(inside);
+	}
+
+	// Rejects a child when its corner furthest along a plane's normal is still outside that plane
+	static uint32_t OverlapFrustum(const BvhNode& node, const Frustum& frustum) {
+		using namespace math;
+		const Vec4 minX = VectorLoad(node.minX), minY = VectorLoad(node.minY), minZ = VectorLoad(node.minZ);
+		const Vec4 maxX = VectorLoad(node.maxX), maxY = VectorLoad(node.maxY), maxZ = VectorLoad(node.maxZ);
+
+		Vec4 outside = VectorZero();
+		for (int i = 0; i < 6; ++i) {
+			const Vec4 plane = frustum.planes[i];
+			const Vec4 x = GetX(plane) >= 0.0f ? maxX : minX;
+			const Vec4 y = GetY(plane) >= 0.0f ? maxY : minY;
+			const Vec4 z = GetZ(plane) >= 0.0f ? maxZ : minZ;
+			const Vec4 distance = MultiplyAdd(SplatX(plane), x, MultiplyAdd(SplatY(plane), y, MultiplyAdd(SplatZ(plane), z, SplatW(plane))));
+			outside = Or(outside, CompareLess(distance, VectorZero()));
+		}
+		return MoveMask(outside) ^ 0xF;
+	}
+
+	// Slab test of the four children, near gets the entry distance of each
+	static uint32_t IntersectRay(const BvhNode& node, const math::Vec4* origin, const math::Vec4* inverse, float maxDistance, math::Vec4& near) {
+		using namespace math;
+		const Vec4 x0 = (VectorLoad(node.minX) - origin[0]) * inverse[0];
+		const Vec4 x1 = (VectorLoad(node.maxX) - origin[0]) * inverse[0];
+		const Vec4 y0 = (VectorLoad(node.minY) - origin[1]) * inverse[1];
+		const Vec4 y1 = (VectorLoad(node.maxY) - origin[1]) * inverse[1];
+		const Vec4 z0 = (VectorLoad(node.minZ) - origin[2]) * inverse[2];
+		const Vec4 z1 = (VectorLoad(node.maxZ) - origin[2]) * inverse[2];
+
+		near = Max(Max(Min(x0, x1), Min(y0, y1)), Max(Min(z0, z1), VectorZero()));
+		const Vec4 far = Min(Min(Max(x0, x1), Max(y0, y1)), Min(Max(z0, z1), VectorSplat(maxDistance)));
+		return MoveMask(CompareLessEqual(near, far));
+	}
+
+	template<typename F, bool AnyHit>
+	RayHit TraceRay(const Ray& ray, const F& intersect) const {
+		using namespace math;
+		RayHit hit = { EDGE_BVH_NO_HIT, ray.maxDistance };
+		if (m_NodeCount == 0) {
+			return hit;
+		}
+
+		// Zero direction components become tiny ones, so the slabs stay free of NaNs
+		Vec4 origin[3];
+		Vec4 inverse[3];
+		for (int axis = 0; axis < 3; ++axis) {
+			const float direction = ray.direction[axis];
+			const float safe = std::fabs(direction) > 1e-20f ? direction : std::copysign(1e-20f, direction);
+			origin[axis] = VectorSplat(ray.origin[axis]);
+			inverse[axis] = VectorSplat(1.0f / safe);
+		}
+
+		struct Entry {
+			uint32_t node;
+			float distance;
+		};
+		Entry stack[STACK_SIZE];
+		uint32_t top = 0;
+		stack[top++] = { 0, 0.0f };
+
+		while (top > 0) {
+			const Entry entry = stack[--top];
+			if (entry.distance > hit.distance) {
+				continue;
+			}
+
+			const BvhNode& node = m_Nodes[entry.node];
+			Vec4 near;
+			uint32_t mask = IntersectRay(node, origin, inverse, hit.distance, near) & GetChildMask(node);
+			alignas(16) float nearDistance[EDGE_BVH_WIDTH];
+			VectorStore(nearDistance, near);
+
+			// Leaves right away, inner children pushed far to near so the nearest pops first
+			Entry inner[EDGE_BVH_WIDTH];
+			uint32_t innerCount = 0;
+			for (; mask != 0; mask &= mask - 1) {
+				const uint32_t slot = LowestBit(mask);
+				if (node.count[slot] == 0) {
+					uint32_t i = innerCount++;
+					for (; i > 0 && inner[i - 1].distance < nearDistance[slot]; --i) {
+						inner[i] = inner[i - 1];
+					}
+					inner[i] = { node.child[slot], nearDistance[slot] };
+					continue;
+				}
+
+				const uint32_t* primitives = m_Primitives + node.child[slot];
+				for (uint32_t i = 0; i < node.count[slot]; ++i) {
+					if (intersect(primitives[i], ray, hit.distance)) {
+						hit.primitive = primitives[i];
+						if (AnyHit) {
+							return hit;
+						}
+					}
+				}
+			}
+
+			for (uint32_t i = 0; i < innerCount; ++i) {
+				stack[top++] = inner[i];
+			}
+		}
+		return hit;
+	}
+
+	template<typename Test, typename F>
+	void TraverseOverlap(const Test& test, const F& visit) const {
+		if (m_NodeCount == 0) {
+			return;
+		}
+
+		uint32_t stack[STACK_SIZE];
+		uint32_t top = 0;
+		stack[top++] = 0;
+
+		while (top > 0) {
+			const BvhNode& node = m_Nodes[stack[--top]];
+			for (uint32_t mask = test(node) & GetChildMask(node); mask != 0; mask &= mask - 1) {
+				const uint32_t slot = LowestBit(mask);
+				if (node.count[slot] == 0) {
+					stack[top++] = node.child[slot];
+					continue;
+				}
+
+				const uint32_t* primitives = m_Primitives + node.child[slot];
+				for (uint32_t i = 0; i < node.count[slot]; ++i) {
+					visit(primitives[i]);
+				}
+			}
+		}
+	}
+
+	template<typename F>
+	static void RunBatch(size_t count, jobs::JobSystem* jobs, const F& query) {
+		if (jobs == nullptr) {
+			for (size_t i = 0; i < count; ++i) {
+				query(i);
+			}
+			return;
+		}
+
+		jobs->ParallelFor(count, BATCH_SIZE, [&query](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i) {
+				query(i);
+			}
+		});
+	}
+
+	// Index of the lowest set bit, mask must be non-zero
+	static uint32_t LowestBit(uint32_t mask) {
+#if EDGE_COMPILER_MSVC
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+	}
+};
+
+END_NS_GEOMETRY
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_BVH_
@@ -0,0 +1,431 @@
+/*
+ * EdgeBlob.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Memory-mapped asset blobs used in place.
+ *
+ */
+
+#include "EdgeBlob.h"
+#include "EdgeProfiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if EDGE_PLATFORM_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+namespace {
+
+constexpr size_t kMinWriterCapacity = 64 * 1024;
+constexpr size_t kMinTableCapacity = 64;
+
+void* AllocateBytes(IAllocator* allocator, size_t size, size_t alignment) {
+	return allocator ? allocator->Allocate(size, alignment) : memory::Allocate(size, alignment);
+}
+
+void FreeBytes(IAllocator* allocator, void* ptr) {
+	if (ptr) {
+		if (allocator) {
+			allocator->Free(ptr);
+		} else {
+			memory::Free(ptr);
+		}
+	}
+}
+
+inline bool IsPowerOfTwo(size_t value) {
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+// count items of size bytes fit between offset and the end of a size byte blob
+inline bool FitsIn(uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t size) {
+	return offset <= size && (itemSize == 0 || count <= (size - offset) / itemSize);
+}
+
+// Map the whole of path copy-on-write, size receives the file size. The handles are closed right
+// away, the view keeps the file alive.
+void* MapFileCopyOnWrite(const char* path, size_t& size) {
+	size = 0;
+#if EDGE_PLATFORM_WINDOWS
+	HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(fileHandle);
+		return nullptr;
+	}
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	CloseHandle(fileHandle);
+	if (!mappingHandle) {
+		return nullptr;
+	}
+	void* view = MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mappingHandle);
+	if (!view) {
+		return nullptr;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return view;
+#else
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return nullptr;
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED) {
+		return nullptr;
+	}
+	size = static_cast<size_t>(info.st_size);
+	return view;
+#endif
+}
+
+void UnmapFile(void* view, size_t size) {
+#if EDGE_PLATFORM_WINDOWS
+	(void)size;
+	UnmapViewOfFile(view);
+#else
+	munmap(view, size);
+#endif
+}
+
+} // namespace
+
+//==================================================================================================
+// BlobWriter Implementation
+//==================================================================================================
+
+BlobWriter::BlobWriter(IAllocator* allocator)
+	: m_Allocator(allocator)
+	, m_Buffer(nullptr)
+	, m_Size(0)
+	, m_Capacity(0)
+	, m_Sections(nullptr)
+	, m_SectionCount(0)
+	, m_SectionCapacity(0)
+	, m_Fixups(nullptr)
+	, m_FixupCount(0)
+	, m_FixupCapacity(0)
+	, m_Failed(false)
+	, m_Finished(false) {
+	// The header goes first, which also keeps offset 0 free to mean failure
+	Allocate(sizeof(BlobHeader), alignof(BlobHeader));
+}
+
+BlobWriter::~BlobWriter() {
+	FreeBytes(m_Allocator, m_Buffer);
+	FreeBytes(m_Allocator, m_Sections);
+	FreeBytes(m_Allocator, m_Fixups);
+}
+
+bool BlobWriter::Reserve(size_t size) {
+	if (size <= m_Capacity) {
+		return true;
+	}
+
+	size_t capacity = m_Capacity ? m_Capacity : kMinWriterCapacity;
+	while (capacity < size) {
+		capacity *= 2;
+	}
+
+	uint8_t* buffer = static_cast<uint8_t*>(AllocateBytes(m_Allocator, capacity, EDGE_BLOB_MAX_ALIGNMENT));
+	EDGE_ASSERT(buffer != nullptr, "Failed to grow BlobWriter");
+	if (!buffer) {
+		m_Failed = true;
+		return false;
+	}
+
+	if (m_Buffer) {
+		memcpy(buffer, m_Buffer, m_Size);
+		FreeBytes(m_Allocator, m_Buffer);
+	}
+	m_Buffer = buffer;
+	m_Capacity = capacity;
+	return true;
+}
+
+template<typename T>
+bool BlobWriter::Append(T*& items, size_t& count, size_t& capacity, const T& item) {
+	if (count == capacity) {
+		const size_t grown = capacity ? capacity * 2 : kMinTableCapacity;
+		T* larger = static_cast<T*>(AllocateBytes(m_Allocator, grown * sizeof(T), alignof(T)));
+		EDGE_ASSERT(larger != nullptr, "Failed to grow BlobWriter tables");
+		if (!larger) {
+			m_Failed = true;
+			return false;
+		}
+		if (items) {
+			memcpy(larger, items, count * sizeof(T));
+			FreeBytes(m_Allocator, items);
+		}
+		items = larger;
+		capacity = grown;
+	}
+
+	items[count++] = item;
+	return true;
+}
+
+size_t BlobWriter::Allocate(size_t size, size_t alignment) {
+	EDGE_ASSERT(!m_Finished, "BlobWriter is already finished");
+	EDGE_ASSERT(IsPowerOfTwo(alignment) && alignment <= EDGE_BLOB_MAX_ALIGNMENT, "Blob alignment out of range");
+	if (m_Finished || m_Failed || !IsPowerOfTwo(alignment) || alignment > EDGE_BLOB_MAX_ALIGNMENT) {
+		return 0;
+	}
+
+	const size_t offset = AlignUp(m_Size, alignment);
+	if (!Reserve(offset + size)) {
+		return 0;
+	}
+
+	memset(m_Buffer + m_Size, 0, offset + size - m_Size);
+	m_Size = offset + size;
+	return offset;
+}
+
+size_t BlobWriter::Write(const void* data, size_t size, size_t alignment) {
+	const size_t offset = Allocate(size, alignment);
+	if (offset != 0 && size > 0) {
+		memcpy(m_Buffer + offset, data, size);
+	}
+	return offset;
+}
+
+void BlobWriter::SetRelative(size_t field, size_t target) {
+	EDGE_ASSERT(field + sizeof(int64_t) <= m_Size && target <= m_Size, "BlobPtr outside the blob");
+	if (m_Failed || field + sizeof(int64_t) > m_Size) {
+		return;
+	}
+
+	const int64_t offset = static_cast<int64_t>(target) - static_cast<int64_t>(field);
+	memcpy(m_Buffer + field, &offset, sizeof(offset));
+}
+
+void BlobWriter::SetPointer(size_t field, size_t target) {
+	EDGE_ASSERT(field + sizeof(void*) <= m_Size && target <= m_Size, "Pointer outside the blob");
+	EDGE_ASSERT(field % alignof(void*) == 0, "Pointer fields must be aligned");
+	if (m_Failed || field + sizeof(void*) > m_Size) {
+		return;
+	}
+
+	// The field holds the target offset until the load adds the base address
+	const uint64_t offset = target;
+	memcpy(m_Buffer + field, &offset, sizeof(offset));
+	Append(m_Fixups, m_FixupCount, m_FixupCapacity, static_cast<uint64_t>(field));
+}
+
+void BlobWriter::AddSection(uint32_t id, size_t offset, size_t count, size_t elementSize, size_t alignment) {
+	EDGE_ASSERT(IsPowerOfTwo(alignment) && alignment <= EDGE_BLOB_MAX_ALIGNMENT, "Blob alignment out of range");
+	EDGE_ASSERT(offset % alignment == 0 && offset + count * elementSize <= m_Size, "Section outside the blob");
+	if (m_Failed) {
+		return;
+	}
+
+	BlobSection section = {};
+	section.id = id;
+	section.elementSize = static_cast<uint32_t>(elementSize);
+	section.alignment = static_cast<uint32_t>(alignment);
+	section.offset = offset;
+	section.count = count;
+	Append(m_Sections, m_SectionCount, m_SectionCapacity, section);
+}
+
+bool BlobWriter::Finish() {
+	if (m_Finished || m_Failed) {
+		return m_Finished && !m_Failed;
+	}
+
+	// The loader wants each field once and in order, a field set twice keeps its last target
+	std::sort(m_Fixups, m_Fixups + m_FixupCount);
+	m_FixupCount = static_cast<size_t>(std::unique(m_Fixups, m_Fixups + m_FixupCount) - m_Fixups);
+
+	const size_t sectionOffset = Write(m_Sections, m_SectionCount * sizeof(BlobSection), alignof(BlobSection));
+	const size_t fixupOffset = Write(m_Fixups, m_FixupCount * sizeof(uint64_t), alignof(uint64_t));
+	if (m_Failed) {
+		return false;
+	}
+
+	BlobHeader* header = reinterpret_cast<BlobHeader*>(m_Buffer);
+	header->magic = BlobHeader::BLOB_MAGIC;
+	header->version = BlobHeader::BLOB_VERSION;
+	header->pointerSize = static_cast<uint16_t>(sizeof(void*));
+	header->size = m_Size;
+	header->sectionOffset = sectionOffset;
+	header->fixupOffset = fixupOffset;
+	header->sectionCount = static_cast<uint32_t>(m_SectionCount);
+	header->fixupCount = static_cast<uint32_t>(m_FixupCount);
+	m_Finished = true;
+	return true;
+}
+
+bool BlobWriter::Save(const char* path) {
+	if (!Finish()) {
+		return false;
+	}
+
+	FILE* file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+
+	const bool written = fwrite(m_Buffer, 1, m_Size, file) == m_Size;
+	return fclose(file) == 0 && written;
+}
+
+//==================================================================================================
+// MappedBlob Implementation
+//==================================================================================================
+
+MappedBlob::MappedBlob()
+	: m_Data(nullptr)
+	, m_Size(0)
+	, m_Sections(nullptr)
+	, m_SectionCount(0)
+	, m_Tag(MemoryTag::NoTag)
+	, m_Mapped(false) {
+}
+
+MappedBlob::~MappedBlob() {
+	Close();
+}
+
+bool MappedBlob::Open(const char* path, MemoryTag tag) {
+	EDGE_PROFILE_SCOPE("Open Blob");
+	EDGE_ASSERT(!IsOpen(), "MappedBlob is already open");
+	if (IsOpen()) {
+		return false;
+	}
+
+	size_t size = 0;
+	void* view = MapFileCopyOnWrite(path, size);
+	if (!view) {
+		return false;
+	}
+
+	if (!Attach(static_cast<uint8_t*>(view), size)) {
+		UnmapFile(view, size);
+		return false;
+	}
+
+	m_Mapped = true;
+	m_Tag = tag;
+	RecordTaggedUse(tag, size);
+	return true;
+}
+
+bool MappedBlob::Open(void* data, size_t size) {
+	EDGE_ASSERT(!IsOpen(), "MappedBlob is already open");
+	if (IsOpen() || !data) {
+		return false;
+	}
+	return Attach(static_cast<uint8_t*>(data), size);
+}
+
+void MappedBlob::Close() {
+	if (!m_Data) {
+		return;
+	}
+
+	if (m_Mapped) {
+		ReleaseTaggedUse(m_Tag, m_Size);
+		UnmapFile(m_Data, m_Size);
+	}
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Sections = nullptr;
+	m_SectionCount = 0;
+	m_Tag = MemoryTag::NoTag;
+	m_Mapped = false;
+}
+
+bool MappedBlob::Attach(uint8_t* data, size_t size) {
+	// Everything is checked before the first write, so a bad file is never half fixed up
+	if (size < sizeof(BlobHeader) || reinterpret_cast<uintptr_t>(data) % alignof(BlobHeader) != 0) {
+		return false;
+	}
+
+	const BlobHeader* header = reinterpret_cast<const BlobHeader*>(data);
+	if (header->magic != BlobHeader::BLOB_MAGIC || header->version != BlobHeader::BLOB_VERSION ||
+		header->pointerSize != sizeof(void*) || header->size != size) {
+		return false;
+	}
+
+	if (header->sectionOffset % alignof(BlobSection) != 0 || header->fixupOffset % alignof(uint64_t) != 0 ||
+		!FitsIn(header->sectionOffset, header->sectionCount, sizeof(BlobSection), size) ||
+		!FitsIn(header->fixupOffset, header->fixupCount, sizeof(uint64_t), size)) {
+		return false;
+	}
+
+	const BlobSection* sections = reinterpret_cast<const BlobSection*>(data + header->sectionOffset);
+	for (uint32_t i = 0; i < header->sectionCount; ++i) {
+		const BlobSection& section = sections[i];
+		if (!IsPowerOfTwo(section.alignment) || section.alignment > EDGE_BLOB_MAX_ALIGNMENT ||
+			(reinterpret_cast<uintptr_t>(data) + section.offset) % section.alignment != 0 ||
+			!FitsIn(section.offset, section.count, section.elementSize, size)) {
+			return false;
+		}
+	}
+
+	// Fields must be strictly increasing, a field listed twice would get the base added twice
+	const uintptr_t base = reinterpret_cast<uintptr_t>(data);
+	const uint64_t* fixups = reinterpret_cast<const uint64_t*>(data + header->fixupOffset);
+	for (uint32_t i = 0; i < header->fixupCount; ++i) {
+		const uint64_t field = fixups[i];
+		if ((i > 0 && field <= fixups[i - 1]) || field % alignof(void*) != 0 || field < sizeof(BlobHeader) ||
+			!FitsIn(field, 1, sizeof(void*), header->sectionOffset) || !FitsIn(field, 1, sizeof(void*), header->fixupOffset)) {
+			return false;
+		}
+
+		// The fixed up pointer has to land in [data, data + size]
+		const uint64_t value = *reinterpret_cast<const uint64_t*>(data + field);
+		if (value > size || base + static_cast<uintptr_t>(value) < base) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < header->fixupCount; ++i) {
+		uintptr_t* field = reinterpret_cast<uintptr_t*>(data + fixups[i]);
+		*field += reinterpret_cast<uintptr_t>(data);
+	}
+
+	m_Data = data;
+	m_Size = size;
+	m_Sections = sections;
+	m_SectionCount = header->sectionCount;
+	return true;
+}
+
+const BlobSection* MappedBlob::FindSection(uint32_t id) const {
+	for (uint32_t i = 0; i < m_SectionCount; ++i) {
+		if (m_Sections[i].id == id) {
+			return &m_Sections[i];
+		}
+	}
+	return nullptr;
+}
+
+END_NS_MEMORY
+END_NS_EDGE
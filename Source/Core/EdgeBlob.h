@@ -0,0 +1,220 @@
+/*
+ * EdgeBlob.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Memory-mapped asset blobs used in place.
+ *
+ * Responsibilities:
+ * - Lay out assets offline in a single file of aligned, named sections,
+ * - Load a blob with one copy-on-write mapping and a pass that fixes up raw pointers in place,
+ * - Link blob-native structs with self-relative offsets that need no fixup at all,
+ * - And charge the mapped bytes to a MemoryTag for as long as the blob is open.
+ */
+
+#ifndef INC_EDGE_CORE_BLOB_
+#define INC_EDGE_CORE_BLOB_
+
+#include "EdgeMemory.h"
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+// Largest section alignment, a mapping is only guaranteed page alignment
+constexpr size_t EDGE_BLOB_MAX_ALIGNMENT = 4096;
+
+// Stable id of a section name, FNV-1a so tools and the runtime agree on it
+constexpr uint32_t GetBlobSectionId(const char* name) {
+	uint32_t hash = 2166136261u;
+	for (; *name; ++name) {
+		hash = (hash ^ static_cast<uint8_t>(*name)) * 16777619u;
+	}
+	return hash;
+}
+
+// File layout: this header, the section data, then the section table and the fixup table
+struct BlobHeader {
+	uint32_t magic;				// BLOB_MAGIC
+	uint16_t version;			// BLOB_VERSION
+	uint16_t pointerSize;		// sizeof(void*) of the writer, fixed up fields are this wide
+	uint64_t size;				// of the whole file
+	uint64_t sectionOffset;
+	uint64_t fixupOffset;
+	uint32_t sectionCount;
+	uint32_t fixupCount;
+	uint8_t reserved[24];
+
+	static constexpr uint32_t BLOB_MAGIC = 0x42474445u;	// "EDGB"
+	static constexpr uint16_t BLOB_VERSION = 1;
+};
+
+static_assert(sizeof(BlobHeader) == 64, "BlobHeader is part of the file format");
+
+// A named array in the blob
+struct BlobSection {
+	uint32_t id;				// GetBlobSectionId of its name
+	uint32_t elementSize;
+	uint32_t alignment;
+	uint32_t reserved;
+	uint64_t offset;
+	uint64_t count;
+};
+
+static_assert(sizeof(BlobSection) == 32, "BlobSection is part of the file format");
+
+// Pointer stored as the distance from itself to its target, 0 is null
+// Valid wherever the bytes holding it and its target are moved together, so blob-native structs
+// read straight from the mapping. Copying a BlobPtr on its own breaks it.
+template<typename T>
+struct BlobPtr {
+	int64_t offset;
+
+	T* Get() const {
+		return offset ? reinterpret_cast<T*>(const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(this)) + offset) : nullptr;
+	}
+	T* operator->() const { return Get(); }
+	T& operator*() const { return *Get(); }
+	explicit operator bool() const { return offset != 0; }
+};
+
+// Self-relative array
+template<typename T>
+struct BlobArray {
+	BlobPtr<T> data;
+	uint64_t count;
+
+	T* begin() const { return data.Get(); }
+	T* end() const { return data.Get() + count; }
+	T& operator[](size_t index) const { return data.Get()[index]; }
+};
+
+// Typed view of a section, empty when the section is missing or doesn't hold Ts
+template<typename T>
+struct BlobView {
+	T* data;
+	size_t count;
+
+	T* begin() const { return data; }
+	T* end() const { return data + count; }
+	T& operator[](size_t index) const { return data[index]; }
+	explicit operator bool() const { return data != nullptr; }
+};
+
+// Builds a blob in memory
+// Everything is addressed by its offset from the start of the blob since the buffer moves as it
+// grows. Raw pointer fields of runtime structs get SetPointer and are fixed up on load, fields of
+// blob-native structs are BlobPtrs and get SetRelative. Allocation failures are sticky, Finish
+// and Save report them.
+class BlobWriter {
+public:
+	explicit BlobWriter(IAllocator* allocator = nullptr);
+	~BlobWriter();
+
+	// Zeroed bytes, returns their offset or 0 once the writer is out of memory
+	size_t Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
+	size_t Write(const void* data, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
+
+	template<typename T>
+	size_t WriteArray(const T* items, size_t count) {
+		return Write(items, count * sizeof(T), alignof(T));
+	}
+
+	// Valid until the next Allocate or Write
+	template<typename T>
+	T* GetPointer(size_t offset) {
+		return reinterpret_cast<T*>(m_Buffer + offset);
+	}
+
+	// Point the BlobPtr at field at target
+	void SetRelative(size_t field, size_t target);
+	// Point the raw pointer at field at target once the blob is loaded, the last call for a field wins
+	void SetPointer(size_t field, size_t target);
+
+	void AddSection(uint32_t id, size_t offset, size_t count, size_t elementSize, size_t alignment);
+
+	template<typename T>
+	void AddSection(uint32_t id, size_t offset, size_t count) {
+		AddSection(id, offset, count, sizeof(T), alignof(T));
+	}
+
+	// Append the tables and complete the header, nothing can be added afterwards
+	bool Finish();
+	bool Save(const char* path);
+
+	// After Finish
+	const uint8_t* GetData() const { return m_Buffer; }
+	size_t GetSize() const { return m_Size; }
+
+	BlobWriter(const BlobWriter&) = delete;
+	BlobWriter& operator=(const BlobWriter&) = delete;
+
+private:
+	IAllocator* m_Allocator;
+	uint8_t* m_Buffer;
+	size_t m_Size;
+	size_t m_Capacity;
+	BlobSection* m_Sections;
+	size_t m_SectionCount;
+	size_t m_SectionCapacity;
+	uint64_t* m_Fixups;
+	size_t m_FixupCount;
+	size_t m_FixupCapacity;
+	bool m_Failed;
+	bool m_Finished;
+
+	bool Reserve(size_t size);
+	template<typename T>
+	bool Append(T*& items, size_t& count, size_t& capacity, const T& item);
+};
+
+// A blob opened for use in place
+// Files are mapped copy-on-write, so pages only the fixups or the caller write to become private
+// and the rest stay shared with the file cache. Everything the blob points to lives until Close.
+class MappedBlob {
+public:
+	MappedBlob();
+	~MappedBlob();
+
+	// Map and fix up the file, its size is charged to tag until Close
+	bool Open(const char* path, MemoryTag tag = MemoryTag::NoTag);
+	// Fix up a blob already in memory in place, data must stay alive and be page aligned or aligned
+	// to its largest section. Fixups are applied once, so the same bytes can't be opened twice.
+	// Its bytes are already counted wherever they came from.
+	bool Open(void* data, size_t size);
+	void Close();
+	bool IsOpen() const { return m_Data != nullptr; }
+
+	const BlobSection* FindSection(uint32_t id) const;
+
+	template<typename T>
+	BlobView<T> Find(uint32_t id) const {
+		const BlobSection* section = FindSection(id);
+		if (!section || section->elementSize != sizeof(T) || section->alignment < alignof(T)) {
+			return BlobView<T>{ nullptr, 0 };
+		}
+		return BlobView<T>{ reinterpret_cast<T*>(m_Data + section->offset), static_cast<size_t>(section->count) };
+	}
+
+	uint8_t* GetData() const { return m_Data; }
+	size_t GetSize() const { return m_Size; }
+
+	MappedBlob(const MappedBlob&) = delete;
+	MappedBlob& operator=(const MappedBlob&) = delete;
+
+private:
+	uint8_t* m_Data;
+	size_t m_Size;
+	const BlobSection* m_Sections;
+	uint32_t m_SectionCount;
+	MemoryTag m_Tag;
+	bool m_Mapped;
+
+	bool Attach(uint8_t* data, size_t size);
+};
+
+END_NS_MEMORY
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_BLOB_
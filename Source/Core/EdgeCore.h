@@ -39,19 +39,44 @@
 #define BEGIN_NS_GEOMETRY namespace geometry {
 #define END_NS_GEOMETRY }
 
+#define BEGIN_NS_MATH namespace math {
+#define END_NS_MATH }
+
 #define BEGIN_NS_ASSERT namespace assert {
 #define END_NS_ASSERT }
 
+#define BEGIN_NS_BENCHMARK namespace benchmark {
+#define END_NS_BENCHMARK }
+
+#define BEGIN_NS_PROFILE namespace profile {
+#define END_NS_PROFILE }
+
+#define BEGIN_NS_JOBS namespace jobs {
+#define END_NS_JOBS }
+
 //==================================================================================================
 // 1. PROJECT-SPECIFIC PREPROCESSOR TOGGLES
 // 
 // These are intended to be defined in the build system (e.g., via -DEDGE_PROFILE=1).
 // If they are not defined by the build system, they default to 0 (disabled).
 //==================================================================================================
+// Zone profiler, see EdgeProfiler.h. Off compiles every EDGE_PROFILE_ macro to nothing.
 #ifndef EDGE_PROFILE
 #define EDGE_PROFILE 0
 #endif
 
+// Memory tracking (leak list, per-tag stats) follows the build type unless set explicitly.
+// EDGE_DEBUG is only resolved in section 8, which is fine as it is expanded at the point of use.
+#ifndef EDGE_MEMORY_TRACKING
+#define EDGE_MEMORY_TRACKING EDGE_DEBUG
+#endif
+
+// Replace the global operator new/delete with the Edge memory system. Only the module that owns
+// the program's entry point should turn this on, a program can only have one replacement.
+#ifndef EDGE_REPLACE_GLOBAL_NEW
+#define EDGE_REPLACE_GLOBAL_NEW 0
+#endif
+
 #ifndef EDGE_TEST
 #define EDGE_TEST 0
 #endif
@@ -159,6 +184,7 @@
 // 
 // Defines: EDGE_PLATFORM_WINDOWS, EDGE_PLATFORM_MACOS, EDGE_PLATFORM_IOS, EDGE_PLATFORM_ANDROID
 //          EDGE_ARCH_X64, EDGE_ARCH_ARM64
+//          EDGE_SIMD_SSE4, EDGE_SIMD_AVX2, EDGE_SIMD_FMA, EDGE_SIMD_F16C, EDGE_SIMD_NEON
 //==================================================================================================
 
 // --- Platform Detection ---
@@ -212,6 +238,43 @@
 #define EDGE_ARCH_ARM64 0
 #endif
 
+// --- SIMD Instruction Sets ---
+// SSE2 and NEON are part of the base architectures. The rest follow the compiler's target flags,
+// MSVC has no SSE4 switch and always accepts its intrinsics.
+#if EDGE_ARCH_X64
+#if EDGE_COMPILER_MSVC || defined(__SSE4_1__)
+#define EDGE_SIMD_SSE4 1
+#endif
+#if defined(__AVX2__)
+#define EDGE_SIMD_AVX2 1
+#endif
+#if defined(__FMA__) || (EDGE_COMPILER_MSVC && defined(__AVX2__))
+#define EDGE_SIMD_FMA 1
+#endif
+#if defined(__F16C__) || (EDGE_COMPILER_MSVC && defined(__AVX2__))
+#define EDGE_SIMD_F16C 1
+#endif
+#elif EDGE_ARCH_ARM64
+#define EDGE_SIMD_NEON 1
+#define EDGE_SIMD_FMA 1
+#endif
+
+#ifndef EDGE_SIMD_SSE4
+#define EDGE_SIMD_SSE4 0
+#endif
+#ifndef EDGE_SIMD_AVX2
+#define EDGE_SIMD_AVX2 0
+#endif
+#ifndef EDGE_SIMD_FMA
+#define EDGE_SIMD_FMA 0
+#endif
+#ifndef EDGE_SIMD_F16C
+#define EDGE_SIMD_F16C 0
+#endif
+#ifndef EDGE_SIMD_NEON
+#define EDGE_SIMD_NEON 0
+#endif
+
 
 //==================================================================================================
 // 5. GLOBAL SUPPORT VALIDATION
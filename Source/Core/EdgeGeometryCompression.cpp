@@ -0,0 +1,487 @@
+/*
+ * EdgeGeometryCompression.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Attribute quantization and the index buffer codec.
+ *
+ */
+
+#include "EdgeGeometryCompression.h"
+#include <cmath>
+#include <cstring>
+
+#if EDGE_SIMD_NEON
+#include <arm_neon.h>
+#elif EDGE_COMPILER_MSVC
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+BEGIN_NS_EDGE
+BEGIN_NS_GEOMETRY
+
+namespace {
+
+constexpr float kSnormScale = 32767.0f;
+constexpr float kGridSteps = 65535.0f;
+
+// Attributes sit at any byte offset in a vertex, so they're copied out rather than dereferenced
+inline void LoadAttribute(float* values, const void* attributes, size_t stride, size_t index, size_t count) {
+	memcpy(values, static_cast<const uint8_t*>(attributes) + index * stride, count * sizeof(float));
+}
+
+inline void StoreAttribute(void* attributes, size_t stride, size_t index, const float* values, size_t count) {
+	memcpy(static_cast<uint8_t*>(attributes) + index * stride, values, count * sizeof(float));
+}
+
+inline float SignNotZero(float value) {
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+inline int16_t ToSnorm(float value) {
+	return static_cast<int16_t>(std::fmin(std::fmax(value, -kSnormScale), kSnormScale));
+}
+
+inline float FromSnorm(int16_t value) {
+	return std::fmax(static_cast<float>(value) / kSnormScale, -1.0f);
+}
+
+inline float Dot(const float a[3], const float b[3]) {
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+inline uint32_t Zigzag(uint32_t delta) {
+	return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+inline uint32_t Unzigzag(uint32_t value) {
+	return (value >> 1) ^ (0u - (value & 1));
+}
+
+inline uint32_t GetByteCount(uint32_t value) {
+	return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+}
+
+// Shuffle that spreads the bytes of a group over four 32-bit lanes, and the bytes it consumes,
+// for every control byte. Lane k of a control byte is bits 2k and 2k + 1, its byte count less one.
+struct GroupTable {
+	alignas(16) uint8_t shuffle[256][16];
+	uint8_t length[256];
+
+	constexpr GroupTable() : shuffle(), length() {
+		for (uint32_t control = 0; control < 256; ++control) {
+			uint32_t offset = 0;
+			for (uint32_t lane = 0; lane < 4; ++lane) {
+				const uint32_t bytes = ((control >> (lane * 2)) & 3) + 1;
+				for (uint32_t byte = 0; byte < 4; ++byte) {
+					// A set high bit zeroes the byte in both pshufb and tbl
+					shuffle[control][lane * 4 + byte] = static_cast<uint8_t>(byte < bytes ? offset + byte : 0x80);
+				}
+				offset += bytes;
+			}
+			length[control] = static_cast<uint8_t>(offset);
+		}
+	}
+};
+
+constexpr GroupTable kGroupTable;
+
+// The widest group, four four byte values, is all a SIMD load ever needs
+constexpr size_t kGroupBytes = 16;
+
+// Decode groups [first, last) while a full 16 byte load stays inside the buffer, returns the next
+#if EDGE_SIMD_SSE4
+
+size_t DecodeGroups(uint32_t* indices, size_t first, size_t last, const uint8_t* control, const uint8_t*& data,
+	const uint8_t* end, uint32_t& previous) {
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i base = _mm_set1_epi32(static_cast<int>(previous));
+
+	size_t group = first;
+	for (; group < last && static_cast<size_t>(end - data) >= kGroupBytes; ++group) {
+		const uint8_t bits = control[group];
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(kGroupTable.shuffle[bits]));
+		const __m128i zigzag = _mm_shuffle_epi8(bytes, mask);
+		__m128i delta = _mm_xor_si128(_mm_srli_epi32(zigzag, 1), _mm_sub_epi32(zero, _mm_and_si128(zigzag, one)));
+
+		delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+		delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+		base = _mm_add_epi32(base, delta);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(indices + group * 4), base);
+		base = _mm_shuffle_epi32(base, _MM_SHUFFLE(3, 3, 3, 3));
+		data += kGroupTable.length[bits];
+	}
+
+	previous = static_cast<uint32_t>(_mm_cvtsi128_si32(base));
+	return group;
+}
+
+#elif EDGE_SIMD_NEON
+
+size_t DecodeGroups(uint32_t* indices, size_t first, size_t last, const uint8_t* control, const uint8_t*& data,
+	const uint8_t* end, uint32_t& previous) {
+	const uint32x4_t one = vdupq_n_u32(1);
+	const uint32x4_t zero = vdupq_n_u32(0);
+	uint32x4_t base = vdupq_n_u32(previous);
+
+	size_t group = first;
+	for (; group < last && static_cast<size_t>(end - data) >= kGroupBytes; ++group) {
+		const uint8_t bits = control[group];
+		const uint8x16_t bytes = vld1q_u8(data);
+		const uint8x16_t mask = vld1q_u8(kGroupTable.shuffle[bits]);
+		const uint32x4_t zigzag = vreinterpretq_u32_u8(vqtbl1q_u8(bytes, mask));
+		uint32x4_t delta = veorq_u32(vshrq_n_u32(zigzag, 1), vsubq_u32(zero, vandq_u32(zigzag, one)));
+
+		delta = vaddq_u32(delta, vextq_u32(zero, delta, 3));
+		delta = vaddq_u32(delta, vextq_u32(zero, delta, 2));
+		base = vaddq_u32(base, delta);
+		vst1q_u32(indices + group * 4, base);
+		base = vdupq_laneq_u32(base, 3);
+		data += kGroupTable.length[bits];
+	}
+
+	previous = vgetq_lane_u32(base, 0);
+	return group;
+}
+
+#else
+
+size_t DecodeGroups(uint32_t*, size_t first, size_t, const uint8_t*, const uint8_t*&, const uint8_t*, uint32_t&) {
+	return first;
+}
+
+#endif
+
+} // namespace
+
+//==================================================================================================
+// Attribute Quantization
+//==================================================================================================
+
+void EncodeOctahedral(int16_t encoded[2], const float normal[3]) {
+	const float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+	if (!(length > 0.0f) || !std::isfinite(length)) {
+		encoded[0] = 0;
+		encoded[1] = 0;
+		return;
+	}
+
+	// Project onto the octahedron and fold the lower half over the upper one
+	float x = normal[0] / length;
+	float y = normal[1] / length;
+	if (normal[2] < 0.0f) {
+		const float folded = (1.0f - std::fabs(y)) * SignNotZero(x);
+		y = (1.0f - std::fabs(x)) * SignNotZero(y);
+		x = folded;
+	}
+
+	// Rounding each axis alone isn't always closest on the sphere, try all four neighbors
+	float direction[3];
+	const float inverse = 1.0f / std::sqrt(Dot(normal, normal));
+	for (int axis = 0; axis < 3; ++axis) {
+		direction[axis] = normal[axis] * inverse;
+	}
+
+	const float fx = std::floor(x * kSnormScale);
+	const float fy = std::floor(y * kSnormScale);
+	float best = -2.0f;
+	for (int i = 0; i < 4; ++i) {
+		const int16_t candidate[2] = { ToSnorm(fx + float(i & 1)), ToSnorm(fy + float(i >> 1)) };
+		float decoded[3];
+		DecodeOctahedral(decoded, candidate);
+		const float similarity = Dot(decoded, direction);
+		if (similarity > best) {
+			best = similarity;
+			encoded[0] = candidate[0];
+			encoded[1] = candidate[1];
+		}
+	}
+}
+
+void DecodeOctahedral(float normal[3], const int16_t encoded[2]) {
+	float x = FromSnorm(encoded[0]);
+	float y = FromSnorm(encoded[1]);
+	const float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+	// Unfold the lower half, a no-op above the equator
+	const float t = std::fmax(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	const float inverse = 1.0f / std::sqrt(x * x + y * y + z * z);
+	normal[0] = x * inverse;
+	normal[1] = y * inverse;
+	normal[2] = z * inverse;
+}
+
+void QuantizeNormals(int16_t* encoded, const void* normals, size_t stride, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		float normal[3];
+		LoadAttribute(normal, normals, stride, i, 3);
+		EncodeOctahedral(encoded + i * 2, normal);
+	}
+}
+
+void DequantizeNormals(void* normals, size_t stride, const int16_t* encoded, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		float normal[3];
+		DecodeOctahedral(normal, encoded + i * 2);
+		StoreAttribute(normals, stride, i, normal, 3);
+	}
+}
+
+void ComputePositionGrid(PositionGrid& grid, const void* positions, size_t stride, size_t count) {
+	float min[3] = { 0.0f, 0.0f, 0.0f };
+	float max[3] = { 0.0f, 0.0f, 0.0f };
+	if (count > 0) {
+		LoadAttribute(min, positions, stride, 0, 3);
+		memcpy(max, min, sizeof(max));
+	}
+
+	for (size_t i = 1; i < count; ++i) {
+		float position[3];
+		LoadAttribute(position, positions, stride, i, 3);
+		for (int axis = 0; axis < 3; ++axis) {
+			min[axis] = std::fmin(min[axis], position[axis]);
+			max[axis] = std::fmax(max[axis], position[axis]);
+		}
+	}
+
+	ComputePositionGrid(grid, min, max);
+}
+
+void ComputePositionGrid(PositionGrid& grid, const float min[3], const float max[3]) {
+	for (int axis = 0; axis < 3; ++axis) {
+		grid.offset[axis] = min[axis];
+		grid.scale[axis] = max[axis] > min[axis] ? (max[axis] - min[axis]) / kGridSteps : 0.0f;
+	}
+}
+
+void QuantizePositions(uint16_t* quantized, const PositionGrid& grid, const void* positions, size_t stride, size_t count) {
+	float inverse[3];
+	for (int axis = 0; axis < 3; ++axis) {
+		inverse[axis] = grid.scale[axis] > 0.0f ? 1.0f / grid.scale[axis] : 0.0f;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		float position[3];
+		LoadAttribute(position, positions, stride, i, 3);
+		uint16_t* out = quantized + i * 4;
+		for (int axis = 0; axis < 3; ++axis) {
+			const float steps = (position[axis] - grid.offset[axis]) * inverse[axis];
+			out[axis] = static_cast<uint16_t>(std::fmin(std::fmax(steps + 0.5f, 0.0f), kGridSteps));
+		}
+		out[3] = 0;
+	}
+}
+
+void DequantizePositions(void* positions, size_t stride, const uint16_t* quantized, const PositionGrid& grid, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		const uint16_t* in = quantized + i * 4;
+		float position[3];
+		for (int axis = 0; axis < 3; ++axis) {
+			position[axis] = grid.offset[axis] + static_cast<float>(in[axis]) * grid.scale[axis];
+		}
+		StoreAttribute(positions, stride, i, position, 3);
+	}
+}
+
+// Bit manipulation after Fabian Giesen's float_to_half_fast3_rtne and half_to_float
+uint16_t EncodeHalf(float value) {
+	constexpr uint32_t kInfinity = 255u << 23;
+	constexpr uint32_t kOverflow = (127u + 16) << 23;		// 65536, everything from 65520 rounds up to it
+	constexpr uint32_t kSmallestNormal = 113u << 23;		// 2^-14
+	constexpr uint32_t kDenormalMagic = ((127u - 15) + (23 - 10) + 1) << 23;
+
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	uint32_t half;
+	if (bits >= kOverflow) {
+		half = bits > kInfinity ? 0x7e00 : 0x7c00;
+	} else if (bits < kSmallestNormal) {
+		// Adding the magic value lines the denormal mantissa up and the FPU rounds it
+		float magic;
+		float f;
+		memcpy(&magic, &kDenormalMagic, sizeof(magic));
+		memcpy(&f, &bits, sizeof(f));
+		f += magic;
+		memcpy(&bits, &f, sizeof(bits));
+		half = bits - kDenormalMagic;
+	} else {
+		const uint32_t odd = (bits >> 13) & 1;
+		bits += ((15u - 127) << 23) + 0xfff + odd;
+		half = bits >> 13;
+	}
+
+	return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+float DecodeHalf(uint16_t value) {
+	constexpr uint32_t kShiftedExponent = 0x7c00u << 13;
+	constexpr uint32_t kMagic = 113u << 23;
+
+	uint32_t bits = (value & 0x7fffu) << 13;
+	const uint32_t exponent = bits & kShiftedExponent;
+	bits += (127u - 15) << 23;
+
+	float result;
+	if (exponent == kShiftedExponent) {
+		bits += (128u - 16) << 23;
+		memcpy(&result, &bits, sizeof(result));
+	} else if (exponent == 0) {
+		float magic;
+		bits += 1u << 23;
+		memcpy(&magic, &kMagic, sizeof(magic));
+		memcpy(&result, &bits, sizeof(result));
+		result -= magic;
+	} else {
+		memcpy(&result, &bits, sizeof(result));
+	}
+
+	return (value & 0x8000u) ? -result : result;
+}
+
+void EncodeHalves(uint16_t* halves, const float* values, size_t count) {
+	size_t i = 0;
+#if EDGE_SIMD_F16C
+	for (; i + 4 <= count; i += 4) {
+		const __m128i packed = _mm_cvtps_ph(_mm_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(halves + i), packed);
+	}
+#elif EDGE_SIMD_NEON
+	for (; i + 4 <= count; i += 4) {
+		vst1_u16(halves + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(values + i))));
+	}
+#endif
+	for (; i < count; ++i) {
+		halves[i] = EncodeHalf(values[i]);
+	}
+}
+
+void DecodeHalves(float* values, const uint16_t* halves, size_t count) {
+	size_t i = 0;
+#if EDGE_SIMD_F16C
+	for (; i + 4 <= count; i += 4) {
+		const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(halves + i));
+		_mm_storeu_ps(values + i, _mm_cvtph_ps(packed));
+	}
+#elif EDGE_SIMD_NEON
+	for (; i + 4 <= count; i += 4) {
+		vst1q_f32(values + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(halves + i))));
+	}
+#endif
+	for (; i < count; ++i) {
+		values[i] = DecodeHalf(halves[i]);
+	}
+}
+
+void QuantizeUVs(uint16_t* halves, const void* uvs, size_t stride, size_t count) {
+	// Tightly packed UVs convert as one flat array
+	if (stride == 2 * sizeof(float) && (reinterpret_cast<uintptr_t>(uvs) & (alignof(float) - 1)) == 0) {
+		EncodeHalves(halves, static_cast<const float*>(uvs), count * 2);
+		return;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		float uv[2];
+		LoadAttribute(uv, uvs, stride, i, 2);
+		halves[i * 2 + 0] = EncodeHalf(uv[0]);
+		halves[i * 2 + 1] = EncodeHalf(uv[1]);
+	}
+}
+
+void DequantizeUVs(void* uvs, size_t stride, const uint16_t* halves, size_t count) {
+	if (stride == 2 * sizeof(float) && (reinterpret_cast<uintptr_t>(uvs) & (alignof(float) - 1)) == 0) {
+		DecodeHalves(static_cast<float*>(uvs), halves, count * 2);
+		return;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		const float uv[2] = { DecodeHalf(halves[i * 2 + 0]), DecodeHalf(halves[i * 2 + 1]) };
+		StoreAttribute(uvs, stride, i, uv, 2);
+	}
+}
+
+//==================================================================================================
+// Index Compression
+//==================================================================================================
+
+size_t GetIndexBufferEncodeBound(size_t indexCount) {
+	return (indexCount + 3) / 4 + indexCount * sizeof(uint32_t);
+}
+
+size_t EncodeIndexBuffer(uint8_t* buffer, size_t bufferSize, const uint32_t* indices, size_t indexCount) {
+	const size_t groupCount = (indexCount + 3) / 4;
+	if (bufferSize < groupCount) {
+		return 0;
+	}
+
+	uint8_t* control = buffer;
+	uint8_t* data = buffer + groupCount;
+	const uint8_t* end = buffer + bufferSize;
+	uint32_t previous = 0;
+
+	for (size_t group = 0; group < groupCount; ++group) {
+		uint8_t bits = 0;
+		for (size_t lane = 0; lane < 4 && group * 4 + lane < indexCount; ++lane) {
+			const uint32_t index = indices[group * 4 + lane];
+			uint32_t value = Zigzag(index - previous);
+			const uint32_t bytes = GetByteCount(value);
+			previous = index;
+
+			if (static_cast<size_t>(end - data) < bytes) {
+				return 0;
+			}
+			for (uint32_t byte = 0; byte < bytes; ++byte, value >>= 8) {
+				*data++ = static_cast<uint8_t>(value);
+			}
+			bits |= static_cast<uint8_t>((bytes - 1) << (lane * 2));
+		}
+		control[group] = bits;
+	}
+
+	return static_cast<size_t>(data - buffer);
+}
+
+bool DecodeIndexBuffer(uint32_t* indices, size_t indexCount, const uint8_t* buffer, size_t bufferSize) {
+	const size_t groupCount = (indexCount + 3) / 4;
+	if (bufferSize < groupCount) {
+		return false;
+	}
+
+	const uint8_t* control = buffer;
+	const uint8_t* data = buffer + groupCount;
+	const uint8_t* end = buffer + bufferSize;
+	uint32_t previous = 0;
+
+	// Whole groups go through the SIMD decoder until its loads would pass the end, the last few
+	// and a partial group byte by byte
+	size_t index = DecodeGroups(indices, 0, indexCount / 4, control, data, end, previous) * 4;
+	for (; index < indexCount; ++index) {
+		const uint32_t bytes = ((control[index / 4] >> ((index % 4) * 2)) & 3) + 1;
+		if (static_cast<size_t>(end - data) < bytes) {
+			return false;
+		}
+
+		uint32_t value = 0;
+		for (uint32_t byte = 0; byte < bytes; ++byte) {
+			value |= static_cast<uint32_t>(*data++) << (byte * 8);
+		}
+		previous += Unzigzag(value);
+		indices[index] = previous;
+	}
+
+	return data == end;
+}
+
+END_NS_GEOMETRY
+END_NS_EDGE
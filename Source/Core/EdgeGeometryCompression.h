@@ -0,0 +1,95 @@
+/*
+ * EdgeGeometryCompression.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Compact vertex and index streams for streaming and GPU fetch.
+ *
+ * Responsibilities:
+ * - Quantize normals to octahedral snorm16, positions to a 16-bit grid over their bounds and UVs
+ *   to half floats, each with a stated error bound,
+ * - Convert floats to and from halves four at a time where the target can,
+ * - And compress index buffers losslessly into a format a SIMD decoder reads four indices at a time.
+ */
+
+#ifndef INC_EDGE_CORE_GEOMETRY_COMPRESSION_
+#define INC_EDGE_CORE_GEOMETRY_COMPRESSION_
+
+#include "EdgeCore.h"
+#include <cstddef>
+#include <cstdint>
+
+BEGIN_NS_EDGE
+BEGIN_NS_GEOMETRY
+
+//==================================================================================================
+// Attribute Quantization
+//
+// Encoders read a float attribute at the start of every stride bytes and write tightly packed
+// output, decoders do the reverse. The packed layouts are what the vertex shaders read, the
+// decoders are for tools and CPU side consumers.
+//==================================================================================================
+
+// Map of a 16-bit position grid, position = offset + q * scale
+// Quantizing through a grid is off by half of scale on each axis, plus float rounding.
+struct PositionGrid {
+	float offset[3];
+	float scale[3];
+};
+
+// Unit normal to the octahedral map as two snorm16s, off by at most 0.01 degrees
+// Zero and non finite normals encode as (0, 0, 1).
+void EncodeOctahedral(int16_t encoded[2], const float normal[3]);
+void DecodeOctahedral(float normal[3], const int16_t encoded[2]);
+
+// Two int16s per normal
+void QuantizeNormals(int16_t* encoded, const void* normals, size_t stride, size_t count);
+void DequantizeNormals(void* normals, size_t stride, const int16_t* encoded, size_t count);
+
+// Grid over the bounds of the positions, or over given bounds so meshes that meet share a grid and
+// leave no cracks. A flat axis gets scale 0 and always quantizes to 0.
+void ComputePositionGrid(PositionGrid& grid, const void* positions, size_t stride, size_t count);
+void ComputePositionGrid(PositionGrid& grid, const float min[3], const float max[3]);
+
+// Four uint16s per position, w is 0 so each one is a single 8 byte fetch
+// Positions outside the grid clamp to its edge.
+void QuantizePositions(uint16_t* quantized, const PositionGrid& grid, const void* positions, size_t stride, size_t count);
+void DequantizePositions(void* positions, size_t stride, const uint16_t* quantized, const PositionGrid& grid, size_t count);
+
+// IEEE half floats, rounding to nearest even
+// Off by at most 2^-11 relative to the value, about 0.00025 for UVs in [0, 1]. Values beyond
+// 65504 become infinity, NaN stays NaN.
+uint16_t EncodeHalf(float value);
+float DecodeHalf(uint16_t value);
+
+void EncodeHalves(uint16_t* halves, const float* values, size_t count);
+void DecodeHalves(float* values, const uint16_t* halves, size_t count);
+
+// Two halves per UV
+void QuantizeUVs(uint16_t* halves, const void* uvs, size_t stride, size_t count);
+void DequantizeUVs(void* uvs, size_t stride, const uint16_t* halves, size_t count);
+
+//==================================================================================================
+// Index Compression
+//
+// Each index is stored as the zigzagged difference from the one before it in one to four bytes.
+// A control byte holds the byte counts of four indices and all control bytes come first, so the
+// decoder expands a group of four with one shuffle and a prefix sum. After the vertex cache and
+// fetch passes most differences fit in a byte and a buffer shrinks about threefold.
+//==================================================================================================
+
+// Largest encoding of indexCount indices
+size_t GetIndexBufferEncodeBound(size_t indexCount);
+
+// Returns the encoded size, or 0 if it doesn't fit in bufferSize
+size_t EncodeIndexBuffer(uint8_t* buffer, size_t bufferSize, const uint32_t* indices, size_t indexCount);
+
+// Returns false if the buffer isn't exactly indexCount encoded indices, indices is then undefined
+bool DecodeIndexBuffer(uint32_t* indices, size_t indexCount, const uint8_t* buffer, size_t bufferSize);
+
+END_NS_GEOMETRY
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_GEOMETRY_COMPRESSION_
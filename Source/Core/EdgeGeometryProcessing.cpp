@@ -0,0 +1,1329 @@
+/*
+ * EdgeGeometryProcessing.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Batch geometry kernels and mesh optimization for content processing.
+ *
+ */
+
+#include "EdgeGeometryProcessing.h"
+#include "EdgeProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+BEGIN_NS_EDGE
+BEGIN_NS_GEOMETRY
+
+using namespace math;
+
+namespace {
+
+//==================================================================================================
+// Batch Registers
+//
+// The kernels are written once against this small set of operations, eight lanes of AVX2 when
+// the target has it and the four-lane math::Vec4 everywhere else. Stream arrays are only
+// guaranteed EDGE_SIMD_ALIGNMENT, so the eight-lane loads are unaligned ones.
+//==================================================================================================
+
+#if EDGE_SIMD_AVX2
+
+using Batch = __m256;
+
+inline Batch BatchLoad(const float* ptr) { return _mm256_loadu_ps(ptr); }
+inline void BatchStore(float* ptr, Batch value) { _mm256_storeu_ps(ptr, value); }
+inline Batch BatchSplat(float value) { return _mm256_set1_ps(value); }
+inline Batch BatchMul(Batch a, Batch b) { return _mm256_mul_ps(a, b); }
+inline Batch BatchMin(Batch a, Batch b) { return _mm256_min_ps(a, b); }
+inline Batch BatchMax(Batch a, Batch b) { return _mm256_max_ps(a, b); }
+
+inline Batch BatchMulAdd(Batch a, Batch b, Batch c) {
+#if EDGE_SIMD_FMA
+	return _mm256_fmadd_ps(a, b, c);
+#else
+	return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+inline Batch BatchReciprocalSqrt(Batch a) {
+	const __m256 estimate = _mm256_rsqrt_ps(a);
+	const __m256 squared = _mm256_mul_ps(_mm256_mul_ps(a, estimate), estimate);
+	return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), estimate), _mm256_sub_ps(_mm256_set1_ps(3.0f), squared));
+}
+
+inline float BatchReduceMin(Batch a) {
+	const Vec4 half = _mm_min_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	return GetX(Min(Min(half, SplatY(half)), Min(SplatZ(half), SplatW(half))));
+}
+
+inline float BatchReduceMax(Batch a) {
+	const Vec4 half = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	return GetX(Max(Max(half, SplatY(half)), Max(SplatZ(half), SplatW(half))));
+}
+
+#else
+
+using Batch = Vec4;
+
+inline Batch BatchLoad(const float* ptr) { return VectorLoadUnaligned(ptr); }
+inline void BatchStore(float* ptr, Batch value) { VectorStoreUnaligned(ptr, value); }
+inline Batch BatchSplat(float value) { return VectorSplat(value); }
+inline Batch BatchMul(Batch a, Batch b) { return a * b; }
+inline Batch BatchMin(Batch a, Batch b) { return Min(a, b); }
+inline Batch BatchMax(Batch a, Batch b) { return Max(a, b); }
+inline Batch BatchMulAdd(Batch a, Batch b, Batch c) { return MultiplyAdd(a, b, c); }
+inline Batch BatchReciprocalSqrt(Batch a) { return ReciprocalSqrt(a); }
+
+inline float BatchReduceMin(Batch a) {
+	return GetX(Min(Min(a, SplatY(a)), Min(SplatZ(a), SplatW(a))));
+}
+
+inline float BatchReduceMax(Batch a) {
+	return GetX(Max(Max(a, SplatY(a)), Max(SplatZ(a), SplatW(a))));
+}
+
+#endif
+
+static_assert(sizeof(Batch) == EDGE_GEOMETRY_BATCH_WIDTH * sizeof(float), "Batch width mismatch");
+
+// Upper 3x4 of a matrix as scalars, rows of the output components
+struct Affine {
+	float m[3][4];
+
+	explicit Affine(const Mat4& transform) {
+		for (int column = 0; column < 4; ++column) {
+			alignas(16) float values[4];
+			VectorStore(values, transform.c[column]);
+			for (int row = 0; row < 3; ++row) {
+				m[row][column] = values[row];
+			}
+		}
+	}
+};
+
+// Shared loop of the transform kernels, reads all three inputs before writing so out may be in
+template<bool Translate, bool Renormalize>
+void TransformStream(const Mat4& transform, const Float3Stream& in, Float3Stream& out) {
+	const Affine a(transform);
+	const size_t count = in.count;
+	size_t i = 0;
+
+	Batch m[3][4];
+	for (int row = 0; row < 3; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			m[row][column] = BatchSplat(a.m[row][column]);
+		}
+	}
+
+	for (; i + EDGE_GEOMETRY_BATCH_WIDTH <= count; i += EDGE_GEOMETRY_BATCH_WIDTH) {
+		const Batch x = BatchLoad(in.x + i);
+		const Batch y = BatchLoad(in.y + i);
+		const Batch z = BatchLoad(in.z + i);
+
+		Batch result[3];
+		for (int row = 0; row < 3; ++row) {
+			Batch value = Translate ? BatchMulAdd(m[row][0], x, m[row][3]) : BatchMul(m[row][0], x);
+			value = BatchMulAdd(m[row][1], y, value);
+			result[row] = BatchMulAdd(m[row][2], z, value);
+		}
+
+		if (Renormalize) {
+			Batch lengthSquared = BatchMul(result[0], result[0]);
+			lengthSquared = BatchMulAdd(result[1], result[1], lengthSquared);
+			lengthSquared = BatchMulAdd(result[2], result[2], lengthSquared);
+			const Batch scale = BatchReciprocalSqrt(BatchMax(lengthSquared, BatchSplat(FLT_MIN)));
+			for (int row = 0; row < 3; ++row) {
+				result[row] = BatchMul(result[row], scale);
+			}
+		}
+
+		BatchStore(out.x + i, result[0]);
+		BatchStore(out.y + i, result[1]);
+		BatchStore(out.z + i, result[2]);
+	}
+
+	for (; i < count; ++i) {
+		const float x = in.x[i], y = in.y[i], z = in.z[i];
+		float result[3];
+		for (int row = 0; row < 3; ++row) {
+			result[row] = a.m[row][0] * x + a.m[row][1] * y + a.m[row][2] * z + (Translate ? a.m[row][3] : 0.0f);
+		}
+
+		if (Renormalize) {
+			const float lengthSquared = result[0] * result[0] + result[1] * result[1] + result[2] * result[2];
+			const float scale = lengthSquared > 0.0f ? 1.0f / std::sqrt(lengthSquared) : 0.0f;
+			for (int row = 0; row < 3; ++row) {
+				result[row] *= scale;
+			}
+		}
+
+		out.x[i] = result[0];
+		out.y[i] = result[1];
+		out.z[i] = result[2];
+	}
+	out.count = count;
+}
+
+} // namespace
+
+//==================================================================================================
+// Streams
+//==================================================================================================
+
+bool AllocateStream(Float3Stream& stream, size_t count, memory::IAllocator* allocator, memory::MemoryTag tag) {
+	// Whole batches per array, so each array starts aligned and a kernel never runs off the end
+	const size_t padded = memory::AlignUp(count ? count : 1, EDGE_GEOMETRY_BATCH_WIDTH);
+	const size_t arrayBytes = memory::AlignUp(padded * sizeof(float), memory::EDGE_SIMD_ALIGNMENT);
+	const size_t totalBytes = arrayBytes * 3;
+
+	void* block = allocator ? allocator->Allocate(totalBytes, tag, memory::EDGE_SIMD_ALIGNMENT)
+		: memory::AllocateTagged(totalBytes, tag, memory::EDGE_SIMD_ALIGNMENT);
+	if (block == nullptr) {
+		stream = Float3Stream();
+		return false;
+	}
+
+	float* base = static_cast<float*>(block);
+	stream.x = base;
+	stream.y = base + arrayBytes / sizeof(float);
+	stream.z = base + 2 * (arrayBytes / sizeof(float));
+	stream.count = count;
+	return true;
+}
+
+void FreeStream(Float3Stream& stream, memory::IAllocator* allocator) {
+	if (stream.x != nullptr) {
+		if (allocator) {
+			allocator->Free(stream.x);
+		}
+		else {
+			memory::Free(stream.x);
+		}
+	}
+	stream = Float3Stream();
+}
+
+void LoadStream(Float3Stream& stream, const void* vertices, size_t stride) {
+	const uint8_t* source = static_cast<const uint8_t*>(vertices);
+	for (size_t i = 0; i < stream.count; ++i, source += stride) {
+		float value[3];
+		memcpy(value, source, sizeof(value));
+		stream.x[i] = value[0];
+		stream.y[i] = value[1];
+		stream.z[i] = value[2];
+	}
+}
+
+void StoreStream(const Float3Stream& stream, void* vertices, size_t stride) {
+	uint8_t* destination = static_cast<uint8_t*>(vertices);
+	for (size_t i = 0; i < stream.count; ++i, destination += stride) {
+		const float value[3] = { stream.x[i], stream.y[i], stream.z[i] };
+		memcpy(destination, value, sizeof(value));
+	}
+}
+
+//==================================================================================================
+// Kernels
+//==================================================================================================
+
+void TransformPoints(const Mat4& transform, const Float3Stream& in, Float3Stream& out) {
+	TransformStream<true, false>(transform, in, out);
+}
+
+void TransformVectors(const Mat4& transform, const Float3Stream& in, Float3Stream& out) {
+	TransformStream<false, false>(transform, in, out);
+}
+
+void TransformNormals(const Mat4& transform, const Float3Stream& in, Float3Stream& out) {
+	TransformStream<false, true>(Mat4NormalMatrix(transform), in, out);
+}
+
+void NormalizeStream(Float3Stream& stream) {
+	TransformStream<false, true>(Mat4Identity(), stream, stream);
+}
+
+void ComputeBounds(const Float3Stream& stream, Vec4& min, Vec4& max) {
+	float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	const float* const arrays[3] = { stream.x, stream.y, stream.z };
+	const size_t count = stream.count;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const float* values = arrays[axis];
+		size_t i = 0;
+
+		if (count >= EDGE_GEOMETRY_BATCH_WIDTH) {
+			Batch batchLow = BatchSplat(FLT_MAX);
+			Batch batchHigh = BatchSplat(-FLT_MAX);
+			for (; i + EDGE_GEOMETRY_BATCH_WIDTH <= count; i += EDGE_GEOMETRY_BATCH_WIDTH) {
+				const Batch value = BatchLoad(values + i);
+				batchLow = BatchMin(batchLow, value);
+				batchHigh = BatchMax(batchHigh, value);
+			}
+			low[axis] = BatchReduceMin(batchLow);
+			high[axis] = BatchReduceMax(batchHigh);
+		}
+
+		for (; i < count; ++i) {
+			low[axis] = values[i] < low[axis] ? values[i] : low[axis];
+			high[axis] = values[i] > high[axis] ? values[i] : high[axis];
+		}
+	}
+
+	min = VectorSet(low[0], low[1], low[2], 0.0f);
+	max = VectorSet(high[0], high[1], high[2], 0.0f);
+}
+
+//==================================================================================================
+// Mesh Optimization
+//==================================================================================================
+
+namespace {
+
+constexpr uint32_t kNoVertex = ~0u;
+
+// Room for the alignment of every scratch allocation a stage makes
+constexpr size_t kScratchSlack = 512;
+
+// Scratch arrays never need tagging, they are rewound before the stage returns
+template<typename T>
+T* AllocateScratch(memory::LinearAllocator& scratch, size_t count) {
+	return static_cast<T*>(scratch.Allocate((count ? count : 1) * sizeof(T), alignof(T) < 16 ? 16 : alignof(T)));
+}
+
+size_t GetWeldTableCapacity(size_t vertexCount) {
+	// At most half full, so probes stay short
+	size_t capacity = 16;
+	while (capacity < vertexCount * 2) {
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+// Murmur3 over the vertex bytes
+uint32_t HashVertex(const uint8_t* vertex, size_t stride) {
+	uint32_t hash = 0x9E3779B9u ^ static_cast<uint32_t>(stride);
+	size_t i = 0;
+	for (; i + 4 <= stride; i += 4) {
+		uint32_t word;
+		memcpy(&word, vertex + i, sizeof(word));
+		word *= 0xCC9E2D51u;
+		word = (word << 15) | (word >> 17);
+		word *= 0x1B873593u;
+		hash ^= word;
+		hash = (hash << 13) | (hash >> 19);
+		hash = hash * 5 + 0xE6546B64u;
+	}
+	for (; i < stride; ++i) {
+		hash = (hash ^ vertex[i]) * 0x01000193u;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6Bu;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+Vec4 LoadPosition(const Mesh& mesh, uint32_t vertex) {
+	alignas(16) float position[3];
+	memcpy(position, mesh.vertices + vertex * mesh.vertexStride + mesh.positionOffset, sizeof(position));
+	return VectorLoad3(position);
+}
+
+// Triangles around every vertex, those of vertex v are adjacency[offsets[v], offsets[v + 1])
+void BuildAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t* offsets, uint32_t* counts, uint32_t* adjacency) {
+	memset(counts, 0, vertexCount * sizeof(uint32_t));
+	for (size_t i = 0; i < indexCount; ++i) {
+		++counts[indices[i]];
+	}
+
+	// Fill through the start offsets, which leaves each at the start of the next vertex, then
+	// shift them back
+	uint32_t offset = 0;
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+		offsets[vertex] = offset;
+		offset += counts[vertex];
+	}
+	for (size_t i = 0; i < indexCount; ++i) {
+		adjacency[offsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+	for (size_t vertex = vertexCount; vertex > 0; --vertex) {
+		offsets[vertex] = offsets[vertex - 1];
+	}
+	offsets[0] = 0;
+}
+
+// FIFO cache simulation, a vertex misses once cacheSize other misses have pushed it out.
+// Times start above cacheSize so every vertex misses on first use, bumping the time by more than
+// cacheSize flushes the cache.
+struct CacheSimulator {
+	uint32_t* cacheTime;
+	uint32_t cacheSize;
+	uint32_t time;
+
+	bool Touch(uint32_t vertex) {
+		if (time - cacheTime[vertex] > cacheSize) {
+			cacheTime[vertex] = time++;
+			return true;
+		}
+		return false;
+	}
+
+	void Flush() { time += cacheSize + 1; }
+};
+
+struct Cluster {
+	float key;
+	uint32_t index;
+
+	bool operator<(const Cluster& other) const {
+		return key > other.key || (key == other.key && index < other.index);
+	}
+};
+
+// Vertex with the best cache position among the ones the last fan touched
+// Tipsify prefers the vertex that entered the cache earliest and is still sure to be in it once
+// its remaining triangles are emitted, and falls back to the dead-end stack and then the next
+// vertex in order that still has triangles.
+uint32_t GetNextFan(const uint32_t* candidates, size_t candidateCount, const uint32_t* live, const uint32_t* cacheTime,
+	uint32_t time, uint32_t cacheSize, const uint32_t* deadEnd, size_t& deadEndCount, uint32_t& cursor, size_t vertexCount) {
+
+	uint32_t best = kNoVertex;
+	uint32_t bestPriority = 0;
+	for (size_t i = 0; i < candidateCount; ++i) {
+		const uint32_t vertex = candidates[i];
+		if (live[vertex] == 0) {
+			continue;
+		}
+
+		const uint32_t age = time - cacheTime[vertex];
+		const uint32_t priority = age + 2 * live[vertex] <= cacheSize ? age : 0;
+		if (best == kNoVertex || priority > bestPriority) {
+			best = vertex;
+			bestPriority = priority;
+		}
+	}
+	if (best != kNoVertex) {
+		return best;
+	}
+
+	while (deadEndCount > 0) {
+		const uint32_t vertex = deadEnd[--deadEndCount];
+		if (live[vertex] > 0) {
+			return vertex;
+		}
+	}
+
+	for (; cursor < vertexCount; ++cursor) {
+		if (live[cursor] > 0) {
+			return cursor;
+		}
+	}
+	return kNoVertex;
+}
+
+} // namespace
+
+size_t GetMeshScratchSize(const Mesh& mesh) {
+	const size_t vertexCount = mesh.vertexCount;
+	const size_t indexCount = mesh.indexCount;
+	const size_t triangleCount = indexCount / 3;
+
+	const size_t weld = (GetWeldTableCapacity(vertexCount) + vertexCount) * sizeof(uint32_t);
+	const size_t cache = (3 * vertexCount + 1 + 4 * indexCount) * sizeof(uint32_t) + triangleCount;
+	const size_t overdraw = (vertexCount + triangleCount + 1 + indexCount) * sizeof(uint32_t) + triangleCount * sizeof(Cluster);
+	const size_t fetch = vertexCount * sizeof(uint32_t) + vertexCount * mesh.vertexStride;
+	return std::max(std::max(weld, cache), std::max(overdraw, fetch)) + kScratchSlack;
+}
+
+bool WeldVertices(Mesh& mesh, memory::LinearAllocator& scratch) {
+	EDGE_PROFILE_SCOPE("Weld Vertices");
+	memory::LinearAllocatorScope scope(scratch);
+
+	const size_t vertexCount = mesh.vertexCount;
+	const size_t stride = mesh.vertexStride;
+	const size_t capacity = GetWeldTableCapacity(vertexCount);
+	uint32_t* table = AllocateScratch<uint32_t>(scratch, capacity);
+	uint32_t* remap = AllocateScratch<uint32_t>(scratch, vertexCount);
+	if (table == nullptr || remap == nullptr) {
+		return false;
+	}
+
+	// The table holds output indices, unique vertices are compacted to the front as they are found.
+	// Output slots are never above the vertex being read, so the compaction can run in place.
+	memset(table, 0xFF, capacity * sizeof(uint32_t));
+	uint32_t uniqueCount = 0;
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+		const uint8_t* data = mesh.vertices + vertex * stride;
+		size_t slot = HashVertex(data, stride) & (capacity - 1);
+		for (;;) {
+			const uint32_t entry = table[slot];
+			if (entry == kNoVertex) {
+				if (uniqueCount != vertex) {
+					memcpy(mesh.vertices + uniqueCount * stride, data, stride);
+				}
+				table[slot] = uniqueCount;
+				remap[vertex] = uniqueCount++;
+				break;
+			}
+			if (memcmp(mesh.vertices + entry * stride, data, stride) == 0) {
+				remap[vertex] = entry;
+				break;
+			}
+			slot = (slot + 1) & (capacity - 1);
+		}
+	}
+
+	for (size_t i = 0; i < mesh.indexCount; ++i) {
+		mesh.indices[i] = remap[mesh.indices[i]];
+	}
+	mesh.vertexCount = uniqueCount;
+	return true;
+}
+
+bool OptimizeVertexCache(Mesh& mesh, const Submesh& submesh, uint32_t cacheSize, memory::LinearAllocator& scratch) {
+	EDGE_PROFILE_SCOPE("Optimize Vertex Cache");
+	memory::LinearAllocatorScope scope(scratch);
+
+	uint32_t* indices = mesh.indices + submesh.indexOffset;
+	const size_t triangleCount = submesh.indexCount / 3;
+	const size_t indexCount = triangleCount * 3;
+	const size_t vertexCount = mesh.vertexCount;
+	if (triangleCount < 2) {
+		return true;
+	}
+
+	uint32_t* offsets = AllocateScratch<uint32_t>(scratch, vertexCount + 1);
+	uint32_t* live = AllocateScratch<uint32_t>(scratch, vertexCount);
+	uint32_t* cacheTime = AllocateScratch<uint32_t>(scratch, vertexCount);
+	uint32_t* adjacency = AllocateScratch<uint32_t>(scratch, indexCount);
+	uint32_t* deadEnd = AllocateScratch<uint32_t>(scratch, indexCount);
+	uint32_t* candidates = AllocateScratch<uint32_t>(scratch, indexCount);
+	uint32_t* output = AllocateScratch<uint32_t>(scratch, indexCount);
+	uint8_t* emitted = AllocateScratch<uint8_t>(scratch, triangleCount);
+	if (offsets == nullptr || live == nullptr || cacheTime == nullptr || adjacency == nullptr || deadEnd == nullptr
+		|| candidates == nullptr || output == nullptr || emitted == nullptr) {
+		return false;
+	}
+
+	// Live counts the triangles of every vertex not emitted yet
+	BuildAdjacency(indices, indexCount, vertexCount, offsets, live, adjacency);
+	memset(cacheTime, 0, vertexCount * sizeof(uint32_t));
+	memset(emitted, 0, triangleCount);
+
+	CacheSimulator cache = { cacheTime, cacheSize, cacheSize + 1 };
+	size_t deadEndCount = 0;
+	size_t outputCount = 0;
+	uint32_t cursor = 0;
+	uint32_t fan = GetNextFan(nullptr, 0, live, cacheTime, cache.time, cacheSize, deadEnd, deadEndCount, cursor, vertexCount);
+
+	while (fan != kNoVertex) {
+		size_t candidateCount = 0;
+		for (uint32_t i = offsets[fan]; i < offsets[fan + 1]; ++i) {
+			const uint32_t triangle = adjacency[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+			emitted[triangle] = 1;
+
+			for (size_t corner = 0; corner < 3; ++corner) {
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				output[outputCount++] = vertex;
+				deadEnd[deadEndCount++] = vertex;
+				candidates[candidateCount++] = vertex;
+				--live[vertex];
+				cache.Touch(vertex);
+			}
+		}
+
+		fan = GetNextFan(candidates, candidateCount, live, cacheTime, cache.time, cacheSize, deadEnd, deadEndCount, cursor, vertexCount);
+	}
+
+	memcpy(indices, output, indexCount * sizeof(uint32_t));
+	return true;
+}
+
+bool OptimizeOverdraw(Mesh& mesh, const Submesh& submesh, uint32_t cacheSize, float threshold, memory::LinearAllocator& scratch) {
+	EDGE_PROFILE_SCOPE("Optimize Overdraw");
+	memory::LinearAllocatorScope scope(scratch);
+
+	uint32_t* indices = mesh.indices + submesh.indexOffset;
+	const size_t triangleCount = submesh.indexCount / 3;
+	const size_t indexCount = triangleCount * 3;
+	const size_t vertexCount = mesh.vertexCount;
+	if (triangleCount < 2) {
+		return true;
+	}
+
+	uint32_t* cacheTime = AllocateScratch<uint32_t>(scratch, vertexCount);
+	uint32_t* clusterStart = AllocateScratch<uint32_t>(scratch, triangleCount + 1);
+	Cluster* clusters = AllocateScratch<Cluster>(scratch, triangleCount);
+	uint32_t* output = AllocateScratch<uint32_t>(scratch, indexCount);
+	if (cacheTime == nullptr || clusterStart == nullptr || clusters == nullptr || output == nullptr) {
+		return false;
+	}
+
+	// Miss ratio of the current order, the clusters may not fall too far below it
+	memset(cacheTime, 0, vertexCount * sizeof(uint32_t));
+	CacheSimulator cache = { cacheTime, cacheSize, cacheSize + 1 };
+	size_t misses = 0;
+	for (size_t i = 0; i < indexCount; ++i) {
+		misses += cache.Touch(indices[i]);
+	}
+	const float missLimit = threshold * static_cast<float>(misses) / static_cast<float>(triangleCount);
+
+	// A triangle that misses on all three vertices starts a cluster for free. A cluster also ends
+	// where, counted from a cold cache, it already meets the limit, the cache is flushed there so
+	// the clusters after it are counted cold too.
+	memset(cacheTime, 0, vertexCount * sizeof(uint32_t));
+	cache.time = cacheSize + 1;
+	size_t clusterCount = 0;
+	size_t clusterMisses = 0;
+	size_t clusterTriangles = 0;
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+		size_t triangleMisses = 0;
+		for (size_t corner = 0; corner < 3; ++corner) {
+			triangleMisses += cache.Touch(indices[triangle * 3 + corner]);
+		}
+
+		if (clusterTriangles == 0 || triangleMisses == 3) {
+			clusterStart[clusterCount++] = static_cast<uint32_t>(triangle);
+			clusterMisses = 0;
+			clusterTriangles = 0;
+		}
+		clusterMisses += triangleMisses;
+		++clusterTriangles;
+
+		if (static_cast<float>(clusterMisses) <= missLimit * static_cast<float>(clusterTriangles)) {
+			clusterTriangles = 0;
+			cache.Flush();
+		}
+	}
+	clusterStart[clusterCount] = static_cast<uint32_t>(triangleCount);
+
+	if (clusterCount < 2) {
+		return true;
+	}
+
+	// Area weighted centroid of the submesh
+	Vec4 centroidSum = VectorZero();
+	Vec4 areaSum = VectorZero();
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+		const Vec4 a = LoadPosition(mesh, indices[triangle * 3 + 0]);
+		const Vec4 b = LoadPosition(mesh, indices[triangle * 3 + 1]);
+		const Vec4 c = LoadPosition(mesh, indices[triangle * 3 + 2]);
+		const Vec4 area = Length3(Cross3(b - a, c - a));
+		centroidSum = MultiplyAdd(area, a + b + c, centroidSum);
+		areaSum += area;
+	}
+	const float totalArea = GetX(areaSum);
+	const Vec4 centroid = totalArea > 0.0f ? centroidSum / (areaSum * VectorSplat(3.0f)) : VectorZero();
+
+	// Clusters further out along their own normal occlude more of the rest and draw first
+	for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+		Vec4 clusterCentroidSum = VectorZero();
+		Vec4 clusterAreaSum = VectorZero();
+		Vec4 normalSum = VectorZero();
+		for (uint32_t triangle = clusterStart[cluster]; triangle < clusterStart[cluster + 1]; ++triangle) {
+			const Vec4 a = LoadPosition(mesh, indices[triangle * 3 + 0]);
+			const Vec4 b = LoadPosition(mesh, indices[triangle * 3 + 1]);
+			const Vec4 c = LoadPosition(mesh, indices[triangle * 3 + 2]);
+			const Vec4 normal = Cross3(b - a, c - a);
+			const Vec4 area = Length3(normal);
+			clusterCentroidSum = MultiplyAdd(area, a + b + c, clusterCentroidSum);
+			clusterAreaSum += area;
+			normalSum += normal;
+		}
+
+		float key = 0.0f;
+		if (GetX(clusterAreaSum) > 0.0f) {
+			const Vec4 clusterCentroid = clusterCentroidSum / (clusterAreaSum * VectorSplat(3.0f));
+			key = GetX(Dot3(clusterCentroid - centroid, Normalize3(normalSum)));
+		}
+		clusters[cluster].key = key;
+		clusters[cluster].index = static_cast<uint32_t>(cluster);
+	}
+	std::sort(clusters, clusters + clusterCount);
+
+	size_t outputCount = 0;
+	for (size_t i = 0; i < clusterCount; ++i) {
+		const uint32_t cluster = clusters[i].index;
+		const size_t begin = clusterStart[cluster] * size_t(3);
+		const size_t count = clusterStart[cluster + 1] * size_t(3) - begin;
+		memcpy(output + outputCount, indices + begin, count * sizeof(uint32_t));
+		outputCount += count;
+	}
+
+	memcpy(indices, output, indexCount * sizeof(uint32_t));
+	return true;
+}
+
+bool OptimizeVertexFetch(Mesh& mesh, memory::LinearAllocator& scratch) {
+	EDGE_PROFILE_SCOPE("Optimize Vertex Fetch");
+	memory::LinearAllocatorScope scope(scratch);
+
+	const size_t vertexCount = mesh.vertexCount;
+	const size_t stride = mesh.vertexStride;
+	uint32_t* remap = AllocateScratch<uint32_t>(scratch, vertexCount);
+	uint8_t* copy = AllocateScratch<uint8_t>(scratch, vertexCount * stride);
+	if (remap == nullptr || copy == nullptr) {
+		return false;
+	}
+
+	memset(remap, 0xFF, vertexCount * sizeof(uint32_t));
+	uint32_t nextVertex = 0;
+	for (size_t i = 0; i < mesh.indexCount; ++i) {
+		uint32_t& index = mesh.indices[i];
+		if (remap[index] == kNoVertex) {
+			remap[index] = nextVertex++;
+		}
+		index = remap[index];
+	}
+
+	memcpy(copy, mesh.vertices, vertexCount * stride);
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+		if (remap[vertex] != kNoVertex) {
+			memcpy(mesh.vertices + remap[vertex] * stride, copy + vertex * stride, stride);
+		}
+	}
+	mesh.vertexCount = nextVertex;
+	return true;
+}
+
+bool AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize,
+	VertexCacheStats& stats, memory::LinearAllocator& scratch) {
+
+	memory::LinearAllocatorScope scope(scratch);
+	stats.misses = 0;
+	stats.acmr = 0.0f;
+	stats.atvr = 0.0f;
+
+	uint32_t* cacheTime = AllocateScratch<uint32_t>(scratch, vertexCount);
+	if (cacheTime == nullptr) {
+		return false;
+	}
+
+	memset(cacheTime, 0, vertexCount * sizeof(uint32_t));
+	CacheSimulator cache = { cacheTime, cacheSize, cacheSize + 1 };
+	for (size_t i = 0; i < indexCount; ++i) {
+		stats.misses += cache.Touch(indices[i]);
+	}
+
+	size_t referenced = 0;
+	for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+		referenced += cacheTime[vertex] != 0;
+	}
+
+	const size_t triangleCount = indexCount / 3;
+	stats.acmr = triangleCount ? static_cast<float>(stats.misses) / static_cast<float>(triangleCount) : 0.0f;
+	stats.atvr = referenced ? static_cast<float>(stats.misses) / static_cast<float>(referenced) : 0.0f;
+	return true;
+}
+
+//==================================================================================================
+// Meshlets
+//==================================================================================================
+
+namespace {
+
+constexpr uint32_t kNoTriangle = ~0u;
+constexpr uint8_t kNoLocalVertex = 0xFF;
+constexpr uint32_t kMaxMeshletVertices = 255;
+constexpr uint32_t kMaxMeshletTriangles = 512;
+
+// A meshlet only closes when the next triangle doesn't fit, so it holds more than maxVertices - 3
+// vertices or exactly maxTriangles triangles
+size_t GetMeshletBound(size_t indexCount, const MeshletSettings& settings) {
+	const size_t full = settings.maxVertices - 2;
+	return (indexCount + full - 1) / full + (indexCount / 3 + settings.maxTriangles - 1) / settings.maxTriangles + 1;
+}
+
+// Ritter's sphere, seeded with the most distant pair of axis extremes and grown to cover every point
+void ComputeSphere(const Vec4* points, size_t count, MeshletBounds& bounds) {
+	size_t low[3] = { 0, 0, 0 };
+	size_t high[3] = { 0, 0, 0 };
+	float lowValue[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float highValue[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t i = 0; i < count; ++i) {
+		alignas(16) float point[4];
+		VectorStore(point, points[i]);
+		for (int axis = 0; axis < 3; ++axis) {
+			if (point[axis] < lowValue[axis]) {
+				low[axis] = i;
+				lowValue[axis] = point[axis];
+			}
+			if (point[axis] > highValue[axis]) {
+				high[axis] = i;
+				highValue[axis] = point[axis];
+			}
+		}
+	}
+
+	int spread = 0;
+	float spreadSquared = -1.0f;
+	for (int axis = 0; axis < 3; ++axis) {
+		const Vec4 span = points[high[axis]] - points[low[axis]];
+		const float lengthSquared = GetX(Dot3(span, span));
+		if (lengthSquared > spreadSquared) {
+			spread = axis;
+			spreadSquared = lengthSquared;
+		}
+	}
+
+	Vec4 center = (points[low[spread]] + points[high[spread]]) * 0.5f;
+	float radius = std::sqrt(spreadSquared) * 0.5f;
+	for (size_t i = 0; i < count; ++i) {
+		const Vec4 offset = points[i] - center;
+		const float distance = GetX(Length3(offset));
+		if (distance > radius) {
+			const float grown = (radius + distance) * 0.5f;
+			center = MultiplyAdd(offset, VectorSplat((grown - radius) / distance), center);
+			radius = grown;
+		}
+	}
+
+	VectorStore3(bounds.center, center);
+	bounds.radius = radius;
+}
+
+// Grows meshlets one triangle at a time in the scratch output arrays
+// The next triangle is always one touching the meshlet, picked for the fewest new vertices and a
+// normal close to the meshlet's, and only when none is left does the builder move on in index order.
+struct MeshletBuilder {
+	const Mesh& mesh;
+	const uint32_t* indices;
+	const MeshletSettings& settings;
+	const uint32_t* offsets;
+	const uint32_t* adjacency;
+	const Vec4* normals;		// unit normal of every triangle, zero for degenerate ones
+	uint32_t* live;
+	uint8_t* emitted;
+	uint8_t* localIndex;
+
+	Meshlet* meshlets;
+	MeshletBounds* bounds;
+	uint32_t* vertices;
+	uint8_t* triangles;
+	size_t meshletCount;
+
+	// Meshlet being grown, its mesh triangles and their normal sum
+	Meshlet current;
+	uint32_t currentTriangles[kMaxMeshletTriangles];
+	Vec4 normalSum;
+
+	MeshletBuilder(const Mesh& mesh, const uint32_t* indices, const MeshletSettings& settings)
+		: mesh(mesh), indices(indices), settings(settings), offsets(nullptr), adjacency(nullptr), normals(nullptr)
+		, live(nullptr), emitted(nullptr), localIndex(nullptr), meshlets(nullptr), bounds(nullptr), vertices(nullptr)
+		, triangles(nullptr), meshletCount(0), normalSum(VectorZero()) {
+		current.vertexOffset = 0;
+		current.triangleOffset = 0;
+		current.vertexCount = 0;
+		current.triangleCount = 0;
+	}
+
+	Vec4 GetNormal(uint32_t triangle) const { return normals[triangle]; }
+
+	uint32_t CountNewVertices(uint32_t triangle) const {
+		const uint32_t* corners = indices + triangle * 3;
+		return (localIndex[corners[0]] == kNoLocalVertex)
+			+ (localIndex[corners[1]] == kNoLocalVertex && corners[1] != corners[0])
+			+ (localIndex[corners[2]] == kNoLocalVertex && corners[2] != corners[0] && corners[2] != corners[1]);
+	}
+
+	bool Fits(uint32_t newVertices) const {
+		return current.vertexCount + newVertices <= settings.maxVertices && current.triangleCount < settings.maxTriangles;
+	}
+
+	void Append(uint32_t triangle) {
+		const uint32_t newVertices = CountNewVertices(triangle);
+		if (!Fits(newVertices)) {
+			Finish();
+		}
+
+		const uint32_t* corners = indices + triangle * 3;
+		uint8_t* local = triangles + current.triangleOffset + current.triangleCount * 3;
+		for (int corner = 0; corner < 3; ++corner) {
+			const uint32_t vertex = corners[corner];
+			if (localIndex[vertex] == kNoLocalVertex) {
+				localIndex[vertex] = static_cast<uint8_t>(current.vertexCount);
+				vertices[current.vertexOffset + current.vertexCount++] = vertex;
+			}
+			local[corner] = localIndex[vertex];
+			--live[vertex];
+		}
+
+		currentTriangles[current.triangleCount++] = triangle;
+		emitted[triangle] = 1;
+		normalSum += GetNormal(triangle);
+	}
+
+	// Best unemitted triangle around the triangle just added, then around the whole meshlet
+	uint32_t FindNext(uint32_t last) const {
+		const Vec4 axis = Normalize3(normalSum);
+		uint32_t best = kNoTriangle;
+		float bestScore = FLT_MAX;
+
+		const uint32_t* corners = indices + last * 3;
+		for (int corner = 0; corner < 3; ++corner) {
+			Score(corners[corner], axis, best, bestScore);
+		}
+		if (best == kNoTriangle) {
+			for (uint32_t i = 0; i < current.vertexCount; ++i) {
+				Score(vertices[current.vertexOffset + i], axis, best, bestScore);
+			}
+		}
+		return best;
+	}
+
+	void Finish() {
+		if (current.triangleCount == 0) {
+			return;
+		}
+
+		Vec4 points[kMaxMeshletVertices];
+		for (uint32_t i = 0; i < current.vertexCount; ++i) {
+			const uint32_t vertex = vertices[current.vertexOffset + i];
+			points[i] = LoadPosition(mesh, vertex);
+			localIndex[vertex] = kNoLocalVertex;
+		}
+
+		MeshletBounds& meshletBounds = bounds[meshletCount];
+		ComputeSphere(points, current.vertexCount, meshletBounds);
+
+		// Cone around the average normal through the widest triangle normal, too wide to cull
+		// past about 84 degrees
+		const Vec4 axis = Normalize3(normalSum);
+		float minDot = 1.0f;
+		for (uint32_t i = 0; i < current.triangleCount; ++i) {
+			const Vec4 normal = GetNormal(currentTriangles[i]);
+			if (GetX(Dot3(normal, normal)) > 0.0f) {
+				const float dot = GetX(Dot3(normal, axis));
+				minDot = dot < minDot ? dot : minDot;
+			}
+		}
+		VectorStore3(meshletBounds.coneAxis, axis);
+		meshletBounds.coneCutoff = GetX(Dot3(axis, axis)) > 0.0f && minDot > 0.1f ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+
+		// Pad the triangle list so the next meshlet starts on a word
+		const uint32_t triangleBytes = current.triangleCount * 3;
+		const uint32_t paddedBytes = static_cast<uint32_t>(memory::AlignUp(triangleBytes, 4));
+		memset(triangles + current.triangleOffset + triangleBytes, 0, paddedBytes - triangleBytes);
+
+		meshlets[meshletCount++] = current;
+		current.vertexOffset += current.vertexCount;
+		current.triangleOffset += paddedBytes;
+		current.vertexCount = 0;
+		current.triangleCount = 0;
+		normalSum = VectorZero();
+	}
+
+	size_t GetVertexCount() const { return current.vertexOffset; }
+	size_t GetTriangleBytes() const { return current.triangleOffset; }
+
+	// Triangles that fit come first, then the fewest new vertices, then the normal closest to the axis
+	void Score(uint32_t vertex, Vec4 axis, uint32_t& best, float& bestScore) const {
+		if (live[vertex] == 0) {
+			return;
+		}
+
+		for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+			const uint32_t triangle = adjacency[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+
+			const uint32_t newVertices = CountNewVertices(triangle);
+			const float spread = 1.0f - GetX(Dot3(GetNormal(triangle), axis));
+			const float score = (Fits(newVertices) ? 0.0f : 8.0f) + static_cast<float>(newVertices) + settings.coneWeight * spread;
+			if (score < bestScore) {
+				best = triangle;
+				bestScore = score;
+			}
+		}
+	}
+};
+
+} // namespace
+
+size_t GetMeshletScratchSize(const Mesh& mesh, const MeshletSettings& settings) {
+	const size_t vertexCount = mesh.vertexCount;
+	const size_t indexCount = mesh.indexCount;
+	const size_t triangleCount = indexCount / 3;
+	const size_t meshletBound = settings.maxVertices > 2 && settings.maxTriangles > 0 ? GetMeshletBound(indexCount, settings) : 0;
+
+	const size_t adjacency = vertexCount + (2 * vertexCount + 1 + indexCount) * sizeof(uint32_t) + triangleCount * (1 + sizeof(Vec4));
+	const size_t output = meshletBound * (sizeof(Meshlet) + sizeof(MeshletBounds) + 3) + indexCount * (sizeof(uint32_t) + 1);
+	return adjacency + output + kScratchSlack;
+}
+
+bool BuildMeshlets(MeshletBuffer& meshlets, const Mesh& mesh, const Submesh& submesh, const MeshletSettings& settings,
+	memory::LinearAllocator& scratch, memory::IAllocator* allocator, memory::MemoryTag tag) {
+
+	EDGE_PROFILE_SCOPE("Build Meshlets");
+	meshlets = MeshletBuffer();
+	if (settings.maxVertices < 3 || settings.maxVertices > kMaxMeshletVertices || settings.maxTriangles < 1
+		|| settings.maxTriangles > kMaxMeshletTriangles) {
+		EDGE_ASSERT(false, "Meshlet limits out of range");
+		return false;
+	}
+
+	const uint32_t* indices = mesh.indices + submesh.indexOffset;
+	const size_t triangleCount = submesh.indexCount / 3;
+	const size_t indexCount = triangleCount * 3;
+	const size_t vertexCount = mesh.vertexCount;
+	if (triangleCount == 0) {
+		return true;
+	}
+
+	memory::LinearAllocatorScope scope(scratch);
+	const size_t meshletBound = GetMeshletBound(indexCount, settings);
+	uint32_t* offsets = AllocateScratch<uint32_t>(scratch, vertexCount + 1);
+	uint32_t* live = AllocateScratch<uint32_t>(scratch, vertexCount);
+	uint32_t* adjacency = AllocateScratch<uint32_t>(scratch, indexCount);
+	Vec4* normals = AllocateScratch<Vec4>(scratch, triangleCount);
+	uint8_t* emitted = AllocateScratch<uint8_t>(scratch, triangleCount);
+	uint8_t* localIndex = AllocateScratch<uint8_t>(scratch, vertexCount);
+	Meshlet* outMeshlets = AllocateScratch<Meshlet>(scratch, meshletBound);
+	MeshletBounds* outBounds = AllocateScratch<MeshletBounds>(scratch, meshletBound);
+	uint32_t* outVertices = AllocateScratch<uint32_t>(scratch, indexCount);
+	uint8_t* outTriangles = AllocateScratch<uint8_t>(scratch, indexCount + meshletBound * 3);
+	if (offsets == nullptr || live == nullptr || adjacency == nullptr || normals == nullptr || emitted == nullptr
+		|| localIndex == nullptr || outMeshlets == nullptr || outBounds == nullptr || outVertices == nullptr || outTriangles == nullptr) {
+		return false;
+	}
+
+	BuildAdjacency(indices, indexCount, vertexCount, offsets, live, adjacency);
+	memset(emitted, 0, triangleCount);
+	memset(localIndex, kNoLocalVertex, vertexCount);
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+		const Vec4 a = LoadPosition(mesh, indices[triangle * 3 + 0]);
+		const Vec4 b = LoadPosition(mesh, indices[triangle * 3 + 1]);
+		const Vec4 c = LoadPosition(mesh, indices[triangle * 3 + 2]);
+		normals[triangle] = Normalize3(Cross3(b - a, c - a));
+	}
+
+	MeshletBuilder builder(mesh, indices, settings);
+	builder.offsets = offsets;
+	builder.adjacency = adjacency;
+	builder.normals = normals;
+	builder.live = live;
+	builder.emitted = emitted;
+	builder.localIndex = localIndex;
+	builder.meshlets = outMeshlets;
+	builder.bounds = outBounds;
+	builder.vertices = outVertices;
+	builder.triangles = outTriangles;
+
+	uint32_t cursor = 0;
+	uint32_t triangle = 0;
+	while (triangle != kNoTriangle) {
+		builder.Append(triangle);
+		triangle = builder.FindNext(triangle);
+
+		if (triangle == kNoTriangle) {
+			while (cursor < triangleCount && emitted[cursor]) {
+				++cursor;
+			}
+			triangle = cursor < triangleCount ? cursor : kNoTriangle;
+		}
+	}
+	builder.Finish();
+
+	// Exact sized copy out of the worst case scratch arrays
+	const size_t meshletCount = builder.meshletCount;
+	const size_t meshletBytes = memory::AlignUp(meshletCount * sizeof(Meshlet), memory::EDGE_SIMD_ALIGNMENT);
+	const size_t boundsBytes = meshletCount * sizeof(MeshletBounds);
+	const size_t vertexBytes = memory::AlignUp(builder.GetVertexCount() * sizeof(uint32_t), memory::EDGE_SIMD_ALIGNMENT);
+	const size_t totalBytes = meshletBytes + boundsBytes + vertexBytes + builder.GetTriangleBytes();
+
+	uint8_t* block = static_cast<uint8_t*>(allocator ? allocator->Allocate(totalBytes, tag, memory::EDGE_SIMD_ALIGNMENT)
+		: memory::AllocateTagged(totalBytes, tag, memory::EDGE_SIMD_ALIGNMENT));
+	if (block == nullptr) {
+		return false;
+	}
+
+	meshlets.meshlets = reinterpret_cast<Meshlet*>(block);
+	meshlets.bounds = reinterpret_cast<MeshletBounds*>(block + meshletBytes);
+	meshlets.vertices = reinterpret_cast<uint32_t*>(block + meshletBytes + boundsBytes);
+	meshlets.triangles = block + meshletBytes + boundsBytes + vertexBytes;
+	meshlets.meshletCount = meshletCount;
+	meshlets.vertexCount = builder.GetVertexCount();
+	meshlets.triangleBytes = builder.GetTriangleBytes();
+
+	memcpy(meshlets.meshlets, outMeshlets, meshletCount * sizeof(Meshlet));
+	memcpy(meshlets.bounds, outBounds, boundsBytes);
+	memcpy(meshlets.vertices, outVertices, meshlets.vertexCount * sizeof(uint32_t));
+	memcpy(meshlets.triangles, outTriangles, meshlets.triangleBytes);
+	return true;
+}
+
+void FreeMeshlets(MeshletBuffer& meshlets, memory::IAllocator* allocator) {
+	if (meshlets.meshlets != nullptr) {
+		if (allocator) {
+			allocator->Free(meshlets.meshlets);
+		}
+		else {
+			memory::Free(meshlets.meshlets);
+		}
+	}
+	meshlets = MeshletBuffer();
+}
+
+//==================================================================================================
+// Blob Storage
+//==================================================================================================
+
+namespace {
+
+// Copy a buffer into the blob and point field at it, null buffers stay null
+bool WriteBuffer(memory::BlobWriter& writer, size_t field, const void* data, size_t size, size_t alignment) {
+	if (data == nullptr) {
+		return true;
+	}
+
+	const size_t offset = writer.Write(data, size, alignment);
+	if (offset == 0) {
+		return false;
+	}
+	writer.SetPointer(field, offset);
+	return true;
+}
+
+} // namespace
+
+bool WriteMeshes(memory::BlobWriter& writer, uint32_t sectionId, const Mesh* meshes, size_t count) {
+	const size_t first = writer.Allocate(count * sizeof(Mesh), alignof(Mesh));
+	if (first == 0) {
+		return false;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		const Mesh& mesh = meshes[i];
+		const size_t at = first + i * sizeof(Mesh);
+
+		Mesh& stored = *writer.GetPointer<Mesh>(at);
+		stored = mesh;
+		stored.vertices = nullptr;
+		stored.indices = nullptr;
+		stored.submeshes = nullptr;
+
+		if (!WriteBuffer(writer, at + offsetof(Mesh, vertices), mesh.vertices, mesh.vertexCount * mesh.vertexStride, memory::EDGE_SIMD_ALIGNMENT) ||
+			!WriteBuffer(writer, at + offsetof(Mesh, indices), mesh.indices, mesh.indexCount * sizeof(uint32_t), alignof(uint32_t)) ||
+			!WriteBuffer(writer, at + offsetof(Mesh, submeshes), mesh.submeshes, mesh.submeshCount * sizeof(Submesh), alignof(Submesh))) {
+			return false;
+		}
+	}
+
+	writer.AddSection<Mesh>(sectionId, first, count);
+	return true;
+}
+
+bool WriteMeshlets(memory::BlobWriter& writer, uint32_t sectionId, const MeshletBuffer* meshlets, size_t count) {
+	const size_t first = writer.Allocate(count * sizeof(MeshletBuffer), alignof(MeshletBuffer));
+	if (first == 0) {
+		return false;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		const MeshletBuffer& buffer = meshlets[i];
+		const size_t at = first + i * sizeof(MeshletBuffer);
+
+		MeshletBuffer& stored = *writer.GetPointer<MeshletBuffer>(at);
+		stored.meshletCount = buffer.meshletCount;
+		stored.vertexCount = buffer.vertexCount;
+		stored.triangleBytes = buffer.triangleBytes;
+
+		if (!WriteBuffer(writer, at + offsetof(MeshletBuffer, meshlets), buffer.meshlets, buffer.meshletCount * sizeof(Meshlet), alignof(Meshlet)) ||
+			!WriteBuffer(writer, at + offsetof(MeshletBuffer, bounds), buffer.bounds, buffer.meshletCount * sizeof(MeshletBounds), alignof(MeshletBounds)) ||
+			!WriteBuffer(writer, at + offsetof(MeshletBuffer, vertices), buffer.vertices, buffer.vertexCount * sizeof(uint32_t), alignof(uint32_t)) ||
+			!WriteBuffer(writer, at + offsetof(MeshletBuffer, triangles), buffer.triangles, buffer.triangleBytes, sizeof(uint32_t))) {
+			return false;
+		}
+	}
+
+	writer.AddSection<MeshletBuffer>(sectionId, first, count);
+	return true;
+}
+
+//==================================================================================================
+// Mesh Optimizer
+//==================================================================================================
+
+// Scratch of the thread that called into the optimizer. Only a caller that isn't a worker ever
+// needs it, when the job system runs stage jobs inline, so it is reserved on first use.
+struct MeshOptimizer::CallerScratch {
+	alignas(memory::LinearAllocator) uint8_t storage[sizeof(memory::LinearAllocator)];
+	memory::LinearAllocator* allocator;
+	size_t size;
+
+	explicit CallerScratch(size_t scratchSize) : allocator(nullptr), size(scratchSize) {}
+	~CallerScratch() {
+		if (allocator != nullptr) {
+			allocator->~LinearAllocator();
+		}
+	}
+
+	memory::LinearAllocator& Get() {
+		if (allocator == nullptr) {
+			allocator = new (storage) memory::LinearAllocator(size, memory::MemoryBacking::Virtual);
+		}
+		return *allocator;
+	}
+
+	CallerScratch(const CallerScratch&) = delete;
+	CallerScratch& operator=(const CallerScratch&) = delete;
+};
+
+MeshOptimizer::MeshOptimizer(jobs::JobSystem& jobs, size_t scratchSize)
+	: m_Jobs(jobs), m_Scratch(nullptr), m_ScratchCount(0), m_ScratchSize(scratchSize) {
+
+	// Virtual backing, a worker only commits what its largest mesh touched
+	const uint32_t workerCount = jobs.GetWorkerCount();
+	m_Scratch = static_cast<memory::LinearAllocator*>(memory::Allocate(sizeof(memory::LinearAllocator) * workerCount, alignof(memory::LinearAllocator)));
+	EDGE_ASSERT(m_Scratch != nullptr, "Failed to allocate MeshOptimizer scratch");
+	if (m_Scratch == nullptr) {
+		m_ScratchSize = 0;
+		return;
+	}
+
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		new (&m_Scratch[i]) memory::LinearAllocator(scratchSize, memory::MemoryBacking::Virtual);
+	}
+	m_ScratchCount = workerCount;
+}
+
+MeshOptimizer::~MeshOptimizer() {
+	for (uint32_t i = 0; i < m_ScratchCount; ++i) {
+		m_Scratch[i].~LinearAllocator();
+	}
+	memory::Free(m_Scratch);
+	m_Scratch = nullptr;
+}
+
+bool MeshOptimizer::Optimize(Mesh* meshes, size_t meshCount, const MeshOptimizeSettings& settings) {
+	EDGE_PROFILE_SCOPE("Optimize Meshes");
+
+	CallerScratch callerScratch(m_ScratchSize);
+	std::atomic<bool> failed(false);
+	m_Jobs.ParallelFor(meshCount, GetBatchSize(meshCount), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			if (!OptimizeMesh(meshes[i], settings, callerScratch)) {
+				failed.store(true, std::memory_order_relaxed);
+			}
+		}
+	});
+	return !failed.load(std::memory_order_relaxed);
+}
+
+bool MeshOptimizer::BuildMeshlets(const Mesh* meshes, size_t meshCount, MeshletBuffer* meshlets, const MeshletSettings& settings,
+	memory::IAllocator* allocator, memory::MemoryTag tag) {
+
+	EDGE_PROFILE_SCOPE("Build Meshlets");
+
+	// First output of every mesh
+	size_t* firstOutput = static_cast<size_t*>(memory::Allocate(sizeof(size_t) * (meshCount ? meshCount : 1)));
+	EDGE_ASSERT(firstOutput != nullptr, "Failed to allocate meshlet outputs");
+	if (firstOutput == nullptr) {
+		return false;
+	}
+	size_t outputCount = 0;
+	for (size_t i = 0; i < meshCount; ++i) {
+		firstOutput[i] = outputCount;
+		outputCount += meshes[i].submeshCount ? meshes[i].submeshCount : 1;
+	}
+
+	CallerScratch callerScratch(m_ScratchSize);
+	std::atomic<bool> failed(false);
+	m_Jobs.ParallelFor(meshCount, GetBatchSize(meshCount), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const Mesh& mesh = meshes[i];
+			const Submesh whole = { 0, mesh.indexCount };
+			const Submesh* submeshes = mesh.submeshCount ? mesh.submeshes : &whole;
+			const size_t submeshCount = mesh.submeshCount ? mesh.submeshCount : 1;
+			MeshletBuffer* output = meshlets + firstOutput[i];
+
+			if (GetMeshletScratchSize(mesh, settings) > m_ScratchSize) {
+				EDGE_ASSERT(false, "Mesh needs more scratch than a MeshOptimizer worker has");
+				for (size_t s = 0; s < submeshCount; ++s) {
+					output[s] = MeshletBuffer();
+				}
+				failed.store(true, std::memory_order_relaxed);
+				continue;
+			}
+
+			m_Jobs.ParallelFor(submeshCount, GetBatchSize(submeshCount), [&](size_t first, size_t last) {
+				memory::LinearAllocator& scratch = GetScratch(callerScratch);
+				for (size_t s = first; s < last; ++s) {
+					if (!geometry::BuildMeshlets(output[s], mesh, submeshes[s], settings, scratch, allocator, tag)) {
+						failed.store(true, std::memory_order_relaxed);
+					}
+				}
+			});
+		}
+	});
+
+	memory::Free(firstOutput);
+	return !failed.load(std::memory_order_relaxed);
+}
+
+// Jobs only leave the workers when they run inline on the caller, the only other thread that
+// runs stages
+memory::LinearAllocator& MeshOptimizer::GetScratch(CallerScratch& callerScratch) {
+	const uint32_t worker = m_Jobs.GetCurrentWorker();
+	return worker < m_ScratchCount ? m_Scratch[worker] : callerScratch.Get();
+}
+
+// Enough batches to keep every worker busy without flooding the job pool
+size_t MeshOptimizer::GetBatchSize(size_t count) const {
+	const size_t batchCount = size_t(m_Jobs.GetWorkerCount()) * 8;
+	return count > batchCount ? (count + batchCount - 1) / batchCount : 1;
+}
+
+// Runs inside a job. Nothing holds scratch across the submesh wait, so jobs this worker picks up
+// meanwhile can use the same arena.
+bool MeshOptimizer::OptimizeMesh(Mesh& mesh, const MeshOptimizeSettings& settings, CallerScratch& callerScratch) {
+	if (GetMeshScratchSize(mesh) > m_ScratchSize) {
+		EDGE_ASSERT(false, "Mesh needs more scratch than a MeshOptimizer worker has");
+		return false;
+	}
+
+	if (settings.weld && !WeldVertices(mesh, GetScratch(callerScratch))) {
+		return false;
+	}
+
+	std::atomic<bool> failed(false);
+	if (settings.vertexCache || settings.overdraw) {
+		const Submesh whole = { 0, mesh.indexCount };
+		const Submesh* submeshes = mesh.submeshCount ? mesh.submeshes : &whole;
+		const size_t submeshCount = mesh.submeshCount ? mesh.submeshCount : 1;
+
+		m_Jobs.ParallelFor(submeshCount, GetBatchSize(submeshCount), [&](size_t begin, size_t end) {
+			memory::LinearAllocator& scratch = GetScratch(callerScratch);
+			for (size_t i = begin; i < end; ++i) {
+				if (settings.vertexCache && !OptimizeVertexCache(mesh, submeshes[i], settings.cacheSize, scratch)) {
+					failed.store(true, std::memory_order_relaxed);
+				}
+				if (settings.overdraw && !OptimizeOverdraw(mesh, submeshes[i], settings.cacheSize, settings.overdrawThreshold, scratch)) {
+					failed.store(true, std::memory_order_relaxed);
+				}
+			}
+		});
+	}
+
+	if (settings.vertexFetch && !OptimizeVertexFetch(mesh, GetScratch(callerScratch))) {
+		return false;
+	}
+	return !failed.load(std::memory_order_relaxed);
+}
+
+END_NS_GEOMETRY
+END_NS_EDGE
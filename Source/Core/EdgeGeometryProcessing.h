@@ -1,6 +1,292 @@
+/*
+ * EdgeGeometryProcessing.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Batch geometry kernels and mesh optimization for content processing.
+ *
+ * Responsibilities:
+ * - Provide structure-of-arrays vertex streams in SIMD aligned memory,
+ * - Convert between interleaved vertex buffers and streams,
+ * - Transform and bound whole streams 8 (AVX2) or 4 (SSE, NEON) vertices at a time,
+ * - Weld vertices and reorder indices and vertices for the vertex cache, overdraw and fetch,
+ * - Split meshes into meshlets with bounding spheres and normal cones for GPU culling,
+ * - And run the mesh stages over many meshes and submeshes on the job system.
+ */
+
 #ifndef INC_EDGE_CORE_GEOMETRY_PROCESSING_
 #define INC_EDGE_CORE_GEOMETRY_PROCESSING_
 
+#include "EdgeBlob.h"
 #include "EdgeCore.h"
+#include "EdgeJobSystem.h"
+#include "EdgeMath.h"
+#include "EdgeMemory.h"
+
+BEGIN_NS_EDGE
+BEGIN_NS_GEOMETRY
+
+// Vertices processed per loop iteration of the batch kernels
+#if EDGE_SIMD_AVX2
+constexpr size_t EDGE_GEOMETRY_BATCH_WIDTH = 8;
+#else
+constexpr size_t EDGE_GEOMETRY_BATCH_WIDTH = 4;
+#endif
+
+// Structure-of-arrays view of count 3D vectors, one array per component
+// Kernels take any pointers, streams from AllocateStream start every array on EDGE_SIMD_ALIGNMENT
+// and pad it to a whole batch. A view doesn't own its arrays.
+struct Float3Stream {
+	float* x;
+	float* y;
+	float* z;
+	size_t count;
+
+	Float3Stream() : x(nullptr), y(nullptr), z(nullptr), count(0) {}
+};
+
+// Elements [begin, begin + count) of a stream, for splitting work across jobs
+inline Float3Stream SubStream(const Float3Stream& stream, size_t begin, size_t count) {
+	Float3Stream sub;
+	sub.x = stream.x + begin;
+	sub.y = stream.y + begin;
+	sub.z = stream.z + begin;
+	sub.count = count;
+	return sub;
+}
+
+// One allocation holds all three arrays. The allocator defaults to the global functions and must
+// be passed to FreeStream again.
+bool AllocateStream(Float3Stream& stream, size_t count, memory::IAllocator* allocator = nullptr,
+	memory::MemoryTag tag = memory::MemoryTag::NoTag);
+void FreeStream(Float3Stream& stream, memory::IAllocator* allocator = nullptr);
+
+// Gather the float3 at the start of every stride bytes of vertices into the stream, and back
+void LoadStream(Float3Stream& stream, const void* vertices, size_t stride);
+void StoreStream(const Float3Stream& stream, void* vertices, size_t stride);
+
+// The out stream needs at least in.count elements and may be in itself
+// Points get the full affine transform, vectors skip the translation.
+void TransformPoints(const math::Mat4& transform, const Float3Stream& in, Float3Stream& out);
+void TransformVectors(const math::Mat4& transform, const Float3Stream& in, Float3Stream& out);
+// Transform by the normal matrix of transform and renormalize, zero normals stay zero
+void TransformNormals(const math::Mat4& transform, const Float3Stream& in, Float3Stream& out);
+void NormalizeStream(Float3Stream& stream);
+
+// Component-wise min and max, w is 0. An empty stream gives min FLT_MAX and max -FLT_MAX.
+void ComputeBounds(const Float3Stream& stream, math::Vec4& min, math::Vec4& max);
+
+//==================================================================================================
+// Mesh Optimization
+//
+// The stages rewrite an indexed triangle list in place. Welding merges identical vertices, the
+// vertex cache pass orders triangles with Tipsify (Sander et al.), the overdraw pass sorts the
+// resulting clusters so outward facing ones draw first, and the fetch pass renumbers vertices in
+// the order the indices first use them. Run them in that order, each one keeps the gains of the
+// ones before it.
+//==================================================================================================
+
+// FIFO cache size the triangle orders are tuned for, at or below the cache of every target GPU
+constexpr uint32_t EDGE_GEOMETRY_VERTEX_CACHE_SIZE = 16;
+
+// Scratch every MeshOptimizer worker reserves, committed as it is touched
+constexpr size_t EDGE_GEOMETRY_DEFAULT_SCRATCH_SIZE = size_t(512) * 1024 * 1024;
+
+// Range of a mesh's index buffer drawn on its own, e.g. one material
+struct Submesh {
+	size_t indexOffset;
+	size_t indexCount;
+};
+
+// Indexed triangle list over interleaved vertices with a float3 position at positionOffset
+// Every index must be below vertexCount. Submeshes are optimized independently and keep their
+// index ranges, a mesh without any is one submesh over all of its indices. Welding and fetch
+// reordering lower vertexCount.
+struct Mesh {
+	uint8_t* vertices;
+	size_t vertexCount;
+	size_t vertexStride;
+	size_t positionOffset;
+	uint32_t* indices;
+	size_t indexCount;
+	const Submesh* submeshes;
+	size_t submeshCount;
+
+	Mesh()
+		: vertices(nullptr), vertexCount(0), vertexStride(0), positionOffset(0)
+		, indices(nullptr), indexCount(0), submeshes(nullptr), submeshCount(0) {
+	}
+};
+
+struct MeshOptimizeSettings {
+	bool weld;
+	bool vertexCache;
+	bool overdraw;
+	bool vertexFetch;
+	uint32_t cacheSize;
+	// Per cluster, not per mesh: a cluster may close once its own miss ratio is within this factor
+	// of the incoming order's. The whole mesh's ratio is not bounded and can rise further.
+	float overdrawThreshold;
+
+	MeshOptimizeSettings()
+		: weld(true), vertexCache(true), overdraw(true), vertexFetch(true)
+		, cacheSize(EDGE_GEOMETRY_VERTEX_CACHE_SIZE), overdrawThreshold(1.05f) {
+	}
+};
+
+struct VertexCacheStats {
+	size_t misses;
+	float acmr;		// misses per triangle, 3 at worst and around 0.6 for a well ordered grid
+	float atvr;		// misses per referenced vertex, 1 at best
+};
+
+// Scratch the largest stage needs for this mesh, size a LinearAllocator with it to run the stages
+size_t GetMeshScratchSize(const Mesh& mesh);
+
+// Single mesh stages. Scratch is rewound before they return, and they return false with the mesh
+// untouched if it runs out.
+// Merge vertices whose bytes are identical and point the indices at the survivors
+bool WeldVertices(Mesh& mesh, memory::LinearAllocator& scratch);
+// Reorder the submesh's triangles for a FIFO cache of cacheSize vertices
+bool OptimizeVertexCache(Mesh& mesh, const Submesh& submesh, uint32_t cacheSize, memory::LinearAllocator& scratch);
+// Split the submesh's triangle order into clusters where the cache restarts, or where the cluster
+// alone stays within threshold of the current miss ratio, and draw them outermost first
+bool OptimizeOverdraw(Mesh& mesh, const Submesh& submesh, uint32_t cacheSize, float threshold, memory::LinearAllocator& scratch);
+// Renumber vertices in first use order, vertices no index refers to are dropped
+bool OptimizeVertexFetch(Mesh& mesh, memory::LinearAllocator& scratch);
+
+// Simulate a FIFO cache of cacheSize vertices over the indices
+bool AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize,
+	VertexCacheStats& stats, memory::LinearAllocator& scratch);
+
+//==================================================================================================
+// Meshlets
+//
+// Small clusters of triangles for mesh shaders and compute culling. The descriptors, bounds,
+// vertex list and triangle list upload as four buffers without any conversion.
+//==================================================================================================
+
+// Meshlet limits the builder defaults to, the sizes mesh shader hardware is fastest with
+constexpr uint32_t EDGE_MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t EDGE_MESHLET_MAX_TRIANGLES = 124;
+
+// Ranges of one meshlet in MeshletBuffer::vertices and MeshletBuffer::triangles
+struct Meshlet {
+	uint32_t vertexOffset;
+	uint32_t triangleOffset;		// in bytes, always a multiple of 4
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+};
+
+static_assert(sizeof(Meshlet) == 16, "Meshlet is read as a uint4 on the GPU");
+
+// Culling data, two float4s
+// Every triangle of the meshlet faces away from a camera at position camera if
+// dot(center - camera, coneAxis) >= coneCutoff * length(center - camera) + radius. A cutoff of 1 is
+// a cone too wide to cull.
+struct alignas(16) MeshletBounds {
+	float center[3];
+	float radius;
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+static_assert(sizeof(MeshletBounds) == 32, "MeshletBounds is read as two float4s on the GPU");
+
+struct MeshletSettings {
+	uint32_t maxVertices;		// at most 255, local indices are bytes
+	uint32_t maxTriangles;		// at most 512
+	float coneWeight;			// 0 only packs vertices, higher trades vertex reuse for tighter cones
+
+	MeshletSettings()
+		: maxVertices(EDGE_MESHLET_MAX_VERTICES), maxTriangles(EDGE_MESHLET_MAX_TRIANGLES), coneWeight(0.25f) {
+	}
+};
+
+// One allocation holds all four arrays, meshlets is its start
+struct MeshletBuffer {
+	Meshlet* meshlets;
+	MeshletBounds* bounds;		// one per meshlet
+	uint32_t* vertices;			// mesh vertex index of every meshlet vertex
+	uint8_t* triangles;			// three meshlet vertex indices per triangle
+	size_t meshletCount;
+	size_t vertexCount;
+	size_t triangleBytes;
+
+	MeshletBuffer()
+		: meshlets(nullptr), bounds(nullptr), vertices(nullptr), triangles(nullptr)
+		, meshletCount(0), vertexCount(0), triangleBytes(0) {
+	}
+};
+
+// Scratch BuildMeshlets needs for any submesh of this mesh
+size_t GetMeshletScratchSize(const Mesh& mesh, const MeshletSettings& settings);
+
+// Grow meshlets from the submesh's triangles, best run after the vertex cache pass since a
+// meshlet starts where the index order does. The allocator defaults to the global functions and
+// must be passed to FreeMeshlets again.
+bool BuildMeshlets(MeshletBuffer& meshlets, const Mesh& mesh, const Submesh& submesh, const MeshletSettings& settings,
+	memory::LinearAllocator& scratch, memory::IAllocator* allocator = nullptr, memory::MemoryTag tag = memory::MemoryTag::NoTag);
+void FreeMeshlets(MeshletBuffer& meshlets, memory::IAllocator* allocator = nullptr);
+
+// CPU version of the cone test in MeshletBounds
+inline bool IsMeshletBackFacing(const MeshletBounds& bounds, math::Vec4 camera) {
+	const math::Vec4 toCenter = math::VectorLoad3(bounds.center) - camera;
+	const float distance = math::GetX(math::Length3(toCenter));
+	return math::GetX(math::Dot3(toCenter, math::VectorLoad3(bounds.coneAxis))) >= bounds.coneCutoff * distance + bounds.radius;
+}
+
+//==================================================================================================
+// Blob Storage
+//
+// Processed meshes and meshlets go into a blob as their runtime structs, followed by the buffers
+// they point to. A loaded blob's section is an array of ready structs used in place: don't free
+// or resize their buffers, they belong to the blob.
+//==================================================================================================
+
+// Write the structs back to back as section sectionId and their buffers after them, returns false
+// if the writer ran out of memory
+bool WriteMeshes(memory::BlobWriter& writer, uint32_t sectionId, const Mesh* meshes, size_t count);
+bool WriteMeshlets(memory::BlobWriter& writer, uint32_t sectionId, const MeshletBuffer* meshlets, size_t count);
+
+// Runs the mesh stages over many meshes on a job system
+// Meshes are welded, their submeshes get cache and overdraw orders in parallel, then their
+// vertices are reordered for fetch. Every worker has its own scratch arena, so the stages never
+// touch the heap or a lock. A caller that isn't a worker gets one too if jobs fall back to
+// running inline on it.
+class MeshOptimizer {
+public:
+	explicit MeshOptimizer(jobs::JobSystem& jobs, size_t scratchSize = EDGE_GEOMETRY_DEFAULT_SCRATCH_SIZE);
+	~MeshOptimizer();
+
+	// Optimize all meshes and wait for them, meshes must not share buffers. Returns false if a
+	// mesh needs more scratch than a worker has, that mesh is skipped.
+	bool Optimize(Mesh* meshes, size_t meshCount, const MeshOptimizeSettings& settings = MeshOptimizeSettings());
+
+	// Build one MeshletBuffer per submesh, meshes without submeshes count as one. meshlets holds
+	// them mesh after mesh. The allocator must be thread safe, with the same skipping as Optimize.
+	bool BuildMeshlets(const Mesh* meshes, size_t meshCount, MeshletBuffer* meshlets, const MeshletSettings& settings = MeshletSettings(),
+		memory::IAllocator* allocator = nullptr, memory::MemoryTag tag = memory::MemoryTag::NoTag);
+
+	MeshOptimizer(const MeshOptimizer&) = delete;
+	MeshOptimizer& operator=(const MeshOptimizer&) = delete;
+
+private:
+	struct CallerScratch;
+
+	jobs::JobSystem& m_Jobs;
+	memory::LinearAllocator* m_Scratch;		// one per worker
+	uint32_t m_ScratchCount;
+	size_t m_ScratchSize;
+
+	memory::LinearAllocator& GetScratch(CallerScratch& callerScratch);
+	size_t GetBatchSize(size_t count) const;
+	bool OptimizeMesh(Mesh& mesh, const MeshOptimizeSettings& settings, CallerScratch& callerScratch);
+};
+
+END_NS_GEOMETRY
+END_NS_EDGE
 
-#endif // INC_EDGE_CORE_GEOMETRY_PROCESSING_
\ No newline at end of file
+#endif // INC_EDGE_CORE_GEOMETRY_PROCESSING_
@@ -0,0 +1,147 @@
+/*
+ * EdgeGlobalNew.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Replacement global operator new/delete over the Edge memory system.
+ *
+ */
+
+#include "EdgeMemory.h"
+
+#if EDGE_REPLACE_GLOBAL_NEW
+
+namespace {
+
+#ifdef __STDCPP_DEFAULT_NEW_ALIGNMENT__
+constexpr size_t kNewAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+#else
+constexpr size_t kNewAlignment = alignof(std::max_align_t);
+#endif
+
+// Zero sized requests still need a unique pointer, the sized delete has to agree
+inline size_t NewSize(size_t size) {
+	return size ? size : 1;
+}
+
+// Standard new semantics, the new handler gets a chance to free memory before bad_alloc
+void* AllocateOrThrow(size_t size, size_t alignment) {
+	for (;;) {
+		void* ptr = ::edge::memory::AllocateTagged(NewSize(size), ::edge::memory::GetCurrentTag(), alignment);
+		if (ptr) {
+			return ptr;
+		}
+
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) {
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+}
+
+void* AllocateNoThrow(size_t size, size_t alignment) noexcept {
+	try {
+		return AllocateOrThrow(size, alignment);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+
+} // namespace
+
+//==================================================================================================
+// Replacement Operators
+//==================================================================================================
+
+void* operator new(size_t size) {
+	return AllocateOrThrow(size, kNewAlignment);
+}
+
+void* operator new[](size_t size) {
+	return AllocateOrThrow(size, kNewAlignment);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return AllocateNoThrow(size, kNewAlignment);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return AllocateNoThrow(size, kNewAlignment);
+}
+
+void operator delete(void* ptr) noexcept {
+	::edge::memory::Free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	::edge::memory::Free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	::edge::memory::Free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	::edge::memory::Free(ptr);
+}
+
+// The compiler passes the size given to new, the thread cache can skip the header lookup
+void operator delete(void* ptr, size_t size) noexcept {
+	::edge::memory::Free(ptr, NewSize(size), kNewAlignment);
+}
+
+void operator delete[](void* ptr, size_t size) noexcept {
+	::edge::memory::Free(ptr, NewSize(size), kNewAlignment);
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(size_t size, std::align_val_t alignment) {
+	return AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return AllocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return AllocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+	(void)alignment;
+	::edge::memory::Free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+	(void)alignment;
+	::edge::memory::Free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	(void)alignment;
+	::edge::memory::Free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	(void)alignment;
+	::edge::memory::Free(ptr);
+}
+
+void operator delete(void* ptr, size_t size, std::align_val_t alignment) noexcept {
+	::edge::memory::Free(ptr, NewSize(size), static_cast<size_t>(alignment));
+}
+
+void operator delete[](void* ptr, size_t size, std::align_val_t alignment) noexcept {
+	::edge::memory::Free(ptr, NewSize(size), static_cast<size_t>(alignment));
+}
+#endif // __cpp_aligned_new
+
+#endif // EDGE_REPLACE_GLOBAL_NEW
@@ -0,0 +1,405 @@
+/*
+ * EdgeHeapAllocator.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * General-purpose heap allocators over bounded memory regions.
+ *
+ */
+
+#include "EdgeHeapAllocator.h"
+#include <cstring>
+
+#if EDGE_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+//==================================================================================================
+// Bit Scan Helpers
+//==================================================================================================
+namespace {
+
+// Index of the lowest set bit, value must be non-zero
+inline size_t LowestBit(uint32_t value) {
+#if EDGE_COMPILER_MSVC
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return index;
+#else
+	return static_cast<size_t>(__builtin_ctz(value));
+#endif
+}
+
+// Index of the highest set bit, value must be non-zero
+inline size_t HighestBit(uint32_t value) {
+#if EDGE_COMPILER_MSVC
+	unsigned long index;
+	_BitScanReverse(&index, value);
+	return index;
+#else
+	return static_cast<size_t>(31 - __builtin_clz(value));
+#endif
+}
+
+inline size_t HighestBit64(uint64_t value) {
+#if EDGE_COMPILER_MSVC
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return index;
+#else
+	return static_cast<size_t>(63 - __builtin_clzll(value));
+#endif
+}
+
+} // namespace
+
+//==================================================================================================
+// TLSFAllocator Implementation
+//
+// Every block starts with a 16 byte header: its payload size (bit 0 set while free) and a pointer
+// to the physically previous block. Free blocks keep their free list links in the payload. The
+// region ends with a zero-sized used sentinel, so merging never has to check for the end.
+//==================================================================================================
+
+namespace {
+constexpr size_t kBlockOverhead = sizeof(size_t) + sizeof(void*);	// header in front of every payload
+constexpr size_t kMinPayload = 2 * sizeof(void*);					// room for the free list links
+}
+
+struct TLSFAllocator::Block {
+	size_t sizeAndFlags;
+	Block* prevPhysical;
+
+	// Free blocks only, these overlap the payload
+	Block* nextFree;
+	Block* prevFree;
+
+	static constexpr size_t FREE_BIT = 1;
+
+	size_t Size() const { return sizeAndFlags & ~FREE_BIT; }
+	bool IsFree() const { return (sizeAndFlags & FREE_BIT) != 0; }
+	void SetSize(size_t size) { sizeAndFlags = size | (sizeAndFlags & FREE_BIT); }
+	void SetFree(bool free) { sizeAndFlags = free ? (sizeAndFlags | FREE_BIT) : (sizeAndFlags & ~FREE_BIT); }
+
+	uint8_t* Payload() { return reinterpret_cast<uint8_t*>(this) + kBlockOverhead; }
+	Block* Next() { return reinterpret_cast<Block*>(Payload() + Size()); }
+
+	static Block* FromPayload(void* ptr) {
+		return reinterpret_cast<Block*>(static_cast<uint8_t*>(ptr) - kBlockOverhead);
+	}
+};
+
+namespace {
+
+// First and second level index of the list a block of this size lives in
+inline void MappingInsert(size_t size, size_t& fl, size_t& sl) {
+	if (size < TLSFAllocator::SMALL_BLOCK_SIZE) {
+		fl = 0;
+		sl = size / (TLSFAllocator::SMALL_BLOCK_SIZE / TLSFAllocator::SL_INDEX_COUNT);
+	}
+	else {
+		const size_t high = HighestBit64(size);
+		sl = (size >> (high - TLSFAllocator::SL_INDEX_COUNT_LOG2)) ^ TLSFAllocator::SL_INDEX_COUNT;
+		fl = high - (TLSFAllocator::FL_INDEX_SHIFT - 1);
+	}
+}
+
+// Like MappingInsert, but rounds up so every block in the resulting list is large enough
+inline void MappingSearch(size_t size, size_t& fl, size_t& sl) {
+	if (size >= TLSFAllocator::SMALL_BLOCK_SIZE) {
+		size += (size_t(1) << (HighestBit64(size) - TLSFAllocator::SL_INDEX_COUNT_LOG2)) - 1;
+	}
+	MappingInsert(size, fl, sl);
+}
+
+} // namespace
+
+TLSFAllocator::TLSFAllocator(void* memory, size_t size)
+	: m_Memory(static_cast<uint8_t*>(memory)), m_Size(size), m_OwnsMemory(false) {
+
+	EDGE_ASSERT(m_Memory != nullptr, "TLSFAllocator needs a memory region");
+	Initialize();
+}
+
+TLSFAllocator::TLSFAllocator(size_t size)
+	: m_Size(size), m_OwnsMemory(true) {
+
+	m_Memory = static_cast<uint8_t*>(memory::Allocate(size, EDGE_CACHE_LINE_SIZE));
+	EDGE_ASSERT(m_Memory != nullptr, "Failed to allocate memory for TLSFAllocator");
+	Initialize();
+}
+
+TLSFAllocator::~TLSFAllocator() {
+	if (m_OwnsMemory) {
+		memory::Free(m_Memory);
+	}
+	m_Memory = nullptr;
+}
+
+void TLSFAllocator::Initialize() {
+	static_assert(offsetof(Block, nextFree) == kBlockOverhead, "Block header must be two words");
+
+	m_FlBitmap = 0;
+	memset(m_SlBitmap, 0, sizeof(m_SlBitmap));
+	memset(m_FreeLists, 0, sizeof(m_FreeLists));
+	memset(&m_Stats, 0, sizeof(MemoryStats));
+
+	uint8_t* begin = static_cast<uint8_t*>(AlignPointer(m_Memory, ALIGN_SIZE));
+	uint8_t* end = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(m_Memory + m_Size) & ~(ALIGN_SIZE - 1));
+	if (end <= begin || static_cast<size_t>(end - begin) < 2 * kBlockOverhead + kMinPayload) {
+		EDGE_ASSERT(false, "TLSFAllocator region is too small");
+		return;
+	}
+
+	size_t payload = static_cast<size_t>(end - begin) - 2 * kBlockOverhead;
+	const size_t maxPayload = (size_t(1) << FL_INDEX_MAX) - ALIGN_SIZE;
+	if (payload > maxPayload) {
+		EDGE_ASSERT(false, "TLSFAllocator region is larger than the largest block, the rest is unused");
+		payload = maxPayload;
+	}
+
+	// One free block spanning the region, followed by the sentinel
+	Block* block = reinterpret_cast<Block*>(begin);
+	block->sizeAndFlags = payload;
+	block->prevPhysical = nullptr;
+	block->SetFree(true);
+
+	Block* sentinel = block->Next();
+	sentinel->sizeAndFlags = 0;
+	sentinel->prevPhysical = block;
+
+	InsertFree(block);
+}
+
+void TLSFAllocator::InsertFree(Block* block) {
+	size_t fl, sl;
+	MappingInsert(block->Size(), fl, sl);
+
+	Block* head = m_FreeLists[fl][sl];
+	block->nextFree = head;
+	block->prevFree = nullptr;
+	if (head) {
+		head->prevFree = block;
+	}
+	m_FreeLists[fl][sl] = block;
+
+	m_FlBitmap |= 1u << fl;
+	m_SlBitmap[fl] |= 1u << sl;
+
+	m_Stats.freeSpace += block->Size();
+	m_Stats.freeBlockCount++;
+}
+
+void TLSFAllocator::RemoveFree(Block* block) {
+	size_t fl, sl;
+	MappingInsert(block->Size(), fl, sl);
+
+	if (block->prevFree) {
+		block->prevFree->nextFree = block->nextFree;
+	}
+	else {
+		m_FreeLists[fl][sl] = block->nextFree;
+		if (m_FreeLists[fl][sl] == nullptr) {
+			m_SlBitmap[fl] &= ~(1u << sl);
+			if (m_SlBitmap[fl] == 0) {
+				m_FlBitmap &= ~(1u << fl);
+			}
+		}
+	}
+	if (block->nextFree) {
+		block->nextFree->prevFree = block->prevFree;
+	}
+
+	m_Stats.freeSpace -= block->Size();
+	m_Stats.freeBlockCount--;
+}
+
+TLSFAllocator::Block* TLSFAllocator::FindFree(size_t size) {
+	size_t fl, sl;
+	MappingSearch(size, fl, sl);
+	if (fl >= FL_INDEX_COUNT) {
+		return nullptr;
+	}
+
+	// Try the rest of this first level list, then the next non-empty first level
+	uint32_t slMap = m_SlBitmap[fl] & (~0u << sl);
+	if (slMap == 0) {
+		const uint32_t flMap = fl + 1 < 32 ? m_FlBitmap & (~0u << (fl + 1)) : 0;
+		if (flMap == 0) {
+			return nullptr;
+		}
+		fl = LowestBit(flMap);
+		slMap = m_SlBitmap[fl];
+	}
+	sl = LowestBit(slMap);
+
+	Block* block = m_FreeLists[fl][sl];
+	RemoveFree(block);
+	return block;
+}
+
+// Shrink block to size and return the block made from the rest, which the caller must link.
+TLSFAllocator::Block* TLSFAllocator::Split(Block* block, size_t size) {
+	Block* rest = reinterpret_cast<Block*>(block->Payload() + size);
+	rest->sizeAndFlags = block->Size() - size - kBlockOverhead;
+	rest->prevPhysical = block;
+	rest->Next()->prevPhysical = rest;
+
+	block->SetSize(size);
+	return rest;
+}
+
+// Coalesce a free block with its free physical neighbours, neither may be in a free list yet.
+TLSFAllocator::Block* TLSFAllocator::Merge(Block* block) {
+	Block* prev = block->prevPhysical;
+	if (prev && prev->IsFree()) {
+		RemoveFree(prev);
+		prev->SetSize(prev->Size() + kBlockOverhead + block->Size());
+		prev->Next()->prevPhysical = prev;
+		block = prev;
+	}
+
+	Block* next = block->Next();
+	if (next->IsFree()) {
+		RemoveFree(next);
+		block->SetSize(block->Size() + kBlockOverhead + next->Size());
+		block->Next()->prevPhysical = block;
+	}
+
+	return block;
+}
+
+void* TLSFAllocator::Allocate(size_t size, size_t alignment) {
+	return Allocate(size, MemoryTag::NoTag, alignment);
+}
+
+void* TLSFAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment) {
+	(void)tag;
+
+	if (size == 0) {
+		return nullptr;
+	}
+
+	EDGE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0,
+		"Alignment must be a power of two.");
+
+	const size_t adjusted = AlignUp(size < kMinPayload ? kMinPayload : size, ALIGN_SIZE);
+	Block* block = nullptr;
+
+	if (alignment <= ALIGN_SIZE) {
+		block = FindFree(adjusted);
+	}
+	else {
+		// Search for enough room to split a free block off the front to reach the alignment
+		const size_t gapMinimum = kBlockOverhead + kMinPayload;
+		block = FindFree(adjusted + alignment + gapMinimum);
+		if (block) {
+			uint8_t* payload = block->Payload();
+			size_t gap = static_cast<uint8_t*>(AlignPointer(payload, alignment)) - payload;
+			if (gap && gap < gapMinimum) {
+				gap = static_cast<uint8_t*>(AlignPointer(payload + gapMinimum, alignment)) - payload;
+			}
+			if (gap) {
+				Block* aligned = Split(block, gap - kBlockOverhead);
+				InsertFree(block);
+				block = aligned;
+			}
+		}
+	}
+
+	if (block == nullptr) {
+		EDGE_ASSERT(false, "TLSFAllocator out of memory");
+		return nullptr;
+	}
+
+	// Return the tail to the free lists if it can hold a block of its own
+	if (block->Size() >= adjusted + kBlockOverhead + kMinPayload) {
+		Block* rest = Split(block, adjusted);
+		rest->SetFree(true);
+		InsertFree(rest);
+	}
+	block->SetFree(false);
+
+	// Update stats
+	m_Stats.totalAllocated += block->Size();
+	m_Stats.currentUsage += block->Size();
+	m_Stats.allocationCount++;
+
+	if (m_Stats.currentUsage > m_Stats.peakUsage) {
+		m_Stats.peakUsage = m_Stats.currentUsage;
+	}
+
+	return block->Payload();
+}
+
+void TLSFAllocator::Free(void* ptr) {
+	if (ptr == nullptr) {
+		return;
+	}
+
+	if (static_cast<uint8_t*>(ptr) < m_Memory || static_cast<uint8_t*>(ptr) >= m_Memory + m_Size) {
+		EDGE_ASSERT(false, "Pointer does not belong to this heap");
+		return;
+	}
+
+	Block* block = Block::FromPayload(ptr);
+	if (block->IsFree()) {
+		EDGE_ASSERT(false, "Double free detected!");
+		return;
+	}
+
+	// Update stats
+	m_Stats.totalFreed += block->Size();
+	m_Stats.currentUsage -= block->Size();
+	m_Stats.freeCount++;
+
+	block->SetFree(true);
+	InsertFree(Merge(block));
+}
+
+void TLSFAllocator::Free(void* ptr, size_t size, size_t alignment) {
+	// Coalescing needs the boundary tags either way
+	(void)size;
+	(void)alignment;
+	Free(ptr);
+}
+
+void TLSFAllocator::GetStats(MemoryStats& stats) const {
+	stats = m_Stats;
+
+	// The largest block lives in the highest non-empty list, only that list needs a scan
+	stats.largestFreeBlock = 0;
+	if (m_FlBitmap) {
+		const size_t fl = HighestBit(m_FlBitmap);
+		const size_t sl = HighestBit(m_SlBitmap[fl]);
+		for (const Block* block = m_FreeLists[fl][sl]; block; block = block->nextFree) {
+			if (block->Size() > stats.largestFreeBlock) {
+				stats.largestFreeBlock = block->Size();
+			}
+		}
+	}
+}
+
+void TLSFAllocator::Reset() {
+	MemoryStats previous = m_Stats;
+	Initialize();
+
+	// Keep lifetime totals, every live block counts as freed
+	m_Stats.totalAllocated = previous.totalAllocated;
+	m_Stats.totalFreed = previous.totalFreed + previous.currentUsage;
+	m_Stats.peakUsage = previous.peakUsage;
+	m_Stats.allocationCount = previous.allocationCount;
+	m_Stats.freeCount = previous.allocationCount;
+}
+
+size_t TLSFAllocator::GetBlockSize(void* ptr) const {
+	return ptr ? Block::FromPayload(ptr)->Size() : 0;
+}
+
+END_NS_MEMORY
+END_NS_EDGE
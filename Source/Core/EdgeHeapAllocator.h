@@ -0,0 +1,78 @@
+/*
+ * EdgeHeapAllocator.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * General-purpose heap allocators over bounded memory regions.
+ *
+ * Responsibilities:
+ * - Provide a Two-Level Segregated Fit heap with O(1) allocate and free,
+ * - Support any power-of-two alignment,
+ * - And report fragmentation through MemoryStats.
+ */
+
+#ifndef INC_EDGE_CORE_HEAP_ALLOCATOR_
+#define INC_EDGE_CORE_HEAP_ALLOCATOR_
+
+#include "EdgeMemory.h"
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+// TLSF allocator - general-purpose heap with bounded, deterministic timing
+// Free blocks are binned by a two-level size index (power of two, then 32 linear steps) with a
+// bitmap per level, so finding a fit and coalescing on free are both constant time.
+// Not thread-safe, give each subsystem its own heap.
+class TLSFAllocator : public IAllocator {
+public:
+	// Manage a caller-provided region, which must outlive the allocator
+	TLSFAllocator(void* memory, size_t size);
+	// Manage a region allocated from the system allocator
+	TLSFAllocator(size_t size);
+	~TLSFAllocator() override;
+
+	void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void* Allocate(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void Free(void* ptr) override;
+	void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override; // Blocks carry their size
+	void GetStats(MemoryStats& stats) const override;
+	void Reset() override; // Frees every block at once
+
+	// Usable size of a live block, at least the requested size
+	size_t GetBlockSize(void* ptr) const;
+
+	static constexpr size_t ALIGN_SIZE_LOG2 = 4;
+	static constexpr size_t ALIGN_SIZE = size_t(1) << ALIGN_SIZE_LOG2;
+	static constexpr size_t SL_INDEX_COUNT_LOG2 = 5;
+	static constexpr size_t SL_INDEX_COUNT = size_t(1) << SL_INDEX_COUNT_LOG2;
+	static constexpr size_t FL_INDEX_MAX = 36;	// largest block is 64GB
+	static constexpr size_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2;
+	static constexpr size_t FL_INDEX_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1;
+	static constexpr size_t SMALL_BLOCK_SIZE = size_t(1) << FL_INDEX_SHIFT;
+
+private:
+	struct Block;
+	uint8_t* m_Memory;
+	size_t m_Size;
+	bool m_OwnsMemory;
+
+	uint32_t m_FlBitmap;
+	uint32_t m_SlBitmap[FL_INDEX_COUNT];
+	Block* m_FreeLists[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+	MemoryStats m_Stats;
+
+	void Initialize();
+	void InsertFree(Block* block);
+	void RemoveFree(Block* block);
+	Block* FindFree(size_t size);
+	Block* Split(Block* block, size_t size);
+	Block* Merge(Block* block);
+};
+
+END_NS_MEMORY
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_HEAP_ALLOCATOR_
@@ -0,0 +1,566 @@
+/*
+ * EdgeJobSystem.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Work-stealing job scheduler.
+ *
+ */
+
+#include "EdgeJobSystem.h"
+#include "EdgeProfiler.h"
+#include <cstdio>
+#include <thread>
+
+#if EDGE_ARCH_X64
+#if EDGE_COMPILER_MSVC
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#elif EDGE_ARCH_ARM64 && EDGE_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+BEGIN_NS_EDGE
+BEGIN_NS_JOBS
+
+namespace {
+
+// Failed searches before an idle worker goes to sleep
+constexpr uint32_t kSpinCount = 256;
+
+// Blocks each thread slot may keep in the job pool's magazine, see ConcurrentPoolAllocator
+constexpr size_t kMagazineSlack = 32;
+
+// Worker names for the profiler, they have to outlive every system
+char g_WorkerNames[memory::EDGE_MAX_THREAD_SLOTS][24];
+
+struct CurrentWorker {
+	const JobSystem* system;
+	uint32_t index;
+};
+
+thread_local CurrentWorker t_Worker = { nullptr, JobSystem::NOT_A_WORKER };
+
+uint32_t ResolveWorkerCount(uint32_t workerCount) {
+	if (workerCount == 0) {
+		workerCount = std::thread::hardware_concurrency();
+	}
+	if (workerCount == 0) {
+		workerCount = 1;
+	}
+	return workerCount < memory::EDGE_MAX_THREAD_SLOTS ? workerCount : static_cast<uint32_t>(memory::EDGE_MAX_THREAD_SLOTS);
+}
+
+inline void CpuPause() {
+#if EDGE_ARCH_X64
+	_mm_pause();
+#elif EDGE_ARCH_ARM64 && EDGE_COMPILER_MSVC
+	__yield();
+#elif EDGE_ARCH_ARM64
+	__asm__ volatile("yield");
+#else
+	std::this_thread::yield();
+#endif
+}
+
+} // namespace
+
+//==================================================================================================
+// Work-Stealing Deque
+//
+// Chase-Lev deque in the formulation for weak memory models by Le, Pop, Cohen and Zappa Nardelli.
+// The owner pushes and pops at the bottom, thieves take from the top, and only the last element
+// is contended. The buffer holds every job the system can create, so it never has to grow.
+//==================================================================================================
+
+class WorkDeque {
+public:
+	WorkDeque() : m_Top(0), m_Bottom(0), m_Buffer(nullptr), m_Mask(0) {}
+
+	bool Initialize(size_t capacity) {
+		size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+
+		m_Buffer = static_cast<std::atomic<Job*>*>(memory::Allocate(sizeof(std::atomic<Job*>) * size, memory::EDGE_CACHE_LINE_SIZE));
+		if (m_Buffer == nullptr) {
+			return false;
+		}
+		for (size_t i = 0; i < size; ++i) {
+			new (&m_Buffer[i]) std::atomic<Job*>(nullptr);
+		}
+		m_Mask = static_cast<int64_t>(size - 1);
+		return true;
+	}
+
+	void Release() {
+		memory::Free(m_Buffer);
+		m_Buffer = nullptr;
+	}
+
+	// Owner only
+	void Push(Job* job) {
+		const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+		const int64_t top = m_Top.load(std::memory_order_acquire);
+		EDGE_ASSERT(bottom - top <= m_Mask, "Work deque overflow");
+		(void)top;
+
+		m_Buffer[bottom & m_Mask].store(job, std::memory_order_relaxed);
+		// Publishes the job's contents along with the slot
+		m_Bottom.store(bottom + 1, std::memory_order_release);
+	}
+
+	// Owner only, newest job first
+	Job* Pop() {
+		const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		m_Bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_Top.load(std::memory_order_relaxed);
+
+		if (top > bottom) {
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = m_Buffer[bottom & m_Mask].load(std::memory_order_relaxed);
+		if (top == bottom) {
+			// Last job, race the thieves for it
+			if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				job = nullptr;
+			}
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	// Any thread, oldest job first. nullptr when empty or when another thread won the race.
+	Job* Steal() {
+		int64_t top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom) {
+			return nullptr;
+		}
+
+		Job* job = m_Buffer[top & m_Mask].load(std::memory_order_relaxed);
+		if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		return job;
+	}
+
+	bool IsEmpty() const {
+		return m_Bottom.load(std::memory_order_relaxed) <= m_Top.load(std::memory_order_relaxed);
+	}
+
+	WorkDeque(const WorkDeque&) = delete;
+	WorkDeque& operator=(const WorkDeque&) = delete;
+
+private:
+	alignas(memory::EDGE_CACHE_LINE_SIZE) std::atomic<int64_t> m_Top;
+	alignas(memory::EDGE_CACHE_LINE_SIZE) std::atomic<int64_t> m_Bottom;
+	std::atomic<Job*>* m_Buffer;
+	int64_t m_Mask;
+};
+
+//==================================================================================================
+// Workers
+//==================================================================================================
+
+struct alignas(memory::EDGE_CACHE_LINE_SIZE) JobSystem::Worker {
+	WorkDeque deque;
+	std::atomic<Job*> mailbox;		// jobs pinned to this worker, pushed by any thread
+	Job* pinned;					// mailbox jobs taken by the owner, oldest first
+	uint32_t random;				// victim selection
+	std::thread thread;
+
+	Worker() : mailbox(nullptr), pinned(nullptr), random(0) {}
+};
+
+JobSystem::JobSystem(uint32_t workerCount, size_t jobCapacity, size_t arenaSize, size_t frameCount)
+	: m_JobPool(sizeof(Job), jobCapacity + kMagazineSlack * (memory::EDGE_MAX_THREAD_SLOTS + 1), alignof(Job))
+	, m_Arena(arenaSize, ResolveWorkerCount(workerCount), frameCount)
+	, m_Workers(nullptr), m_WorkerCount(0), m_SharedHead(nullptr), m_SharedTail(nullptr), m_SharedCount(0)
+	, m_WorkEpoch(0), m_IdleWorkers(0), m_DoneWaiters(0), m_Quit(false) {
+
+	EDGE_ASSERT(t_Worker.system == nullptr, "The calling thread is already a worker of another JobSystem");
+
+	workerCount = ResolveWorkerCount(workerCount);
+	m_Workers = static_cast<Worker*>(memory::Allocate(sizeof(Worker) * workerCount, alignof(Worker)));
+	EDGE_ASSERT(m_Workers != nullptr, "Failed to allocate JobSystem workers");
+	if (m_Workers == nullptr) {
+		return;
+	}
+
+	// The pool holds every job, so a deque the size of the pool can't overflow
+	const size_t dequeCapacity = jobCapacity + kMagazineSlack * (memory::EDGE_MAX_THREAD_SLOTS + 1);
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		Worker* worker = new (&m_Workers[i]) Worker();
+		worker->random = 0x9E3779B9u * (i + 1);
+		if (!worker->deque.Initialize(dequeCapacity)) {
+			EDGE_ASSERT(false, "Failed to allocate a JobSystem work deque");
+			worker->~Worker();
+			break;
+		}
+		snprintf(g_WorkerNames[i], sizeof(g_WorkerNames[i]), "Job Worker %u", i);
+		m_WorkerCount = i + 1;
+	}
+
+	t_Worker.system = this;
+	t_Worker.index = 0;
+
+	for (uint32_t i = 1; i < m_WorkerCount; ++i) {
+		m_Workers[i].thread = std::thread(&JobSystem::WorkerMain, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	EDGE_ASSERT(GetCurrentWorker() == 0, "JobSystem must be destroyed by the thread that created it");
+
+	m_Quit.store(true, std::memory_order_seq_cst);
+	NotifyWork(true);
+
+	for (uint32_t i = 1; i < m_WorkerCount; ++i) {
+		m_Workers[i].thread.join();
+	}
+
+	for (uint32_t i = 0; i < m_WorkerCount; ++i) {
+		Worker& worker = m_Workers[i];
+		EDGE_ASSERT(worker.deque.IsEmpty() && worker.pinned == nullptr && worker.mailbox.load() == nullptr,
+			"JobSystem destroyed with jobs still queued");
+		worker.deque.Release();
+		worker.~Worker();
+	}
+	EDGE_ASSERT(m_SharedHead == nullptr, "JobSystem destroyed with jobs still queued");
+
+	memory::Free(m_Workers);
+	m_Workers = nullptr;
+
+	if (t_Worker.system == this) {
+		t_Worker.system = nullptr;
+		t_Worker.index = NOT_A_WORKER;
+	}
+}
+
+uint32_t JobSystem::GetCurrentWorker() const {
+	return t_Worker.system == this ? t_Worker.index : NOT_A_WORKER;
+}
+
+void JobSystem::BeginFrame() {
+	m_Arena.BeginFrame();
+}
+
+//==================================================================================================
+// Submission
+//==================================================================================================
+
+// Both allocations fail quietly, running the job inline is the fallback
+Job* JobSystem::AllocateJob() {
+	return static_cast<Job*>(m_JobPool.TryAllocate(sizeof(Job), alignof(Job)));
+}
+
+// Workers own the slice of their index, threads outside the system share the overflow slice
+void* JobSystem::AllocateClosure(size_t size, size_t alignment) {
+	return m_Arena.TryAllocateFromSlice(GetCurrentWorker(), size, alignment);
+}
+
+void JobSystem::ReleaseJob(Job* job) {
+	m_JobPool.Free(job, sizeof(Job), alignof(Job));
+}
+
+void JobSystem::InitJob(Job* job, JobFunction function, void* data, JobCounter* counter, uint32_t affinity) {
+	job->function = function;
+	job->data = data;
+	job->counter = counter;
+	job->next = nullptr;
+	job->affinity = affinity < m_WorkerCount ? affinity : ANY_WORKER;
+
+	// Published to whoever runs the job by the push that schedules it
+	if (counter != nullptr) {
+		counter->m_State.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void JobSystem::Run(JobFunction function, void* data, JobCounter* counter, uint32_t affinity) {
+	Job* job = AllocateJob();
+	if (job == nullptr) {
+		function(data);
+		return;
+	}
+
+	InitJob(job, function, data, counter, affinity);
+	Schedule(job);
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, JobFunction function, void* data, JobCounter* counter, uint32_t affinity) {
+	Job* job = AllocateJob();
+	if (job == nullptr) {
+		Wait(dependency);
+		function(data);
+		return;
+	}
+
+	InitJob(job, function, data, counter, affinity);
+	AddDependent(dependency, job);
+}
+
+void JobSystem::Schedule(Job* job) {
+	if (job->affinity != ANY_WORKER) {
+		std::atomic<Job*>& mailbox = m_Workers[job->affinity].mailbox;
+		Job* head = mailbox.load(std::memory_order_relaxed);
+		do {
+			job->next = head;
+		} while (!mailbox.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+
+		// Only the target can run it, a single wakeup could go to another worker
+		NotifyWork(true);
+		return;
+	}
+
+	const uint32_t worker = GetCurrentWorker();
+	if (worker != NOT_A_WORKER) {
+		m_Workers[worker].deque.Push(job);
+	}
+	else {
+		std::lock_guard<std::mutex> lock(m_SharedLock);
+		job->next = nullptr;
+		if (m_SharedTail != nullptr) {
+			m_SharedTail->next = job;
+		}
+		else {
+			m_SharedHead = job;
+		}
+		m_SharedTail = job;
+		m_SharedCount.fetch_add(1, std::memory_order_release);
+	}
+
+	NotifyWork(false);
+}
+
+void JobSystem::ScheduleList(Job* list) {
+	while (list != nullptr) {
+		Job* next = list->next;
+		Schedule(list);
+		list = next;
+	}
+}
+
+// The dependent is pushed before the counter is checked and the last job's completion swaps the
+// list out after its count hits zero, so one of the two always finds it. Both may drain, each
+// job is still taken only once.
+void JobSystem::AddDependent(JobCounter& dependency, Job* job) {
+	Job* head = dependency.m_Dependents.load(std::memory_order_relaxed);
+	do {
+		job->next = head;
+	} while (!dependency.m_Dependents.compare_exchange_weak(head, job, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+	if ((dependency.m_State.load(std::memory_order_seq_cst) & JobCounter::COUNT_MASK) == 0) {
+		ScheduleList(dependency.m_Dependents.exchange(nullptr, std::memory_order_acquire));
+	}
+}
+
+// The epoch bump pairs with the check a worker makes before sleeping, so a job pushed while a
+// worker heads to sleep either gets found or wakes it
+void JobSystem::NotifyWork(bool wakeAll) {
+	m_WorkEpoch.fetch_add(1, std::memory_order_seq_cst);
+	if (m_IdleWorkers.load(std::memory_order_seq_cst) == 0) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepLock);
+	}
+	if (wakeAll) {
+		m_WorkCondition.notify_all();
+	}
+	else {
+		m_WorkCondition.notify_one();
+	}
+}
+
+//==================================================================================================
+// Execution
+//==================================================================================================
+
+Job* JobSystem::PopShared() {
+	if (m_SharedCount.load(std::memory_order_acquire) == 0) {
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(m_SharedLock);
+	Job* job = m_SharedHead;
+	if (job != nullptr) {
+		m_SharedHead = job->next;
+		if (m_SharedHead == nullptr) {
+			m_SharedTail = nullptr;
+		}
+		m_SharedCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+// Pinned jobs first, then the own deque, the shared queue and finally the other workers
+Job* JobSystem::FindJob(uint32_t index) {
+	Worker& worker = m_Workers[index];
+
+	if (worker.pinned == nullptr && worker.mailbox.load(std::memory_order_relaxed) != nullptr) {
+		// The mailbox is newest first, reverse it so pinned jobs run in submission order
+		Job* list = worker.mailbox.exchange(nullptr, std::memory_order_acquire);
+		while (list != nullptr) {
+			Job* next = list->next;
+			list->next = worker.pinned;
+			worker.pinned = list;
+			list = next;
+		}
+	}
+	if (worker.pinned != nullptr) {
+		Job* job = worker.pinned;
+		worker.pinned = job->next;
+		return job;
+	}
+
+	if (Job* job = worker.deque.Pop()) {
+		return job;
+	}
+	if (Job* job = PopShared()) {
+		return job;
+	}
+
+	if (m_WorkerCount > 1) {
+		// xorshift, a random first victim keeps thieves from piling onto the same deque
+		uint32_t random = worker.random;
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+		worker.random = random;
+
+		const uint32_t first = random % m_WorkerCount;
+		for (uint32_t i = 0; i < m_WorkerCount; ++i) {
+			const uint32_t victim = (first + i) % m_WorkerCount;
+			if (victim == index) {
+				continue;
+			}
+			if (Job* job = m_Workers[victim].deque.Steal()) {
+				return job;
+			}
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::Execute(Job* job) {
+	JobCounter* counter = job->counter;
+
+	{
+		EDGE_PROFILE_SCOPE("Job");
+		job->function(job->data);
+	}
+
+	ReleaseJob(job);
+	if (counter != nullptr) {
+		Complete(*counter);
+	}
+}
+
+void JobSystem::Complete(JobCounter& counter) {
+	// Drop the job and mark this thread busy with the counter in one step
+	const uint64_t previous = counter.m_State.fetch_add(JobCounter::BUSY_ONE - 1, std::memory_order_seq_cst);
+	Job* dependents = nullptr;
+	if ((previous & JobCounter::COUNT_MASK) == 1) {
+		dependents = counter.m_Dependents.exchange(nullptr, std::memory_order_acquire);
+	}
+
+	// The counter may be gone once this lands, a dependent's Wait can return right after
+	const uint64_t remaining = counter.m_State.fetch_sub(JobCounter::BUSY_ONE, std::memory_order_seq_cst) - JobCounter::BUSY_ONE;
+	ScheduleList(dependents);
+
+	if (remaining == 0 && m_DoneWaiters.load(std::memory_order_seq_cst) != 0) {
+		{
+			std::lock_guard<std::mutex> lock(m_SleepLock);
+		}
+		m_DoneCondition.notify_all();
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	if (counter.IsDone()) {
+		return;
+	}
+
+	const uint32_t worker = GetCurrentWorker();
+	if (worker != NOT_A_WORKER) {
+		EDGE_PROFILE_SCOPE("Job Wait");
+
+		uint32_t spins = 0;
+		while (!counter.IsDone()) {
+			if (Job* job = FindJob(worker)) {
+				Execute(job);
+				spins = 0;
+			}
+			else if (++spins < kSpinCount) {
+				CpuPause();
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		return;
+	}
+
+	// Pairs with the waiter check in Complete
+	m_DoneWaiters.fetch_add(1, std::memory_order_seq_cst);
+	{
+		std::unique_lock<std::mutex> lock(m_SleepLock);
+		while (counter.m_State.load(std::memory_order_seq_cst) != 0) {
+			m_DoneCondition.wait(lock);
+		}
+	}
+	m_DoneWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void JobSystem::WorkerMain(uint32_t index) {
+	t_Worker.system = this;
+	t_Worker.index = index;
+	EDGE_PROFILE_THREAD_NAME(g_WorkerNames[index]);
+
+	uint32_t spins = 0;
+	while (!m_Quit.load(std::memory_order_relaxed)) {
+		if (Job* job = FindJob(index)) {
+			Execute(job);
+			spins = 0;
+			continue;
+		}
+		if (++spins < kSpinCount) {
+			CpuPause();
+			continue;
+		}
+		spins = 0;
+
+		// Anything pushed after this load moves the epoch, so the last search below can't miss a
+		// job without the sleep seeing the epoch change
+		const uint64_t epoch = m_WorkEpoch.load(std::memory_order_seq_cst);
+		if (Job* job = FindJob(index)) {
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_SleepLock);
+		m_IdleWorkers.fetch_add(1, std::memory_order_seq_cst);
+		while (m_WorkEpoch.load(std::memory_order_seq_cst) == epoch && !m_Quit.load(std::memory_order_relaxed)) {
+			m_WorkCondition.wait(lock);
+		}
+		m_IdleWorkers.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	t_Worker.system = nullptr;
+	t_Worker.index = NOT_A_WORKER;
+}
+
+END_NS_JOBS
+END_NS_EDGE
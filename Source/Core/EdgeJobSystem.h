@@ -0,0 +1,238 @@
+/*
+ * EdgeJobSystem.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Work-stealing job scheduler.
+ *
+ * Responsibilities:
+ * - Run jobs on a fixed set of worker threads with per-worker work-stealing deques,
+ * - Track completion with job counters and start dependent jobs when a counter reaches zero,
+ * - Pin jobs to a worker for thread-affine work,
+ * - And keep jobs and closures in pool and frame memory, off the global heap.
+ */
+
+#ifndef INC_EDGE_CORE_JOB_SYSTEM_
+#define INC_EDGE_CORE_JOB_SYSTEM_
+
+#include "EdgeMemory.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+BEGIN_NS_EDGE
+BEGIN_NS_JOBS
+
+// Closures up to this size live inside the job, larger ones go to the frame arena
+constexpr size_t EDGE_JOB_PAYLOAD_SIZE = 80;
+
+// Default number of jobs that can be queued or running at once
+constexpr size_t EDGE_JOB_DEFAULT_CAPACITY = 4096;
+
+// Default closure arena per worker and frame
+constexpr size_t EDGE_JOB_DEFAULT_ARENA_SIZE = 64 * 1024;
+
+using JobFunction = void (*)(void* data);
+
+class JobCounter;
+
+// One unit of work, two cache lines including the inline closure storage.
+// Created by JobSystem::Run, user code never needs to touch one.
+struct alignas(memory::EDGE_CACHE_LINE_SIZE) Job {
+	JobFunction function;
+	void* data;
+	JobCounter* counter;		// completed when the job has run
+	Job* next;					// link in a mailbox, the shared queue or a counter's dependents
+	uint32_t affinity;
+	alignas(16) uint8_t payload[EDGE_JOB_PAYLOAD_SIZE];
+};
+
+static_assert(sizeof(Job) == 2 * memory::EDGE_CACHE_LINE_SIZE, "Job should stay two cache lines");
+
+// Outstanding job count
+// Every job run with a counter adds one and removes it when it finishes. A counter that reaches
+// zero starts the jobs queued on it with RunAfter. All jobs of a counter must be added before the
+// first dependent, and the counter must outlive its jobs, Wait guarantees that.
+class JobCounter {
+public:
+	JobCounter() : m_State(0), m_Dependents(nullptr) {}
+	~JobCounter() {
+		EDGE_ASSERT(IsDone(), "JobCounter destroyed with jobs still attached");
+	}
+
+	bool IsDone() const { return m_State.load(std::memory_order_acquire) == 0; }
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_State.load(std::memory_order_relaxed) & COUNT_MASK); }
+
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+private:
+	friend class JobSystem;
+
+	// Pending jobs in the low half, threads still finishing a job of this counter in the high
+	// half, so Wait doesn't return while a finishing thread is still reading the counter
+	static constexpr uint64_t COUNT_MASK = 0xFFFFFFFFull;
+	static constexpr uint64_t BUSY_ONE = uint64_t(1) << 32;
+
+	std::atomic<uint64_t> m_State;
+	std::atomic<Job*> m_Dependents;
+};
+
+// Work-stealing job scheduler
+// Every worker owns a Chase-Lev deque: it pushes and pops its own jobs at the bottom without
+// contention, idle workers steal from the top of the others. Jobs run from a thread that isn't
+// a worker go through a shared queue. Waiting on a worker runs other jobs until the counter is
+// done, so a job may wait on the jobs it spawned. Other threads block in Wait.
+// The thread that creates the system is worker 0. It has a deque but no thread of its own, so it
+// only runs jobs while it waits, and it is the only thread that may destroy the system.
+class JobSystem {
+public:
+	static constexpr uint32_t ANY_WORKER = ~0u;
+	static constexpr uint32_t NOT_A_WORKER = ~0u;
+
+	// workerCount includes the creating thread, 0 uses one worker per hardware thread
+	explicit JobSystem(uint32_t workerCount = 0, size_t jobCapacity = EDGE_JOB_DEFAULT_CAPACITY,
+		size_t arenaSize = EDGE_JOB_DEFAULT_ARENA_SIZE, size_t frameCount = 2);
+	// Every job must have finished
+	~JobSystem();
+
+	// Run function(data), data stays owned by the caller
+	void Run(JobFunction function, void* data, JobCounter* counter = nullptr, uint32_t affinity = ANY_WORKER);
+	// Run function(data) once dependency reaches zero
+	void RunAfter(JobCounter& dependency, JobFunction function, void* data, JobCounter* counter = nullptr, uint32_t affinity = ANY_WORKER);
+
+	// Run a callable, it is moved into the job and destroyed after it has run
+	template<typename F>
+	void Run(F&& function, JobCounter* counter = nullptr, uint32_t affinity = ANY_WORKER) {
+		if (Job* job = CreateJob(std::forward<F>(function), counter, affinity)) {
+			Schedule(job);
+		}
+		else {
+			function();
+		}
+	}
+
+	template<typename F>
+	void RunAfter(JobCounter& dependency, F&& function, JobCounter* counter = nullptr, uint32_t affinity = ANY_WORKER) {
+		if (Job* job = CreateJob(std::forward<F>(function), counter, affinity)) {
+			AddDependent(dependency, job);
+		}
+		else {
+			Wait(dependency);
+			function();
+		}
+	}
+
+	// Call body(begin, end) over [0, count) in batches of batchSize and wait for all of them
+	template<typename F>
+	void ParallelFor(size_t count, size_t batchSize, const F& body) {
+		if (batchSize == 0) {
+			batchSize = 1;
+		}
+
+		JobCounter counter;
+		for (size_t begin = 0; begin < count; begin += batchSize) {
+			const size_t end = count - begin > batchSize ? begin + batchSize : count;
+			Run([&body, begin, end]() { body(begin, end); }, &counter);
+		}
+		Wait(counter);
+	}
+
+	// Return once the counter is done. Workers run other jobs meanwhile, other threads sleep.
+	void Wait(JobCounter& counter);
+
+	// Recycle the oldest closure arena. Call at a frame sync point, no job may be older than
+	// frameCount frames.
+	void BeginFrame();
+
+	uint32_t GetWorkerCount() const { return m_WorkerCount; }
+	// Index of the calling thread in this system, NOT_A_WORKER for other threads.
+	// Jobs only ever run on workers, so inside a job it is always below GetWorkerCount.
+	uint32_t GetCurrentWorker() const;
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+private:
+	struct Worker;
+
+	memory::ConcurrentPoolAllocator m_JobPool;
+	memory::FrameAllocator m_Arena;				// closures too large for a job, one slice per worker
+	Worker* m_Workers;
+	uint32_t m_WorkerCount;
+
+	// Jobs run from threads that aren't workers
+	std::mutex m_SharedLock;
+	Job* m_SharedHead;
+	Job* m_SharedTail;
+	std::atomic<size_t> m_SharedCount;
+
+	// Sleeping workers wait for the work epoch to move, threads outside the system wait for a
+	// counter to finish
+	std::mutex m_SleepLock;
+	std::condition_variable m_WorkCondition;
+	std::condition_variable m_DoneCondition;
+	std::atomic<uint64_t> m_WorkEpoch;
+	std::atomic<uint32_t> m_IdleWorkers;
+	std::atomic<uint32_t> m_DoneWaiters;
+	std::atomic<bool> m_Quit;
+
+	template<typename F>
+	static void InvokeClosure(void* data) {
+		F& closure = *static_cast<F*>(data);
+		closure();
+		closure.~F();
+	}
+
+	// nullptr when the job pool or the arena is exhausted, the callers then run the callable
+	// inline and leave it untouched
+	template<typename F>
+	Job* CreateJob(F&& function, JobCounter* counter, uint32_t affinity) {
+		using Closure = typename std::decay<F>::type;
+
+		Job* job = AllocateJob();
+		if (job == nullptr) {
+			return nullptr;
+		}
+
+		void* storage = job->payload;
+		if (sizeof(Closure) > EDGE_JOB_PAYLOAD_SIZE || alignof(Closure) > 16) {
+			storage = AllocateClosure(sizeof(Closure), alignof(Closure));
+			if (storage == nullptr) {
+				ReleaseJob(job);
+				return nullptr;
+			}
+		}
+
+		new (storage) Closure(std::forward<F>(function));
+		InitJob(job, &InvokeClosure<Closure>, storage, counter, affinity);
+		return job;
+	}
+
+	Job* AllocateJob();
+	void ReleaseJob(Job* job);
+	void* AllocateClosure(size_t size, size_t alignment);
+	void InitJob(Job* job, JobFunction function, void* data, JobCounter* counter, uint32_t affinity);
+	void Schedule(Job* job);
+	void ScheduleList(Job* list);
+	void AddDependent(JobCounter& dependency, Job* job);
+	void NotifyWork(bool wakeAll);
+
+	Job* FindJob(uint32_t worker);
+	Job* PopShared();
+	void Execute(Job* job);
+	void Complete(JobCounter& counter);
+	void WorkerMain(uint32_t worker);
+};
+
+END_NS_JOBS
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_JOB_SYSTEM_
@@ -0,0 +1,641 @@
+/*
+ * EdgeMath.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * SIMD vector math.
+ *
+ * Responsibilities:
+ * - Provide a four-wide vector type over SSE on x64 and NEON on ARM64,
+ * - Provide quaternions and column-major 4x4 matrices on top of it,
+ * - And keep every operation inline and in registers, with no scalar fallback to maintain.
+ */
+
+#ifndef INC_EDGE_CORE_MATH_
+#define INC_EDGE_CORE_MATH_
+
+#include "EdgeCore.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+#if EDGE_SIMD_NEON
+#include <arm_neon.h>
+#elif EDGE_COMPILER_MSVC
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+BEGIN_NS_EDGE
+BEGIN_NS_MATH
+
+#if EDGE_SIMD_NEON
+using VectorRegister = float32x4_t;
+#else
+using VectorRegister = __m128;
+#endif
+
+// Four floats in one SIMD register. Operations that reduce to a scalar, like Dot3, return it
+// splatted to all lanes so chains stay in registers, GetX pulls it out.
+struct Vec4 {
+	VectorRegister v;
+
+	Vec4() = default;
+	Vec4(VectorRegister value) : v(value) {}
+	operator VectorRegister() const { return v; }
+};
+
+// Rotation quaternion, (x, y, z) is the vector part and w the scalar part
+struct Quat {
+	Vec4 v;
+
+	Quat() = default;
+	explicit Quat(Vec4 value) : v(value) {}
+};
+
+// Column-major 4x4 matrix for column vectors, TransformPoint computes M * (x, y, z, 1).
+// Column 3 holds the translation of an affine transform.
+struct Mat4 {
+	Vec4 c[4];
+};
+
+//==================================================================================================
+// Vector Construction and Access
+//==================================================================================================
+
+inline Vec4 VectorZero() {
+#if EDGE_SIMD_NEON
+	return vdupq_n_f32(0.0f);
+#else
+	return _mm_setzero_ps();
+#endif
+}
+
+inline Vec4 VectorSet(float x, float y, float z, float w) {
+#if EDGE_SIMD_NEON
+	const float values[4] = { x, y, z, w };
+	return vld1q_f32(values);
+#else
+	return _mm_set_ps(w, z, y, x);
+#endif
+}
+
+inline Vec4 VectorSplat(float value) {
+#if EDGE_SIMD_NEON
+	return vdupq_n_f32(value);
+#else
+	return _mm_set1_ps(value);
+#endif
+}
+
+// ptr must be 16 byte aligned
+inline Vec4 VectorLoad(const float* ptr) {
+#if EDGE_SIMD_NEON
+	return vld1q_f32(ptr);
+#else
+	return _mm_load_ps(ptr);
+#endif
+}
+
+inline Vec4 VectorLoadUnaligned(const float* ptr) {
+#if EDGE_SIMD_NEON
+	return vld1q_f32(ptr);
+#else
+	return _mm_loadu_ps(ptr);
+#endif
+}
+
+// Three floats, w is 0. Never reads past ptr[2].
+inline Vec4 VectorLoad3(const float* ptr) {
+#if EDGE_SIMD_NEON
+	const float32x2_t xy = vld1_f32(ptr);
+	const float32x2_t z0 = vld1_lane_f32(ptr + 2, vdup_n_f32(0.0f), 0);
+	return vcombine_f32(xy, z0);
+#else
+	const __m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(ptr)));
+	const __m128 z = _mm_load_ss(ptr + 2);
+	return _mm_movelh_ps(xy, z);
+#endif
+}
+
+// ptr must be 16 byte aligned
+inline void VectorStore(float* ptr, Vec4 value) {
+#if EDGE_SIMD_NEON
+	vst1q_f32(ptr, value.v);
+#else
+	_mm_store_ps(ptr, value.v);
+#endif
+}
+
+inline void VectorStoreUnaligned(float* ptr, Vec4 value) {
+#if EDGE_SIMD_NEON
+	vst1q_f32(ptr, value.v);
+#else
+	_mm_storeu_ps(ptr, value.v);
+#endif
+}
+
+// Writes x, y and z only
+inline void VectorStore3(float* ptr, Vec4 value) {
+#if EDGE_SIMD_NEON
+	vst1_f32(ptr, vget_low_f32(value.v));
+	vst1q_lane_f32(ptr + 2, value.v, 2);
+#else
+	_mm_store_sd(reinterpret_cast<double*>(ptr), _mm_castps_pd(value.v));
+	_mm_store_ss(ptr + 2, _mm_movehl_ps(value.v, value.v));
+#endif
+}
+
+inline float GetX(Vec4 value) {
+#if EDGE_SIMD_NEON
+	return vgetq_lane_f32(value.v, 0);
+#else
+	return _mm_cvtss_f32(value.v);
+#endif
+}
+
+inline float GetY(Vec4 value) {
+#if EDGE_SIMD_NEON
+	return vgetq_lane_f32(value.v, 1);
+#else
+	return _mm_cvtss_f32(_mm_shuffle_ps(value.v, value.v, _MM_SHUFFLE(1, 1, 1, 1)));
+#endif
+}
+
+inline float GetZ(Vec4 value) {
+#if EDGE_SIMD_NEON
+	return vgetq_lane_f32(value.v, 2);
+#else
+	return _mm_cvtss_f32(_mm_movehl_ps(value.v, value.v));
+#endif
+}
+
+inline float GetW(Vec4 value) {
+#if EDGE_SIMD_NEON
+	return vgetq_lane_f32(value.v, 3);
+#else
+	return _mm_cvtss_f32(_mm_shuffle_ps(value.v, value.v, _MM_SHUFFLE(3, 3, 3, 3)));
+#endif
+}
+
+inline Vec4 SplatX(Vec4 value) {
+#if EDGE_SIMD_NEON
+	return vdupq_laneq_f32(value.v, 0);
+#else
+	return _mm_shuffle_ps(value.v, value.v, _MM_SHUFFLE(0, 0, 0, 0));
+#endif
+}
+
+inline Vec4 SplatY(Vec4 value) {
+#if EDGE_SIMD_NEON
+	return vdupq_laneq_f32(value.v, 1);
+#else
+	return _mm_shuffle_ps(value.v, value.v, _MM_SHUFFLE(1, 1, 1, 1));
+#endif
+}
+
+inline Vec4 SplatZ(Vec4 value) {
+#if EDGE_SIMD_NEON
+	return vdupq_laneq_f32(value.v, 2);
+#else
+	return _mm_shuffle_ps(value.v, value.v, _MM_SHUFFLE(2, 2, 2, 2));
+#endif
+}
+
+inline Vec4 SplatW(Vec4 value) {
+#if EDGE_SIMD_NEON
+	return vdupq_laneq_f32(value.v, 3);
+#else
+	return _mm_shuffle_ps(value.v, value.v, _MM_SHUFFLE(3, 3, 3, 3));
+#endif
+}
+
+// value with its w replaced by w's x lane
+inline Vec4 VectorSetW(Vec4 value, Vec4 w) {
+#if EDGE_SIMD_NEON
+	return vsetq_lane_f32(vgetq_lane_f32(w.v, 0), value.v, 3);
+#elif EDGE_SIMD_SSE4
+	return _mm_blend_ps(value.v, _mm_shuffle_ps(w.v, w.v, _MM_SHUFFLE(0, 0, 0, 0)), 0x8);
+#else
+	const __m128 zw = _mm_unpackhi_ps(value.v, _mm_shuffle_ps(w.v, w.v, _MM_SHUFFLE(0, 0, 0, 0)));
+	return _mm_shuffle_ps(value.v, zw, _MM_SHUFFLE(1, 0, 1, 0));
+#endif
+}
+
+//==================================================================================================
+// Vector Arithmetic
+//==================================================================================================
+
+inline Vec4 operator+(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vaddq_f32(a.v, b.v);
+#else
+	return _mm_add_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 operator-(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vsubq_f32(a.v, b.v);
+#else
+	return _mm_sub_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 operator*(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vmulq_f32(a.v, b.v);
+#else
+	return _mm_mul_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 operator/(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vdivq_f32(a.v, b.v);
+#else
+	return _mm_div_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 operator*(Vec4 a, float b) { return a * VectorSplat(b); }
+inline Vec4 operator*(float a, Vec4 b) { return VectorSplat(a) * b; }
+
+inline Vec4 operator-(Vec4 a) {
+#if EDGE_SIMD_NEON
+	return vnegq_f32(a.v);
+#else
+	return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f));
+#endif
+}
+
+inline Vec4& operator+=(Vec4& a, Vec4 b) { a = a + b; return a; }
+inline Vec4& operator-=(Vec4& a, Vec4 b) { a = a - b; return a; }
+inline Vec4& operator*=(Vec4& a, Vec4 b) { a = a * b; return a; }
+
+// a * b + c, fused where the target has FMA
+inline Vec4 MultiplyAdd(Vec4 a, Vec4 b, Vec4 c) {
+#if EDGE_SIMD_NEON
+	return vfmaq_f32(c.v, a.v, b.v);
+#elif EDGE_SIMD_FMA
+	return _mm_fmadd_ps(a.v, b.v, c.v);
+#else
+	return _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v);
+#endif
+}
+
+inline Vec4 Min(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vminq_f32(a.v, b.v);
+#else
+	return _mm_min_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 Max(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vmaxq_f32(a.v, b.v);
+#else
+	return _mm_max_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 Abs(Vec4 a) {
+#if EDGE_SIMD_NEON
+	return vabsq_f32(a.v);
+#else
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v);
+#endif
+}
+
+inline Vec4 Sqrt(Vec4 a) {
+#if EDGE_SIMD_NEON
+	return vsqrtq_f32(a.v);
+#else
+	return _mm_sqrt_ps(a.v);
+#endif
+}
+
+// Hardware estimate refined with Newton-Raphson, about 22 bits on either architecture
+inline Vec4 ReciprocalSqrt(Vec4 a) {
+#if EDGE_SIMD_NEON
+	float32x4_t estimate = vrsqrteq_f32(a.v);
+	estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(a.v, estimate), estimate));
+	return vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(a.v, estimate), estimate));
+#else
+	const __m128 estimate = _mm_rsqrt_ps(a.v);
+	const __m128 squared = _mm_mul_ps(_mm_mul_ps(a.v, estimate), estimate);
+	return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), _mm_sub_ps(_mm_set1_ps(3.0f), squared));
+#endif
+}
+
+inline Vec4 Lerp(Vec4 a, Vec4 b, float t) {
+	return MultiplyAdd(b - a, VectorSplat(t), a);
+}
+
+//==================================================================================================
+// Comparisons
+//
+// Comparisons return all ones in the lanes where they hold and zero elsewhere, MoveMask packs the
+// lanes into the low four bits of an integer, x in bit 0.
+//==================================================================================================
+
+inline Vec4 CompareLess(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vreinterpretq_f32_u32(vcltq_f32(a.v, b.v));
+#else
+	return _mm_cmplt_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 CompareLessEqual(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vreinterpretq_f32_u32(vcleq_f32(a.v, b.v));
+#else
+	return _mm_cmple_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 And(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)));
+#else
+	return _mm_and_ps(a.v, b.v);
+#endif
+}
+
+inline Vec4 Or(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)));
+#else
+	return _mm_or_ps(a.v, b.v);
+#endif
+}
+
+// Lanes of mask pick b where set and a where clear
+inline Vec4 Select(Vec4 a, Vec4 b, Vec4 mask) {
+#if EDGE_SIMD_NEON
+	return vbslq_f32(vreinterpretq_u32_f32(mask.v), b.v, a.v);
+#elif EDGE_SIMD_SSE4
+	return _mm_blendv_ps(a.v, b.v, mask.v);
+#else
+	return _mm_or_ps(_mm_and_ps(mask.v, b.v), _mm_andnot_ps(mask.v, a.v));
+#endif
+}
+
+inline uint32_t MoveMask(Vec4 mask) {
+#if EDGE_SIMD_NEON
+	static const int32_t shifts[4] = { 0, 1, 2, 3 };
+	const uint32x4_t bits = vshlq_u32(vshrq_n_u32(vreinterpretq_u32_f32(mask.v), 31), vld1q_s32(shifts));
+	return vaddvq_u32(bits);
+#else
+	return static_cast<uint32_t>(_mm_movemask_ps(mask.v));
+#endif
+}
+
+//==================================================================================================
+// Geometric Operations
+//==================================================================================================
+
+inline Vec4 Dot4(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	return vdupq_n_f32(vaddvq_f32(vmulq_f32(a.v, b.v)));
+#else
+	const __m128 product = _mm_mul_ps(a.v, b.v);
+	const __m128 pairs = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_add_ps(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2)));
+#endif
+}
+
+// Ignores w
+inline Vec4 Dot3(Vec4 a, Vec4 b) {
+#if EDGE_SIMD_NEON
+	const float32x4_t product = vsetq_lane_f32(0.0f, vmulq_f32(a.v, b.v), 3);
+	return vdupq_n_f32(vaddvq_f32(product));
+#elif EDGE_SIMD_SSE4
+	return _mm_dp_ps(a.v, b.v, 0x7F);
+#else
+	const __m128 product = _mm_mul_ps(a.v, b.v);
+	const __m128 x = _mm_shuffle_ps(product, product, _MM_SHUFFLE(0, 0, 0, 0));
+	const __m128 y = _mm_shuffle_ps(product, product, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 z = _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 2, 2, 2));
+	return _mm_add_ps(_mm_add_ps(x, y), z);
+#endif
+}
+
+// (y, z, x, w), the one swizzle the cross product needs
+inline Vec4 PermuteYZXW(Vec4 a) {
+#if EDGE_SIMD_NEON
+	const float32x4_t yzwx = vextq_f32(a.v, a.v, 1);
+	const float32x4_t yzxx = vsetq_lane_f32(vgetq_lane_f32(a.v, 0), yzwx, 2);
+	return vsetq_lane_f32(vgetq_lane_f32(a.v, 3), yzxx, 3);
+#else
+	return _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 0, 2, 1));
+#endif
+}
+
+// w is a.w * b.w - a.w * b.w, 0 for finite inputs
+inline Vec4 Cross3(Vec4 a, Vec4 b) {
+	const Vec4 c = a * PermuteYZXW(b) - PermuteYZXW(a) * b;
+	return PermuteYZXW(c);
+}
+
+inline Vec4 Length3(Vec4 a) {
+	return Sqrt(Dot3(a, a));
+}
+
+// Zero stays zero
+inline Vec4 Normalize3(Vec4 a) {
+	return a * ReciprocalSqrt(Max(Dot3(a, a), VectorSplat(FLT_MIN)));
+}
+
+inline Vec4 Normalize4(Vec4 a) {
+	return a * ReciprocalSqrt(Max(Dot4(a, a), VectorSplat(FLT_MIN)));
+}
+
+//==================================================================================================
+// Quaternions
+//==================================================================================================
+
+inline Quat QuatIdentity() {
+	return Quat(VectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+// axis must be normalized, angle is in radians
+inline Quat QuatFromAxisAngle(Vec4 axis, float angle) {
+	const float half = angle * 0.5f;
+	return Quat(VectorSetW(axis * std::sin(half), VectorSplat(std::cos(half))));
+}
+
+// a * b, applies b first
+inline Quat QuatMultiply(Quat a, Quat b) {
+	const Vec4 aw = SplatW(a.v);
+	const Vec4 bw = SplatW(b.v);
+	const Vec4 vector = MultiplyAdd(aw, b.v, MultiplyAdd(bw, a.v, Cross3(a.v, b.v)));
+	return Quat(VectorSetW(vector, aw * bw - Dot3(a.v, b.v)));
+}
+
+inline Quat QuatConjugate(Quat q) {
+	return Quat(q.v * VectorSet(-1.0f, -1.0f, -1.0f, 1.0f));
+}
+
+inline Quat QuatNormalize(Quat q) {
+	return Quat(Normalize4(q.v));
+}
+
+// v rotated by unit quaternion q, w passes through
+inline Vec4 QuatRotate(Quat q, Vec4 v) {
+	const Vec4 t = Cross3(q.v, v) * 2.0f;
+	return MultiplyAdd(SplatW(q.v), t, v + Cross3(q.v, t));
+}
+
+// Normalized lerp along the shorter arc, cheaper than Slerp and close for small angles
+inline Quat QuatNlerp(Quat a, Quat b, float t) {
+	const float sign = GetX(Dot4(a.v, b.v)) < 0.0f ? -1.0f : 1.0f;
+	return QuatNormalize(Quat(Lerp(a.v, b.v * sign, t)));
+}
+
+inline Quat QuatSlerp(Quat a, Quat b, float t) {
+	float cosine = GetX(Dot4(a.v, b.v));
+	Vec4 target = b.v;
+	if (cosine < 0.0f) {
+		cosine = -cosine;
+		target = -target;
+	}
+
+	// Nearly parallel, the sine below would lose all precision
+	if (cosine > 0.9995f) {
+		return QuatNormalize(Quat(Lerp(a.v, target, t)));
+	}
+
+	const float angle = std::acos(cosine);
+	const float inverseSine = 1.0f / std::sin(angle);
+	const float weightA = std::sin((1.0f - t) * angle) * inverseSine;
+	const float weightB = std::sin(t * angle) * inverseSine;
+	return Quat(MultiplyAdd(a.v, VectorSplat(weightA), target * weightB));
+}
+
+//==================================================================================================
+// Matrices
+//==================================================================================================
+
+inline Mat4 Mat4Identity() {
+	Mat4 m;
+	m.c[0] = VectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+	m.c[1] = VectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	m.c[2] = VectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	m.c[3] = VectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	return m;
+}
+
+inline Mat4 Mat4Transpose(const Mat4& m) {
+	Mat4 result;
+#if EDGE_SIMD_NEON
+	const float32x4x2_t c01 = vtrnq_f32(m.c[0].v, m.c[1].v);
+	const float32x4x2_t c23 = vtrnq_f32(m.c[2].v, m.c[3].v);
+	result.c[0] = vcombine_f32(vget_low_f32(c01.val[0]), vget_low_f32(c23.val[0]));
+	result.c[1] = vcombine_f32(vget_low_f32(c01.val[1]), vget_low_f32(c23.val[1]));
+	result.c[2] = vcombine_f32(vget_high_f32(c01.val[0]), vget_high_f32(c23.val[0]));
+	result.c[3] = vcombine_f32(vget_high_f32(c01.val[1]), vget_high_f32(c23.val[1]));
+#else
+	__m128 c0 = m.c[0].v, c1 = m.c[1].v, c2 = m.c[2].v, c3 = m.c[3].v;
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	result.c[0] = c0;
+	result.c[1] = c1;
+	result.c[2] = c2;
+	result.c[3] = c3;
+#endif
+	return result;
+}
+
+// m * v for all four components
+inline Vec4 Mat4Transform(const Mat4& m, Vec4 v) {
+	Vec4 result = m.c[0] * SplatX(v);
+	result = MultiplyAdd(m.c[1], SplatY(v), result);
+	result = MultiplyAdd(m.c[2], SplatZ(v), result);
+	return MultiplyAdd(m.c[3], SplatW(v), result);
+}
+
+// m * (x, y, z, 1)
+inline Vec4 Mat4TransformPoint(const Mat4& m, Vec4 p) {
+	Vec4 result = MultiplyAdd(m.c[0], SplatX(p), m.c[3]);
+	result = MultiplyAdd(m.c[1], SplatY(p), result);
+	return MultiplyAdd(m.c[2], SplatZ(p), result);
+}
+
+// m * (x, y, z, 0)
+inline Vec4 Mat4TransformVector(const Mat4& m, Vec4 v) {
+	Vec4 result = m.c[0] * SplatX(v);
+	result = MultiplyAdd(m.c[1], SplatY(v), result);
+	return MultiplyAdd(m.c[2], SplatZ(v), result);
+}
+
+// a * b, applies b first
+inline Mat4 Mat4Multiply(const Mat4& a, const Mat4& b) {
+	Mat4 result;
+	for (int i = 0; i < 4; ++i) {
+		result.c[i] = Mat4Transform(a, b.c[i]);
+	}
+	return result;
+}
+
+inline Mat4 Mat4FromQuat(Quat q) {
+	const float x = GetX(q.v), y = GetY(q.v), z = GetZ(q.v), w = GetW(q.v);
+	const float xx = x * x, yy = y * y, zz = z * z;
+	const float xy = x * y, xz = x * z, yz = y * z;
+	const float wx = w * x, wy = w * y, wz = w * z;
+
+	Mat4 m;
+	m.c[0] = VectorSet(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f);
+	m.c[1] = VectorSet(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f);
+	m.c[2] = VectorSet(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f);
+	m.c[3] = VectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	return m;
+}
+
+// Scale, then rotate, then translate
+inline Mat4 Mat4FromTRS(Vec4 translation, Quat rotation, Vec4 scale) {
+	Mat4 m = Mat4FromQuat(rotation);
+	m.c[0] = m.c[0] * SplatX(scale);
+	m.c[1] = m.c[1] * SplatY(scale);
+	m.c[2] = m.c[2] * SplatZ(scale);
+	m.c[3] = VectorSetW(translation, VectorSplat(1.0f));
+	return m;
+}
+
+// Inverse of an affine transform, the upper 3x3 must not be singular
+inline Mat4 Mat4InverseAffine(const Mat4& m) {
+	// Rows of the inverse 3x3 are the cofactor columns over the determinant
+	const Vec4 inverseDet = VectorSplat(1.0f) / Dot3(m.c[0], Cross3(m.c[1], m.c[2]));
+
+	Mat4 rows;
+	rows.c[0] = Cross3(m.c[1], m.c[2]) * inverseDet;
+	rows.c[1] = Cross3(m.c[2], m.c[0]) * inverseDet;
+	rows.c[2] = Cross3(m.c[0], m.c[1]) * inverseDet;
+	rows.c[3] = VectorZero();
+
+	Mat4 result = Mat4Transpose(rows);
+	result.c[3] = VectorSetW(-Mat4TransformVector(result, m.c[3]), VectorSplat(1.0f));
+	return result;
+}
+
+// Inverse transpose of the upper 3x3, transforms normals under non-uniform scale.
+// The cofactors need no transpose, so this is three cross products and a divide.
+inline Mat4 Mat4NormalMatrix(const Mat4& m) {
+	const Vec4 inverseDet = VectorSplat(1.0f) / Dot3(m.c[0], Cross3(m.c[1], m.c[2]));
+
+	Mat4 result;
+	result.c[0] = Cross3(m.c[1], m.c[2]) * inverseDet;
+	result.c[1] = Cross3(m.c[2], m.c[0]) * inverseDet;
+	result.c[2] = Cross3(m.c[0], m.c[1]) * inverseDet;
+	result.c[3] = VectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	return result;
+}
+
+END_NS_MATH
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_MATH_
@@ -16,481 +16,2887 @@
 */
 
 #include "EdgeMemory.h"
+#include "EdgeAllocationTrace.h"
+#include "EdgeProfiler.h"
 #include <cstring>
+#include <atomic>
+
+#include <cmath>
 
 #if EDGE_PLATFORM_WINDOWS
 #include <Windows.h>
 #else
 #include <malloc.h>
+#include <unwind.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if EDGE_PLATFORM_MACOS && EDGE_ARCH_X64
+#include <mach/vm_statistics.h>
+#endif
 #endif
 
 BEGIN_NS_EDGE
 BEGIN_NS_MEMORY
 
 //==============================================================================
-// SystemAllocator
+// Thread Slots
+//==============================================================================
+namespace {
+
+std::atomic<uint64_t> g_ThreadSlotMask(0);
+static_assert(EDGE_MAX_THREAD_SLOTS <= 64, "Thread slots are tracked in a single 64 bit mask");
+
+// Claims the lowest free slot on first use and gives it back when the thread exits.
+struct ThreadSlot {
+	uint32_t index;
+
+	ThreadSlot() : index(static_cast<uint32_t>(EDGE_MAX_THREAD_SLOTS)) {
+		uint64_t mask = g_ThreadSlotMask.load(std::memory_order_relaxed);
+		for (;;) {
+			uint32_t slot = 0;
+			while (slot < EDGE_MAX_THREAD_SLOTS && (mask & (uint64_t(1) << slot))) {
+				++slot;
+			}
+			if (slot == EDGE_MAX_THREAD_SLOTS) {
+				return;
+			}
+			if (g_ThreadSlotMask.compare_exchange_weak(mask, mask | (uint64_t(1) << slot), std::memory_order_acquire)) {
+				index = slot;
+				return;
+			}
+		}
+	}
+
+	~ThreadSlot() {
+		if (index < EDGE_MAX_THREAD_SLOTS) {
+			g_ThreadSlotMask.fetch_and(~(uint64_t(1) << index), std::memory_order_release);
+		}
+		// Later thread-exit code may still allocate, it must not touch the slot it gave back
+		index = static_cast<uint32_t>(EDGE_MAX_THREAD_SLOTS);
+	}
+};
+
+thread_local ThreadSlot t_ThreadSlot;
+
+} // namespace
+
+uint32_t GetThreadSlot()
+{
+	return t_ThreadSlot.index;
+}
+
 //==============================================================================
-struct SystemAllocator::AllocationHeader
+// Memory Tags
+//==============================================================================
+namespace {
+
+const char* const kTagNames[] = {
+	"NoTag",
+	"Foreground",
+	"Background",
+	"Interior",
+	"Animation",
+	"AnimationLocomotion",
+	"AnimationMotionMatching",
+	"Particles",
+	"Actors",
+	"AudioGlobal",
+	"AudioSFX",
+	"AudioMusic",
+	"AudioSpeech",
+	"AudioVox",
+	"AI",
+	"AITask",
+	"AIBrain",
+	"GUI",
+	"Physics",
+	"Cinematic",
+	"Lighting",
+	"Gameplay",
+	"Script",
+	"Net",
+	"Debug",
+	"Temp",
+};
+
+static_assert(sizeof(kTagNames) / sizeof(kTagNames[0]) == static_cast<size_t>(MemoryTag::COUNT),
+	"Every MemoryTag needs a name");
+
+} // namespace
+
+const char* GetTagName(MemoryTag tag)
+{
+	const size_t index = static_cast<size_t>(tag);
+	return index < static_cast<size_t>(MemoryTag::COUNT) ? kTagNames[index] : "Unknown";
+}
+
+//==============================================================================
+// LeakTracking
+//
+// Each shard is an open-addressed table with linear probing. Removal shifts the following
+// entries back instead of leaving tombstones, so probe lengths stay short under churn.
+// Tables grow from the platform allocator and never show up in their own report.
+//==============================================================================
+namespace {
+
+constexpr size_t kLeakShardCount = 32;			// power of two
+constexpr size_t kLeakShardInitialCapacity = 256;	// power of two
+
+} // namespace
+
+struct LeakTracking::Record
 {
+	void* ptr;			// nullptr marks an empty slot
 	size_t size;
-	size_t alignment;
-	MemoryTag tag;
 	const char* file;
 	int line;
-	AllocationHeader* prev;
-	AllocationHeader* next;
-	uint32_t guardValue;
+	MemoryTag tag;
+};
 
-	static constexpr uint32_t GUARD_VALUE = 0xDEADC0DE;
+struct alignas(EDGE_CACHE_LINE_SIZE) LeakTracking::Shard
+{
+	std::mutex lock;
+	Record* records;
+	size_t capacity;
+	size_t count;
+
+	Shard() : records(nullptr), capacity(0), count(0) {}
 };
 
-// Constructor for allocator
-SystemAllocator::SystemAllocator() : m_TrackingEnabled(EDGE_DEBUG ? true : false)
+LeakTracking::LeakTracking() : m_Shards(nullptr)
 {
-	memset(&m_Stats, 0, sizeof(MemoryStats));
-	memset(m_TagStats, 0, sizeof(m_TagStats));
+	void* memory = PlatformAlignedAlloc(kLeakShardCount * sizeof(Shard), alignof(Shard));
+	EDGE_ASSERT(memory, "Failed to allocate the leak tracking index!");
 
-	// Initialize tracking list
-	m_FirstAllocation = nullptr;
-	m_LastAllocation = nullptr;
+	m_Shards = static_cast<Shard*>(memory);
+	for (size_t i = 0; i < kLeakShardCount; ++i) {
+		new (&m_Shards[i]) Shard();
+	}
 }
 
-// Deconstructor for allocation
-SystemAllocator::~SystemAllocator()
+LeakTracking::~LeakTracking()
 {
-	if (m_TrackingEnabled && m_Stats.allocationCount > m_Stats.freeCount)
-	{
-		ReportLeaks();
+	if (!m_Shards) {
+		return;
 	}
 
-	EDGE_ASSERT(m_Stats.allocationCount == m_Stats.freeCount, "Memory leak detected!");
+	for (size_t i = 0; i < kLeakShardCount; ++i) {
+		PlatformAlignedFree(m_Shards[i].records);
+		m_Shards[i].~Shard();
+	}
+	PlatformAlignedFree(m_Shards);
 }
 
-void* SystemAllocator::Allocate(size_t size, size_t alignment)
+LeakTracking::Shard& LeakTracking::ShardFor(const void* ptr, size_t& hash) const
 {
-	return Allocate(size, MemoryTag::NoTag, alignment);
+	// Low bits are mostly alignment, fold them away before picking a shard
+	uint64_t value = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr));
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCDull;
+	value ^= value >> 33;
+
+	hash = static_cast<size_t>(value);
+	return m_Shards[(value >> 58) & (kLeakShardCount - 1)];
 }
 
-void* SystemAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment)
+bool LeakTracking::OnAllocate(void* userPtr, size_t size, MemoryTag tag, size_t alignment, const char* file, int line)
 {
-	if (size == 0)
-	{
-		return nullptr;
+	(void)alignment;
+
+	size_t hash = 0;
+	Shard& shard = ShardFor(userPtr, hash);
+	std::lock_guard<std::mutex> lock(shard.lock);
+
+	// Grow at 3/4 load
+	Record* records = nullptr;
+	const size_t capacity = shard.capacity ? shard.capacity * 2 : kLeakShardInitialCapacity;
+	if ((shard.count + 1) * 4 > shard.capacity * 3) {
+		records = static_cast<Record*>(PlatformAlignedAlloc(capacity * sizeof(Record), EDGE_CACHE_LINE_SIZE));
 	}
 
-	EDGE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0,
-		"Alignment must be a power of two.");
+	if (records) {
+		memset(records, 0, capacity * sizeof(Record));
+
+		for (size_t i = 0; i < shard.capacity; ++i) {
+			const Record& record = shard.records[i];
+			if (!record.ptr) {
+				continue;
+			}
+			size_t recordHash = 0;
+			ShardFor(record.ptr, recordHash);
+			size_t slot = recordHash & (capacity - 1);
+			while (records[slot].ptr) {
+				slot = (slot + 1) & (capacity - 1);
+			}
+			records[slot] = record;
+		}
 
-	// For tracking, we want to allocate
-	// extra space for our header.
-	size_t totalSize = size;
-	void* memory = nullptr;
-	if (m_TrackingEnabled)
-	{
-		totalSize += sizeof(AllocationHeader);
+		PlatformAlignedFree(shard.records);
+		shard.records = records;
+		shard.capacity = capacity;
+	}
+	else if (shard.count + 1 >= shard.capacity) {
+		// Probes stop at an empty slot, so the last one is never filled
+		EDGE_ASSERT(false, "Failed to grow the leak tracking index!");
+		return false;
 	}
 
-#if EDGE_PLATFORM_WINDOWS
-	memory = _aligned_malloc(totalSize, alignment);
-#else
-	memory = aligned_alloc(alignment, Memory::AlignUp(totalSize, alignment));
-#endif // EDGE_PLATFORM_WINDOWS
+	// A failed grow keeps filling the current table past 3/4, longer probes beat losing a record
+	size_t slot = hash & (shard.capacity - 1);
+	while (shard.records[slot].ptr) {
+		slot = (slot + 1) & (shard.capacity - 1);
+	}
 
-	if (!memory)
-	{
-		EDGE_ASSERT(false, "Memory allocation failed!");
+	Record& record = shard.records[slot];
+	record.ptr = userPtr;
+	record.size = size;
+	record.file = file;
+	record.line = line;
+	record.tag = tag;
+	shard.count++;
+	return true;
+}
+
+void* LeakTracking::OnFree(void* userPtr, size_t& size, MemoryTag& tag)
+{
+	size_t hash = 0;
+	Shard& shard = ShardFor(userPtr, hash);
+	std::lock_guard<std::mutex> lock(shard.lock);
+
+	if (shard.capacity == 0) {
+		EDGE_ASSERT(false, "Freeing a pointer that is not tracked, double free or foreign pointer!");
 		return nullptr;
 	}
 
-	void* userPtr = memory;
+	const size_t mask = shard.capacity - 1;
+	size_t slot = hash & mask;
+	while (shard.records[slot].ptr != userPtr) {
+		if (!shard.records[slot].ptr) {
+			EDGE_ASSERT(false, "Freeing a pointer that is not tracked, double free or foreign pointer!");
+			return nullptr;
+		}
+		slot = (slot + 1) & mask;
+	}
 
-	if (m_TrackingEnabled)
-	{
-		// Setup allocation header
-		AllocationHeader* header = static_cast<AllocationHeader*>(memory);
-		header->size = size;
-		header->alignment = alignment;
-		header->tag = tag;
-		header->file = nullptr;		// could retrieve from callstack if needed.
-		header->line = 0;
-		header->guardValue = AllocationHeader::GUARD_VALUE;
-		header->prev = nullptr;
-		header->next = nullptr;
-		// Track this allocation
-		TrackAllocation(header, size, tag);
-		// User memory starts after header
-		userPtr = reinterpret_cast<uint8_t*>(memory) + sizeof(AllocationHeader);
+	size = shard.records[slot].size;
+	tag = shard.records[slot].tag;
+
+	// Backward shift deletion, pull later entries of the probe run into the hole
+	size_t hole = slot;
+	size_t next = (hole + 1) & mask;
+	while (shard.records[next].ptr) {
+		size_t recordHash = 0;
+		ShardFor(shard.records[next].ptr, recordHash);
+		const size_t home = recordHash & mask;
+
+		// Move it if its home slot is not in the cyclic range (hole, next]
+		if (((next - home) & mask) >= ((next - hole) & mask)) {
+			shard.records[hole] = shard.records[next];
+			hole = next;
+		}
+		next = (next + 1) & mask;
 	}
+	shard.records[hole].ptr = nullptr;
+	shard.count--;
 
 	return userPtr;
 }
 
-void SystemAllocator::Free(void* ptr)
+void LeakTracking::ReportLeaks() const
 {
-	if (!ptr)
-	{
+	size_t liveCount = 0;
+	for (size_t i = 0; i < kLeakShardCount; ++i) {
+		std::lock_guard<std::mutex> lock(m_Shards[i].lock);
+		liveCount += m_Shards[i].count;
+	}
+
+	if (liveCount == 0) {
 		return;
 	}
 
-	void* actualPtr = ptr;
+	// Walk every shard to report each leak's details
+	EDGE_WARNING("Memory leaks detected!");
 
-	if (m_TrackingEnabled)
-	{
-		// the header stored before the user pointer
-		AllocationHeader* header = reinterpret_cast<AllocationHeader*>(
-			reinterpret_cast<uint8_t*>(ptr) - sizeof(AllocationHeader));
+	printf("\nDetailed leak report:\n");
+	printf("-------------------------------------------------\n");
 
-		// verify guard value
-		if (header->guardValue != AllocationHeader::GUARD_VALUE)
-		{
-			EDGE_ASSERT(false, "Memory corruption detected!");
-			return;
+	int leakCount = 0;
+	for (size_t i = 0; i < kLeakShardCount; ++i) {
+		Shard& shard = m_Shards[i];
+		std::lock_guard<std::mutex> lock(shard.lock);
+
+		for (size_t slot = 0; slot < shard.capacity; ++slot) {
+			const Record& record = shard.records[slot];
+			if (!record.ptr) {
+				continue;
+			}
+
+			leakCount++;
+			printf("Leak #%d: %zu bytes at %p (tag: %d)",
+				leakCount,
+				record.size,
+				record.ptr,
+				static_cast<int>(record.tag));
+
+			if (record.file) {
+				printf(", allocated at %s:%d", record.file, record.line);
+			}
+
+			printf("\n");
 		}
-
-		TrackDeallocation(header);
-		actualPtr = header;
 	}
 
-#if EDGE_PLATFORM_WINDOWS
-	_aligned_free(actualPtr);
-#else
-	free(actualPtr);
-#endif
+	printf("-------------------------------------------------\n");
+	printf("Total leaks found: %d\n", leakCount);
 }
 
-void SystemAllocator::GetStats(MemoryStats& stats) const
+void LeakTracking::Clear()
 {
-	stats = m_Stats;
+	for (size_t i = 0; i < kLeakShardCount; ++i) {
+		Shard& shard = m_Shards[i];
+		std::lock_guard<std::mutex> lock(shard.lock);
+		PlatformAlignedFree(shard.records);
+		shard.records = nullptr;
+		shard.capacity = 0;
+		shard.count = 0;
+	}
 }
 
-void SystemAllocator::GetTagStats(MemoryTag tag, MemoryStats& stats) const
-{
-	size_t tagIndex = static_cast<size_t>(tag);
-	if (tagIndex < static_cast<size_t>(MemoryTag::COUNT)) {
-		stats = m_TagStats[tagIndex];
+//==============================================================================
+// TagStats
+//==============================================================================
+namespace {
+
+// Owned counters are only written by one thread, a relaxed load/store pair avoids a locked
+// instruction. Shared counters need the read-modify-write.
+template<typename T>
+inline T AddCounter(std::atomic<T>& counter, T value, bool shared) {
+	if (shared) {
+		return counter.fetch_add(value, std::memory_order_relaxed) + value;
 	}
-	else {
-		memset(&stats, 0, sizeof(MemoryStats));
+	const T result = counter.load(std::memory_order_relaxed) + value;
+	counter.store(result, std::memory_order_relaxed);
+	return result;
+}
+
+inline void RaisePeak(std::atomic<int64_t>& peak, int64_t value) {
+	int64_t current = peak.load(std::memory_order_relaxed);
+	while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
 	}
 }
 
-void SystemAllocator::Reset()
-{
-	EDGE_ASSERT(m_Stats.allocationCount == m_Stats.freeCount,
-		"Cannot reset allocator with active allocations!");
+// Add to a thread's pending usage and fold it into the shared total once it passes a batch.
+// Only the rare fold touches a shared cache line, the peak is raised at the same time.
+inline void AddUsage(std::atomic<int64_t>& pending, int64_t delta, std::atomic<int64_t>& current,
+	std::atomic<int64_t>& peak, bool shared) {
+	int64_t value = AddCounter(pending, delta, shared);
+	if (value < TagStats::USAGE_BATCH_BYTES && value > -TagStats::USAGE_BATCH_BYTES) {
+		return;
+	}
 
-	memset(&m_Stats, 0, sizeof(MemoryStats));
-	memset(m_TagStats, 0, sizeof(m_TagStats));
+	if (shared) {
+		value = pending.exchange(0, std::memory_order_relaxed);
+	}
+	else {
+		pending.store(0, std::memory_order_relaxed);
+	}
 
-	// Reset tracking list
-	m_FirstAllocation = nullptr;
-	m_LastAllocation = nullptr;
+	const int64_t usage = current.fetch_add(value, std::memory_order_relaxed) + value;
+	RaisePeak(peak, usage);
 }
 
-void SystemAllocator::SetTrackingEnabled(bool enabled) {
-	EDGE_ASSERT(m_Stats.allocationCount == m_Stats.freeCount,
-		"Cannot change tracking state with active allocations!");
+} // namespace
 
-	m_TrackingEnabled = enabled;
+void TagStats::OnAllocate(size_t size, MemoryTag tag, size_t count)
+{
+	Update(size, count, tag, false);
 }
 
-bool SystemAllocator::IsTrackingEnabled() const
+void TagStats::OnFree(size_t size, MemoryTag tag, size_t count)
 {
-	return m_TrackingEnabled;
+	Update(size, count, tag, true);
 }
 
-// Implementation using a linked list to track all allocations
-void SystemAllocator::TrackAllocation(AllocationHeader* header, size_t size, MemoryTag tag)
+void TagStats::Update(size_t size, size_t count, MemoryTag tag, bool isFree)
 {
-	// Update global stats
-	m_Stats.totalAllocated += size;
-	m_Stats.currentUsage += size;
-	m_Stats.allocationCount++;
-
-	if (m_Stats.currentUsage > m_Stats.peakUsage) {
-		m_Stats.peakUsage = m_Stats.currentUsage;
+	const uint32_t slot = GetThreadSlot();
+	const bool shared = slot >= EDGE_MAX_THREAD_SLOTS;
+	SlotCounters& slotCounters = m_Slots[shared ? EDGE_MAX_THREAD_SLOTS : slot];
+
+	// Tags past COUNT are counted as untagged
+	const size_t tagIndex = static_cast<size_t>(tag) < TAG_COUNT ? static_cast<size_t>(tag) : 0;
+	Counters& counters = slotCounters.tags[tagIndex];
+
+	int64_t delta = static_cast<int64_t>(size);
+	if (isFree) {
+		AddCounter(counters.totalFreed, size, shared);
+		AddCounter(counters.freeCount, count, shared);
+		delta = -delta;
+	}
+	else {
+		AddCounter(counters.totalAllocated, size, shared);
+		AddCounter(counters.allocationCount, count, shared);
 	}
 
-	// Update tag-specific stats
-	size_t tagIndex = static_cast<size_t>(tag);
-	if (tagIndex < static_cast<size_t>(MemoryTag::COUNT)) {
-		m_TagStats[tagIndex].totalAllocated += size;
-		m_TagStats[tagIndex].currentUsage += size;
-		m_TagStats[tagIndex].allocationCount++;
+	AddUsage(counters.pendingUsage, delta, m_Usage[tagIndex].current, m_Usage[tagIndex].peak, shared);
+	AddUsage(slotCounters.pendingUsage, delta, m_Usage[TAG_COUNT].current, m_Usage[TAG_COUNT].peak, shared);
+}
 
-		if (m_TagStats[tagIndex].currentUsage > m_TagStats[tagIndex].peakUsage) {
-			m_TagStats[tagIndex].peakUsage = m_TagStats[tagIndex].currentUsage;
+// Sum every slot for a tag, or for every tag when tagIndex == TAG_COUNT.
+void TagStats::Collect(size_t tagIndex, MemoryStats& stats) const
+{
+	const size_t first = tagIndex < TAG_COUNT ? tagIndex : 0;
+	const size_t last = tagIndex < TAG_COUNT ? tagIndex + 1 : TAG_COUNT;
+
+	size_t totalAllocated = 0, totalFreed = 0, allocationCount = 0, freeCount = 0;
+	for (const SlotCounters& slotCounters : m_Slots) {
+		for (size_t i = first; i < last; ++i) {
+			const Counters& counters = slotCounters.tags[i];
+			totalAllocated += counters.totalAllocated.load(std::memory_order_relaxed);
+			totalFreed += counters.totalFreed.load(std::memory_order_relaxed);
+			allocationCount += counters.allocationCount.load(std::memory_order_relaxed);
+			freeCount += counters.freeCount.load(std::memory_order_relaxed);
 		}
 	}
 
-	// Add to linked list for tracking
-	if (m_FirstAllocation == nullptr) {
-		m_FirstAllocation = header;
-		m_LastAllocation = header;
-	}
-	else {
-		header->prev = m_LastAllocation;
-		m_LastAllocation->next = header;
-		m_LastAllocation = header;
-	}
+	// Blocks may be freed on another thread than the one that allocated them, so usage is
+	// only meaningful over the sum. The sum also catches a peak still pending in some slot.
+	// A free scanned before its allocation can put the sum below zero, which reads as empty.
+	const int64_t usage = static_cast<int64_t>(totalAllocated) - static_cast<int64_t>(totalFreed);
+	const size_t currentUsage = usage > 0 ? static_cast<size_t>(usage) : 0;
+	std::atomic<int64_t>& peak = m_Usage[tagIndex < TAG_COUNT ? tagIndex : TAG_COUNT].peak;
+	RaisePeak(peak, static_cast<int64_t>(currentUsage));
+
+	stats = MemoryStats();
+	stats.totalAllocated = totalAllocated;
+	stats.totalFreed = totalFreed;
+	stats.currentUsage = currentUsage;
+	stats.peakUsage = static_cast<size_t>(peak.load(std::memory_order_relaxed));
+	stats.allocationCount = allocationCount;
+	stats.freeCount = freeCount;
 }
 
-void SystemAllocator::TrackDeallocation(AllocationHeader* header) {
-	// Update global stats
-	m_Stats.totalFreed += header->size;
-	m_Stats.currentUsage -= header->size;
-	m_Stats.freeCount++;
-
-	// Update tag-specific stats
-	size_t tagIndex = static_cast<size_t>(header->tag);
-	if (tagIndex < static_cast<size_t>(MemoryTag::COUNT)) {
-		m_TagStats[tagIndex].totalFreed += header->size;
-		m_TagStats[tagIndex].currentUsage -= header->size;
-		m_TagStats[tagIndex].freeCount++;
-	}
-
-	// Remove from tracking list
-	if (header->prev) {
-		header->prev->next = header->next;
-	}
-	else {
-		m_FirstAllocation = header->next;
-	}
+void TagStats::GetStats(MemoryStats& stats) const
+{
+	Collect(TAG_COUNT, stats);
+}
 
-	if (header->next) {
-		header->next->prev = header->prev;
-	}
-	else {
-		m_LastAllocation = header->prev;
+void TagStats::GetTagStats(MemoryTag tag, MemoryStats& stats) const
+{
+	if (static_cast<size_t>(tag) >= TAG_COUNT) {
+		stats = MemoryStats();
+		return;
 	}
+	Collect(static_cast<size_t>(tag), stats);
 }
 
-void SystemAllocator::ReportLeaks() {
-	if (!m_TrackingEnabled || m_Stats.allocationCount == m_Stats.freeCount) {
+void TagStats::ReportLeaks() const
+{
+	MemoryStats total;
+	GetStats(total);
+	if (total.allocationCount == total.freeCount) {
 		return;
 	}
 
-	// Iterate through the linked list of allocation headers to report each leak's details
-	EDGE_WARNING("Memory leaks detected!");
-
 	printf("Total leaked memory: %zu bytes\n",
-		m_Stats.totalAllocated - m_Stats.totalFreed);
+		total.totalAllocated - total.totalFreed);
 	printf("Total allocations: %zu, frees: %zu\n",
-		m_Stats.allocationCount, m_Stats.freeCount);
+		total.allocationCount, total.freeCount);
 
 	// Report tag-specific leaks
-	for (size_t i = 0; i < static_cast<size_t>(MemoryTag::COUNT); ++i) {
-		if (m_TagStats[i].allocationCount > m_TagStats[i].freeCount) {
+	for (size_t i = 0; i < TAG_COUNT; ++i) {
+		MemoryStats tagStats;
+		Collect(i, tagStats);
+		if (tagStats.allocationCount > tagStats.freeCount) {
 			printf("Tag %zu: Leaked %zu bytes in %zu blocks\n", i,
-				m_TagStats[i].totalAllocated - m_TagStats[i].totalFreed,
-				m_TagStats[i].allocationCount - m_TagStats[i].freeCount);
+				tagStats.totalAllocated - tagStats.totalFreed,
+				tagStats.allocationCount - tagStats.freeCount);
 		}
 	}
+}
 
-	// Report individual leaks
-	printf("\nDetailed leak report:\n");
-	printf("-------------------------------------------------\n");
-
-	AllocationHeader* current = m_FirstAllocation;
-	int leakCount = 0;
-
-	while (current) {
-		leakCount++;
-		printf("Leak #%d: %zu bytes (tag: %d)",
-			leakCount,
-			current->size,
-			static_cast<int>(current->tag));
-
-		if (current->file) {
-			printf(", allocated at %s:%d", current->file, current->line);
+void TagStats::Clear()
+{
+	for (SlotCounters& slotCounters : m_Slots) {
+		for (Counters& counters : slotCounters.tags) {
+			counters.totalAllocated.store(0, std::memory_order_relaxed);
+			counters.totalFreed.store(0, std::memory_order_relaxed);
+			counters.allocationCount.store(0, std::memory_order_relaxed);
+			counters.freeCount.store(0, std::memory_order_relaxed);
+			counters.pendingUsage.store(0, std::memory_order_relaxed);
 		}
-
-		printf("\n");
-		current = current->next;
+		slotCounters.pendingUsage.store(0, std::memory_order_relaxed);
 	}
 
-	printf("-------------------------------------------------\n");
-	printf("Total leaks found: %d\n", leakCount);
+	for (Usage& usage : m_Usage) {
+		usage.current.store(0, std::memory_order_relaxed);
+		usage.peak.store(0, std::memory_order_relaxed);
+	}
 }
 
-//==================================================================================================
-// LinearAllocator Implementation
-//==================================================================================================
-
-LinearAllocator::LinearAllocator(size_t size)
-	: m_Size(size), m_Offset(0) {
+//==============================================================================
+// IAllocator
+//==============================================================================
 
-	m_Buffer = static_cast<uint8_t*>(Memory::Allocate(size, EDGE_CACHE_LINE_SIZE));
-	EDGE_ASSERT(m_Buffer != nullptr, "Failed to allocate memory for LinearAllocator");
-	memset(&m_Stats, 0, sizeof(MemoryStats));
+void IAllocator::Free(void* ptr, size_t size, size_t alignment)
+{
+	(void)size;
+	(void)alignment;
+	Free(ptr);
 }
 
-LinearAllocator::~LinearAllocator() {
-	Memory::Free(m_Buffer);
-	m_Buffer = nullptr;
+bool IAllocator::AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag)
+{
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = Allocate(size, tag, alignment);
+		if (!out[i]) {
+			FreeBatch(out, i);
+			return false;
+		}
+	}
+	return true;
 }
 
-void* LinearAllocator::Allocate(size_t size, size_t alignment) {
-	return Allocate(size, MemoryTag::NoTag, alignment);
+void IAllocator::FreeBatch(void** ptrs, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		Free(ptrs[i]);
+	}
 }
 
-void* LinearAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment) {
-	if (size == 0) {
-		return nullptr;
-	}
+//==============================================================================
+// SystemAllocator
+//==============================================================================
 
-	// Calculate aligned address
-	size_t alignmentMask = alignment - 1;
-	size_t alignedOffset = (m_Offset + alignmentMask) & ~alignmentMask;
+// Constructor for allocator
+#if EDGE_MEMORY_TRACKING
+SystemAllocator::SystemAllocator() : m_TrackingEnabled(true)
+{
+}
+#else
+SystemAllocator::SystemAllocator()
+{
+}
+#endif
 
-	if (alignedOffset + size > m_Size) {
-		EDGE_ASSERT(false, "LinearAllocator out of memory");
-		return nullptr;
+// Deconstructor for allocation
+SystemAllocator::~SystemAllocator()
+{
+#if EDGE_MEMORY_TRACKING
+	MemoryStats stats;
+	m_Tracked.GetStats(stats);
+	if (stats.allocationCount > stats.freeCount)
+	{
+		m_Tracked.ReportLeaks();
 	}
 
-	void* ptr = m_Buffer + alignedOffset;
-	m_Offset = alignedOffset + size;
+	EDGE_ASSERT(stats.allocationCount == stats.freeCount, "Memory leak detected!");
+#endif
+}
 
-	// Update stats
-	m_Stats.totalAllocated += size;
-	m_Stats.currentUsage += size;
-	m_Stats.allocationCount++;
+void* SystemAllocator::Allocate(size_t size, size_t alignment)
+{
+	return Allocate(size, MemoryTag::NoTag, alignment);
+}
 
-	if (m_Stats.currentUsage > m_Stats.peakUsage) {
-		m_Stats.peakUsage = m_Stats.currentUsage;
+void* SystemAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment)
+{
+	return Allocate(size, tag, alignment, nullptr, 0);
+}
+
+void* SystemAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment, const char* file, int line)
+{
+#if EDGE_MEMORY_TRACKING
+	if (m_TrackingEnabled)
+	{
+		return m_Tracked.Allocate(size, tag, alignment, file, line);
 	}
+#endif
+	(void)file;
+	(void)line;
+	return m_Platform.Allocate(size, tag, alignment);
+}
 
-	return ptr;
+void SystemAllocator::Free(void* ptr)
+{
+#if EDGE_MEMORY_TRACKING
+	if (m_TrackingEnabled)
+	{
+		m_Tracked.Free(ptr);
+		return;
+	}
+#endif
+	m_Platform.Free(ptr);
 }
 
-void LinearAllocator::Free(void* ptr) {
-	// Individual frees are not supported in a linear allocator
-	// We simply ignore this call
-	(void)ptr;
+void SystemAllocator::Free(void* ptr, size_t size, size_t alignment)
+{
+#if EDGE_MEMORY_TRACKING
+	if (m_TrackingEnabled)
+	{
+		m_Tracked.Free(ptr, size, alignment);
+		return;
+	}
+#endif
+	m_Platform.Free(ptr, size, alignment);
 }
 
-void LinearAllocator::GetStats(MemoryStats& stats) const {
-	stats = m_Stats;
+bool SystemAllocator::AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag)
+{
+#if EDGE_MEMORY_TRACKING
+	if (m_TrackingEnabled)
+	{
+		return m_Tracked.AllocateBatch(count, size, alignment, out, tag);
+	}
+#endif
+	return m_Platform.AllocateBatch(count, size, alignment, out, tag);
 }
 
-void LinearAllocator::Reset() {
-	m_Offset = 0;
-	m_Stats.totalFreed += m_Stats.currentUsage;
-	m_Stats.currentUsage = 0;
-	m_Stats.freeCount += m_Stats.allocationCount;
+void SystemAllocator::FreeBatch(void** ptrs, size_t count)
+{
+#if EDGE_MEMORY_TRACKING
+	if (m_TrackingEnabled)
+	{
+		m_Tracked.FreeBatch(ptrs, count);
+		return;
+	}
+#endif
+	m_Platform.FreeBatch(ptrs, count);
 }
 
-//==================================================================================================
-// PoolAllocator Implementation
-//==================================================================================================
+void SystemAllocator::GetStats(MemoryStats& stats) const
+{
+#if EDGE_MEMORY_TRACKING
+	m_Tracked.GetStats(stats);
+#else
+	m_Platform.GetStats(stats);
+#endif
+}
+
+void SystemAllocator::GetTagStats(MemoryTag tag, MemoryStats& stats) const
+{
+#if EDGE_MEMORY_TRACKING
+	m_Tracked.GetTagStats(tag, stats);
+#else
+	m_Platform.GetTagStats(tag, stats);
+#endif
+}
+
+void SystemAllocator::Reset()
+{
+#if EDGE_MEMORY_TRACKING
+	MemoryStats stats;
+	m_Tracked.GetStats(stats);
+	EDGE_ASSERT(stats.allocationCount == stats.freeCount,
+		"Cannot reset allocator with active allocations!");
+
+	m_Tracked.Reset();
+#endif
+}
+
+void SystemAllocator::SetTrackingEnabled(bool enabled) {
+#if EDGE_MEMORY_TRACKING
+	MemoryStats stats;
+	m_Tracked.GetStats(stats);
+	EDGE_ASSERT(stats.allocationCount == stats.freeCount,
+		"Cannot change tracking state with active allocations!");
+
+	m_TrackingEnabled = enabled;
+#else
+	EDGE_ASSERT(!enabled, "Memory tracking is compiled out, build with EDGE_MEMORY_TRACKING=1");
+	(void)enabled;
+#endif
+}
+
+void SystemAllocator::ReportLeaks() {
+#if EDGE_MEMORY_TRACKING
+	if (m_TrackingEnabled) {
+		m_Tracked.ReportLeaks();
+	}
+#endif
+}
+
+//==================================================================================================
+// Virtual Memory
+//==================================================================================================
+namespace {
+
+void* PlatformReserve(size_t size) {
+#if EDGE_PLATFORM_WINDOWS
+	return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+	flags |= MAP_NORESERVE;
+#endif
+	void* ptr = mmap(nullptr, size, PROT_NONE, flags, -1, 0);
+	return ptr == MAP_FAILED ? nullptr : ptr;
+#endif
+}
+
+bool PlatformCommit(void* ptr, size_t size) {
+#if EDGE_PLATFORM_WINDOWS
+	return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+	return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void PlatformDecommit(void* ptr, size_t size) {
+#if EDGE_PLATFORM_WINDOWS
+	VirtualFree(ptr, size, MEM_DECOMMIT);
+#else
+	// Darwin only drops MADV_DONTNEED pages lazily, MADV_FREE gives them back under pressure
+#if EDGE_PLATFORM_MACOS || EDGE_PLATFORM_IOS
+	madvise(ptr, size, MADV_FREE);
+#else
+	madvise(ptr, size, MADV_DONTNEED);
+#endif
+	mprotect(ptr, size, PROT_NONE);
+#endif
+}
+
+void PlatformRelease(void* ptr, size_t size) {
+#if EDGE_PLATFORM_WINDOWS
+	(void)size;
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+	munmap(ptr, size);
+#endif
+}
+
+std::atomic<size_t> g_LargePageBytes(0);
+
+#if EDGE_PLATFORM_WINDOWS
+// Large pages need SeLockMemoryPrivilege, which the account must hold for this to succeed
+bool EnableLockMemoryPrivilege() {
+	HANDLE token = nullptr;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+		return false;
+	}
+
+	TOKEN_PRIVILEGES privileges;
+	privileges.PrivilegeCount = 1;
+	privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+	bool enabled = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+		AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+		GetLastError() == ERROR_SUCCESS;
+
+	CloseHandle(token);
+	return enabled;
+}
+#endif
+
+// Reserve and commit size bytes of large pages, size must be a multiple of the large page size
+void* PlatformReserveLargePages(size_t size) {
+#if EDGE_PLATFORM_WINDOWS
+	static const bool privilegeEnabled = EnableLockMemoryPrivilege();
+	if (!privilegeEnabled) {
+		return nullptr;
+	}
+	return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+#elif EDGE_PLATFORM_MACOS && EDGE_ARCH_X64
+	void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+	return ptr == MAP_FAILED ? nullptr : ptr;
+#elif defined(MAP_HUGETLB)
+	// Fails unless the system has enough explicit huge pages set aside
+	void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	return ptr == MAP_FAILED ? nullptr : ptr;
+#else
+	(void)size;
+	return nullptr;
+#endif
+}
+
+} // namespace
+
+size_t GetLargePageSize()
+{
+	static const size_t largePageSize = []() -> size_t {
+#if EDGE_PLATFORM_WINDOWS
+		return static_cast<size_t>(GetLargePageMinimum());
+#elif EDGE_PLATFORM_MACOS && EDGE_ARCH_X64
+		return size_t(2) << 20;
+#elif defined(MAP_HUGETLB)
+		size_t size = 0;
+		if (FILE* file = fopen("/proc/meminfo", "r")) {
+			char line[128];
+			while (fgets(line, sizeof(line), file)) {
+				unsigned long kilobytes = 0;
+				if (sscanf(line, "Hugepagesize: %lu kB", &kilobytes) == 1) {
+					size = static_cast<size_t>(kilobytes) * 1024;
+					break;
+				}
+			}
+			fclose(file);
+		}
+		return size;
+#else
+		return 0;
+#endif
+	}();
+	return largePageSize;
+}
+
+size_t GetLargePageBytes()
+{
+	return g_LargePageBytes.load(std::memory_order_relaxed);
+}
+
+size_t GetPageSize()
+{
+	static const size_t pageSize = []() {
+#if EDGE_PLATFORM_WINDOWS
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return static_cast<size_t>(info.dwPageSize);
+#else
+		return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}();
+	return pageSize;
+}
+
+VirtualRange::VirtualRange() : m_Base(nullptr), m_Reserved(0), m_Committed(0), m_LargePages(false)
+{
+}
+
+VirtualRange::~VirtualRange()
+{
+	Release();
+}
+
+bool VirtualRange::Reserve(size_t size)
+{
+	EDGE_ASSERT(m_Base == nullptr, "VirtualRange is already reserved");
+
+	const size_t reserved = AlignUp(size, GetPageSize());
+	m_Base = static_cast<uint8_t*>(PlatformReserve(reserved));
+	if (!m_Base) {
+		EDGE_ASSERT(false, "Failed to reserve virtual memory");
+		return false;
+	}
+
+	m_Reserved = reserved;
+	m_Committed = 0;
+	return true;
+}
+
+bool VirtualRange::ReserveLargePages(size_t size)
+{
+	EDGE_ASSERT(m_Base == nullptr, "VirtualRange is already reserved");
+
+	const size_t largePageSize = GetLargePageSize();
+	if (largePageSize != 0) {
+		const size_t reserved = AlignUp(size, largePageSize);
+		m_Base = static_cast<uint8_t*>(PlatformReserveLargePages(reserved));
+		if (m_Base) {
+			m_Reserved = reserved;
+			m_Committed = reserved;
+			m_LargePages = true;
+			g_LargePageBytes.fetch_add(reserved, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+#if !EDGE_PLATFORM_WINDOWS && defined(MADV_HUGEPAGE)
+	// Transparent huge pages only back 2MB aligned runs, so line the reservation up with one
+	if (largePageSize != 0) {
+		const size_t reserved = AlignUp(size, largePageSize);
+		uint8_t* raw = static_cast<uint8_t*>(PlatformReserve(reserved + largePageSize));
+		if (raw) {
+			uint8_t* base = static_cast<uint8_t*>(AlignPointer(raw, largePageSize));
+			if (base != raw) {
+				munmap(raw, static_cast<size_t>(base - raw));
+			}
+			munmap(base + reserved, static_cast<size_t>(raw + largePageSize - base));
+
+			madvise(base, reserved, MADV_HUGEPAGE);
+			m_Base = base;
+			m_Reserved = reserved;
+			m_Committed = 0;
+			return false;
+		}
+	}
+#endif
+
+	Reserve(size);
+	return false;
+}
+
+void VirtualRange::Release()
+{
+	if (m_Base) {
+		PlatformRelease(m_Base, m_Reserved);
+	}
+	if (m_LargePages) {
+		g_LargePageBytes.fetch_sub(m_Reserved, std::memory_order_relaxed);
+	}
+	m_Base = nullptr;
+	m_Reserved = 0;
+	m_Committed = 0;
+	m_LargePages = false;
+}
+
+bool VirtualRange::Commit(size_t size)
+{
+	if (size <= m_Committed) {
+		return true;
+	}
+	if (size > m_Reserved) {
+		return false;
+	}
+
+	EDGE_PROFILE_SCOPE("VirtualRange Commit");
+
+	// Commit in large steps to keep the number of system calls down
+	size_t target = AlignUp(size, COMMIT_GRANULARITY);
+	if (target > m_Reserved) {
+		target = m_Reserved;
+	}
+
+	if (!PlatformCommit(m_Base + m_Committed, target - m_Committed)) {
+		return false;
+	}
+
+	m_Committed = target;
+	return true;
+}
+
+void VirtualRange::Decommit(size_t size)
+{
+	const size_t keep = AlignUp(size, GetPageSize());
+	if (m_LargePages || keep >= m_Committed) {
+		return;
+	}
+
+	EDGE_PROFILE_SCOPE("VirtualRange Decommit");
+
+	PlatformDecommit(m_Base + keep, m_Committed - keep);
+	m_Committed = keep;
+}
+
+//==================================================================================================
+// LinearAllocator Implementation
+//==================================================================================================
+
+LinearAllocator::LinearAllocator(size_t size, MemoryBacking backing)
+	: m_Buffer(nullptr), m_Size(size), m_Offset(0), m_CommitLimit(0), m_Backing(backing) {
+
+	memset(&m_Stats, 0, sizeof(MemoryStats));
+
+	if (m_Backing == MemoryBacking::LargePages) {
+		m_Range.ReserveLargePages(size);
+		m_Buffer = m_Range.GetBase();
+		m_CommitLimit = m_Range.GetCommittedSize();
+		return;
+	}
+
+	if (m_Backing == MemoryBacking::Virtual) {
+		if (m_Range.Reserve(size)) {
+			m_Buffer = m_Range.GetBase();
+		}
+		return;
+	}
+
+	m_Buffer = static_cast<uint8_t*>(memory::Allocate(size, EDGE_CACHE_LINE_SIZE));
+	EDGE_ASSERT(m_Buffer != nullptr, "Failed to allocate memory for LinearAllocator");
+	m_CommitLimit = m_Buffer ? size : 0;
+}
+
+LinearAllocator::~LinearAllocator() {
+	if (m_Backing == MemoryBacking::Heap) {
+		memory::Free(m_Buffer);
+	}
+	m_Buffer = nullptr;
+}
+
+bool LinearAllocator::CommitTo(size_t offset) {
+	if (m_Backing == MemoryBacking::Heap || !m_Range.Commit(offset)) {
+		return false;
+	}
+
+	m_CommitLimit = m_Range.GetCommittedSize();
+	return true;
+}
+
+void* LinearAllocator::Allocate(size_t size, size_t alignment) {
+	return Allocate(size, MemoryTag::NoTag, alignment);
+}
+
+void* LinearAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment) {
+	(void)tag;
+	if (size == 0) {
+		return nullptr;
+	}
+
+	void* ptr = TryAllocate(size, alignment);
+	EDGE_ASSERT(ptr, "LinearAllocator out of memory");
+	return ptr;
+}
+
+void* LinearAllocator::TryAllocate(size_t size, size_t alignment) {
+	if (size == 0) {
+		return nullptr;
+	}
+
+	// Calculate aligned address
+	size_t alignmentMask = alignment - 1;
+	size_t alignedOffset = (m_Offset + alignmentMask) & ~alignmentMask;
+
+	if (alignedOffset + size > m_CommitLimit) {
+		if (alignedOffset + size > m_Size || !CommitTo(alignedOffset + size)) {
+			return nullptr;
+		}
+	}
+
+	void* ptr = m_Buffer + alignedOffset;
+	m_Offset = alignedOffset + size;
+
+	// Update stats
+	m_Stats.totalAllocated += size;
+	m_Stats.currentUsage += size;
+	m_Stats.allocationCount++;
+
+	if (m_Stats.currentUsage > m_Stats.peakUsage) {
+		m_Stats.peakUsage = m_Stats.currentUsage;
+	}
+
+	return ptr;
+}
+
+bool LinearAllocator::AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag) {
+	(void)tag;
+	if (count == 0) {
+		return true;
+	}
+	if (size == 0) {
+		return false;
+	}
+
+	const size_t stride = memory::AlignUp(size, alignment);
+	const size_t alignedOffset = memory::AlignUp(m_Offset, alignment);
+	if (alignedOffset > m_Size || (m_Size - alignedOffset) / stride < count - 1 ||
+		m_Size - alignedOffset - stride * (count - 1) < size) {
+		EDGE_ASSERT(false, "LinearAllocator out of memory");
+		return false;
+	}
+
+	const size_t end = alignedOffset + stride * (count - 1) + size;
+	if (end > m_CommitLimit && !CommitTo(end)) {
+		EDGE_ASSERT(false, "LinearAllocator failed to commit memory");
+		return false;
+	}
+
+	uint8_t* ptr = m_Buffer + alignedOffset;
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = ptr;
+		ptr += stride;
+	}
+	m_Offset = end;
+
+	// Update stats
+	m_Stats.totalAllocated += size * count;
+	m_Stats.currentUsage += size * count;
+	m_Stats.allocationCount += count;
+
+	if (m_Stats.currentUsage > m_Stats.peakUsage) {
+		m_Stats.peakUsage = m_Stats.currentUsage;
+	}
+
+	return true;
+}
+
+void LinearAllocator::FreeBatch(void** ptrs, size_t count) {
+	(void)ptrs;
+	(void)count;
+}
+
+void LinearAllocator::Free(void* ptr) {
+	// Individual frees are not supported in a linear allocator
+	// We simply ignore this call
+	(void)ptr;
+}
+
+void LinearAllocator::Free(void* ptr, size_t size, size_t alignment) {
+	(void)ptr;
+	(void)size;
+	(void)alignment;
+}
+
+void LinearAllocator::GetStats(MemoryStats& stats) const {
+	stats = m_Stats;
+	stats.largePageBytes = m_Range.UsesLargePages() ? m_Range.GetReservedSize() : 0;
+}
+
+void LinearAllocator::Reset() {
+	m_Offset = 0;
+	if (m_Backing != MemoryBacking::Heap) {
+		// Give the pages back, markers rewind too often for this to pay off there
+		m_Range.Decommit(0);
+		m_CommitLimit = m_Range.GetCommittedSize();
+	}
+
+	m_Stats.totalFreed += m_Stats.currentUsage;
+	m_Stats.currentUsage = 0;
+	m_Stats.freeCount = m_Stats.allocationCount;
+}
+
+LinearAllocator::Marker LinearAllocator::GetMarker() const {
+	Marker marker;
+	marker.offset = m_Offset;
+	marker.usage = m_Stats.currentUsage;
+	marker.allocationCount = m_Stats.allocationCount;
+	marker.freeCount = m_Stats.freeCount;
+	return marker;
+}
+
+void LinearAllocator::FreeToMarker(const Marker& marker) {
+	if (marker.offset > m_Offset) {
+		EDGE_ASSERT(false, "Marker is past the current offset, markers must be freed in stack order");
+		return;
+	}
+
+	m_Offset = marker.offset;
+
+	// Everything allocated after the marker counts as freed
+	m_Stats.totalFreed += m_Stats.currentUsage - marker.usage;
+	m_Stats.currentUsage = marker.usage;
+	m_Stats.freeCount = marker.freeCount + (m_Stats.allocationCount - marker.allocationCount);
+}
+
+//==================================================================================================
+// FrameAllocator Implementation
+//==================================================================================================
+
+struct alignas(EDGE_CACHE_LINE_SIZE) FrameAllocator::Slice {
+	LinearAllocator allocator;
+	uint64_t frame;		// frame the slice was last reset for
+
+	Slice(size_t size) : allocator(size), frame(0) {
+	}
+};
+
+FrameAllocator::FrameAllocator(size_t sliceSize, size_t sliceCount, size_t frameCount)
+	: m_SliceCount(sliceCount), m_FrameCount(frameCount), m_FrameIndex(0), m_ObservedPeak(0) {
+
+	EDGE_ASSERT(frameCount > 0, "FrameAllocator needs at least one frame buffer");
+
+	const size_t total = m_FrameCount * (m_SliceCount + 1);
+	m_Slices = static_cast<Slice*>(memory::Allocate(sizeof(Slice) * total, alignof(Slice)));
+	EDGE_ASSERT(m_Slices != nullptr, "Failed to allocate slices for FrameAllocator");
+
+	for (size_t i = 0; i < total; ++i) {
+		new (&m_Slices[i]) Slice(sliceSize);
+	}
+}
+
+FrameAllocator::~FrameAllocator() {
+	const size_t total = m_FrameCount * (m_SliceCount + 1);
+	for (size_t i = 0; i < total; ++i) {
+		m_Slices[i].~Slice();
+	}
+	memory::Free(m_Slices);
+	m_Slices = nullptr;
+}
+
+FrameAllocator::Slice& FrameAllocator::GetSlice(uint64_t frame, size_t slice) const {
+	return m_Slices[(frame % m_FrameCount) * (m_SliceCount + 1) + slice];
+}
+
+// Slice allocator for the frame, reset first if it still holds an older frame's data
+LinearAllocator& FrameAllocator::GetFrameSlice(uint64_t frame, size_t slice) {
+	Slice& current = GetSlice(frame, slice);
+	if (current.frame != frame) {
+		current.allocator.Reset();
+		current.frame = frame;
+	}
+	return current.allocator;
+}
+
+void* FrameAllocator::Allocate(size_t size, size_t alignment) {
+	return Allocate(size, MemoryTag::NoTag, alignment);
+}
+
+void* FrameAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment) {
+	// Only written by BeginFrame at a sync point, the load is a plain read on the hot path
+	const uint64_t frame = m_FrameIndex.load(std::memory_order_relaxed);
+	const uint32_t slot = GetThreadSlot();
+
+	if (slot < m_SliceCount) {
+		return GetFrameSlice(frame, slot).Allocate(size, tag, alignment);
+	}
+
+	std::lock_guard<std::mutex> lock(m_OverflowLock);
+	return GetFrameSlice(frame, m_SliceCount).Allocate(size, tag, alignment);
+}
+
+void* FrameAllocator::TryAllocateFromSlice(size_t slice, size_t size, size_t alignment) {
+	const uint64_t frame = m_FrameIndex.load(std::memory_order_relaxed);
+	if (slice < m_SliceCount) {
+		return GetFrameSlice(frame, slice).TryAllocate(size, alignment);
+	}
+
+	std::lock_guard<std::mutex> lock(m_OverflowLock);
+	return GetFrameSlice(frame, m_SliceCount).TryAllocate(size, alignment);
+}
+
+bool FrameAllocator::AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag) {
+	const uint64_t frame = m_FrameIndex.load(std::memory_order_relaxed);
+	const uint32_t slot = GetThreadSlot();
+
+	if (slot < m_SliceCount) {
+		return GetFrameSlice(frame, slot).AllocateBatch(count, size, alignment, out, tag);
+	}
+
+	// One trip through the overflow lock for the whole batch
+	std::lock_guard<std::mutex> lock(m_OverflowLock);
+	return GetFrameSlice(frame, m_SliceCount).AllocateBatch(count, size, alignment, out, tag);
+}
+
+void FrameAllocator::FreeBatch(void** ptrs, size_t count) {
+	(void)ptrs;
+	(void)count;
+}
+
+void FrameAllocator::Free(void* ptr) {
+	// Frame memory is released in bulk when its buffer comes around again
+	(void)ptr;
+}
+
+void FrameAllocator::Free(void* ptr, size_t size, size_t alignment) {
+	(void)ptr;
+	(void)size;
+	(void)alignment;
+}
+
+void FrameAllocator::GetStats(MemoryStats& stats) const {
+	memset(&stats, 0, sizeof(MemoryStats));
+
+	const uint64_t frame = m_FrameIndex.load(std::memory_order_relaxed);
+	const size_t total = m_FrameCount * (m_SliceCount + 1);
+	for (size_t i = 0; i < total; ++i) {
+		MemoryStats sliceStats;
+		m_Slices[i].allocator.GetStats(sliceStats);
+
+		// Slices that haven't been touched since their buffer was recycled hold dead data
+		const bool live = m_Slices[i].frame + m_FrameCount > frame;
+		stats.totalAllocated += sliceStats.totalAllocated;
+		stats.allocationCount += sliceStats.allocationCount;
+		if (live) {
+			stats.totalFreed += sliceStats.totalFreed;
+			stats.currentUsage += sliceStats.currentUsage;
+			stats.freeCount += sliceStats.freeCount;
+		}
+		else {
+			stats.totalFreed += sliceStats.totalAllocated;
+			stats.freeCount += sliceStats.allocationCount;
+		}
+	}
+
+	// Slices are reset lazily, so the peak is the highest usage seen by a query
+	size_t peak = m_ObservedPeak.load(std::memory_order_relaxed);
+	while (stats.currentUsage > peak && !m_ObservedPeak.compare_exchange_weak(peak, stats.currentUsage, std::memory_order_relaxed)) {
+	}
+	stats.peakUsage = stats.currentUsage > peak ? stats.currentUsage : peak;
+}
+
+void FrameAllocator::Reset() {
+	const uint64_t frame = m_FrameIndex.load(std::memory_order_relaxed);
+	const size_t total = m_FrameCount * (m_SliceCount + 1);
+	for (size_t i = 0; i < total; ++i) {
+		m_Slices[i].allocator.Reset();
+		m_Slices[i].frame = frame;
+	}
+}
+
+void FrameAllocator::BeginFrame() {
+	m_FrameIndex.store(m_FrameIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint64_t FrameAllocator::GetFrameIndex() const {
+	return m_FrameIndex.load(std::memory_order_relaxed);
+}
+
+//==================================================================================================
+// PoolAllocator Implementation
+//==================================================================================================
+namespace {
+constexpr size_t kMinChunkSize = 4096;
+}
+
+struct PoolAllocator::Chunk {
+	PoolAllocator* owner;		// checked by Free to reject foreign pointers
+	Chunk* prev;
+	Chunk* next;
+	Chunk* prevAvailable;
+	Chunk* nextAvailable;
+	uintptr_t* freeList;
+	size_t freeCount;
+};
+
+PoolAllocator::PoolAllocator(size_t elementSize, size_t elementCount, size_t alignment, PoolGrowth growth, MemoryBacking backing)
+	: m_Buffer(nullptr), m_FreeList(nullptr), m_ElementSize(elementSize), m_ElementCount(elementCount), m_AlignedElementSize(0),
+	m_ElementAlignment(alignment), m_FreeCount(elementCount), m_CarvedCount(0), m_Backing(backing), m_Growth(growth), m_Chunks(nullptr), m_Available(nullptr), m_ChunkSize(0), m_ChunkHeaderSize(0), m_ChunkCapacity(0),
+	m_ChunkCount(0), m_IdleChunks(0), m_MaxIdleChunks(std::numeric_limits<size_t>::max()) {
+
+	// Calculate aligned element size
+	m_AlignedElementSize = memory::AlignUp(elementSize, alignment);
+	memset(&m_Stats, 0, sizeof(MemoryStats));
+
+	if (m_Growth == PoolGrowth::Chunked) {
+		// Chunks already grow on demand, keep them on the heap
+		EDGE_ASSERT(m_Backing == MemoryBacking::Heap, "Virtual and large page backing only apply to fixed pools");
+		m_Backing = MemoryBacking::Heap;
+
+		// Round the chunk up to a power of two so it can be aligned to its own size
+		m_ChunkHeaderSize = memory::AlignUp(sizeof(Chunk), alignment);
+		size_t required = m_ChunkHeaderSize + m_AlignedElementSize * elementCount;
+		m_ChunkSize = kMinChunkSize;
+		while (m_ChunkSize < required) {
+			m_ChunkSize <<= 1;
+		}
+		m_ChunkCapacity = (m_ChunkSize - m_ChunkHeaderSize) / m_AlignedElementSize;
+		m_ElementCount = 0;
+		m_FreeCount = 0;
+
+		AddChunk();
+		return;
+	}
+
+	// Allocate the pool, elements are carved from it lazily so no free list is built up front
+	size_t totalSize = m_AlignedElementSize * elementCount;
+	if (m_Backing != MemoryBacking::Heap) {
+		EDGE_ASSERT(alignment <= GetPageSize(), "Virtual pools align to at most a page");
+		if (m_Backing == MemoryBacking::LargePages) {
+			m_Range.ReserveLargePages(totalSize);
+		}
+		else {
+			m_Range.Reserve(totalSize);
+		}
+		m_Buffer = m_Range.GetBase();
+		return;
+	}
+
+	m_Buffer = static_cast<uint8_t*>(memory::Allocate(totalSize, alignment));
+	EDGE_ASSERT(m_Buffer != nullptr, "Failed to allocate memory for PoolAllocator");
+}
+
+PoolAllocator::~PoolAllocator() {
+	while (m_Chunks) {
+		Chunk* next = m_Chunks->next;
+		GetSystemAllocator()->Free(m_Chunks);
+		m_Chunks = next;
+	}
+
+	if (m_Backing == MemoryBacking::Heap) {
+		memory::Free(m_Buffer);
+	}
+	m_Buffer = nullptr;
+	m_FreeList = nullptr;
+}
+
+void* PoolAllocator::Allocate(size_t size, size_t alignment) {
+	return Allocate(size, MemoryTag::NoTag, alignment);
+}
+
+void* PoolAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment) {
+	if (size > m_ElementSize) {
+		EDGE_ASSERT(false, "Requested size is larger than pool element size");
+		return nullptr;
+	}
+
+	void* ptr = nullptr;
+
+	if (m_Growth == PoolGrowth::Chunked) {
+		Chunk* chunk = m_Available ? m_Available : AddChunk();
+		if (chunk == nullptr) {
+			EDGE_ASSERT(false, "Pool allocator failed to grow");
+			return nullptr;
+		}
+
+		if (chunk->freeCount == m_ChunkCapacity) {
+			m_IdleChunks--;
+		}
+
+		ptr = chunk->freeList;
+		chunk->freeList = reinterpret_cast<uintptr_t*>(*chunk->freeList);
+		chunk->freeCount--;
+		if (chunk->freeCount == 0) {
+			UnlinkAvailable(chunk);
+		}
+	}
+	else if (m_FreeList) {
+		ptr = m_FreeList;
+		m_FreeList = reinterpret_cast<uintptr_t*>(*m_FreeList);
+	}
+	else {
+		if (m_Buffer == nullptr || m_CarvedCount == m_ElementCount) {
+			EDGE_ASSERT(false, "Pool allocator is out of memory");
+			return nullptr;
+		}
+
+		const size_t end = (m_CarvedCount + 1) * m_AlignedElementSize;
+		if (m_Backing != MemoryBacking::Heap && !m_Range.Commit(end)) {
+			EDGE_ASSERT(false, "Pool allocator failed to commit memory");
+			return nullptr;
+		}
+
+		ptr = m_Buffer + m_CarvedCount * m_AlignedElementSize;
+		m_CarvedCount++;
+	}
+
+	m_FreeCount--;
+
+	// Update stats
+	m_Stats.totalAllocated += m_ElementSize;
+	m_Stats.currentUsage += m_ElementSize;
+	m_Stats.allocationCount++;
+
+	if (m_Stats.currentUsage > m_Stats.peakUsage) {
+		m_Stats.peakUsage = m_Stats.currentUsage;
+	}
+
+	return ptr;
+}
+
+void PoolAllocator::Free(void* ptr) {
+	if (ptr == nullptr) {
+		return;
+	}
+
+	if (m_Growth == PoolGrowth::Chunked) {
+		if (!ReturnToChunk(ptr)) {
+			return;
+		}
+
+		// Update stats
+		m_Stats.totalFreed += m_ElementSize;
+		m_Stats.currentUsage -= m_ElementSize;
+		m_Stats.freeCount++;
+		return;
+	}
+
+	// Validate the pointer is within our pool
+	if (ptr < m_Buffer || ptr >= (m_Buffer + m_AlignedElementSize * m_ElementCount)) {
+		EDGE_ASSERT(false, "Pointer does not belong to this pool");
+		return;
+	}
+
+	// Insert at the head of free list
+	*reinterpret_cast<uintptr_t*>(ptr) = reinterpret_cast<uintptr_t>(m_FreeList);
+	m_FreeList = reinterpret_cast<uintptr_t*>(ptr);
+	m_FreeCount++;
+
+	// Update stats
+	m_Stats.totalFreed += m_ElementSize;
+	m_Stats.currentUsage -= m_ElementSize;
+	m_Stats.freeCount++;
+}
+
+void PoolAllocator::Free(void* ptr, size_t size, size_t alignment) {
+	// Every element has the same size, there is nothing to look up
+	(void)alignment;
+	EDGE_ASSERT(size <= m_ElementSize, "Sized free is larger than pool element size");
+	(void)size;
+	Free(ptr);
+}
+
+bool PoolAllocator::AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag) {
+	(void)alignment;
+	(void)tag;
+	if (size > m_ElementSize) {
+		EDGE_ASSERT(false, "Requested size is larger than pool element size");
+		return false;
+	}
+	if (count == 0) {
+		return true;
+	}
+
+	if (m_Growth == PoolGrowth::Chunked) {
+		// Grow up front so a failed batch leaves nothing allocated
+		while (m_FreeCount < count) {
+			if (AddChunk() == nullptr) {
+				EDGE_ASSERT(false, "Pool allocator failed to grow");
+				return false;
+			}
+		}
+
+		// Take a run off each available chunk's free list until the batch is filled
+		size_t filled = 0;
+		while (filled < count) {
+			Chunk* chunk = m_Available;
+			if (chunk->freeCount == m_ChunkCapacity) {
+				m_IdleChunks--;
+			}
+
+			const size_t take = chunk->freeCount < count - filled ? chunk->freeCount : count - filled;
+			uintptr_t* block = chunk->freeList;
+			for (size_t i = 0; i < take; ++i) {
+				out[filled++] = block;
+				block = reinterpret_cast<uintptr_t*>(*block);
+			}
+			chunk->freeList = block;
+			chunk->freeCount -= take;
+			if (chunk->freeCount == 0) {
+				UnlinkAvailable(chunk);
+			}
+		}
+	}
+	else {
+		if (m_Buffer == nullptr || count > m_FreeCount) {
+			EDGE_ASSERT(false, "Pool allocator is out of memory");
+			return false;
+		}
+
+		// Recycled elements go first, whatever they don't cover is carved as one run
+		const size_t listed = m_FreeCount - (m_ElementCount - m_CarvedCount);
+		const size_t carved = count > listed ? count - listed : 0;
+		if (carved && m_Backing != MemoryBacking::Heap && !m_Range.Commit((m_CarvedCount + carved) * m_AlignedElementSize)) {
+			EDGE_ASSERT(false, "Pool allocator failed to commit memory");
+			return false;
+		}
+
+		size_t filled = 0;
+		uintptr_t* block = m_FreeList;
+		while (filled < count - carved) {
+			out[filled++] = block;
+			block = reinterpret_cast<uintptr_t*>(*block);
+		}
+		m_FreeList = block;
+
+		uint8_t* element = m_Buffer + m_CarvedCount * m_AlignedElementSize;
+		while (filled < count) {
+			out[filled++] = element;
+			element += m_AlignedElementSize;
+		}
+		m_CarvedCount += carved;
+	}
+
+	m_FreeCount -= count;
+
+	// Update stats
+	m_Stats.totalAllocated += m_ElementSize * count;
+	m_Stats.currentUsage += m_ElementSize * count;
+	m_Stats.allocationCount += count;
+
+	if (m_Stats.currentUsage > m_Stats.peakUsage) {
+		m_Stats.peakUsage = m_Stats.currentUsage;
+	}
+
+	return true;
+}
+
+void PoolAllocator::FreeBatch(void** ptrs, size_t count) {
+	size_t freed = 0;
+
+	if (m_Growth == PoolGrowth::Chunked) {
+		for (size_t i = 0; i < count; ++i) {
+			if (ptrs[i] && ReturnToChunk(ptrs[i])) {
+				freed++;
+			}
+		}
+	}
+	else {
+		// Link the batch back to front so it lands on the free list in order, as one segment
+		const uint8_t* end = m_Buffer + m_AlignedElementSize * m_ElementCount;
+		uintptr_t* head = m_FreeList;
+		for (size_t i = count; i-- > 0;) {
+			uint8_t* ptr = static_cast<uint8_t*>(ptrs[i]);
+			if (ptr == nullptr) {
+				continue;
+			}
+			if (ptr < m_Buffer || ptr >= end) {
+				EDGE_ASSERT(false, "Pointer does not belong to this pool");
+				continue;
+			}
+
+			*reinterpret_cast<uintptr_t*>(ptr) = reinterpret_cast<uintptr_t>(head);
+			head = reinterpret_cast<uintptr_t*>(ptr);
+			freed++;
+		}
+		m_FreeList = head;
+		m_FreeCount += freed;
+	}
+
+	// Update stats
+	m_Stats.totalFreed += m_ElementSize * freed;
+	m_Stats.currentUsage -= m_ElementSize * freed;
+	m_Stats.freeCount += freed;
+}
+
+void PoolAllocator::GetStats(MemoryStats& stats) const {
+	stats = m_Stats;
+	stats.largePageBytes = m_Range.UsesLargePages() ? m_Range.GetReservedSize() : 0;
+}
+
+void PoolAllocator::Reset() {
+	if (m_Growth == PoolGrowth::Chunked) {
+		m_Available = nullptr;
+		for (Chunk* chunk = m_Chunks; chunk; chunk = chunk->next) {
+			BuildChunkFreeList(chunk);
+			LinkAvailable(chunk);
+		}
+		m_FreeCount = m_ElementCount;
+		m_IdleChunks = m_ChunkCount;
+
+		// Trim back down to the idle limit, always keeping one chunk
+		while (m_IdleChunks > m_MaxIdleChunks && m_ChunkCount > 1) {
+			ReleaseChunk(m_Chunks);
+		}
+	}
+	else {
+		// Every element goes back to unused, carving starts over from the front
+		m_FreeList = nullptr;
+		m_CarvedCount = 0;
+		m_FreeCount = m_ElementCount;
+
+		if (m_Backing != MemoryBacking::Heap) {
+			m_Range.Decommit(0);
+		}
+	}
+
+	// Update stats
+	m_Stats.totalFreed += m_Stats.currentUsage;
+	m_Stats.currentUsage = 0;
+	m_Stats.freeCount = m_Stats.allocationCount;
+}
+
+void PoolAllocator::SetIdleChunkLimit(size_t maxIdleChunks) {
+	EDGE_ASSERT(m_Growth == PoolGrowth::Chunked, "Idle chunk limit only applies to chunked pools");
+	m_MaxIdleChunks = maxIdleChunks;
+}
+
+size_t PoolAllocator::GetChunkCount() const {
+	return m_Growth == PoolGrowth::Chunked ? m_ChunkCount : 1;
+}
+
+PoolAllocator::Chunk* PoolAllocator::AddChunk() {
+	EDGE_PROFILE_SCOPE("PoolAllocator AddChunk");
+	// Chunks come straight from the system allocator, the thread cache would pad the alignment
+	Chunk* chunk = static_cast<Chunk*>(GetSystemAllocator()->Allocate(m_ChunkSize, m_ChunkSize));
+	if (chunk == nullptr) {
+		return nullptr;
+	}
+
+	chunk->owner = this;
+	chunk->prev = nullptr;
+	chunk->next = m_Chunks;
+	if (m_Chunks) {
+		m_Chunks->prev = chunk;
+	}
+	m_Chunks = chunk;
+
+	BuildChunkFreeList(chunk);
+	LinkAvailable(chunk);
+
+	m_ChunkCount++;
+	m_IdleChunks++;
+	m_ElementCount += m_ChunkCapacity;
+	m_FreeCount += m_ChunkCapacity;
+	return chunk;
+}
+
+// Push an element back onto its chunk, releasing the chunk once it goes idle past the limit
+bool PoolAllocator::ReturnToChunk(void* ptr) {
+	// Chunks are aligned to their size, the header sits at the masked address
+	Chunk* chunk = reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(ptr) & ~(m_ChunkSize - 1));
+	if (chunk->owner != this) {
+		EDGE_ASSERT(false, "Pointer does not belong to this pool");
+		return false;
+	}
+
+	EDGE_ASSERT((static_cast<uint8_t*>(ptr) - reinterpret_cast<uint8_t*>(chunk) - m_ChunkHeaderSize) % m_AlignedElementSize == 0,
+		"Pointer is not the start of a pool element");
+
+	*reinterpret_cast<uintptr_t*>(ptr) = reinterpret_cast<uintptr_t>(chunk->freeList);
+	chunk->freeList = reinterpret_cast<uintptr_t*>(ptr);
+	if (chunk->freeCount++ == 0) {
+		LinkAvailable(chunk);
+	}
+	m_FreeCount++;
+
+	// Like Reset, always keep one chunk so an alloc/free loop doesn't churn a chunk per iteration
+	if (chunk->freeCount == m_ChunkCapacity && ++m_IdleChunks > m_MaxIdleChunks && m_ChunkCount > 1) {
+		ReleaseChunk(chunk);
+	}
+	return true;
+}
+
+void PoolAllocator::ReleaseChunk(Chunk* chunk) {
+	EDGE_ASSERT(chunk->freeCount == m_ChunkCapacity, "Cannot release a chunk with live elements");
+
+	UnlinkAvailable(chunk);
+	if (chunk->prev) {
+		chunk->prev->next = chunk->next;
+	}
+	else {
+		m_Chunks = chunk->next;
+	}
+	if (chunk->next) {
+		chunk->next->prev = chunk->prev;
+	}
+
+	m_ChunkCount--;
+	m_IdleChunks--;
+	m_ElementCount -= m_ChunkCapacity;
+	m_FreeCount -= m_ChunkCapacity;
+
+	chunk->owner = nullptr;
+	GetSystemAllocator()->Free(chunk);
+}
+
+void PoolAllocator::BuildChunkFreeList(Chunk* chunk) {
+	uint8_t* elements = reinterpret_cast<uint8_t*>(chunk) + m_ChunkHeaderSize;
+	for (size_t i = 0; i < m_ChunkCapacity - 1; ++i) {
+		uintptr_t* block = reinterpret_cast<uintptr_t*>(elements + (i * m_AlignedElementSize));
+		*block = reinterpret_cast<uintptr_t>(elements + ((i + 1) * m_AlignedElementSize));
+	}
+	*reinterpret_cast<uintptr_t*>(elements + ((m_ChunkCapacity - 1) * m_AlignedElementSize)) = 0;
+
+	chunk->freeList = reinterpret_cast<uintptr_t*>(elements);
+	chunk->freeCount = m_ChunkCapacity;
+}
+
+void PoolAllocator::LinkAvailable(Chunk* chunk) {
+	chunk->prevAvailable = nullptr;
+	chunk->nextAvailable = m_Available;
+	if (m_Available) {
+		m_Available->prevAvailable = chunk;
+	}
+	m_Available = chunk;
+}
+
+void PoolAllocator::UnlinkAvailable(Chunk* chunk) {
+	if (chunk->prevAvailable) {
+		chunk->prevAvailable->nextAvailable = chunk->nextAvailable;
+	}
+	else if (m_Available == chunk) {
+		m_Available = chunk->nextAvailable;
+	}
+	if (chunk->nextAvailable) {
+		chunk->nextAvailable->prevAvailable = chunk->prevAvailable;
+	}
+	chunk->prevAvailable = nullptr;
+	chunk->nextAvailable = nullptr;
+}
+
+//==================================================================================================
+// ConcurrentPoolAllocator Implementation
+//==================================================================================================
+namespace {
+constexpr uint32_t kNullIndex = 0xFFFFFFFF;
+constexpr uint32_t kMagazineCapacity = 32;
+}
+
+struct alignas(EDGE_CACHE_LINE_SIZE) ConcurrentPoolAllocator::Magazine {
+	uint32_t count;
+	uint32_t blocks[kMagazineCapacity];
+	// Written by the owning thread only, except for the shared overflow magazine
+	std::atomic<size_t> allocationCount;
+	std::atomic<size_t> freeCount;
+};
+
+ConcurrentPoolAllocator::ConcurrentPoolAllocator(size_t elementSize, size_t elementCount, size_t alignment, bool useMagazines)
+	: m_Head(0), m_ElementSize(elementSize), m_ElementCount(elementCount), m_ResetCount(0), m_ObservedPeak(0), m_UseMagazines(useMagazines) {
+
+	EDGE_ASSERT(elementCount > 0 && elementCount < kNullIndex, "ConcurrentPoolAllocator element count out of range");
+
+	// Every free block stores the index of the next one
+	m_AlignedElementSize = memory::AlignUp(elementSize > sizeof(uint32_t) ? elementSize : sizeof(uint32_t), alignment);
+
+	m_Buffer = static_cast<uint8_t*>(memory::Allocate(m_AlignedElementSize * elementCount, alignment));
+	EDGE_ASSERT(m_Buffer != nullptr, "Failed to allocate memory for ConcurrentPoolAllocator");
+
+	m_Magazines = static_cast<Magazine*>(memory::Allocate(sizeof(Magazine) * (EDGE_MAX_THREAD_SLOTS + 1), alignof(Magazine)));
+	EDGE_ASSERT(m_Magazines != nullptr, "Failed to allocate magazines for ConcurrentPoolAllocator");
+	for (size_t i = 0; i <= EDGE_MAX_THREAD_SLOTS; ++i) {
+		new (&m_Magazines[i]) Magazine();
+		m_Magazines[i].count = 0;
+		m_Magazines[i].allocationCount.store(0, std::memory_order_relaxed);
+		m_Magazines[i].freeCount.store(0, std::memory_order_relaxed);
+	}
+
+	Reset();
+	m_ResetCount = 0;
+}
+
+ConcurrentPoolAllocator::~ConcurrentPoolAllocator() {
+	for (size_t i = 0; i <= EDGE_MAX_THREAD_SLOTS; ++i) {
+		m_Magazines[i].~Magazine();
+	}
+	memory::Free(m_Magazines);
+	memory::Free(m_Buffer);
+	m_Magazines = nullptr;
+	m_Buffer = nullptr;
+}
+
+std::atomic<uint32_t>& ConcurrentPoolAllocator::NextIndex(uint32_t index) const {
+	return *reinterpret_cast<std::atomic<uint32_t>*>(m_Buffer + index * m_AlignedElementSize);
+}
+
+uint32_t ConcurrentPoolAllocator::PopShared() {
+	uint64_t head = m_Head.load(std::memory_order_acquire);
+	for (;;) {
+		uint32_t index = static_cast<uint32_t>(head);
+		if (index == kNullIndex) {
+			return kNullIndex;
+		}
+
+		// If another thread pops this block first the read may be stale, the tag bump
+		// guarantees the exchange fails in that case.
+		uint32_t next = NextIndex(index).load(std::memory_order_relaxed);
+		uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+		if (m_Head.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire)) {
+			return index;
+		}
+	}
+}
+
+// Push a chain of blocks already linked from first to last.
+void ConcurrentPoolAllocator::PushShared(uint32_t first, uint32_t last) {
+	uint64_t head = m_Head.load(std::memory_order_relaxed);
+	uint64_t newHead;
+	do {
+		NextIndex(last).store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+		newHead = (((head >> 32) + 1) << 32) | first;
+	} while (!m_Head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void* ConcurrentPoolAllocator::Allocate(size_t size, size_t alignment) {
+	return Allocate(size, MemoryTag::NoTag, alignment);
+}
+
+void* ConcurrentPoolAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment) {
+	(void)tag;
+
+	if (size > m_ElementSize) {
+		EDGE_ASSERT(false, "Requested size is larger than pool element size");
+		return nullptr;
+	}
+
+	void* ptr = TryAllocate(size, alignment);
+	EDGE_ASSERT(ptr, "Pool allocator is out of memory");
+	return ptr;
+}
+
+void* ConcurrentPoolAllocator::TryAllocate(size_t size, size_t alignment) {
+	(void)alignment;
+
+	if (size > m_ElementSize) {
+		return nullptr;
+	}
+
+	const uint32_t slot = GetThreadSlot();
+	Magazine& magazine = m_Magazines[slot];
+	uint32_t index = kNullIndex;
+
+	if (m_UseMagazines && slot < EDGE_MAX_THREAD_SLOTS) {
+		if (magazine.count == 0) {
+			// Refill half a magazine so alternating alloc/free doesn't bounce on the shared list
+			while (magazine.count < kMagazineCapacity / 2) {
+				uint32_t popped = PopShared();
+				if (popped == kNullIndex) {
+					break;
+				}
+				magazine.blocks[magazine.count++] = popped;
+			}
+		}
+		if (magazine.count > 0) {
+			index = magazine.blocks[--magazine.count];
+		}
+	}
+	else {
+		index = PopShared();
+	}
+
+	if (index == kNullIndex) {
+		return nullptr;
+	}
+
+	if (slot < EDGE_MAX_THREAD_SLOTS) {
+		magazine.allocationCount.store(magazine.allocationCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	else {
+		magazine.allocationCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return m_Buffer + index * m_AlignedElementSize;
+}
+
+void ConcurrentPoolAllocator::Free(void* ptr) {
+	if (ptr == nullptr) {
+		return;
+	}
+
+	// Validate the pointer is within our pool
+	uint8_t* block = static_cast<uint8_t*>(ptr);
+	if (block < m_Buffer || block >= (m_Buffer + m_AlignedElementSize * m_ElementCount)) {
+		EDGE_ASSERT(false, "Pointer does not belong to this pool");
+		return;
+	}
+
+	const uint32_t index = static_cast<uint32_t>((block - m_Buffer) / m_AlignedElementSize);
+	const uint32_t slot = GetThreadSlot();
+	Magazine& magazine = m_Magazines[slot];
+
+	if (m_UseMagazines && slot < EDGE_MAX_THREAD_SLOTS) {
+		if (magazine.count == kMagazineCapacity) {
+			// Hand the older half back as one chain
+			const uint32_t half = kMagazineCapacity / 2;
+			for (uint32_t i = 0; i + 1 < half; ++i) {
+				NextIndex(magazine.blocks[i]).store(magazine.blocks[i + 1], std::memory_order_relaxed);
+			}
+			PushShared(magazine.blocks[0], magazine.blocks[half - 1]);
+			memmove(magazine.blocks, magazine.blocks + half, (kMagazineCapacity - half) * sizeof(uint32_t));
+			magazine.count -= half;
+		}
+		magazine.blocks[magazine.count++] = index;
+	}
+	else {
+		PushShared(index, index);
+	}
+
+	if (slot < EDGE_MAX_THREAD_SLOTS) {
+		magazine.freeCount.store(magazine.freeCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	else {
+		magazine.freeCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void ConcurrentPoolAllocator::Free(void* ptr, size_t size, size_t alignment) {
+	(void)alignment;
+	EDGE_ASSERT(size <= m_ElementSize, "Sized free is larger than pool element size");
+	(void)size;
+	Free(ptr);
+}
+
+void ConcurrentPoolAllocator::GetStats(MemoryStats& stats) const {
+	size_t allocations = 0;
+	size_t frees = m_ResetCount;
+	for (size_t i = 0; i <= EDGE_MAX_THREAD_SLOTS; ++i) {
+		allocations += m_Magazines[i].allocationCount.load(std::memory_order_relaxed);
+		frees += m_Magazines[i].freeCount.load(std::memory_order_relaxed);
+	}
+
+	// Counters are merged on read, so the peak is the highest usage seen by a query. A block
+	// allocated and freed on other magazines mid-scan can put frees ahead, clamp that to empty.
+	const int64_t liveCount = static_cast<int64_t>(allocations) - static_cast<int64_t>(frees);
+	const size_t currentUsage = liveCount > 0 ? static_cast<size_t>(liveCount) * m_ElementSize : 0;
+	size_t peak = m_ObservedPeak.load(std::memory_order_relaxed);
+	while (currentUsage > peak && !m_ObservedPeak.compare_exchange_weak(peak, currentUsage, std::memory_order_relaxed)) {
+	}
+
+	stats = MemoryStats();
+	stats.totalAllocated = allocations * m_ElementSize;
+	stats.totalFreed = frees * m_ElementSize;
+	stats.currentUsage = currentUsage;
+	stats.peakUsage = currentUsage > peak ? currentUsage : peak;
+	stats.allocationCount = allocations;
+	stats.freeCount = frees;
+}
+
+void ConcurrentPoolAllocator::Reset() {
+	// Reinitialize the free list
+	for (size_t i = 0; i < m_ElementCount - 1; ++i) {
+		NextIndex(static_cast<uint32_t>(i)).store(static_cast<uint32_t>(i + 1), std::memory_order_relaxed);
+	}
+	NextIndex(static_cast<uint32_t>(m_ElementCount - 1)).store(kNullIndex, std::memory_order_relaxed);
+
+	const uint64_t tag = (m_Head.load(std::memory_order_relaxed) >> 32) + 1;
+	m_Head.store(tag << 32, std::memory_order_release);
+
+	// Every outstanding block counts as freed
+	size_t allocations = 0;
+	size_t frees = m_ResetCount;
+	for (size_t i = 0; i <= EDGE_MAX_THREAD_SLOTS; ++i) {
+		m_Magazines[i].count = 0;
+		allocations += m_Magazines[i].allocationCount.load(std::memory_order_relaxed);
+		frees += m_Magazines[i].freeCount.load(std::memory_order_relaxed);
+	}
+	m_ResetCount += allocations - frees;
+}
+
+//==================================================================================================
+// Thread Cache
+//
+// Small untracked allocations are carved out of 64KB spans and handed out by size class. Each
+// thread keeps its own bins and only touches the shared central bins, one lock per size class,
+// to refill or drain a whole batch at a time. Every block carries a 16 byte header in front of
+// the user pointer so Free can route it without a lookup. A sized free gets the route from the
+// size and alignment and only reads the tag, from the line it links the block through anyway.
+//==================================================================================================
+namespace {
+
+constexpr size_t kBlockHeaderSize = 16;
+constexpr size_t kSpanSize = 64 * 1024;
+constexpr size_t kSpanHeaderSize = EDGE_CACHE_LINE_SIZE;
+constexpr size_t kMaxSmallSize = 2048;
+constexpr size_t kSizeClasses[] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048 };
+constexpr size_t kSizeClassCount = sizeof(kSizeClasses) / sizeof(kSizeClasses[0]);
+constexpr size_t kTagCount = static_cast<size_t>(MemoryTag::COUNT);
+constexpr uint16_t kBlockMagic = 0xED6E;
+constexpr uint8_t kLargeBlockClass = 0xFF;
+
+// Large blocks go straight to the platform, the thread cache keeps its own stats
+PlatformAllocator g_PlatformAllocator;
+
+// Header in front of every block handed out by the thread cache.
+struct BlockHeader {
+	uint64_t size;			// requested size, used for stats
+	uint32_t offset;		// distance from the raw allocation to the user pointer (large blocks)
+	uint16_t magic;
+	uint8_t sizeClass;		// index into kSizeClasses, or kLargeBlockClass
+	uint8_t tag;
+};
+static_assert(sizeof(BlockHeader) == kBlockHeaderSize, "BlockHeader must keep user pointers 16 byte aligned");
+
+// Free blocks are linked through their header.
+struct BlockNode {
+	BlockNode* next;
+};
+
+struct Span {
+	Span* next;
+	size_t blockCount;
+};
+
+// Maps (size + 15) / 16 to a size class index.
+struct SizeClassTable {
+	uint8_t classForSize[kMaxSmallSize / 16 + 1];
+
+	constexpr SizeClassTable() : classForSize() {
+		size_t sizeClass = 0;
+		for (size_t i = 0; i <= kMaxSmallSize / 16; ++i) {
+			while (kSizeClasses[sizeClass] < i * 16) {
+				++sizeClass;
+			}
+			classForSize[i] = static_cast<uint8_t>(sizeClass);
+		}
+	}
+};
+constexpr SizeClassTable kSizeClassTable;
+
+inline size_t SizeToClass(size_t size) {
+	return kSizeClassTable.classForSize[(size + 15) / 16];
+}
+
+inline size_t BlockStride(size_t sizeClass) {
+	return kBlockHeaderSize + kSizeClasses[sizeClass];
+}
+
+// Number of blocks moved between a thread bin and the central bin at once.
+inline uint32_t BatchSize(size_t sizeClass) {
+	size_t count = (8 * 1024) / BlockStride(sizeClass);
+	return static_cast<uint32_t>(count < 4 ? 4 : (count > 64 ? 64 : count));
+}
+
+// Requests served from the size classes, anything else is a large block
+inline bool IsSmallRequest(size_t size, size_t alignment) {
+	return size <= kMaxSmallSize && alignment <= kBlockHeaderSize;
+}
+
+// Distance from a large block's raw allocation to the user pointer
+inline size_t LargeBlockOffset(size_t alignment) {
+	return alignment > kBlockHeaderSize ? alignment : kBlockHeaderSize;
+}
+
+inline BlockHeader* HeaderFromUser(void* ptr) {
+	return reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(ptr) - kBlockHeaderSize);
+}
+
+inline void* UserFromHeader(void* header) {
+	return static_cast<uint8_t*>(header) + kBlockHeaderSize;
+}
+
+// Counters for every thread cache, kept per thread slot so the allocation path has no locked
+// instructions. Constant initialized, allocations made during static initialization are fine.
+BudgetStats g_CacheStats;
+
+// Tagged use recorded by containers and other users of non-global allocators
+BudgetStats g_NestedStats;
+
+struct CentralBin {
+	std::mutex lock;
+	BlockNode* head = nullptr;
+	size_t count = 0;
+};
+
+class ThreadCache;
+
+// Shared backend behind every thread cache.
+struct CentralCache {
+	CentralBin bins[kSizeClassCount];
+
+	std::mutex spanLock;
+	Span* spans = nullptr;
+
+	// Live thread caches
+	std::mutex registryLock;
+	ThreadCache* caches = nullptr;
+};
+
+CentralCache g_Central;
+
+// Carve a new span into blocks of the given class, returning them as a linked chain.
+BlockNode* CarveSpan(size_t sizeClass, uint32_t& count) {
+	uint8_t* memory = static_cast<uint8_t*>(PlatformAlignedAlloc(kSpanSize, EDGE_CACHE_LINE_SIZE));
+	if (!memory) {
+		EDGE_ASSERT(false, "Thread cache failed to allocate a span!");
+		count = 0;
+		return nullptr;
+	}
+
+	const size_t stride = BlockStride(sizeClass);
+	const size_t blocks = (kSpanSize - kSpanHeaderSize) / stride;
+
+	{
+		std::lock_guard<std::mutex> lock(g_Central.spanLock);
+		Span* span = reinterpret_cast<Span*>(memory);
+		span->next = g_Central.spans;
+		span->blockCount = blocks;
+		g_Central.spans = span;
+	}
+
+	BlockNode* head = nullptr;
+	for (size_t i = blocks; i > 0; --i) {
+		BlockNode* node = reinterpret_cast<BlockNode*>(memory + kSpanHeaderSize + (i - 1) * stride);
+		node->next = head;
+		head = node;
+	}
+
+	count = static_cast<uint32_t>(blocks);
+	return head;
+}
+
+class ThreadCache {
+public:
+	ThreadCache() {
+		memset(m_Bins, 0, sizeof(m_Bins));
+
+		std::lock_guard<std::mutex> lock(g_Central.registryLock);
+		m_Prev = nullptr;
+		m_Next = g_Central.caches;
+		if (m_Next) {
+			m_Next->m_Prev = this;
+		}
+		g_Central.caches = this;
+	}
+
+	~ThreadCache() {
+		Flush();
+
+		std::lock_guard<std::mutex> lock(g_Central.registryLock);
+		if (m_Prev) {
+			m_Prev->m_Next = m_Next;
+		}
+		else {
+			g_Central.caches = m_Next;
+		}
+		if (m_Next) {
+			m_Next->m_Prev = m_Prev;
+		}
+	}
+
+	void* AllocateSmall(size_t size, MemoryTag tag) {
+		const size_t sizeClass = SizeToClass(size);
+		Bin& bin = m_Bins[sizeClass];
+
+		if (!bin.head) {
+			Refill(sizeClass);
+			if (!bin.head) {
+				return nullptr;
+			}
+		}
+
+		BlockNode* node = bin.head;
+		bin.head = node->next;
+		bin.count--;
+
+		BlockHeader* header = reinterpret_cast<BlockHeader*>(node);
+		header->size = size;
+		header->offset = 0;
+		header->magic = kBlockMagic;
+		header->sizeClass = static_cast<uint8_t>(sizeClass);
+		header->tag = static_cast<uint8_t>(tag);
+
+		RecordAllocation(tag, size);
+		return UserFromHeader(header);
+	}
+
+	void* AllocateLarge(size_t size, MemoryTag tag, size_t alignment) {
+		// Keep the header in front of the user pointer without breaking its alignment
+		const size_t offset = LargeBlockOffset(alignment);
+		uint8_t* memory = static_cast<uint8_t*>(g_PlatformAllocator.Allocate(size + offset, tag, alignment));
+		if (!memory) {
+			return nullptr;
+		}
+
+		BlockHeader* header = HeaderFromUser(memory + offset);
+		header->size = size;
+		header->offset = static_cast<uint32_t>(offset);
+		header->magic = kBlockMagic;
+		header->sizeClass = kLargeBlockClass;
+		header->tag = static_cast<uint8_t>(tag);
+
+		RecordAllocation(tag, size);
+		return memory + offset;
+	}
+
+	void Free(void* ptr) {
+		BlockHeader* header = HeaderFromUser(ptr);
+		if (header->magic != kBlockMagic) {
+			EDGE_ASSERT(false, "Memory corruption detected!");
+			return;
+		}
+
+		RecordFree(static_cast<MemoryTag>(header->tag), static_cast<size_t>(header->size));
+		header->magic = 0;
+
+		if (header->sizeClass == kLargeBlockClass) {
+			g_PlatformAllocator.Free(static_cast<uint8_t*>(ptr) - header->offset);
+			return;
+		}
+
+		PushBlock(header, header->sizeClass);
+	}
+
+	// Size and alignment must match the allocation, they pick the route in place of the header
+	void Free(void* ptr, size_t size, size_t alignment) {
+		BlockHeader* header = HeaderFromUser(ptr);
+		EDGE_ASSERT(header->magic == kBlockMagic && header->size == size,
+			"Sized free does not match the allocation!");
+
+		RecordFree(static_cast<MemoryTag>(header->tag), size);
+		header->magic = 0;
+
+		if (!IsSmallRequest(size, alignment)) {
+			g_PlatformAllocator.Free(static_cast<uint8_t*>(ptr) - LargeBlockOffset(alignment));
+			return;
+		}
+
+		PushBlock(header, SizeToClass(size));
+	}
+
+	// Give every cached block back to the central bins.
+	void Flush() {
+		for (size_t i = 0; i < kSizeClassCount; ++i) {
+			if (m_Bins[i].count) {
+				Drain(i, m_Bins[i].count);
+			}
+		}
+	}
+
+	ThreadCache* Next() const {
+		return m_Next;
+	}
+
+private:
+	struct Bin {
+		BlockNode* head;
+		uint32_t count;
+	};
+
+	Bin m_Bins[kSizeClassCount];
+	ThreadCache* m_Prev;
+	ThreadCache* m_Next;
+
+	void RecordAllocation(MemoryTag tag, size_t size) {
+		g_CacheStats.OnAllocate(size, tag);
+	}
+
+	void PushBlock(BlockHeader* header, size_t sizeClass) {
+		Bin& bin = m_Bins[sizeClass];
+		BlockNode* node = reinterpret_cast<BlockNode*>(header);
+		node->next = bin.head;
+		bin.head = node;
+		bin.count++;
+
+		if (bin.count >= 2 * BatchSize(sizeClass)) {
+			Drain(sizeClass, BatchSize(sizeClass));
+		}
+	}
+
+	void RecordFree(MemoryTag tag, size_t size) {
+		g_CacheStats.OnFree(size, tag);
+	}
+
+	void Refill(size_t sizeClass) {
+		EDGE_PROFILE_SCOPE("ThreadCache Refill");
+		Bin& bin = m_Bins[sizeClass];
+		CentralBin& central = g_Central.bins[sizeClass];
+		const uint32_t batch = BatchSize(sizeClass);
+
+		{
+			std::lock_guard<std::mutex> lock(central.lock);
+			while (central.head && bin.count < batch) {
+				BlockNode* node = central.head;
+				central.head = node->next;
+				central.count--;
+				node->next = bin.head;
+				bin.head = node;
+				bin.count++;
+			}
+		}
+
+		if (bin.head) {
+			return;
+		}
+
+		// Central bin is empty, take a batch from a fresh span and hand the rest to the central bin
+		uint32_t carved = 0;
+		BlockNode* chain = CarveSpan(sizeClass, carved);
+		BlockNode* tail = chain;
+		for (uint32_t i = 1; i < batch && tail && tail->next; ++i) {
+			tail = tail->next;
+		}
+		if (!tail) {
+			return;
+		}
+
+		BlockNode* rest = tail->next;
+		tail->next = nullptr;
+		bin.head = chain;
+		bin.count = carved < batch ? carved : batch;
+
+		if (rest) {
+			BlockNode* restTail = rest;
+			while (restTail->next) {
+				restTail = restTail->next;
+			}
+			std::lock_guard<std::mutex> lock(central.lock);
+			restTail->next = central.head;
+			central.head = rest;
+			central.count += carved - bin.count;
+		}
+	}
+
+	void Drain(size_t sizeClass, uint32_t count) {
+		EDGE_PROFILE_SCOPE("ThreadCache Drain");
+		Bin& bin = m_Bins[sizeClass];
+		BlockNode* head = bin.head;
+		BlockNode* tail = head;
+		for (uint32_t i = 1; i < count; ++i) {
+			tail = tail->next;
+		}
+		bin.head = tail->next;
+		bin.count -= count;
+
+		CentralBin& central = g_Central.bins[sizeClass];
+		std::lock_guard<std::mutex> lock(central.lock);
+		tail->next = central.head;
+		central.head = head;
+		central.count += count;
+	}
+};
+
+thread_local ThreadCache t_ThreadCache;
+
+// Highest merged usage any stats query has seen, per tag plus one for every tag
+std::atomic<size_t> g_MergedPeak[kTagCount + 1];
+
+// Add the counters of another source. Peaks of different sources happened at different times,
+// so they are not summed, see FinishMergedPeak.
+void MergeStats(MemoryStats& stats, const MemoryStats& other) {
+	stats.totalAllocated += other.totalAllocated;
+	stats.totalFreed += other.totalFreed;
+	stats.currentUsage += other.currentUsage;
+	stats.peakUsage = other.peakUsage > stats.peakUsage ? other.peakUsage : stats.peakUsage;
+	stats.allocationCount += other.allocationCount;
+	stats.freeCount += other.freeCount;
+}
+
+// The merged peak is approximate: at least the largest single source's peak and the highest
+// merged usage seen by a query, but a combined peak between queries can go unseen.
+void FinishMergedPeak(size_t tagIndex, MemoryStats& stats) {
+	std::atomic<size_t>& observed = g_MergedPeak[tagIndex];
+	size_t peak = observed.load(std::memory_order_relaxed);
+	while (stats.currentUsage > peak && !observed.compare_exchange_weak(peak, stats.currentUsage, std::memory_order_relaxed)) {
+	}
+
+	const size_t merged = stats.currentUsage > peak ? stats.currentUsage : peak;
+	stats.peakUsage = merged > stats.peakUsage ? merged : stats.peakUsage;
+}
+
+// Add the thread cache counters for a tag, or for every tag when tagIndex == kTagCount.
+void MergeThreadCacheStats(size_t tagIndex, MemoryStats& stats) {
+	MemoryStats cached;
+	if (tagIndex < kTagCount) {
+		g_CacheStats.GetTagStats(static_cast<MemoryTag>(tagIndex), cached);
+	}
+	else {
+		g_CacheStats.GetStats(cached);
+	}
+	MergeStats(stats, cached);
+}
+
+// Flush every thread cache, then release the spans if no block carved from them is still live.
+// Spans are not tracked per block, so one live block keeps them all, and its Free stays valid.
+void ReleaseThreadCaches() {
+	std::lock_guard<std::mutex> registryLock(g_Central.registryLock);
+	for (ThreadCache* cache = g_Central.caches; cache; cache = cache->Next()) {
+		cache->Flush();
+	}
+
+	std::lock_guard<std::mutex> spanLock(g_Central.spanLock);
+	size_t carvedCount = 0;
+	for (const Span* span = g_Central.spans; span; span = span->next) {
+		carvedCount += span->blockCount;
+	}
+
+	size_t freeCount = 0;
+	for (CentralBin& bin : g_Central.bins) {
+		std::lock_guard<std::mutex> lock(bin.lock);
+		freeCount += bin.count;
+	}
+	if (freeCount != carvedCount) {
+		return;
+	}
+
+	for (CentralBin& bin : g_Central.bins) {
+		std::lock_guard<std::mutex> lock(bin.lock);
+		bin.head = nullptr;
+		bin.count = 0;
+	}
+
+	while (g_Central.spans) {
+		Span* next = g_Central.spans->next;
+		PlatformAlignedFree(g_Central.spans);
+		g_Central.spans = next;
+	}
+}
+
+} // namespace
+
+//==================================================================================================
+// Allocation Sampling
+//
+// Each thread keeps a byte countdown drawn from an exponential distribution, so the fast path
+// is a subtract and a compare. Crossing zero captures a stack and merges it into an
+// open-addressed site table under one lock, which is fine at the rates sampling runs at.
+//==================================================================================================
+namespace {
+
+constexpr size_t kSiteTableSize = 1024;		// power of two
+constexpr size_t kMaxSiteProbes = 32;
+constexpr uint32_t kSkippedFrames = 2;		// the sampler itself
+
+struct SiteEntry {
+	uint64_t hash;		// 0 marks an empty entry
+	AllocationSite site;
+};
+
+struct SamplerState {
+	int64_t bytesUntilSample;
+	uint64_t random;
+	size_t interval;	// interval the countdown was drawn with
+};
+
+std::atomic<size_t> g_SampleInterval(0);
+std::mutex g_SiteLock;
+SiteEntry* g_Sites = nullptr;
+size_t g_DroppedSamples = 0;
+
+thread_local SamplerState t_Sampler = { 0, 0, 0 };
+
+#if !EDGE_PLATFORM_WINDOWS
+struct UnwindState {
+	void** frames;
+	uint32_t count;
+	uint32_t maxFrames;
+	uint32_t skip;
+};
+
+_Unwind_Reason_Code UnwindCallback(struct _Unwind_Context* context, void* arg) {
+	UnwindState* state = static_cast<UnwindState*>(arg);
+	const uintptr_t ip = static_cast<uintptr_t>(_Unwind_GetIP(context));
+	if (ip == 0) {
+		return _URC_END_OF_STACK;
+	}
+	if (state->skip > 0) {
+		--state->skip;
+		return _URC_NO_REASON;
+	}
+	state->frames[state->count++] = reinterpret_cast<void*>(ip);
+	return state->count < state->maxFrames ? _URC_NO_REASON : _URC_END_OF_STACK;
+}
+#endif
+
+uint32_t CaptureStack(void** frames, uint32_t maxFrames, uint32_t skip) {
+#if EDGE_PLATFORM_WINDOWS
+	return RtlCaptureStackBackTrace(skip, maxFrames, frames, nullptr);
+#else
+	UnwindState state = { frames, 0, maxFrames, skip };
+	_Unwind_Backtrace(UnwindCallback, &state);
+	return state.count;
+#endif
+}
+
+// Bytes until the next sample, exponentially distributed with the given mean
+int64_t NextSampleDistance(SamplerState& state, size_t interval) {
+	if (state.random == 0) {
+		state.random = reinterpret_cast<uintptr_t>(&state) * 0x9E3779B97F4A7C15ull | 1;
+	}
+	// xorshift64*
+	state.random ^= state.random >> 12;
+	state.random ^= state.random << 25;
+	state.random ^= state.random >> 27;
+	const uint64_t bits = state.random * 0x2545F4914F6CDD1Dull;
+
+	const double uniform = (static_cast<double>(bits >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+	const double distance = -std::log(uniform) * static_cast<double>(interval);
+	return distance < 1.0 ? 1 : static_cast<int64_t>(distance);
+}
+
+inline uint64_t HashSite(const char* file, int line, MemoryTag tag, void* const* frames, uint32_t frameCount) {
+	uint64_t hash = 0xCBF29CE484222325ull;
+	auto mix = [&hash](uint64_t value) {
+		hash ^= value;
+		hash *= 0x100000001B3ull;
+		hash ^= hash >> 29;
+	};
+	mix(reinterpret_cast<uintptr_t>(file));
+	mix(static_cast<uint64_t>(line) << 8 | static_cast<uint64_t>(tag));
+	for (uint32_t i = 0; i < frameCount; ++i) {
+		mix(reinterpret_cast<uintptr_t>(frames[i]));
+	}
+	return hash ? hash : 1;
+}
+
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+void RecordSample(size_t size, MemoryTag tag, const char* file, int line, size_t interval) {
+	SamplerState& state = t_Sampler;
+	if (state.interval != interval) {
+		// First sample on this thread or the interval changed, start a fresh countdown
+		state.interval = interval;
+		state.bytesUntilSample = NextSampleDistance(state, interval) - static_cast<int64_t>(size);
+		if (state.bytesUntilSample > 0) {
+			return;
+		}
+	}
+	state.bytesUntilSample = NextSampleDistance(state, interval);
+
+	void* frames[EDGE_ALLOCATION_SITE_FRAMES];
+	const uint32_t frameCount = CaptureStack(frames, static_cast<uint32_t>(EDGE_ALLOCATION_SITE_FRAMES), kSkippedFrames);
+	const uint64_t hash = HashSite(file, line, tag, frames, frameCount);
+
+	// A sample stands for the interval on average, small blocks are only rarely picked so the
+	// estimate divides by the chance of picking one at all.
+	const double ratio = static_cast<double>(size) / static_cast<double>(interval);
+	const size_t estimate = static_cast<size_t>(static_cast<double>(size) / (1.0 - std::exp(-ratio)));
+
+	std::lock_guard<std::mutex> lock(g_SiteLock);
+	if (!g_Sites) {
+		return;
+	}
+
+	for (size_t probe = 0; probe < kMaxSiteProbes; ++probe) {
+		SiteEntry& entry = g_Sites[(hash + probe) & (kSiteTableSize - 1)];
+		if (entry.hash == 0) {
+			entry.hash = hash;
+			entry.site.file = file;
+			entry.site.line = line;
+			entry.site.tag = tag;
+			entry.site.frameCount = frameCount;
+			memcpy(entry.site.frames, frames, frameCount * sizeof(void*));
+			entry.site.sampleCount = 1;
+			entry.site.sampledBytes = size;
+			entry.site.estimatedBytes = estimate;
+			return;
+		}
 
-PoolAllocator::PoolAllocator(size_t elementSize, size_t elementCount, size_t alignment)
-	: m_ElementSize(elementSize), m_ElementCount(elementCount), m_FreeCount(elementCount) {
+		if (entry.hash == hash && entry.site.file == file && entry.site.line == line &&
+			entry.site.tag == tag && entry.site.frameCount == frameCount &&
+			memcmp(entry.site.frames, frames, frameCount * sizeof(void*)) == 0) {
+			entry.site.sampleCount++;
+			entry.site.sampledBytes += size;
+			entry.site.estimatedBytes += estimate;
+			return;
+		}
+	}
 
-	// Calculate aligned element size
-	m_AlignedElementSize = memory::AlignUp(elementSize, alignment);
+	g_DroppedSamples++;
+}
 
-	// Allocate the pool
-	size_t totalSize = m_AlignedElementSize * elementCount;
-	m_Buffer = static_cast<uint8_t*>(memory::Allocate(totalSize, alignment));
-	EDGE_ASSERT(m_Buffer != nullptr, "Failed to allocate memory for PoolAllocator");
+inline void SampleAllocation(size_t size, MemoryTag tag, const char* file, int line) {
+	const size_t interval = g_SampleInterval.load(std::memory_order_relaxed);
+	if (interval == 0) {
+		return;
+	}
+
+	SamplerState& state = t_Sampler;
+	state.bytesUntilSample -= static_cast<int64_t>(size);
+	if (state.bytesUntilSample > 0 && state.interval == interval) {
+		return;
+	}
+	RecordSample(size, tag, file, line, interval);
+}
 
-	// Setup free list
-	m_FreeList = reinterpret_cast<uintptr_t*>(m_Buffer);
+void ReleaseAllocationSites() {
+	g_SampleInterval.store(0, std::memory_order_relaxed);
 
-	for (size_t i = 0; i < elementCount - 1; ++i) {
-		uintptr_t* block = reinterpret_cast<uintptr_t*>(m_Buffer + (i * m_AlignedElementSize));
-		*block = reinterpret_cast<uintptr_t>(m_Buffer + ((i + 1) * m_AlignedElementSize));
+	std::lock_guard<std::mutex> lock(g_SiteLock);
+	PlatformAlignedFree(g_Sites);
+	g_Sites = nullptr;
+	g_DroppedSamples = 0;
+}
+
+} // namespace
+
+//==================================================================================================
+// Allocation Tracing
+//==================================================================================================
+namespace {
+
+// Published once the trace is open, cleared before it closes
+std::atomic<AllocationTrace*> g_ActiveTrace(nullptr);
+AllocationTrace g_AllocationTrace;
+
+} // namespace
+
+bool StartAllocationTrace(const char* path, size_t capacity)
+{
+	EDGE_ASSERT(g_ActiveTrace.load() == nullptr, "An allocation trace is already running");
+	if (g_ActiveTrace.load() != nullptr || !g_AllocationTrace.Open(path, capacity)) {
+		return false;
 	}
 
-	// Last block points to nullptr
-	uintptr_t* lastBlock = reinterpret_cast<uintptr_t*>(m_Buffer + ((elementCount - 1) * m_AlignedElementSize));
-	*lastBlock = 0;
+	g_ActiveTrace.store(&g_AllocationTrace, std::memory_order_release);
+	return true;
+}
 
-	memset(&m_Stats, 0, sizeof(MemoryStats));
+void StopAllocationTrace()
+{
+	// Threads that already loaded the trace are waited for by Close
+	if (g_ActiveTrace.exchange(nullptr) != nullptr) {
+		g_AllocationTrace.Close();
+	}
 }
 
-PoolAllocator::~PoolAllocator() {
-	Memory::Free(m_Buffer);
-	m_Buffer = nullptr;
-	m_FreeList = nullptr;
+void MarkAllocationTraceFrame()
+{
+	if (AllocationTrace* trace = g_ActiveTrace.load(std::memory_order_relaxed)) {
+		trace->RecordFrame();
+	}
 }
 
-void* PoolAllocator::Allocate(size_t size, size_t alignment) {
-	return Allocate(size, MemoryTag::NoTag, alignment);
+//==================================================================================================
+// Tag Budgets
+//
+// Usage is folded in per thread slot the way the TagStats totals are, onto a per-tag line that
+// also holds the cached hard budget. The allocation path reads that line, which only changes
+// once a batch is folded, and compares. The soft budget is only looked at while folding.
+//==================================================================================================
+namespace {
+
+constexpr int64_t kNoBudget = std::numeric_limits<int64_t>::max();
+
+struct alignas(EDGE_CACHE_LINE_SIZE) TagBudget {
+	std::atomic<int64_t> usage;		// folded, every slot can also have up to a batch pending
+	std::atomic<int64_t> hard;
+	std::atomic<int64_t> soft;
+	std::atomic<bool> overSoft;		// handler called, until usage drops below the soft budget
+
+	constexpr TagBudget() : usage(0), hard(kNoBudget), soft(kNoBudget), overSoft(false) {}
+};
+
+struct alignas(EDGE_CACHE_LINE_SIZE) BudgetSlot {
+	std::atomic<int64_t> pending[kTagCount];
+};
+
+// Constant initialized like the stats they are fed from
+TagBudget g_TagBudgets[kTagCount];
+BudgetSlot g_BudgetSlots[EDGE_MAX_THREAD_SLOTS + 1];
+
+// Set while a handler runs, so its own allocations don't call it again
+thread_local bool t_InBudgetHandler = false;
+
+// Tags past COUNT are counted as untagged
+inline size_t GetBudgetIndex(MemoryTag tag) {
+	return static_cast<size_t>(tag) < kTagCount ? static_cast<size_t>(tag) : 0;
 }
 
-void* PoolAllocator::Allocate(size_t size, MemoryTag tag, size_t alignment) {
-	if (size > m_ElementSize) {
-		EDGE_ASSERT(false, "Requested size is larger than pool element size");
-		return nullptr;
+inline int64_t ToBudgetLimit(size_t budget) {
+	return budget != 0 && budget < static_cast<size_t>(kNoBudget) ? static_cast<int64_t>(budget) : kNoBudget;
+}
+
+// Folded usage can dip below zero while frees are folded ahead of their allocations
+inline size_t ToBudgetSize(int64_t value) {
+	return value > 0 ? static_cast<size_t>(value) : 0;
+}
+
+void CallBudgetHandler(const BudgetInfo& info) {
+	if (t_InBudgetHandler) {
+		return;
 	}
+	t_InBudgetHandler = true;
+	BudgetHandler::Get().HandleBudget(info);
+	t_InBudgetHandler = false;
+}
 
-	if (m_FreeList == nullptr) {
-		EDGE_ASSERT(false, "Pool allocator is out of memory");
-		return nullptr;
+void AddBudgetUsage(MemoryTag tag, int64_t delta) {
+	const size_t index = GetBudgetIndex(tag);
+	const uint32_t slot = GetThreadSlot();
+	const bool shared = slot >= EDGE_MAX_THREAD_SLOTS;
+	std::atomic<int64_t>& pending = g_BudgetSlots[shared ? EDGE_MAX_THREAD_SLOTS : slot].pending[index];
+
+	int64_t value = AddCounter(pending, delta, shared);
+	if (value < TagStats::USAGE_BATCH_BYTES && value > -TagStats::USAGE_BATCH_BYTES) {
+		return;
 	}
 
-	void* ptr = m_FreeList;
-	m_FreeList = reinterpret_cast<uintptr_t*>(*m_FreeList);
-	m_FreeCount--;
+	if (shared) {
+		value = pending.exchange(0, std::memory_order_relaxed);
+	}
+	else {
+		pending.store(0, std::memory_order_relaxed);
+	}
 
-	// Update stats
-	m_Stats.totalAllocated += m_ElementSize;
-	m_Stats.currentUsage += m_ElementSize;
-	m_Stats.allocationCount++;
+	TagBudget& budget = g_TagBudgets[index];
+	const int64_t usage = budget.usage.fetch_add(value, std::memory_order_relaxed) + value;
+	const int64_t soft = budget.soft.load(std::memory_order_relaxed);
+	if (usage < soft) {
+		if (budget.overSoft.load(std::memory_order_relaxed)) {
+			budget.overSoft.store(false, std::memory_order_relaxed);
+		}
+		return;
+	}
 
-	if (m_Stats.currentUsage > m_Stats.peakUsage) {
-		m_Stats.peakUsage = m_Stats.currentUsage;
+	if (!budget.overSoft.exchange(true, std::memory_order_relaxed)) {
+		CallBudgetHandler(BudgetInfo{ static_cast<MemoryTag>(index), BudgetLevel::Soft, ToBudgetSize(usage), ToBudgetSize(soft), 0 });
 	}
+}
 
-	return ptr;
+// False once the handler has been told, the caller fails the allocation
+inline bool FitsTagBudget(MemoryTag tag, size_t size) {
+	const size_t index = GetBudgetIndex(tag);
+	const TagBudget& budget = g_TagBudgets[index];
+	const int64_t usage = budget.usage.load(std::memory_order_relaxed);
+	const int64_t hard = budget.hard.load(std::memory_order_relaxed);
+
+	// Wraps rather than overflows for sizes no allocation could be served for anyway
+	if (static_cast<int64_t>(static_cast<uint64_t>(usage) + size) <= hard) {
+		return true;
+	}
+
+	CallBudgetHandler(BudgetInfo{ static_cast<MemoryTag>(index), BudgetLevel::Hard, ToBudgetSize(usage), ToBudgetSize(hard), size });
+	return false;
 }
 
-void PoolAllocator::Free(void* ptr) {
-	if (ptr == nullptr) {
+} // namespace
+
+void BudgetStats::OnAllocate(size_t size, MemoryTag tag, size_t count)
+{
+	TagStats::OnAllocate(size, tag, count);
+	AddBudgetUsage(tag, static_cast<int64_t>(size));
+}
+
+void BudgetStats::OnFree(size_t size, MemoryTag tag, size_t count)
+{
+	TagStats::OnFree(size, tag, count);
+	AddBudgetUsage(tag, -static_cast<int64_t>(size));
+}
+
+BudgetHandler& BudgetHandler::Get() {
+	static BudgetHandler instance;
+	return instance;
+}
+
+void BudgetHandler::SetCallback(BudgetCallbackFn callback) {
+	m_Callback = callback;
+}
+
+void BudgetHandler::ResetCallback() {
+	m_Callback = nullptr;
+}
+
+void BudgetHandler::HandleBudget(const BudgetInfo& info) {
+	// A custom callback replaces the default report
+	if (m_Callback) {
+		m_Callback(info);
 		return;
 	}
 
-	// Validate the pointer is within our pool
-	if (ptr < m_Buffer || ptr >= (m_Buffer + m_AlignedElementSize * m_ElementCount)) {
-		EDGE_ASSERT(false, "Pointer does not belong to this pool");
-		return;
+	DefaultHandler(info);
+}
+
+void BudgetHandler::DefaultHandler(const BudgetInfo& info) {
+	if (info.level == BudgetLevel::Soft) {
+		printf("Memory tag %s crossed its soft budget: %zu of %zu bytes\n",
+			GetTagName(info.tag), info.usage, info.budget);
+	}
+	else {
+		printf("Memory tag %s refused %zu bytes over its hard budget: %zu of %zu bytes\n",
+			GetTagName(info.tag), info.size, info.usage, info.budget);
 	}
+}
 
-	// Insert at the head of free list
-	*reinterpret_cast<uintptr_t*>(ptr) = reinterpret_cast<uintptr_t>(m_FreeList);
-	m_FreeList = reinterpret_cast<uintptr_t*>(ptr);
-	m_FreeCount++;
+void SetTagBudget(MemoryTag tag, size_t softBudget, size_t hardBudget)
+{
+	EDGE_ASSERT(static_cast<size_t>(tag) < kTagCount, "Invalid memory tag!");
+	EDGE_ASSERT(softBudget == 0 || hardBudget == 0 || softBudget <= hardBudget,
+		"Soft budget is above the hard budget!");
+
+	TagBudget& budget = g_TagBudgets[GetBudgetIndex(tag)];
+	budget.soft.store(ToBudgetLimit(softBudget), std::memory_order_relaxed);
+	budget.hard.store(ToBudgetLimit(hardBudget), std::memory_order_relaxed);
+	// Already over the new soft budget calls the handler on the next fold
+	budget.overSoft.store(false, std::memory_order_relaxed);
+}
 
-	// Update stats
-	m_Stats.totalFreed += m_ElementSize;
-	m_Stats.currentUsage -= m_ElementSize;
-	m_Stats.freeCount++;
+void GetTagBudget(MemoryTag tag, size_t& softBudget, size_t& hardBudget)
+{
+	const TagBudget& budget = g_TagBudgets[GetBudgetIndex(tag)];
+	const int64_t soft = budget.soft.load(std::memory_order_relaxed);
+	const int64_t hard = budget.hard.load(std::memory_order_relaxed);
+	softBudget = soft == kNoBudget ? 0 : static_cast<size_t>(soft);
+	hardBudget = hard == kNoBudget ? 0 : static_cast<size_t>(hard);
 }
 
-void PoolAllocator::GetStats(MemoryStats& stats) const {
-	stats = m_Stats;
+//==================================================================================================
+// Allocation Scopes
+//==================================================================================================
+namespace {
+
+// Constant initialized, reading them never runs a thread_local initializer
+thread_local MemoryTag t_CurrentTag = MemoryTag::NoTag;
+thread_local IAllocator* t_CurrentAllocator = nullptr;
+
+} // namespace
+
+MemoryTag GetCurrentTag() {
+	return t_CurrentTag;
 }
 
-void PoolAllocator::Reset() {
-	// Reinitialize the free list
-	for (size_t i = 0; i < m_ElementCount - 1; ++i) {
-		uintptr_t* block = reinterpret_cast<uintptr_t*>(m_Buffer + (i * m_AlignedElementSize));
-		*block = reinterpret_cast<uintptr_t>(m_Buffer + ((i + 1) * m_AlignedElementSize));
-	}
+IAllocator* GetCurrentAllocator() {
+	return t_CurrentAllocator;
+}
 
-	// Last block points to nullptr
-	uintptr_t* lastBlock = reinterpret_cast<uintptr_t*>(m_Buffer + ((m_ElementCount - 1) * m_AlignedElementSize));
-	*lastBlock = 0;
+MemoryScope::MemoryScope(MemoryTag tag)
+	: m_PrevAllocator(t_CurrentAllocator), m_PrevTag(t_CurrentTag) {
+	t_CurrentTag = tag;
+}
 
-	m_FreeList = reinterpret_cast<uintptr_t*>(m_Buffer);
-	m_FreeCount = m_ElementCount;
+MemoryScope::MemoryScope(IAllocator* allocator)
+	: m_PrevAllocator(t_CurrentAllocator), m_PrevTag(t_CurrentTag) {
+	t_CurrentAllocator = allocator;
+}
 
-	// Update stats
-	m_Stats.totalFreed += m_Stats.currentUsage;
-	m_Stats.currentUsage = 0;
-	m_Stats.freeCount += m_Stats.allocationCount;
+MemoryScope::MemoryScope(IAllocator* allocator, MemoryTag tag)
+	: m_PrevAllocator(t_CurrentAllocator), m_PrevTag(t_CurrentTag) {
+	t_CurrentAllocator = allocator;
+	t_CurrentTag = tag;
+}
+
+MemoryScope::~MemoryScope() {
+	t_CurrentAllocator = m_PrevAllocator;
+	t_CurrentTag = m_PrevTag;
 }
 
 //==================================================================================================
@@ -498,76 +2904,324 @@ void PoolAllocator::Reset() {
 //==================================================================================================
 
 // Global system allocator instance
+// Built in static storage, with the global operator new replaced a heap allocation would recurse.
 static SystemAllocator* g_SystemAllocator = nullptr;
+alignas(SystemAllocator) static uint8_t g_SystemAllocatorStorage[sizeof(SystemAllocator)];
 
-namespace Memory {
+void Initialize() {
+	if (g_SystemAllocator == nullptr) {
+		g_SystemAllocator = new (g_SystemAllocatorStorage) SystemAllocator();
+	}
+}
 
-	void Initialize() {
-		if (g_SystemAllocator == nullptr) {
-			// Use standard new/delete to create system allocator
-			g_SystemAllocator = new SystemAllocator();
-		}
+void Shutdown() {
+	StopAllocationTrace();
+#if EDGE_REPLACE_GLOBAL_NEW
+	// Static destructors still delete through the replaced operators after this point, so the
+	// backend stays up for the rest of the process. Blocks they own are indistinguishable from
+	// leaks here, call ReportLeaks explicitly where that is known to be meaningful.
+	FlushThreadCache();
+#else
+	if (g_SystemAllocator) {
+		// Worker threads must be joined before this point, their cached blocks are flushed
+		ReleaseThreadCaches();
+		ReleaseAllocationSites();
+		g_SystemAllocator->~SystemAllocator();
+		g_SystemAllocator = nullptr;
+	}
+#endif
+}
+
+SystemAllocator* GetSystemAllocator() {
+	if (!g_SystemAllocator) {
+		Initialize();
+	}
+	return g_SystemAllocator;
+}
+
+void* Allocate(size_t size, size_t alignment)
+{
+	return AllocateTagged(size, t_CurrentTag, alignment);
+}
+
+void* AllocateAligned(size_t size, size_t alignment)
+{
+	return AllocateTagged(size, t_CurrentTag, alignment);
+}
+
+void* AllocateTagged(size_t size, MemoryTag tag, size_t alignment)
+{
+	return AllocateTagged(size, tag, alignment, nullptr, 0);
+}
+
+void* AllocateTagged(size_t size, MemoryTag tag, size_t alignment, const char* file, int line)
+{
+	if (size == 0)
+	{
+		return nullptr;
+	}
+
+	if (!FitsTagBudget(tag, size))
+	{
+		return nullptr;
 	}
 
-	void Shutdown() {
-		if (g_SystemAllocator) {
-			delete g_SystemAllocator;
-			g_SystemAllocator = nullptr;
+	void* ptr = nullptr;
+	SystemAllocator* backend = GetSystemAllocator();
+	if (backend->IsTrackingEnabled())
+	{
+		ptr = backend->Allocate(size, tag, alignment, file, line);
+	}
+	else
+	{
+		EDGE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0,
+			"Alignment must be a power of two.");
+
+		if (IsSmallRequest(size, alignment))
+		{
+			ptr = t_ThreadCache.AllocateSmall(size, tag);
+		}
+		else
+		{
+			ptr = t_ThreadCache.AllocateLarge(size, tag, alignment);
 		}
 	}
 
-	SystemAllocator* GetSystemAllocator() {
-		if (!g_SystemAllocator) {
-			Initialize();
+	if (ptr)
+	{
+		SampleAllocation(size, tag, file, line);
+		if (AllocationTrace* trace = g_ActiveTrace.load(std::memory_order_relaxed))
+		{
+			trace->RecordAllocate(ptr, size, alignment, tag, GetTraceSiteId(file, line));
 		}
-		return g_SystemAllocator;
+	}
+	return ptr;
+}
+
+void Free(void* ptr)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	if (AllocationTrace* trace = g_ActiveTrace.load(std::memory_order_relaxed))
+	{
+		trace->RecordFree(ptr);
+	}
+
+	SystemAllocator* backend = GetSystemAllocator();
+	if (backend->IsTrackingEnabled())
+	{
+		backend->Free(ptr);
+		return;
 	}
 
-	void* Allocate(size_t size, size_t alignment)
+	t_ThreadCache.Free(ptr);
+}
+
+void Free(void* ptr, size_t size, size_t alignment)
+{
+	if (!ptr)
 	{
-		return GetSystemAllocator()->Allocate(size, alignment);
+		return;
 	}
 
-	void* AllocateAligned(size_t size, size_t alignment)
+	if (AllocationTrace* trace = g_ActiveTrace.load(std::memory_order_relaxed))
 	{
-		return GetSystemAllocator()->Allocate(size, alignment);
+		trace->RecordFree(ptr, size);
 	}
 
-	void* AllocateTagged(size_t size, MemoryTag tag, size_t alignment)
+	SystemAllocator* backend = GetSystemAllocator();
+	if (backend->IsTrackingEnabled())
 	{
-		return GetSystemAllocator()->Allocate(size, tag, alignment);
+		backend->Free(ptr, size, alignment);
+		return;
+	}
+
+	t_ThreadCache.Free(ptr, size, alignment);
+}
+
+void FreeAligned(void* ptr)
+{
+	Free(ptr);
+}
+
+void FlushThreadCache()
+{
+	t_ThreadCache.Flush();
+}
+
+void EnableTracking(bool enabled)
+{
+	MemoryStats cached;
+	MergeThreadCacheStats(kTagCount, cached);
+	EDGE_ASSERT(cached.allocationCount == cached.freeCount,
+		"Cannot change tracking state with active allocations!");
+
+	GetSystemAllocator()->SetTrackingEnabled(enabled);
+}
+
+void ReportLeaks()
+{
+	GetSystemAllocator()->ReportLeaks();
+
+	MemoryStats cached;
+	MergeThreadCacheStats(kTagCount, cached);
+	if (cached.allocationCount > cached.freeCount) {
+		printf("Untracked leaks: %zu bytes in %zu blocks\n",
+			cached.currentUsage, cached.allocationCount - cached.freeCount);
+	}
+}
+
+void GetStats(MemoryStats& stats)
+{
+	GetSystemAllocator()->GetStats(stats);
+	MergeThreadCacheStats(kTagCount, stats);
+	FinishMergedPeak(kTagCount, stats);
+	stats.largePageBytes = GetLargePageBytes();
+}
+
+void GetTagStats(MemoryTag tag, MemoryStats& stats) {
+	// Access the tag-specific stats from the allocator
+	GetSystemAllocator()->GetTagStats(tag, stats);
+	if (static_cast<size_t>(tag) < kTagCount) {
+		MergeThreadCacheStats(static_cast<size_t>(tag), stats);
+
+		MemoryStats nested;
+		g_NestedStats.GetTagStats(tag, nested);
+		MergeStats(stats, nested);
+		FinishMergedPeak(static_cast<size_t>(tag), stats);
 	}
+}
+
+void RecordTaggedUse(MemoryTag tag, size_t size) {
+	g_NestedStats.OnAllocate(size, tag);
+}
+
+void ReleaseTaggedUse(MemoryTag tag, size_t size) {
+	g_NestedStats.OnFree(size, tag);
+}
 
-	void Free(void* ptr)
+void SetAllocationSampleInterval(size_t bytes)
+{
+	if (bytes != 0)
 	{
-		GetSystemAllocator()->Free(ptr);
+		std::lock_guard<std::mutex> lock(g_SiteLock);
+		if (!g_Sites)
+		{
+			// Kept out of the tracked allocators so the table never shows up in its own report
+			const size_t tableBytes = kSiteTableSize * sizeof(SiteEntry);
+			g_Sites = static_cast<SiteEntry*>(PlatformAlignedAlloc(tableBytes, EDGE_CACHE_LINE_SIZE));
+			if (!g_Sites)
+			{
+				EDGE_ASSERT(false, "Failed to allocate the allocation site table!");
+				return;
+			}
+			memset(g_Sites, 0, tableBytes);
+		}
 	}
 
-	void FreeAligned(void* ptr)
+	g_SampleInterval.store(bytes, std::memory_order_relaxed);
+}
+
+size_t GetAllocationSampleInterval()
+{
+	return g_SampleInterval.load(std::memory_order_relaxed);
+}
+
+size_t GetAllocationSites(AllocationSite* sites, size_t maxSites)
+{
+	std::lock_guard<std::mutex> lock(g_SiteLock);
+	if (!g_Sites || maxSites == 0)
 	{
-		GetSystemAllocator()->Free(ptr);
+		return 0;
 	}
 
-	void EnableTracking(bool enabled)
+	// Keep the heaviest sites, sorted in place by insertion
+	size_t count = 0;
+	for (size_t i = 0; i < kSiteTableSize; ++i)
 	{
-		GetSystemAllocator()->SetTrackingEnabled(enabled);
+		const SiteEntry& entry = g_Sites[i];
+		if (entry.hash == 0)
+		{
+			continue;
+		}
+
+		size_t position = count < maxSites ? count : maxSites;
+		while (position > 0 && sites[position - 1].estimatedBytes < entry.site.estimatedBytes)
+		{
+			if (position < maxSites)
+			{
+				sites[position] = sites[position - 1];
+			}
+			--position;
+		}
+
+		if (position < maxSites)
+		{
+			sites[position] = entry.site;
+			if (count < maxSites)
+			{
+				++count;
+			}
+		}
 	}
+	return count;
+}
 
-	void ReportLeaks()
+void ReportAllocationSites(size_t maxSites)
+{
+	AllocationSite* sites = static_cast<AllocationSite*>(
+		PlatformAlignedAlloc(maxSites * sizeof(AllocationSite), alignof(AllocationSite)));
+	if (!sites)
 	{
-		GetSystemAllocator()->ReportLeaks();
+		return;
 	}
 
-	void GetStats(MemoryStats& stats)
+	const size_t count = GetAllocationSites(sites, maxSites);
+	size_t dropped = 0;
 	{
-		GetSystemAllocator()->GetStats(stats);
+		std::lock_guard<std::mutex> lock(g_SiteLock);
+		dropped = g_DroppedSamples;
 	}
 
-	void GetTagStats(MemoryTag tag, MemoryStats& stats) {
-		// Access the tag-specific stats from the allocator
-		GetSystemAllocator()->GetTagStats(tag, stats);
+	printf("\nAllocation sites (1 sample per %zu bytes):\n", GetAllocationSampleInterval());
+	printf("-------------------------------------------------\n");
+	for (size_t i = 0; i < count; ++i)
+	{
+		const AllocationSite& site = sites[i];
+		printf("#%zu: ~%zu bytes, %zu samples (tag: %d)", i + 1,
+			site.estimatedBytes, site.sampleCount, static_cast<int>(site.tag));
+		if (site.file)
+		{
+			printf(", allocated at %s:%d", site.file, site.line);
+		}
+		printf("\n");
+
+		for (uint32_t frame = 0; frame < site.frameCount; ++frame)
+		{
+			printf("    [%u] %p\n", frame, site.frames[frame]);
+		}
+	}
+	printf("-------------------------------------------------\n");
+	if (dropped > 0)
+	{
+		printf("Samples dropped, site table full: %zu\n", dropped);
 	}
 
+	PlatformAlignedFree(sites);
+}
+
+void ClearAllocationSites()
+{
+	std::lock_guard<std::mutex> lock(g_SiteLock);
+	if (g_Sites)
+	{
+		memset(g_Sites, 0, kSiteTableSize * sizeof(SiteEntry));
+	}
+	g_DroppedSamples = 0;
 }
+
 END_NS_MEMORY
-END_NS_EDGE
\ No newline at end of file
+END_NS_EDGE
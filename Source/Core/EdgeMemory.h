@@ -23,6 +23,15 @@
 #include <cstdint>
 #include <new>
 #include <limits>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
+#include <cstdlib>
+#include <functional>
+
+#if EDGE_PLATFORM_WINDOWS
+#include <malloc.h>
+#endif
 
 BEGIN_NS_EDGE
 BEGIN_NS_MEMORY
@@ -32,6 +41,41 @@ constexpr size_t EDGE_DEFAULT_ALIGNMENT = alignof(max_align_t);
 constexpr size_t EDGE_SIMD_ALIGNMENT = 16;
 constexpr size_t EDGE_CACHE_LINE_SIZE = 64;
 
+// Maximum number of threads that get a dedicated slot in per-thread allocator state
+constexpr size_t EDGE_MAX_THREAD_SLOTS = 64;
+
+// Deepest stack kept for a sampled allocation site
+constexpr size_t EDGE_ALLOCATION_SITE_FRAMES = 16;
+
+// Default ring size of an allocation trace, in events of 32 bytes
+constexpr size_t EDGE_ALLOCATION_TRACE_CAPACITY = size_t(1) << 20;
+
+// Alignment utilities
+inline size_t AlignUp(size_t size, size_t alignment) {
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+inline void* AlignPointer(void* ptr, size_t alignment) {
+	return reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(ptr) + alignment - 1) & ~(alignment - 1));
+}
+
+// Platform aligned allocation, the bottom of every allocator
+inline void* PlatformAlignedAlloc(size_t size, size_t alignment) {
+#if EDGE_PLATFORM_WINDOWS
+	return _aligned_malloc(size, alignment);
+#else
+	return aligned_alloc(alignment, AlignUp(size, alignment));
+#endif // EDGE_PLATFORM_WINDOWS
+}
+
+inline void PlatformAlignedFree(void* ptr) {
+#if EDGE_PLATFORM_WINDOWS
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
 // Memory allocation tags for tracking
 enum class MemoryTag : uint8_t {
 	NoTag = 0,
@@ -82,6 +126,9 @@ enum class MemoryTag : uint8_t {
 	COUNT			// Total
 };
 
+// Name of a tag as written in the enum, "Unknown" when out of range
+const char* GetTagName(MemoryTag tag);
+
 // Memory allocation stats
 struct MemoryStats {
 	size_t totalAllocated;
@@ -91,13 +138,29 @@ struct MemoryStats {
 	size_t allocationCount;
 	size_t freeCount;
 
+	// Heap allocators only, zero elsewhere
+	size_t freeSpace;			// bytes held in free blocks
+	size_t largestFreeBlock;	// largest single free block
+	size_t freeBlockCount;		// number of free blocks
+
+	size_t largePageBytes;		// bytes backed by large pages
+
 	MemoryStats() :
 		totalAllocated(0),
 		totalFreed(0),
 		currentUsage(0),
 		peakUsage(0),
 		allocationCount(0),
-		freeCount(0) {
+		freeCount(0),
+		freeSpace(0),
+		largestFreeBlock(0),
+		freeBlockCount(0),
+		largePageBytes(0) {
+	}
+
+	// 0 when all free space is one block, approaching 1 as it splinters
+	float GetFragmentation() const {
+		return freeSpace ? 1.0f - static_cast<float>(largestFreeBlock) / static_cast<float>(freeSpace) : 0.0f;
 	}
 };
 
@@ -109,11 +172,360 @@ public:
 	virtual void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) = 0;
 	virtual void* Allocate(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT) = 0;
 	virtual void Free(void* ptr) = 0;
+	// Sized free, size and alignment must match the allocation. Allocators that can route a block
+	// by its size skip their header lookup, the default calls Free(ptr).
+	virtual void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
 	virtual void GetStats(MemoryStats& stats) const = 0;
 	virtual void Reset() = 0;
+
+	// Allocate count blocks of size bytes into out. All or nothing, on failure no block stays
+	// allocated and false is returned. The defaults loop over Allocate and Free, allocators
+	// override them to pay their bookkeeping once per batch.
+	virtual bool AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag = MemoryTag::NoTag);
+	virtual void FreeBatch(void** ptrs, size_t count);
 };
 
+//==================================================================================================
+// Allocator Policies
+//
+// SystemAllocatorT composes a tracking, a stats and a threading policy at compile time, so a
+// build only carries the bookkeeping it enables. The empty policies are inline no-ops, with all
+// three the allocator is a direct call to the platform allocator.
+//==================================================================================================
+
+// Tracking policy - no per-allocation header
+struct NoTracking {
+	static constexpr bool ENABLED = false;
+
+	size_t HeaderSpace(size_t alignment) const { (void)alignment; return 0; }
+	bool OnAllocate(void* userPtr, size_t size, MemoryTag tag, size_t alignment, const char* file, int line) {
+		(void)userPtr; (void)size; (void)tag; (void)alignment; (void)file; (void)line;
+		return true;
+	}
+	void* OnFree(void* userPtr, size_t& size, MemoryTag& tag) { (void)size; (void)tag; return userPtr; }
+	void ReportLeaks() const {}
+	void Clear() {}
+};
+
+// Tracking policy - live allocations recorded out of line in a hash index keyed by pointer
+// The index is split into shards with a lock each, so threads freeing unrelated blocks rarely
+// meet, and user blocks keep the size and alignment they asked for.
+class LeakTracking {
+public:
+	static constexpr bool ENABLED = true;
+
+	LeakTracking();
+	~LeakTracking();
+
+	size_t HeaderSpace(size_t alignment) const { (void)alignment; return 0; }
+	// False if the block could not be recorded, the caller must not hand it out
+	bool OnAllocate(void* userPtr, size_t size, MemoryTag tag, size_t alignment, const char* file, int line);
+	// Returns the raw allocation, or nullptr if the pointer is not tracked
+	void* OnFree(void* userPtr, size_t& size, MemoryTag& tag);
+	void ReportLeaks() const;
+	void Clear();
+
+	LeakTracking(const LeakTracking&) = delete;
+	LeakTracking& operator=(const LeakTracking&) = delete;
+
+private:
+	struct Record;
+	struct Shard;
+	Shard* m_Shards;
+
+	Shard& ShardFor(const void* ptr, size_t& hash) const;
+};
+
+// Stats policy - no counters
+struct NoStats {
+	static constexpr bool ENABLED = false;
+
+	void OnAllocate(size_t size, MemoryTag tag, size_t count = 1) { (void)size; (void)tag; (void)count; }
+	void OnFree(size_t size, MemoryTag tag, size_t count = 1) { (void)size; (void)tag; (void)count; }
+	void GetStats(MemoryStats& stats) const { stats = MemoryStats(); }
+	void GetTagStats(MemoryTag tag, MemoryStats& stats) const { (void)tag; stats = MemoryStats(); }
+	void ReportLeaks() const {}
+	void Clear() {}
+};
+
+// Stats policy - global and per-tag counters, safe to update from any thread
+// Every thread slot owns a cache-line aligned block of counters that only it writes, and reads
+// sum all blocks. Net usage is also folded into shared totals once a thread has moved it by
+// USAGE_BATCH_BYTES, which keeps peakUsage exact to within one batch per thread without
+// touching a shared line on every call. Threads without a slot share one block atomically.
+class TagStats {
+public:
+	static constexpr bool ENABLED = true;
+	static constexpr int64_t USAGE_BATCH_BYTES = 8 * 1024;
+
+	// Constant initialized, so a static instance is usable before dynamic initialization
+	constexpr TagStats() : m_Slots(), m_Usage() {}
+
+	// size is the total over count blocks, so a batch is recorded in one update
+	void OnAllocate(size_t size, MemoryTag tag, size_t count = 1);
+	void OnFree(size_t size, MemoryTag tag, size_t count = 1);
+	void GetStats(MemoryStats& stats) const;
+	void GetTagStats(MemoryTag tag, MemoryStats& stats) const;
+	void ReportLeaks() const;
+	// Only valid while no other thread is updating the stats
+	void Clear();
+
+	TagStats(const TagStats&) = delete;
+	TagStats& operator=(const TagStats&) = delete;
+
+private:
+	static constexpr size_t TAG_COUNT = static_cast<size_t>(MemoryTag::COUNT);
+
+	struct Counters {
+		std::atomic<size_t> totalAllocated;
+		std::atomic<size_t> totalFreed;
+		std::atomic<size_t> allocationCount;
+		std::atomic<size_t> freeCount;
+		std::atomic<int64_t> pendingUsage;	// not yet folded into m_Usage
+	};
+
+	struct alignas(EDGE_CACHE_LINE_SIZE) SlotCounters {
+		Counters tags[TAG_COUNT];
+		std::atomic<int64_t> pendingUsage;	// all tags
+	};
+
+	struct alignas(EDGE_CACHE_LINE_SIZE) Usage {
+		std::atomic<int64_t> current;
+		mutable std::atomic<int64_t> peak;
+	};
+
+	SlotCounters m_Slots[EDGE_MAX_THREAD_SLOTS + 1];
+	Usage m_Usage[TAG_COUNT + 1];	// per tag, then all tags
+
+	void Update(size_t size, size_t count, MemoryTag tag, bool isFree);
+	void Collect(size_t tagIndex, MemoryStats& stats) const;
+};
+
+// Stats policy - TagStats whose usage also counts toward the tag budgets
+// Used by the global heap and RecordTaggedUse, see SetTagBudget.
+class BudgetStats : public TagStats {
+public:
+	void OnAllocate(size_t size, MemoryTag tag, size_t count = 1);
+	void OnFree(size_t size, MemoryTag tag, size_t count = 1);
+};
+
+// Thread policy - no lock, for single-threaded use or policies that synchronize themselves
+// Tracking policies always synchronize themselves, the thread policy only guards the stats policy.
+struct NoLocking {
+	struct Guard {
+		explicit Guard(const NoLocking& policy) { (void)policy; }
+	};
+};
+
+// Thread policy - one mutex around all bookkeeping
+struct MutexLocking {
+	struct Guard {
+		explicit Guard(const MutexLocking& policy) : lock(policy.m_Mutex) {}
+		std::lock_guard<std::mutex> lock;
+	};
+
+	mutable std::mutex m_Mutex;
+};
+
+// Platform allocator with compile-time selected bookkeeping, no virtual dispatch
+template<typename TrackingPolicy, typename StatsPolicy, typename ThreadPolicy>
+class SystemAllocatorT : private TrackingPolicy, private StatsPolicy, private ThreadPolicy {
+public:
+	static_assert(!StatsPolicy::ENABLED || TrackingPolicy::ENABLED,
+		"Stats need a tracking header to know the size of a freed block");
+
+	static constexpr bool HAS_BOOKKEEPING = TrackingPolicy::ENABLED || StatsPolicy::ENABLED;
+
+	void* Allocate(size_t size, MemoryTag tag = MemoryTag::NoTag, size_t alignment = EDGE_DEFAULT_ALIGNMENT,
+		const char* file = nullptr, int line = 0) {
+		if (size == 0) {
+			return nullptr;
+		}
+
+		EDGE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0,
+			"Alignment must be a power of two.");
+
+		const size_t headerSpace = TrackingPolicy::HeaderSpace(alignment);
+		void* memory = PlatformAlignedAlloc(size + headerSpace, alignment);
+		if (!memory) {
+			EDGE_ASSERT(false, "Memory allocation failed!");
+			return nullptr;
+		}
+
+		void* userPtr = static_cast<uint8_t*>(memory) + headerSpace;
+		if (HAS_BOOKKEEPING) {
+			// An untracked block could never be freed, so it is not handed out
+			if (!TrackingPolicy::OnAllocate(userPtr, size, tag, alignment, file, line)) {
+				PlatformAlignedFree(memory);
+				return nullptr;
+			}
+			typename ThreadPolicy::Guard guard(*this);
+			StatsPolicy::OnAllocate(size, tag);
+		}
+		return userPtr;
+	}
+
+	void Free(void* ptr) {
+		if (!ptr) {
+			return;
+		}
+
+		void* actualPtr = ptr;
+		if (HAS_BOOKKEEPING) {
+			size_t size = 0;
+			MemoryTag tag = MemoryTag::NoTag;
+			actualPtr = TrackingPolicy::OnFree(ptr, size, tag);
+			if (!actualPtr) {
+				return;
+			}
+			typename ThreadPolicy::Guard guard(*this);
+			StatsPolicy::OnFree(size, tag);
+		}
+		PlatformAlignedFree(actualPtr);
+	}
+
+	// The platform allocator needs no size, with tracking the size is checked against the record
+	void Free(void* ptr, size_t size, size_t alignment) {
+		(void)size;
+		(void)alignment;
+		if (!ptr) {
+			return;
+		}
+
+		void* actualPtr = ptr;
+		if (HAS_BOOKKEEPING) {
+			size_t trackedSize = 0;
+			MemoryTag tag = MemoryTag::NoTag;
+			actualPtr = TrackingPolicy::OnFree(ptr, trackedSize, tag);
+			if (!actualPtr) {
+				return;
+			}
+			EDGE_ASSERT(trackedSize == size, "Sized free does not match the allocation!");
+			typename ThreadPolicy::Guard guard(*this);
+			StatsPolicy::OnFree(trackedSize, tag);
+		}
+		PlatformAlignedFree(actualPtr);
+	}
+
+	// Every block is tracked on its own, the stats are updated once for the whole batch
+	bool AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag = MemoryTag::NoTag) {
+		if (size == 0) {
+			return false;
+		}
+
+		EDGE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0,
+			"Alignment must be a power of two.");
+
+		const size_t headerSpace = TrackingPolicy::HeaderSpace(alignment);
+		for (size_t i = 0; i < count; ++i) {
+			void* memory = PlatformAlignedAlloc(size + headerSpace, alignment);
+			if (!memory) {
+				// Nothing has been tracked yet, give back what this batch got
+				while (i > 0) {
+					PlatformAlignedFree(static_cast<uint8_t*>(out[--i]) - headerSpace);
+				}
+				EDGE_ASSERT(false, "Memory allocation failed!");
+				return false;
+			}
+			out[i] = static_cast<uint8_t*>(memory) + headerSpace;
+		}
+
+		if (HAS_BOOKKEEPING && count) {
+			for (size_t i = 0; i < count; ++i) {
+				if (TrackingPolicy::OnAllocate(out[i], size, tag, alignment, nullptr, 0)) {
+					continue;
+				}
+
+				// Untrack what was recorded and give the whole batch back
+				for (size_t j = 0; j < i; ++j) {
+					size_t trackedSize = 0;
+					MemoryTag trackedTag = MemoryTag::NoTag;
+					TrackingPolicy::OnFree(out[j], trackedSize, trackedTag);
+				}
+				for (size_t j = 0; j < count; ++j) {
+					PlatformAlignedFree(static_cast<uint8_t*>(out[j]) - headerSpace);
+				}
+				return false;
+			}
+			typename ThreadPolicy::Guard guard(*this);
+			StatsPolicy::OnAllocate(size * count, tag, count);
+		}
+		return true;
+	}
+
+	// Consecutive blocks with the same tag share one stats update
+	void FreeBatch(void** ptrs, size_t count) {
+		MemoryTag runTag = MemoryTag::NoTag;
+		size_t runBytes = 0;
+		size_t runCount = 0;
+
+		for (size_t i = 0; i < count; ++i) {
+			if (!ptrs[i]) {
+				continue;
+			}
+
+			void* actualPtr = ptrs[i];
+			if (HAS_BOOKKEEPING) {
+				size_t size = 0;
+				MemoryTag tag = MemoryTag::NoTag;
+				actualPtr = TrackingPolicy::OnFree(ptrs[i], size, tag);
+				if (!actualPtr) {
+					continue;
+				}
+				if (runCount && tag != runTag) {
+					typename ThreadPolicy::Guard guard(*this);
+					StatsPolicy::OnFree(runBytes, runTag, runCount);
+					runBytes = 0;
+					runCount = 0;
+				}
+				runTag = tag;
+				runBytes += size;
+				runCount++;
+			}
+			PlatformAlignedFree(actualPtr);
+		}
+
+		if (HAS_BOOKKEEPING && runCount) {
+			typename ThreadPolicy::Guard guard(*this);
+			StatsPolicy::OnFree(runBytes, runTag, runCount);
+		}
+	}
+
+	void GetStats(MemoryStats& stats) const {
+		typename ThreadPolicy::Guard guard(*this);
+		StatsPolicy::GetStats(stats);
+	}
+
+	void GetTagStats(MemoryTag tag, MemoryStats& stats) const {
+		typename ThreadPolicy::Guard guard(*this);
+		StatsPolicy::GetTagStats(tag, stats);
+	}
+
+	void ReportLeaks() const {
+		typename ThreadPolicy::Guard guard(*this);
+		StatsPolicy::ReportLeaks();
+		TrackingPolicy::ReportLeaks();
+	}
+
+	// Forget all bookkeeping, only valid with no live allocations
+	void Reset() {
+		typename ThreadPolicy::Guard guard(*this);
+		StatsPolicy::Clear();
+		TrackingPolicy::Clear();
+	}
+};
+
+// Direct platform allocation, no header and no bookkeeping
+using PlatformAllocator = SystemAllocatorT<NoTracking, NoStats, NoLocking>;
+
+#if EDGE_MEMORY_TRACKING
+// Full leak tracking and per-tag stats, safe to share between threads as both policies are
+using TrackedSystemAllocator = SystemAllocatorT<LeakTracking, BudgetStats, NoLocking>;
+#endif
+
 // System allocator that uses platform-specific memory allocation
+// Tracking can be toggled at runtime in builds with EDGE_MEMORY_TRACKING, other builds compile
+// it out and every call goes straight to the platform allocator.
 class SystemAllocator : public IAllocator {
 public:
 	SystemAllocator();
@@ -121,72 +533,308 @@ public:
 
 	void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
 	void* Allocate(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	// Records the call site in the leak report when tracking is enabled
+	void* Allocate(size_t size, MemoryTag tag, size_t alignment, const char* file, int line);
 	void Free(void* ptr) override;
+	void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
 	void GetStats(MemoryStats& stats) const override;
 	void GetTagStats(MemoryTag tag, MemoryStats& stats) const;
 	void Reset() override;
 
+	bool AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag = MemoryTag::NoTag) override;
+	void FreeBatch(void** ptrs, size_t count) override;
+
 	// Enable/disable memory tracking
 	void SetTrackingEnabled(bool enabled);
-	bool IsTrackingEnabled() const;
+	bool IsTrackingEnabled() const {
+#if EDGE_MEMORY_TRACKING
+		return m_TrackingEnabled;
+#else
+		return false;
+#endif
+	}
 
 	// Leak detection
 	void ReportLeaks();
 
 private:
-	struct AllocationHeader;
-	MemoryStats m_Stats;
-	MemoryStats m_TagStats[static_cast<size_t>(MemoryTag::COUNT)];
+	PlatformAllocator m_Platform;
+#if EDGE_MEMORY_TRACKING
+	TrackedSystemAllocator m_Tracked;
 	bool m_TrackingEnabled;
+#endif
+};
+
+//==================================================================================================
+// Virtual Memory
+//==================================================================================================
+
+// Size of a virtual memory page
+size_t GetPageSize();
+
+// Size of a large page, 0 when the platform has none
+size_t GetLargePageSize();
+
+// Bytes currently backed by large pages across the process
+size_t GetLargePageBytes();
+
+// Reserved address range with pages committed on demand
+// Reserving costs address space only, physical memory is used once a page is committed. Decommitted
+// pages are given back to the OS and read back with undefined contents when committed again.
+class VirtualRange {
+public:
+	VirtualRange();
+	~VirtualRange();
 
-	// Linked list tracking
-	AllocationHeader* m_FirstAllocation;
-	AllocationHeader* m_LastAllocation;
+	// Reserve at least size bytes, rounded up to the page size
+	bool Reserve(size_t size);
+	// Reserve and commit the whole range with large pages. When the OS has none to give, falls back
+	// to Reserve with a transparent huge page hint where supported and returns false.
+	bool ReserveLargePages(size_t size);
+	void Release();
+
+	// Make sure the first size bytes are committed, commits grow in COMMIT_GRANULARITY steps
+	bool Commit(size_t size);
+	// Decommit every page past the first size bytes
+	void Decommit(size_t size);
+
+	uint8_t* GetBase() const { return m_Base; }
+	size_t GetReservedSize() const { return m_Reserved; }
+	size_t GetCommittedSize() const { return m_Committed; }
+	// Large pages stay committed until Release
+	bool UsesLargePages() const { return m_LargePages; }
+
+	static constexpr size_t COMMIT_GRANULARITY = 64 * 1024;
+
+	VirtualRange(const VirtualRange&) = delete;
+	VirtualRange& operator=(const VirtualRange&) = delete;
+
+private:
+	uint8_t* m_Base;
+	size_t m_Reserved;
+	size_t m_Committed;
+	bool m_LargePages;
+};
 
-	// Track an allocation in debug builds
-	void TrackAllocation(AllocationHeader* header, size_t size, MemoryTag tag);
-	void TrackDeallocation(AllocationHeader* header);
+// Where an arena or pool gets its backing memory from
+enum class MemoryBacking : uint8_t {
+	Heap,		// committed up front from the system allocator
+	Virtual,	// reserved up front, committed as it fills and decommitted on Reset
+	LargePages,	// committed up front with large pages to save TLB misses, falls back to Virtual
 };
 
 // Linear allocator - fast allocations, no individual frees
+// Markers let nested work rewind the allocator in stack order instead of resetting all of it.
+// Virtual backing lets an arena be sized for the worst case and only use what it touches.
 class LinearAllocator : public IAllocator {
 public:
-	LinearAllocator(size_t size);
+	// Position in the allocator, rewinding to it frees everything allocated since
+	struct Marker {
+		size_t offset;
+		size_t usage;
+		size_t allocationCount;
+		size_t freeCount;
+	};
+
+	LinearAllocator(size_t size, MemoryBacking backing = MemoryBacking::Heap);
 	~LinearAllocator() override;
 
 	void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
 	void* Allocate(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
 	void Free(void* ptr) override; // No-op for individual elements
+	void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override; // No-op
 	void GetStats(MemoryStats& stats) const override;
 	void Reset() override;
 
+	// Bumps once for the whole batch, blocks are laid out back to back at the aligned stride
+	bool AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag = MemoryTag::NoTag) override;
+	void FreeBatch(void** ptrs, size_t count) override; // No-op
+
+	// nullptr instead of an assert when the arena is full, for callers with a fallback
+	void* TryAllocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
+
+	Marker GetMarker() const;
+	void FreeToMarker(const Marker& marker);
+
 private:
 	uint8_t* m_Buffer;
 	size_t m_Size;
 	size_t m_Offset;
+	size_t m_CommitLimit;		// bytes usable without committing more, m_Size for heap and large page backing
 	MemoryStats m_Stats;
+	MemoryBacking m_Backing;
+	VirtualRange m_Range;
+
+	bool CommitTo(size_t offset);
+};
+
+// Rewinds a LinearAllocator to where it was when the scope was entered
+class LinearAllocatorScope {
+public:
+	explicit LinearAllocatorScope(LinearAllocator& allocator)
+		: m_Allocator(allocator), m_Marker(allocator.GetMarker()) {
+	}
+
+	~LinearAllocatorScope() {
+		m_Allocator.FreeToMarker(m_Marker);
+	}
+
+	LinearAllocatorScope(const LinearAllocatorScope&) = delete;
+	LinearAllocatorScope& operator=(const LinearAllocatorScope&) = delete;
+
+private:
+	LinearAllocator& m_Allocator;
+	LinearAllocator::Marker m_Marker;
+};
+
+// Frame allocator - N-buffered per-frame arenas split into per-thread slices
+// Memory allocated during a frame stays valid until BeginFrame has been called frameCount more
+// times, so GPU and async consumers can keep reading the previous frames' data. Threads with a
+// thread slot below sliceCount bump-allocate from their own slice without atomics, any other
+// thread shares a locked overflow slice. Slices are reset lazily on first use in a new frame,
+// which keeps BeginFrame O(1).
+class FrameAllocator : public IAllocator {
+public:
+	FrameAllocator(size_t sliceSize, size_t sliceCount, size_t frameCount = 2);
+	~FrameAllocator() override;
+
+	void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void* Allocate(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void Free(void* ptr) override; // No-op, memory is recycled by BeginFrame
+	void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override; // No-op
+	void GetStats(MemoryStats& stats) const override;
+	void Reset() override; // Frees every buffered frame
+
+	bool AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag = MemoryTag::NoTag) override;
+	void FreeBatch(void** ptrs, size_t count) override; // No-op
+
+	// Allocate from a slice the caller picks, such as its worker index, instead of its thread slot.
+	// Slices at or past sliceCount share the overflow slice. nullptr instead of an assert when full.
+	// Each slice must only be used by one thread at a time.
+	void* TryAllocateFromSlice(size_t slice, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
+
+	// Rotate to the next frame buffer. Call at a frame sync point, while no thread is allocating.
+	void BeginFrame();
+	uint64_t GetFrameIndex() const;
+
+private:
+	struct Slice;
+	Slice* m_Slices;			// frameCount rows of sliceCount + 1 slices, the last one is the overflow slice
+	size_t m_SliceCount;
+	size_t m_FrameCount;
+	std::atomic<uint64_t> m_FrameIndex;
+	std::mutex m_OverflowLock;
+	mutable std::atomic<size_t> m_ObservedPeak;
+
+	Slice& GetSlice(uint64_t frame, size_t slice) const;
+	LinearAllocator& GetFrameSlice(uint64_t frame, size_t slice);
+};
+
+// Pool growth behaviour
+enum class PoolGrowth : uint8_t {
+	Fixed,		// one buffer of elementCount elements, Allocate fails once it is used up
+	Chunked,	// chunks of at least elementCount elements are added on demand
 };
 
 // Pool allocator - fixed size allocations
+// Chunked pools align every chunk to its own power-of-two size, so Free finds the owning chunk
+// by masking the pointer. Fixed pools recycle freed elements first and only carve never-used ones,
+// in address order, once none are free, so a virtual-backed fixed pool commits up to its peak.
 class PoolAllocator : public IAllocator {
 public:
-	PoolAllocator(size_t elementSize, size_t elementCount, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
+	PoolAllocator(size_t elementSize, size_t elementCount, size_t alignment = EDGE_DEFAULT_ALIGNMENT,
+		PoolGrowth growth = PoolGrowth::Fixed, MemoryBacking backing = MemoryBacking::Heap);
 	~PoolAllocator() override;
 
 	void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
 	void* Allocate(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
 	void Free(void* ptr) override;
+	void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
 	void GetStats(MemoryStats& stats) const override;
 	void Reset() override;
 
+	// Pops whole free-list segments and carves unused elements as one run
+	bool AllocateBatch(size_t count, size_t size, size_t alignment, void** out, MemoryTag tag = MemoryTag::NoTag) override;
+	// Splices the blocks onto the free list as one segment
+	void FreeBatch(void** ptrs, size_t count) override;
+
+	// Chunked pools only, release empty chunks once more than maxIdleChunks of them are idle.
+	// The last chunk is always kept. Defaults to never releasing.
+	void SetIdleChunkLimit(size_t maxIdleChunks);
+	size_t GetChunkCount() const;
+
+	size_t GetElementSize() const { return m_ElementSize; }
+	size_t GetElementAlignment() const { return m_ElementAlignment; }
+
 private:
+	struct Chunk;
 	uint8_t* m_Buffer;
 	uintptr_t* m_FreeList;
 	size_t m_ElementSize;
 	size_t m_ElementCount;
 	size_t m_AlignedElementSize;
+	size_t m_ElementAlignment;
 	size_t m_FreeCount;
+	size_t m_CarvedCount;		// fixed mode, elements handed out at least once since the last reset
 	MemoryStats m_Stats;
+	MemoryBacking m_Backing;
+	VirtualRange m_Range;
+
+	// Chunked mode
+	PoolGrowth m_Growth;
+	Chunk* m_Chunks;			// every chunk
+	Chunk* m_Available;			// chunks with at least one free element
+	size_t m_ChunkSize;
+	size_t m_ChunkHeaderSize;
+	size_t m_ChunkCapacity;
+	size_t m_ChunkCount;
+	size_t m_IdleChunks;
+	size_t m_MaxIdleChunks;
+
+	Chunk* AddChunk();
+	bool ReturnToChunk(void* ptr);
+	void ReleaseChunk(Chunk* chunk);
+	void BuildChunkFreeList(Chunk* chunk);
+	void LinkAvailable(Chunk* chunk);
+	void UnlinkAvailable(Chunk* chunk);
+};
+
+// Concurrent pool allocator - fixed size allocations from any thread
+// The shared free list is a lock-free stack of block indices with an ABA tag packed next to the
+// head. With magazines enabled each thread also keeps a small private stack of blocks and only
+// touches the shared list to exchange half a magazine at a time.
+// Blocks left in a magazine stay with its thread slot until the next thread to claim that slot
+// uses them, so size the pool for roughly 32 extra elements per worker.
+class ConcurrentPoolAllocator : public IAllocator {
+public:
+	ConcurrentPoolAllocator(size_t elementSize, size_t elementCount, size_t alignment = EDGE_DEFAULT_ALIGNMENT, bool useMagazines = true);
+	~ConcurrentPoolAllocator() override;
+
+	void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void* Allocate(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void Free(void* ptr) override;
+	void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT) override;
+	void GetStats(MemoryStats& stats) const override;
+	void Reset() override; // Not thread-safe, no other thread may use the pool during a reset
+
+	// nullptr instead of an assert when the pool is exhausted, for callers with a fallback
+	void* TryAllocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
+
+private:
+	struct Magazine;
+	uint8_t* m_Buffer;
+	Magazine* m_Magazines;			// one per thread slot, plus a shared one for threads without a slot
+	std::atomic<uint64_t> m_Head;	// block index in the low 32 bits, ABA tag in the high 32 bits
+	size_t m_ElementSize;
+	size_t m_ElementCount;
+	size_t m_AlignedElementSize;
+	size_t m_ResetCount;			// blocks implicitly freed by Reset
+	mutable std::atomic<size_t> m_ObservedPeak;
+	bool m_UseMagazines;
+
+	uint32_t PopShared();
+	void PushShared(uint32_t first, uint32_t last);
+	std::atomic<uint32_t>& NextIndex(uint32_t index) const;
 };
 
 // Global memory management functions
@@ -194,65 +842,212 @@ private:
 void Initialize();
 
 // Shutdown the memory subsystem
+// Call it after the last Free. Thread cache memory is only released once every block is back,
+// so a block freed later is still valid, but it and everything cached stay allocated.
 void Shutdown();
 
 // Get the default system allocator
 SystemAllocator* GetSystemAllocator();
 
-// Global memory allocation functions that use the system allocator
+// Global memory allocation functions that use the system allocator.
+// When tracking is disabled, small requests are served from a per-thread cache of size-classed
+// blocks that refills and drains in batches against a shared backend, so they never take a
+// global lock. When tracking is enabled every request goes straight to the system allocator.
 void* Allocate(size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
 void* AllocateAligned(size_t size, size_t alignment);
 void* AllocateTagged(size_t size, MemoryTag tag, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
+// Same as AllocateTagged, the call site goes to the leak report and the allocation sampler
+void* AllocateTagged(size_t size, MemoryTag tag, size_t alignment, const char* file, int line);
 void Free(void* ptr);
+// Sized free, size and alignment must match the allocation. The thread cache routes the block by
+// its size instead of reading the route from the block header.
+void Free(void* ptr, size_t size, size_t alignment = EDGE_DEFAULT_ALIGNMENT);
 void FreeAligned(void* ptr);
 
 // Utility functions
+// Return nullptr without constructing when the allocation fails or a hard budget refuses it
 template<typename T, typename... Args>
 T* New(Args&&... args) {
 	void* ptr = Allocate(sizeof(T), alignof(T));
+	if (!ptr) {
+		return nullptr;
+	}
 	return new(ptr) T(std::forward<Args>(args)...);
 }
 
+// New with a tag and the call site, what EDGE_NEW and EDGE_NEW_TAGGED expand to
+template<typename T, typename... Args>
+T* NewTagged(MemoryTag tag, const char* file, int line, Args&&... args) {
+	void* ptr = AllocateTagged(sizeof(T), tag, alignof(T), file, line);
+	if (!ptr) {
+		return nullptr;
+	}
+	return new(ptr) T(std::forward<Args>(args)...);
+}
+
+// Objects are freed with their size unless T is an open polymorphic type, whose pointer may hold
+// a larger derived object
 template<typename T>
 void Delete(T* ptr) {
 	if (ptr) {
 		ptr->~T();
-		Free(ptr);
+		if (std::is_polymorphic<T>::value && !std::is_final<T>::value) {
+			Free(ptr);
+		}
+		else {
+			Free(ptr, sizeof(T), alignof(T));
+		}
 	}
 }
 
+// Small dense index for the calling thread, recycled when the thread exits.
+// Returns EDGE_MAX_THREAD_SLOTS when every slot is taken.
+uint32_t GetThreadSlot();
+
+// Return the calling thread's cached blocks to the shared backend.
+// Runs automatically on thread exit, call it early for long-lived idle threads.
+void FlushThreadCache();
+
 // Memory leak detection
 void EnableTracking(bool enabled);
 void ReportLeaks();
 
-// Get memory stats
+// Get memory stats, per-thread cache counters are merged in on each call.
+// The merged peakUsage is approximate: at least the largest peak of any one source and the highest
+// merged usage a query has seen, a combined peak between two queries can go unseen.
 void GetStats(MemoryStats& stats);
 void GetTagStats(MemoryTag tag, MemoryStats& stats);
 
-// Alignment utilities
-inline size_t AlignUp(size_t size, size_t alignment) {
-	return (size + alignment - 1) & ~(alignment - 1);
-}
+// Attribution for memory carved out of an allocator other than the global one, such as a
+// container drawing from an arena. GetTagStats adds it on top of whatever the backing memory
+// itself was tagged with, GetStats leaves it out so the bytes are not counted twice there.
+void RecordTaggedUse(MemoryTag tag, size_t size);
+void ReleaseTaggedUse(MemoryTag tag, size_t size);
+
+// Tag budgets
+// A tag can have a soft and a hard budget on its current usage, counted the way GetTagStats
+// counts it. Every thread folds its usage in once it has moved it by USAGE_BATCH_BYTES, so a
+// budget can be crossed by up to one batch per thread before it is noticed, and the allocation
+// path only adds one compare against the cached hard budget. Crossing the soft budget calls the
+// budget handler once, and again after usage has dropped back below it. A global allocation that
+// would go over the hard budget calls the handler and returns nullptr. RecordTaggedUse counts
+// toward both budgets but can't fail, that memory is already allocated.
+enum class BudgetLevel {
+	Soft,		// Usage crossed the soft budget, the allocation went ahead
+	Hard		// The allocation would have gone over the hard budget and failed
+};
+
+// Info about a budget crossing
+struct BudgetInfo {
+	MemoryTag tag;
+	BudgetLevel level;
+	size_t usage;		// Usage of the tag before the failed allocation, or after the soft crossing
+	size_t budget;		// Budget that was crossed
+	size_t size;		// Size of the failed allocation, 0 for the soft budget
+};
+
+// Function type for custom budget handlers
+using BudgetCallbackFn = std::function<void(const BudgetInfo&)>;
+
+// Budget handler class - allows streaming and LOD systems to react to memory pressure
+// The callback runs inside the allocation that crossed the budget. Keep it short, note the
+// pressure and evict or drop quality on the next update. Allocations it makes don't call it again.
+class BudgetHandler {
+public:
+	static BudgetHandler& Get();
+
+	// Register a custom handler, during startup as it is read without a lock
+	void SetCallback(BudgetCallbackFn callback);
+
+	// Reset to default handler
+	void ResetCallback();
+
+	// Handle a budget crossing
+	void HandleBudget(const BudgetInfo& info);
+
+private:
+	BudgetHandler() = default;
+	BudgetCallbackFn m_Callback;
+
+	// Default handler behavior
+	void DefaultHandler(const BudgetInfo& info);
+};
+
+// A budget of 0 removes it, the soft budget should be below the hard one
+void SetTagBudget(MemoryTag tag, size_t softBudget, size_t hardBudget);
+void GetTagBudget(MemoryTag tag, size_t& softBudget, size_t& hardBudget);
+
+// Allocation scopes
+// Every thread has a current tag and a current allocator, set for the lifetime of a MemoryScope
+// and restored when it ends, so nested scopes form a stack. Allocate and operator new (with
+// EDGE_REPLACE_GLOBAL_NEW) tag untagged requests with the current tag. The current allocator is
+// picked up by users that keep their allocator for the free, like StlAllocator, global
+// operator new can't and always uses the global functions.
+MemoryTag GetCurrentTag();
+// nullptr when no scope set one, meaning the global functions
+IAllocator* GetCurrentAllocator();
+
+class MemoryScope {
+public:
+	// Keeps the current allocator
+	explicit MemoryScope(MemoryTag tag);
+	// Keeps the current tag
+	explicit MemoryScope(IAllocator* allocator);
+	MemoryScope(IAllocator* allocator, MemoryTag tag);
+	~MemoryScope();
+
+	MemoryScope(const MemoryScope&) = delete;
+	MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+	IAllocator* m_PrevAllocator;
+	MemoryTag m_PrevTag;
+};
+
+// Allocation sampling
+// Cheap enough for release builds: each thread counts down the bytes it allocates and takes a
+// stack trace once it crosses an exponentially distributed threshold with the configured mean,
+// so every byte has the same chance of being sampled. Samples with the same call site and stack
+// are merged into one entry of a fixed-size site table.
+struct AllocationSite {
+	const char* file;		// nullptr when the allocation did not come through a macro
+	int line;
+	MemoryTag tag;
+	uint32_t frameCount;
+	void* frames[EDGE_ALLOCATION_SITE_FRAMES];
+	size_t sampleCount;
+	size_t sampledBytes;	// sum of the sampled allocation sizes
+	size_t estimatedBytes;	// estimate of all bytes allocated from this site
+};
+
+// Mean bytes between samples, 0 disables sampling (the default)
+void SetAllocationSampleInterval(size_t bytes);
+size_t GetAllocationSampleInterval();
+
+// Copies up to maxSites entries, heaviest first, and returns how many were copied
+size_t GetAllocationSites(AllocationSite* sites, size_t maxSites);
+void ReportAllocationSites(size_t maxSites = 16);
+void ClearAllocationSites();
+
+// Allocation tracing
+// Streams every allocate and free of the global functions into a memory-mapped ring file, with
+// the call site of the macros as the site id. See EdgeAllocationTrace.h for the format and for
+// tracing other allocators. While no trace runs the fast path costs one relaxed load.
+bool StartAllocationTrace(const char* path, size_t capacity = EDGE_ALLOCATION_TRACE_CAPACITY);
+// Waits for events being recorded on other threads, then finishes the file
+void StopAllocationTrace();
+// Frame boundary for replays, call once per frame while tracing
+void MarkAllocationTraceFrame();
 
-inline void* AlignPointer(void* ptr, size_t alignment) {
-	return reinterpret_cast<void*>((reinterpret_cast<uintptr_t>(ptr) + alignment - 1) & ~(alignment - 1));
-}
 END_NS_MEMORY
 END_NS_EDGE
 
 // Macros for memory allocation with automatic source tracking
-#if EDGE_DEBUG
-#define EDGE_NEW(Type, ...) new (Edge::Memory::AllocateTagged(sizeof(Type), Edge::MemoryTag::Default, alignof(Type))) Type(__VA_ARGS__)
-#define EDGE_DELETE(ptr) Edge::Memory::Delete(ptr)
-#define EDGE_MALLOC(size) Edge::Memory::Allocate(size)
-#define EDGE_MALLOC_TAGGED(size, tag) Edge::Memory::AllocateTagged(size, tag)
-#define EDGE_FREE(ptr) Edge::Memory::Free(ptr)
-#else
-#define EDGE_NEW(Type, ...) new Type(__VA_ARGS__)
-#define EDGE_DELETE(ptr) delete ptr
-#define EDGE_MALLOC(size) Edge::Memory::Allocate(size)
-#define EDGE_MALLOC_TAGGED(size, tag) Edge::Memory::AllocateTagged(size, tag)
-#define EDGE_FREE(ptr) Edge::Memory::Free(ptr)
-#endif
+#define EDGE_NEW(Type, ...) ::edge::memory::NewTagged<Type>(::edge::memory::MemoryTag::NoTag, __FILE__, __LINE__, ##__VA_ARGS__)
+#define EDGE_NEW_TAGGED(Type, tag, ...) ::edge::memory::NewTagged<Type>(tag, __FILE__, __LINE__, ##__VA_ARGS__)
+#define EDGE_DELETE(ptr) ::edge::memory::Delete(ptr)
+#define EDGE_MALLOC(size) ::edge::memory::AllocateTagged(size, ::edge::memory::MemoryTag::NoTag, ::edge::memory::EDGE_DEFAULT_ALIGNMENT, __FILE__, __LINE__)
+#define EDGE_MALLOC_TAGGED(size, tag) ::edge::memory::AllocateTagged(size, tag, ::edge::memory::EDGE_DEFAULT_ALIGNMENT, __FILE__, __LINE__)
+#define EDGE_FREE(ptr) ::edge::memory::Free(ptr)
 
 #endif // INC_EDGE_CORE_MEMORY_
\ No newline at end of file
@@ -0,0 +1,380 @@
+/*
+ * EdgeProfiler.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Instrumentation profiler for profile builds.
+ *
+ */
+
+#include "EdgeProfiler.h"
+
+#if EDGE_PROFILE
+
+#include "EdgeMemory.h"
+#include <chrono>
+#include <cstdio>
+#include <new>
+
+BEGIN_NS_EDGE
+BEGIN_NS_PROFILE
+
+//==================================================================================================
+// Ring Registry
+//
+// Rings are pushed onto a lock-free list and never unlinked before Shutdown, so the exporter can
+// walk it at any time. Rings come from the platform allocator and stay out of the memory stats.
+//==================================================================================================
+
+class RingRegistry {
+public:
+	static ThreadRing* Acquire();
+	static void Retire(ThreadRing* ring);
+	static void ReleaseAll();
+
+	static ThreadRing* GetFirst();
+	static ThreadRing* GetNext(const ThreadRing* ring) { return ring->m_Next; }
+};
+
+namespace {
+
+std::atomic<ThreadRing*> g_Rings(nullptr);
+std::atomic<uint32_t> g_NextRingId(0);
+std::atomic<uint64_t> g_BaseTimestamp(0);	// first event of the profile, time zero in exports
+std::atomic<uint32_t> g_Generation(1);		// bumped by Shutdown, rings of an older one are gone
+
+// Taken by threads that exit or fail to get a ring, written to but never exported
+ThreadRing& GetDiscardRing() {
+	alignas(ThreadRing) static uint8_t storage[sizeof(ThreadRing)];
+	static ThreadRing* ring = new (storage) ThreadRing(~0u);
+	return *ring;
+}
+
+struct ThreadRingHolder {
+	ThreadRing* ring;
+	uint32_t generation;
+	bool exited;
+
+	// Allocators flush from their own thread-exit code, which may run after this, so the thread
+	// keeps writing into the discard ring rather than into a ring that is already handed on
+	~ThreadRingHolder() {
+		if (ring && generation == g_Generation.load(std::memory_order_relaxed)) {
+			RingRegistry::Retire(ring);
+		}
+		ring = &GetDiscardRing();
+		exited = true;
+	}
+};
+
+thread_local ThreadRingHolder t_Ring = { nullptr, 0, false };
+
+} // namespace
+
+ThreadRing* RingRegistry::Acquire() {
+	uint64_t expectedBase = 0;
+	g_BaseTimestamp.compare_exchange_strong(expectedBase, ReadTimestamp(), std::memory_order_relaxed);
+
+	// Take over the ring of a thread that exited
+	for (ThreadRing* ring = g_Rings.load(std::memory_order_acquire); ring; ring = ring->m_Next) {
+		bool inUse = false;
+		if (ring->m_InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) {
+			ring->SetName(nullptr);
+			return ring;
+		}
+	}
+
+	void* memory = memory::PlatformAlignedAlloc(sizeof(ThreadRing), memory::EDGE_CACHE_LINE_SIZE);
+	if (!memory) {
+		EDGE_ASSERT(false, "Failed to allocate a profiler ring");
+		return nullptr;
+	}
+
+	ThreadRing* ring = new (memory) ThreadRing(g_NextRingId.fetch_add(1, std::memory_order_relaxed));
+	ring->m_Next = g_Rings.load(std::memory_order_relaxed);
+	while (!g_Rings.compare_exchange_weak(ring->m_Next, ring, std::memory_order_release, std::memory_order_relaxed)) {
+	}
+	return ring;
+}
+
+void RingRegistry::Retire(ThreadRing* ring) {
+	ring->m_InUse.store(false, std::memory_order_release);
+}
+
+void RingRegistry::ReleaseAll() {
+	g_Generation.fetch_add(1, std::memory_order_relaxed);
+	ThreadRing* ring = g_Rings.exchange(nullptr, std::memory_order_acquire);
+	while (ring) {
+		ThreadRing* next = ring->m_Next;
+		ring->~ThreadRing();
+		memory::PlatformAlignedFree(ring);
+		ring = next;
+	}
+	g_NextRingId.store(0, std::memory_order_relaxed);
+	g_BaseTimestamp.store(0, std::memory_order_relaxed);
+}
+
+ThreadRing* RingRegistry::GetFirst() {
+	return g_Rings.load(std::memory_order_acquire);
+}
+
+ThreadRing& GetThreadRing() {
+	ThreadRingHolder& holder = t_Ring;
+	const uint32_t generation = g_Generation.load(std::memory_order_relaxed);
+	if (holder.ring && (holder.generation == generation || holder.exited)) {
+		return *holder.ring;
+	}
+
+	ThreadRing* ring = RingRegistry::Acquire();
+	holder.ring = ring ? ring : &GetDiscardRing();
+	holder.generation = generation;
+	return *holder.ring;
+}
+
+//==================================================================================================
+// Timing
+//==================================================================================================
+
+uint64_t GetTimestampFrequency() {
+	static const uint64_t frequency = []() {
+		// Long enough for a stable figure, paid once by the first export
+		const auto start = std::chrono::steady_clock::now();
+		const uint64_t startTicks = ReadTimestamp();
+		while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20)) {
+		}
+		const auto end = std::chrono::steady_clock::now();
+		const uint64_t endTicks = ReadTimestamp();
+
+		const double seconds = std::chrono::duration<double>(end - start).count();
+		return static_cast<uint64_t>(static_cast<double>(endTicks - startTicks) / seconds);
+	}();
+	return frequency;
+}
+
+//==================================================================================================
+// Frames and Counters
+//==================================================================================================
+namespace {
+
+constexpr size_t kTagCount = static_cast<size_t>(memory::MemoryTag::COUNT);
+
+std::atomic<uint64_t> g_FrameIndex(0);
+std::atomic<bool> g_MemoryCounters(true);
+
+// Only touched by the thread that marks frames
+uint64_t g_LastTagUsage[kTagCount + 1];
+
+void SampleMemoryCounters(ThreadRing& ring) {
+	for (size_t i = 0; i < kTagCount; ++i) {
+		const memory::MemoryTag tag = static_cast<memory::MemoryTag>(i);
+		memory::MemoryStats stats;
+		memory::GetTagStats(tag, stats);
+		if (stats.currentUsage != g_LastTagUsage[i]) {
+			g_LastTagUsage[i] = stats.currentUsage;
+			ring.Write(EventType::Counter, memory::GetTagName(tag), stats.currentUsage);
+		}
+	}
+
+	memory::MemoryStats total;
+	memory::GetStats(total);
+	if (total.currentUsage != g_LastTagUsage[kTagCount]) {
+		g_LastTagUsage[kTagCount] = total.currentUsage;
+		ring.Write(EventType::Counter, "Memory", total.currentUsage);
+	}
+}
+
+} // namespace
+
+void MarkFrame() {
+	ThreadRing& ring = GetThreadRing();
+	ring.Write(EventType::Frame, nullptr, g_FrameIndex.fetch_add(1, std::memory_order_relaxed));
+	if (g_MemoryCounters.load(std::memory_order_relaxed)) {
+		SampleMemoryCounters(ring);
+	}
+}
+
+void SetMemoryCountersEnabled(bool enabled) {
+	g_MemoryCounters.store(enabled, std::memory_order_relaxed);
+}
+
+void SetThreadName(const char* name) {
+	GetThreadRing().SetName(name);
+}
+
+//==================================================================================================
+// Chrome Trace Export
+//
+// Each ring is copied before it is written out. A writer may overwrite the oldest slots during
+// the copy, so the write index is read again afterwards and everything it may have reached is
+// dropped. Zone ends whose begin was lost to the ring are skipped, zones still open at the end
+// of the window are closed at its last event.
+//==================================================================================================
+namespace {
+
+struct EventCopy {
+	uint64_t timestamp;
+	uint64_t data;
+	uint64_t value;
+};
+
+// Copies the ring's window into events and returns the number of events still valid, starting
+// at events + first
+size_t CopyRing(const ThreadRing& ring, EventCopy* events, size_t& first) {
+	const uint64_t end = ring.GetWriteIndex();
+	const uint64_t begin = end > EDGE_PROFILE_RING_EVENTS ? end - EDGE_PROFILE_RING_EVENTS : 0;
+	for (uint64_t index = begin; index < end; ++index) {
+		const Event& event = ring.GetEvent(index);
+		EventCopy& copy = events[index - begin];
+		copy.timestamp = event.timestamp.load(std::memory_order_relaxed);
+		copy.data = event.data.load(std::memory_order_relaxed);
+		copy.value = event.value.load(std::memory_order_relaxed);
+	}
+
+	// The slot of the next unpublished event may already hold a partial write
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64_t after = ring.GetWriteIndex() + 1;
+	const uint64_t validBegin = after > EDGE_PROFILE_RING_EVENTS ? after - EDGE_PROFILE_RING_EVENTS : 0;
+	first = validBegin > begin ? static_cast<size_t>(validBegin - begin) : 0;
+	const size_t count = static_cast<size_t>(end - begin);
+	return count > first ? count - first : 0;
+}
+
+void WriteJsonString(FILE* file, const char* value) {
+	fputc('"', file);
+	for (const char* c = value ? value : ""; *c; ++c) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', file);
+			fputc(*c, file);
+		}
+		else if (static_cast<unsigned char>(*c) < 0x20) {
+			fprintf(file, "\\u%04x", static_cast<unsigned>(static_cast<unsigned char>(*c)));
+		}
+		else {
+			fputc(*c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+struct TraceWriter {
+	FILE* file;
+	bool first;
+	uint64_t base;
+	double ticksToMicroseconds;
+
+	// Opens an event object with the fields every event has
+	void Begin(const char* name, const char* phase, uint64_t timestamp, uint32_t thread) {
+		fputs(first ? "\n" : ",\n", file);
+		first = false;
+		fputs("{\"name\":", file);
+		WriteJsonString(file, name);
+		const double ts = timestamp > base ? static_cast<double>(timestamp - base) * ticksToMicroseconds : 0.0;
+		fprintf(file, ",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":0,\"tid\":%u", phase, ts, thread);
+	}
+};
+
+void WriteRing(TraceWriter& writer, const ThreadRing& ring, const EventCopy* events, size_t count) {
+	const uint32_t thread = ring.GetId();
+
+	writer.Begin("thread_name", "M", writer.base, thread);
+	fputs(",\"args\":{\"name\":", writer.file);
+	char fallbackName[32];
+	snprintf(fallbackName, sizeof(fallbackName), "Thread %u", thread);
+	WriteJsonString(writer.file, ring.GetName() ? ring.GetName() : fallbackName);
+	fputs("}}", writer.file);
+
+	size_t depth = 0;
+	uint64_t lastFrame = 0;
+	uint64_t lastTimestamp = writer.base;
+	for (size_t i = 0; i < count; ++i) {
+		const EventCopy& event = events[i];
+		const EventType type = static_cast<EventType>(event.value >> 56);
+		const uint64_t value = event.value & ThreadRing::VALUE_MASK;
+		lastTimestamp = event.timestamp;
+
+		switch (type) {
+		case EventType::ZoneBegin: {
+			const ZoneSite* site = reinterpret_cast<const ZoneSite*>(static_cast<uintptr_t>(event.data));
+			writer.Begin(site->name, "B", event.timestamp, thread);
+			fputs(",\"args\":{\"file\":", writer.file);
+			WriteJsonString(writer.file, site->file);
+			fprintf(writer.file, ",\"line\":%d}}", site->line);
+			depth++;
+			break;
+		}
+		case EventType::ZoneEnd:
+			if (depth > 0) {
+				writer.Begin("", "E", event.timestamp, thread);
+				fputs("}", writer.file);
+				depth--;
+			}
+			break;
+		case EventType::Frame:
+			writer.Begin("Frame", "i", event.timestamp, thread);
+			fprintf(writer.file, ",\"s\":\"g\",\"args\":{\"frame\":%llu}}", static_cast<unsigned long long>(value));
+			if (lastFrame != 0) {
+				// Spikes stand out as a counter track
+				const double milliseconds = static_cast<double>(event.timestamp - lastFrame) * writer.ticksToMicroseconds / 1000.0;
+				writer.Begin("Frame Time (ms)", "C", event.timestamp, thread);
+				fprintf(writer.file, ",\"args\":{\"value\":%.3f}}", milliseconds);
+			}
+			lastFrame = event.timestamp;
+			break;
+		case EventType::Counter:
+			writer.Begin(reinterpret_cast<const char*>(static_cast<uintptr_t>(event.data)), "C", event.timestamp, thread);
+			fprintf(writer.file, ",\"args\":{\"value\":%llu}}", static_cast<unsigned long long>(value));
+			break;
+		}
+	}
+
+	for (; depth > 0; --depth) {
+		writer.Begin("", "E", lastTimestamp, thread);
+		fputs("}", writer.file);
+	}
+}
+
+} // namespace
+
+bool ExportChromeTrace(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (!file) {
+		return false;
+	}
+
+	EventCopy* events = static_cast<EventCopy*>(
+		memory::PlatformAlignedAlloc(EDGE_PROFILE_RING_EVENTS * sizeof(EventCopy), alignof(EventCopy)));
+	if (!events) {
+		fclose(file);
+		return false;
+	}
+
+	TraceWriter writer = { file, true, g_BaseTimestamp.load(std::memory_order_relaxed),
+		1e6 / static_cast<double>(GetTimestampFrequency()) };
+
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+	for (ThreadRing* ring = RingRegistry::GetFirst(); ring; ring = RingRegistry::GetNext(ring)) {
+		size_t first = 0;
+		const size_t count = CopyRing(*ring, events, first);
+		WriteRing(writer, *ring, events + first, count);
+	}
+	fputs("\n]}\n", file);
+
+	memory::PlatformAlignedFree(events);
+	const bool written = ferror(file) == 0;
+	fclose(file);
+	return written;
+}
+
+void Shutdown() {
+	RingRegistry::ReleaseAll();
+	g_FrameIndex.store(0, std::memory_order_relaxed);
+	for (uint64_t& usage : g_LastTagUsage) {
+		usage = 0;
+	}
+}
+
+END_NS_PROFILE
+END_NS_EDGE
+
+#endif // EDGE_PROFILE
@@ -0,0 +1,189 @@
+/*
+ * EdgeProfiler.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Instrumentation profiler for profile builds.
+ *
+ * Responsibilities:
+ * - Record nested CPU zones, frame markers and counters into per-thread rings,
+ * - Sample the memory system's per-tag usage once per frame,
+ * - And export the recorded window as a Chrome trace.
+ */
+
+#ifndef INC_EDGE_CORE_PROFILER_
+#define INC_EDGE_CORE_PROFILER_
+
+#include "EdgeCore.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if EDGE_PROFILE && EDGE_ARCH_X64
+#if EDGE_COMPILER_MSVC
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#elif EDGE_PROFILE && EDGE_ARCH_ARM64 && EDGE_COMPILER_MSVC
+#include <intrin.h>
+#elif EDGE_PROFILE
+#include <chrono>
+#endif
+
+#if EDGE_PROFILE
+
+BEGIN_NS_EDGE
+BEGIN_NS_PROFILE
+
+// Events kept per thread, older ones are overwritten
+constexpr size_t EDGE_PROFILE_RING_EVENTS = size_t(1) << 16;
+
+// Raw CPU timestamp, the invariant TSC on x64 and the virtual counter on ARM64
+inline uint64_t ReadTimestamp() {
+#if EDGE_ARCH_X64
+	return __rdtsc();
+#elif EDGE_ARCH_ARM64 && EDGE_COMPILER_MSVC
+	return static_cast<uint64_t>(_ReadStatusReg(ARM64_CNTVCT));
+#elif EDGE_ARCH_ARM64
+	uint64_t value;
+	__asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+	return value;
+#else
+	return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Timestamp ticks per second, calibrated against the steady clock on first use
+uint64_t GetTimestampFrequency();
+
+// Static description of one EDGE_PROFILE_SCOPE
+struct ZoneSite {
+	const char* name;
+	const char* file;
+	int line;
+};
+
+enum class EventType : uint8_t {
+	ZoneBegin,
+	ZoneEnd,
+	Frame,
+	Counter,
+};
+
+// One ring slot. The owning thread is the only writer, the fields are relaxed atomics so the
+// exporter can copy a ring while it is being written and drop whatever was overwritten meanwhile.
+struct Event {
+	std::atomic<uint64_t> timestamp;
+	std::atomic<uint64_t> data;		// ZoneSite for zones, the name for counters
+	std::atomic<uint64_t> value;	// type in the top byte, counter value or frame index below
+};
+
+// Events of one thread, a single-producer ring
+// A thread that exits leaves its ring to the next new thread, which continues it under the same
+// thread id in exported traces.
+class ThreadRing {
+public:
+	explicit ThreadRing(uint32_t id) : m_WriteIndex(0), m_Next(nullptr), m_Name(nullptr), m_Id(id), m_InUse(true) {}
+
+	void Write(EventType type, const void* data, uint64_t value) {
+		const uint64_t index = m_WriteIndex.load(std::memory_order_relaxed);
+		// Keeps the slot writes after the last publish, the exporter relies on it to spot overwritten
+		// slots. Free on x64, a store barrier on ARM64.
+		std::atomic_thread_fence(std::memory_order_release);
+		Event& event = m_Events[index & (EDGE_PROFILE_RING_EVENTS - 1)];
+		event.timestamp.store(ReadTimestamp(), std::memory_order_relaxed);
+		event.data.store(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(data)), std::memory_order_relaxed);
+		event.value.store((static_cast<uint64_t>(type) << 56) | (value & VALUE_MASK), std::memory_order_relaxed);
+		m_WriteIndex.store(index + 1, std::memory_order_release);
+	}
+
+	// Events written so far, the ring holds the last EDGE_PROFILE_RING_EVENTS of them
+	uint64_t GetWriteIndex() const { return m_WriteIndex.load(std::memory_order_acquire); }
+	const Event& GetEvent(uint64_t index) const { return m_Events[index & (EDGE_PROFILE_RING_EVENTS - 1)]; }
+
+	uint32_t GetId() const { return m_Id; }
+	const char* GetName() const { return m_Name.load(std::memory_order_relaxed); }
+	void SetName(const char* name) { m_Name.store(name, std::memory_order_relaxed); }
+
+	static constexpr uint64_t VALUE_MASK = (uint64_t(1) << 56) - 1;
+
+private:
+	friend class RingRegistry;
+
+	std::atomic<uint64_t> m_WriteIndex;
+	ThreadRing* m_Next;					// registry list, never changes once published
+	std::atomic<const char*> m_Name;
+	uint32_t m_Id;
+	std::atomic<bool> m_InUse;
+	Event m_Events[EDGE_PROFILE_RING_EVENTS];
+};
+
+// Ring of the calling thread, created on its first event
+ThreadRing& GetThreadRing();
+
+// Zone for the lifetime of the scope
+class ZoneScope {
+public:
+	explicit ZoneScope(const ZoneSite* site) : m_Ring(GetThreadRing()) {
+		m_Ring.Write(EventType::ZoneBegin, site, 0);
+	}
+	~ZoneScope() {
+		m_Ring.Write(EventType::ZoneEnd, nullptr, 0);
+	}
+
+	ZoneScope(const ZoneScope&) = delete;
+	ZoneScope& operator=(const ZoneScope&) = delete;
+
+private:
+	ThreadRing& m_Ring;
+};
+
+// Ends a frame, call it from one thread. When enabled it also records the usage of every memory
+// tag that changed since the last frame. Exports turn the markers into a frame time counter.
+void MarkFrame();
+
+// Value of a named counter, name must be a string that outlives the profile
+inline void RecordCounter(const char* name, uint64_t value) {
+	GetThreadRing().Write(EventType::Counter, name, value);
+}
+
+// Per-tag usage counters in MarkFrame, on by default
+void SetMemoryCountersEnabled(bool enabled);
+
+// Display name of the calling thread in exported traces, name must outlive the profile
+void SetThreadName(const char* name);
+
+// Write every thread's recorded window as Chrome trace event JSON, readable by chrome://tracing,
+// Perfetto and Speedscope. Safe to call while other threads keep recording.
+bool ExportChromeTrace(const char* path);
+
+// Release every ring, no thread may record during or after this
+void Shutdown();
+
+END_NS_PROFILE
+END_NS_EDGE
+
+#define EDGE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define EDGE_PROFILE_CONCAT(a, b) EDGE_PROFILE_CONCAT_IMPL(a, b)
+
+// The site is a constant-initialized static, a zone costs two timestamps and two ring writes
+#define EDGE_PROFILE_SCOPE(name) \
+	static const ::edge::profile::ZoneSite EDGE_PROFILE_CONCAT(edgeZoneSite_, __LINE__) = { name, __FILE__, __LINE__ }; \
+	::edge::profile::ZoneScope EDGE_PROFILE_CONCAT(edgeZone_, __LINE__)(&EDGE_PROFILE_CONCAT(edgeZoneSite_, __LINE__))
+#define EDGE_PROFILE_FRAME() ::edge::profile::MarkFrame()
+#define EDGE_PROFILE_COUNTER(name, value) ::edge::profile::RecordCounter(name, static_cast<uint64_t>(value))
+#define EDGE_PROFILE_THREAD_NAME(name) ::edge::profile::SetThreadName(name)
+
+#else
+
+#define EDGE_PROFILE_SCOPE(name)
+#define EDGE_PROFILE_FRAME()
+#define EDGE_PROFILE_COUNTER(name, value)
+#define EDGE_PROFILE_THREAD_NAME(name)
+
+#endif // EDGE_PROFILE
+
+#endif // INC_EDGE_CORE_PROFILER_
@@ -0,0 +1,418 @@
+/*
+ * EdgeRelocatableHeap.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Handle-based heap that defragments itself a slice at a time.
+ *
+ */
+
+#include "EdgeRelocatableHeap.h"
+#include "EdgeProfiler.h"
+#include <cstddef>
+#include <cstring>
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+struct RelocatableHeap::Block {
+	size_t size;				// header included
+	size_t previousSize;		// 0 for the first block
+	uint32_t entry;				// table entry of a used block, FREE for a hole
+	uint32_t reserved[3];
+
+	// Holes only, a used block's payload starts here
+	Block* nextFree;
+	Block* previousFree;
+
+	static constexpr uint32_t FREE = 0xFFFFFFFFu;
+};
+
+struct RelocatableHeap::Entry {
+	size_t offset;				// of the block, the next free entry while unused
+	uint32_t generation;
+	uint32_t pins;
+};
+
+namespace {
+
+constexpr size_t kAlignment = 16;
+constexpr size_t kHeaderSize = 32;		// Block up to its free list links
+constexpr size_t kMinBlockSize = kHeaderSize + kAlignment;
+constexpr uint32_t kNoEntry = 0xFFFFFFFFu;
+constexpr uint32_t kMinEntryCapacity = 64;
+
+} // namespace
+
+//==================================================================================================
+// RelocatableHeap Implementation
+//==================================================================================================
+
+RelocatableHeap::RelocatableHeap(size_t capacity, MemoryTag tag)
+	: m_Entries(nullptr)
+	, m_EntryCount(0)
+	, m_EntryCapacity(0)
+	, m_FreeEntry(kNoEntry)
+	, m_FreeBlocks(nullptr)
+	, m_Top(0)
+	, m_LastSize(0)
+	, m_Cursor(0)
+	, m_HoleBytes(0)
+	, m_Budget(EDGE_RELOCATABLE_HEAP_DEFAULT_BUDGET)
+	, m_Tag(tag) {
+	static_assert(offsetof(Block, nextFree) == kHeaderSize, "Block header size mismatch");
+	static_assert(sizeof(Block) <= kMinBlockSize, "Holes must fit their free list links");
+
+	const bool reserved = m_Range.Reserve(capacity);
+	EDGE_ASSERT(reserved, "Failed to reserve RelocatableHeap");
+	(void)reserved;
+}
+
+RelocatableHeap::~RelocatableHeap() {
+	EDGE_ASSERT(m_Stats.currentUsage == 0, "RelocatableHeap destroyed with live blocks");
+	ReleaseTaggedUse(m_Tag, m_Stats.currentUsage);
+	memory::Free(m_Entries);
+}
+
+RelocatableHeap::Block* RelocatableHeap::GetBlock(size_t offset) const {
+	return reinterpret_cast<Block*>(m_Range.GetBase() + offset);
+}
+
+size_t RelocatableHeap::GetOffset(const Block* block) const {
+	return static_cast<size_t>(reinterpret_cast<const uint8_t*>(block) - m_Range.GetBase());
+}
+
+RelocatableHeap::Block* RelocatableHeap::GetNext(Block* block) const {
+	const size_t next = GetOffset(block) + block->size;
+	return next < m_Top ? GetBlock(next) : nullptr;
+}
+
+RelocatableHeap::Block* RelocatableHeap::GetPrevious(Block* block) const {
+	return block->previousSize ? reinterpret_cast<Block*>(reinterpret_cast<uint8_t*>(block) - block->previousSize) : nullptr;
+}
+
+RelocatableHeap::Entry* RelocatableHeap::FindEntry(RelocatableHandle handle) const {
+	if (handle.index >= m_EntryCount) {
+		return nullptr;
+	}
+	Entry* entry = &m_Entries[handle.index];
+	return handle.generation != 0 && entry->generation == handle.generation ? entry : nullptr;
+}
+
+bool RelocatableHeap::GrowEntries() {
+	const uint32_t capacity = m_EntryCapacity ? m_EntryCapacity * 2 : kMinEntryCapacity;
+	Entry* entries = static_cast<Entry*>(memory::Allocate(capacity * sizeof(Entry), alignof(Entry)));
+	EDGE_ASSERT(entries != nullptr, "Failed to grow RelocatableHeap handle table");
+	if (!entries) {
+		return false;
+	}
+
+	if (m_Entries) {
+		memcpy(entries, m_Entries, m_EntryCount * sizeof(Entry));
+		memory::Free(m_Entries);
+	}
+	m_Entries = entries;
+	m_EntryCapacity = capacity;
+	return true;
+}
+
+void RelocatableHeap::InsertFree(Block* block) {
+	block->entry = Block::FREE;
+	block->previousFree = nullptr;
+	block->nextFree = m_FreeBlocks;
+	if (m_FreeBlocks) {
+		m_FreeBlocks->previousFree = block;
+	}
+	m_FreeBlocks = block;
+	m_HoleBytes += block->size;
+}
+
+void RelocatableHeap::RemoveFree(Block* block) {
+	if (block->previousFree) {
+		block->previousFree->nextFree = block->nextFree;
+	}
+	else {
+		m_FreeBlocks = block->nextFree;
+	}
+	if (block->nextFree) {
+		block->nextFree->previousFree = block->previousFree;
+	}
+	m_HoleBytes -= block->size;
+}
+
+RelocatableHeap::Block* RelocatableHeap::TakeFree(size_t size) {
+	Block* block = m_FreeBlocks;
+	while (block && block->size < size) {
+		block = block->nextFree;
+	}
+	if (!block) {
+		return nullptr;
+	}
+
+	RemoveFree(block);
+
+	// Split off the rest, its neighbor above is used since holes are always merged
+	const size_t remainder = block->size - size;
+	if (remainder >= kMinBlockSize) {
+		block->size = size;
+		Block* rest = GetNext(block);
+		rest->size = remainder;
+		rest->previousSize = size;
+		GetNext(rest)->previousSize = remainder;
+		InsertFree(rest);
+	}
+	return block;
+}
+
+RelocatableHeap::Block* RelocatableHeap::TakeTop(size_t size) {
+	if (size > m_Range.GetReservedSize() - m_Top || !m_Range.Commit(m_Top + size)) {
+		return nullptr;
+	}
+
+	Block* block = GetBlock(m_Top);
+	block->size = size;
+	block->previousSize = m_LastSize;
+	m_Top += size;
+	m_LastSize = size;
+	return block;
+}
+
+void RelocatableHeap::Release(Block* block) {
+	Block* next = GetNext(block);
+	if (next && next->entry == Block::FREE) {
+		RemoveFree(next);
+		block->size += next->size;
+	}
+
+	Block* previous = GetPrevious(block);
+	if (previous && previous->entry == Block::FREE) {
+		RemoveFree(previous);
+		previous->size += block->size;
+		block = previous;
+	}
+
+	// The last block is never a hole, the top just comes down
+	const size_t offset = GetOffset(block);
+	if (offset + block->size == m_Top) {
+		m_Top = offset;
+		m_LastSize = block->previousSize;
+		return;
+	}
+
+	GetNext(block)->previousSize = block->size;
+	InsertFree(block);
+	if (offset < m_Cursor) {
+		m_Cursor = offset;
+	}
+}
+
+RelocatableHandle RelocatableHeap::Allocate(size_t size) {
+	EDGE_ASSERT(size > 0, "RelocatableHeap can't allocate 0 bytes");
+	if (size == 0 || size > m_Range.GetReservedSize()) {
+		return RelocatableHandle();
+	}
+
+	if (m_FreeEntry == kNoEntry && m_EntryCount == m_EntryCapacity && !GrowEntries()) {
+		return RelocatableHandle();
+	}
+
+	size_t blockSize = AlignUp(size, kAlignment) + kHeaderSize;
+	if (blockSize < kMinBlockSize) {
+		blockSize = kMinBlockSize;
+	}
+
+	Block* block = TakeFree(blockSize);
+	if (!block) {
+		block = TakeTop(blockSize);
+	}
+	if (!block && m_HoleBytes + (m_Range.GetReservedSize() - m_Top) >= blockSize) {
+		Compact(~size_t(0));
+		block = TakeFree(blockSize);
+		if (!block) {
+			block = TakeTop(blockSize);
+		}
+	}
+	if (!block) {
+		return RelocatableHandle();
+	}
+
+	uint32_t index = m_FreeEntry;
+	if (index != kNoEntry) {
+		m_FreeEntry = static_cast<uint32_t>(m_Entries[index].offset);
+	}
+	else {
+		index = m_EntryCount++;
+		m_Entries[index].generation = 1;
+	}
+
+	Entry& entry = m_Entries[index];
+	entry.offset = GetOffset(block);
+	entry.pins = 0;
+	block->entry = index;
+
+	const size_t payload = block->size - kHeaderSize;
+	m_Stats.totalAllocated += payload;
+	m_Stats.currentUsage += payload;
+	m_Stats.allocationCount++;
+	if (m_Stats.currentUsage > m_Stats.peakUsage) {
+		m_Stats.peakUsage = m_Stats.currentUsage;
+	}
+	RecordTaggedUse(m_Tag, payload);
+	return RelocatableHandle(index, entry.generation);
+}
+
+void RelocatableHeap::Free(RelocatableHandle handle) {
+	Entry* entry = FindEntry(handle);
+	EDGE_ASSERT(entry != nullptr, "Freeing a stale RelocatableHandle");
+	if (!entry) {
+		return;
+	}
+	EDGE_ASSERT(entry->pins == 0, "Freeing a pinned block");
+
+	Block* block = GetBlock(entry->offset);
+	const size_t payload = block->size - kHeaderSize;
+	m_Stats.totalFreed += payload;
+	m_Stats.currentUsage -= payload;
+	m_Stats.freeCount++;
+	ReleaseTaggedUse(m_Tag, payload);
+
+	// The bumped generation invalidates every copy of the handle
+	entry->generation = entry->generation + 1 ? entry->generation + 1 : 1;
+	entry->pins = 0;
+	entry->offset = m_FreeEntry;
+	m_FreeEntry = handle.index;
+
+	block->entry = Block::FREE;
+	Release(block);
+}
+
+bool RelocatableHeap::IsValid(RelocatableHandle handle) const {
+	return FindEntry(handle) != nullptr;
+}
+
+void* RelocatableHeap::Resolve(RelocatableHandle handle) const {
+	const Entry* entry = FindEntry(handle);
+	return entry ? m_Range.GetBase() + entry->offset + kHeaderSize : nullptr;
+}
+
+size_t RelocatableHeap::GetSize(RelocatableHandle handle) const {
+	const Entry* entry = FindEntry(handle);
+	return entry ? GetBlock(entry->offset)->size - kHeaderSize : 0;
+}
+
+void* RelocatableHeap::Pin(RelocatableHandle handle) {
+	Entry* entry = FindEntry(handle);
+	EDGE_ASSERT(entry != nullptr, "Pinning a stale RelocatableHandle");
+	if (!entry) {
+		return nullptr;
+	}
+
+	entry->pins++;
+	return m_Range.GetBase() + entry->offset + kHeaderSize;
+}
+
+void RelocatableHeap::Unpin(RelocatableHandle handle) {
+	Entry* entry = FindEntry(handle);
+	EDGE_ASSERT(entry != nullptr && entry->pins > 0, "Unpin without a matching Pin");
+	if (!entry || entry->pins == 0 || --entry->pins != 0) {
+		return;
+	}
+
+	// The compactor stepped over the hole below a pinned block, send it back
+	Block* previous = GetPrevious(GetBlock(entry->offset));
+	if (previous && previous->entry == Block::FREE && GetOffset(previous) < m_Cursor) {
+		m_Cursor = GetOffset(previous);
+	}
+}
+
+size_t RelocatableHeap::Compact() {
+	return Compact(m_Budget);
+}
+
+size_t RelocatableHeap::Compact(size_t maxBytes) {
+	if (m_Cursor >= m_Top) {
+		m_Cursor = m_Top;
+		m_Range.Decommit(AlignUp(m_Top, VirtualRange::COMMIT_GRANULARITY));
+		return 0;
+	}
+
+	EDGE_PROFILE_SCOPE("Compact Relocatable Heap");
+
+	size_t moved = 0;
+	size_t offset = m_Cursor;
+	bool cursorFollows = true;		// until a hole is left behind a pinned block
+
+	while (offset < m_Top) {
+		Block* block = GetBlock(offset);
+		if (block->entry != Block::FREE) {
+			offset += block->size;
+			if (cursorFollows) {
+				m_Cursor = offset;
+			}
+			continue;
+		}
+
+		// A hole is always followed by a used block
+		Block* next = GetNext(block);
+		Entry& entry = m_Entries[next->entry];
+		if (entry.pins) {
+			offset = GetOffset(next) + next->size;
+			cursorFollows = false;
+			continue;
+		}
+		if (moved > 0 && moved + next->size > maxBytes) {
+			break;
+		}
+
+		// Slide the block down and the hole up past it, then merge the hole with whatever is above
+		const size_t holeSize = block->size;
+		const size_t previousSize = block->previousSize;
+		const size_t blockSize = next->size;
+		RemoveFree(block);
+		memmove(block, next, blockSize);
+		block->previousSize = previousSize;
+		entry.offset = offset;
+		moved += blockSize;
+
+		offset += blockSize;
+		Block* hole = GetBlock(offset);
+		hole->size = holeSize;
+		hole->previousSize = blockSize;
+		hole->entry = Block::FREE;
+		Release(hole);
+		if (cursorFollows) {
+			m_Cursor = offset;
+		}
+
+		if (moved >= maxBytes) {
+			break;
+		}
+	}
+
+	if (cursorFollows && offset >= m_Top) {
+		m_Cursor = m_Top;
+	}
+
+	m_Range.Decommit(AlignUp(m_Top, VirtualRange::COMMIT_GRANULARITY));
+	return moved;
+}
+
+void RelocatableHeap::GetStats(MemoryStats& stats) const {
+	stats = m_Stats;
+
+	const size_t room = m_Range.GetReservedSize() - m_Top;
+	stats.freeSpace = m_HoleBytes + room;
+	stats.largestFreeBlock = room;
+	stats.freeBlockCount = room ? 1 : 0;
+	for (const Block* block = m_FreeBlocks; block; block = block->nextFree) {
+		if (block->size > stats.largestFreeBlock) {
+			stats.largestFreeBlock = block->size;
+		}
+		stats.freeBlockCount++;
+	}
+}
+
+END_NS_MEMORY
+END_NS_EDGE
@@ -0,0 +1,120 @@
+/*
+ * EdgeRelocatableHeap.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Handle-based heap that defragments itself a slice at a time.
+ *
+ * Responsibilities:
+ * - Hand out handles resolved through an indirection table instead of raw pointers,
+ * - Slide unpinned blocks toward the bottom of the heap within a per-frame byte budget,
+ * - Let blocks in active use be pinned so the compactor steps around them,
+ * - And give pages above the compacted top back to the OS.
+ */
+
+#ifndef INC_EDGE_CORE_RELOCATABLE_HEAP_
+#define INC_EDGE_CORE_RELOCATABLE_HEAP_
+
+#include "EdgeMemory.h"
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+// Bytes the compactor moves per Compact call unless told otherwise
+constexpr size_t EDGE_RELOCATABLE_HEAP_DEFAULT_BUDGET = 256 * 1024;
+
+// Reference to a relocatable block
+// Like SlotHandle, the generation changes every time a table entry is reused so a handle to a
+// freed block stays invalid. A zero generation is never issued.
+struct RelocatableHandle {
+	uint32_t index;
+	uint32_t generation;
+
+	RelocatableHandle() : index(0), generation(0) {}
+	RelocatableHandle(uint32_t entryIndex, uint32_t entryGeneration) : index(entryIndex), generation(entryGeneration) {}
+
+	bool IsValid() const { return generation != 0; }
+	bool operator==(const RelocatableHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const RelocatableHandle& other) const { return !(*this == other); }
+};
+
+// Relocatable heap - blocks addressed through handles so they can move
+// Blocks sit back to back in one reserved range, a free block is first fit from an unordered free
+// list and otherwise bump allocated from the top. Compact slides the block after each hole down
+// into it, so over a few frames the free space gathers above the top. Pointers from Resolve are
+// good until the next Compact, Pin one to keep it across. When no hole fits an allocation, the
+// heap compacts as far as the pins allow before giving up.
+// Payloads are 16-byte aligned. Not thread-safe, give each subsystem its own heap.
+class RelocatableHeap {
+public:
+	// Reserve capacity bytes, committed as the top rises. Live bytes are charged to tag.
+	explicit RelocatableHeap(size_t capacity, MemoryTag tag = MemoryTag::NoTag);
+	~RelocatableHeap();
+
+	// Returns an invalid handle when the heap is full even after compacting
+	RelocatableHandle Allocate(size_t size);
+	void Free(RelocatableHandle handle);
+
+	bool IsValid(RelocatableHandle handle) const;
+	// Null for a stale handle
+	void* Resolve(RelocatableHandle handle) const;
+	// Usable size of the block, at least the requested size
+	size_t GetSize(RelocatableHandle handle) const;
+
+	// Pins nest, a block stays put until every Pin has its Unpin
+	void* Pin(RelocatableHandle handle);
+	void Unpin(RelocatableHandle handle);
+
+	// Move at most the budget's worth of blocks and return the bytes moved. A block bigger than the
+	// whole budget moves on its own so every call makes progress.
+	size_t Compact();
+	size_t Compact(size_t maxBytes);
+
+	void SetCompactionBudget(size_t bytes) { m_Budget = bytes; }
+	size_t GetCompactionBudget() const { return m_Budget; }
+
+	// Free space counts the holes and the room above the top
+	void GetStats(MemoryStats& stats) const;
+	size_t GetCapacity() const { return m_Range.GetReservedSize(); }
+
+	RelocatableHeap(const RelocatableHeap&) = delete;
+	RelocatableHeap& operator=(const RelocatableHeap&) = delete;
+
+private:
+	struct Block;
+	struct Entry;
+
+	VirtualRange m_Range;
+	Entry* m_Entries;
+	uint32_t m_EntryCount;		// entries ever handed out
+	uint32_t m_EntryCapacity;
+	uint32_t m_FreeEntry;
+	Block* m_FreeBlocks;
+	size_t m_Top;				// end of the last block, which is never free
+	size_t m_LastSize;			// size of the last block, 0 when empty
+	size_t m_Cursor;			// nothing below it is a hole the compactor can close
+	size_t m_HoleBytes;
+	size_t m_Budget;
+	MemoryTag m_Tag;
+	MemoryStats m_Stats;
+
+	Block* GetBlock(size_t offset) const;
+	size_t GetOffset(const Block* block) const;
+	Block* GetNext(Block* block) const;
+	Block* GetPrevious(Block* block) const;
+	Entry* FindEntry(RelocatableHandle handle) const;
+
+	Block* TakeFree(size_t size);
+	Block* TakeTop(size_t size);
+	void InsertFree(Block* block);
+	void RemoveFree(Block* block);
+	void Release(Block* block);
+	bool GrowEntries();
+};
+
+END_NS_MEMORY
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_RELOCATABLE_HEAP_
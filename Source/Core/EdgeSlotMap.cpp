@@ -0,0 +1,161 @@
+/*
+ * EdgeSlotMap.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Typed object containers over the memory system.
+ *
+ */
+
+#include "EdgeSlotMap.h"
+#include <cstring>
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+//==================================================================================================
+// SlotIndex Implementation
+//==================================================================================================
+
+SlotIndex::SlotIndex(IAllocator* allocator, MemoryTag tag)
+	: m_Allocator(allocator), m_Tag(tag), m_Slots(nullptr), m_DenseToSlot(nullptr),
+	m_Size(0), m_SlotCount(0), m_Capacity(0), m_FreeHead(INVALID_INDEX) {
+}
+
+SlotIndex::~SlotIndex() {
+	FreeArray(m_Slots);
+	FreeArray(m_DenseToSlot);
+	m_Slots = nullptr;
+	m_DenseToSlot = nullptr;
+}
+
+SlotHandle SlotIndex::Insert() {
+	EDGE_ASSERT(m_Size < m_Capacity, "SlotIndex is full, reserve before inserting");
+
+	uint32_t slotIndex = m_FreeHead;
+	if (slotIndex != INVALID_INDEX) {
+		m_FreeHead = m_Slots[slotIndex].denseIndex;
+	}
+	else {
+		slotIndex = m_SlotCount++;
+		m_Slots[slotIndex].generation = 1;
+	}
+
+	Slot& slot = m_Slots[slotIndex];
+	slot.denseIndex = m_Size;
+	m_DenseToSlot[m_Size] = slotIndex;
+	m_Size++;
+
+	return SlotHandle(slotIndex, slot.generation);
+}
+
+uint32_t SlotIndex::Find(SlotHandle handle) const {
+	// Free slots always carry a newer generation than any handle issued for them
+	if (handle.index >= m_SlotCount || handle.generation == 0 || m_Slots[handle.index].generation != handle.generation) {
+		return INVALID_INDEX;
+	}
+	return m_Slots[handle.index].denseIndex;
+}
+
+uint32_t SlotIndex::Remove(SlotHandle handle) {
+	const uint32_t denseIndex = Find(handle);
+	if (denseIndex == INVALID_INDEX) {
+		return INVALID_INDEX;
+	}
+
+	// The last element moves into the hole, point its slot at the new position
+	const uint32_t last = m_Size - 1;
+	if (denseIndex != last) {
+		const uint32_t movedSlot = m_DenseToSlot[last];
+		m_DenseToSlot[denseIndex] = movedSlot;
+		m_Slots[movedSlot].denseIndex = denseIndex;
+	}
+	m_Size--;
+
+	Slot& slot = m_Slots[handle.index];
+	if (++slot.generation == 0) {
+		slot.generation = 1;
+	}
+	slot.denseIndex = m_FreeHead;
+	m_FreeHead = handle.index;
+
+	return denseIndex;
+}
+
+SlotHandle SlotIndex::GetHandle(uint32_t denseIndex) const {
+	if (denseIndex >= m_Size) {
+		return SlotHandle();
+	}
+
+	const uint32_t slotIndex = m_DenseToSlot[denseIndex];
+	return SlotHandle(slotIndex, m_Slots[slotIndex].generation);
+}
+
+bool SlotIndex::Reserve(uint32_t capacity) {
+	if (capacity <= m_Capacity) {
+		return true;
+	}
+
+	// Slots are only ever added while an element is inserted, so capacity bounds both arrays
+	Slot* slots = static_cast<Slot*>(AllocateArray(sizeof(Slot) * capacity, alignof(Slot)));
+	uint32_t* denseToSlot = static_cast<uint32_t*>(AllocateArray(sizeof(uint32_t) * capacity, alignof(uint32_t)));
+	if (!slots || !denseToSlot) {
+		FreeArray(slots);
+		FreeArray(denseToSlot);
+		EDGE_ASSERT(false, "SlotIndex failed to grow");
+		return false;
+	}
+
+	if (m_SlotCount) {
+		memcpy(slots, m_Slots, sizeof(Slot) * m_SlotCount);
+	}
+	if (m_Size) {
+		memcpy(denseToSlot, m_DenseToSlot, sizeof(uint32_t) * m_Size);
+	}
+
+	FreeArray(m_Slots);
+	FreeArray(m_DenseToSlot);
+	m_Slots = slots;
+	m_DenseToSlot = denseToSlot;
+	m_Capacity = capacity;
+	return true;
+}
+
+void SlotIndex::Clear() {
+	// Invalidate every live handle and give its slot back
+	for (uint32_t i = 0; i < m_Size; ++i) {
+		const uint32_t slotIndex = m_DenseToSlot[i];
+		Slot& slot = m_Slots[slotIndex];
+		if (++slot.generation == 0) {
+			slot.generation = 1;
+		}
+		slot.denseIndex = m_FreeHead;
+		m_FreeHead = slotIndex;
+	}
+	m_Size = 0;
+}
+
+void* SlotIndex::AllocateArray(size_t size, size_t alignment) const {
+	if (m_Allocator) {
+		return m_Allocator->Allocate(size, m_Tag, alignment);
+	}
+	return AllocateTagged(size, m_Tag, alignment);
+}
+
+void SlotIndex::FreeArray(void* ptr) const {
+	if (!ptr) {
+		return;
+	}
+
+	if (m_Allocator) {
+		m_Allocator->Free(ptr);
+	}
+	else {
+		memory::Free(ptr);
+	}
+}
+
+END_NS_MEMORY
+END_NS_EDGE
@@ -0,0 +1,377 @@
+/*
+ * EdgeSlotMap.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Typed object containers over the memory system.
+ *
+ * Responsibilities:
+ * - Provide a typed pool with stable pointers on top of PoolAllocator,
+ * - Provide slot maps with generational handles and dense, contiguous iteration,
+ * - And provide a structure-of-arrays slot map with SIMD aligned field arrays.
+ */
+
+#ifndef INC_EDGE_CORE_SLOT_MAP_
+#define INC_EDGE_CORE_SLOT_MAP_
+
+#include "EdgeMemory.h"
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+// Typed pool - PoolAllocator for a single type, with construction and destruction
+// Pointers stay valid until the object is deleted, iteration is not supported.
+template<typename T>
+class TypedPool {
+public:
+	explicit TypedPool(size_t capacity, PoolGrowth growth = PoolGrowth::Chunked, MemoryBacking backing = MemoryBacking::Heap)
+		: m_Pool(ELEMENT_SIZE, capacity, ELEMENT_ALIGNMENT, growth, backing) {
+	}
+
+	~TypedPool() {
+		MemoryStats stats;
+		m_Pool.GetStats(stats);
+		EDGE_ASSERT(stats.currentUsage == 0, "TypedPool destroyed with live objects");
+	}
+
+	template<typename... Args>
+	T* New(Args&&... args) {
+		void* ptr = m_Pool.Allocate(ELEMENT_SIZE, ELEMENT_ALIGNMENT);
+		return ptr ? new(ptr) T(std::forward<Args>(args)...) : nullptr;
+	}
+
+	void Delete(T* ptr) {
+		if (ptr) {
+			ptr->~T();
+			m_Pool.Free(ptr);
+		}
+	}
+
+	void GetStats(MemoryStats& stats) const { m_Pool.GetStats(stats); }
+	PoolAllocator& GetAllocator() { return m_Pool; }
+
+	TypedPool(const TypedPool&) = delete;
+	TypedPool& operator=(const TypedPool&) = delete;
+
+private:
+	// Free elements hold the free list link
+	static constexpr size_t ELEMENT_SIZE = sizeof(T) > sizeof(uintptr_t) ? sizeof(T) : sizeof(uintptr_t);
+	static constexpr size_t ELEMENT_ALIGNMENT = alignof(T) > alignof(uintptr_t) ? alignof(T) : alignof(uintptr_t);
+
+	PoolAllocator m_Pool;
+};
+
+// Stable reference to a slot map element
+// The generation changes every time a slot is reused, so a handle to a removed element stays
+// invalid even after its slot holds something else. A zero generation is never issued.
+struct SlotHandle {
+	uint32_t index;
+	uint32_t generation;
+
+	SlotHandle() : index(0), generation(0) {}
+	SlotHandle(uint32_t slotIndex, uint32_t slotGeneration) : index(slotIndex), generation(slotGeneration) {}
+
+	bool IsValid() const { return generation != 0; }
+	bool operator==(const SlotHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Handle to dense index mapping shared by the slot maps
+// Elements live packed at dense indices [0, Size()). Removing one moves the last element into
+// its place, the index remaps that element's slot so its handle keeps working. Storage is
+// grown from the given allocator, or from the global thread-cached functions when null.
+class SlotIndex {
+public:
+	static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	explicit SlotIndex(IAllocator* allocator = nullptr, MemoryTag tag = MemoryTag::NoTag);
+	~SlotIndex();
+
+	// Claim a slot for a new element at dense index Size(), capacity must already be reserved
+	SlotHandle Insert();
+	// Dense index of a live handle, or INVALID_INDEX
+	uint32_t Find(SlotHandle handle) const;
+	// Release a live handle and return its dense index, or INVALID_INDEX. The caller moves the
+	// element at the new Size() into the returned index, unless they are equal.
+	uint32_t Remove(SlotHandle handle);
+	SlotHandle GetHandle(uint32_t denseIndex) const;
+
+	bool Reserve(uint32_t capacity);
+	void Clear();
+
+	uint32_t Size() const { return m_Size; }
+	uint32_t Capacity() const { return m_Capacity; }
+	// Capacity to grow to when full
+	uint32_t NextCapacity() const { return m_Capacity ? m_Capacity * 2 : 16; }
+
+	// Element storage for the containers, from the same allocator and tag as the index
+	void* AllocateArray(size_t size, size_t alignment) const;
+	void FreeArray(void* ptr) const;
+
+	SlotIndex(const SlotIndex&) = delete;
+	SlotIndex& operator=(const SlotIndex&) = delete;
+
+private:
+	struct Slot {
+		uint32_t denseIndex;	// next free slot while the slot is unused
+		uint32_t generation;
+	};
+
+	IAllocator* m_Allocator;
+	MemoryTag m_Tag;
+	Slot* m_Slots;
+	uint32_t* m_DenseToSlot;
+	uint32_t m_Size;
+	uint32_t m_SlotCount;		// slots ever handed out
+	uint32_t m_Capacity;
+	uint32_t m_FreeHead;
+};
+
+// Slot map - packed array of T addressed through generational handles
+// Iterate it like an array, pointers are only valid until the next insert or remove.
+template<typename T>
+class SlotMap {
+public:
+	explicit SlotMap(uint32_t capacity = 0, IAllocator* allocator = nullptr, MemoryTag tag = MemoryTag::NoTag)
+		: m_Index(allocator, tag), m_Data(nullptr) {
+		if (capacity) {
+			Grow(capacity);
+		}
+	}
+
+	~SlotMap() {
+		Clear();
+		m_Index.FreeArray(m_Data);
+	}
+
+	template<typename... Args>
+	SlotHandle Insert(Args&&... args) {
+		if (m_Index.Size() == m_Index.Capacity() && !Grow(m_Index.NextCapacity())) {
+			return SlotHandle();
+		}
+
+		SlotHandle handle = m_Index.Insert();
+		new(&m_Data[m_Index.Size() - 1]) T(std::forward<Args>(args)...);
+		return handle;
+	}
+
+	bool Remove(SlotHandle handle) {
+		const uint32_t denseIndex = m_Index.Remove(handle);
+		if (denseIndex == SlotIndex::INVALID_INDEX) {
+			return false;
+		}
+
+		// Swap and pop, the last element fills the hole
+		const uint32_t last = m_Index.Size();
+		if (denseIndex != last) {
+			m_Data[denseIndex] = std::move(m_Data[last]);
+		}
+		m_Data[last].~T();
+		return true;
+	}
+
+	T* Get(SlotHandle handle) {
+		const uint32_t denseIndex = m_Index.Find(handle);
+		return denseIndex != SlotIndex::INVALID_INDEX ? &m_Data[denseIndex] : nullptr;
+	}
+
+	const T* Get(SlotHandle handle) const {
+		const uint32_t denseIndex = m_Index.Find(handle);
+		return denseIndex != SlotIndex::INVALID_INDEX ? &m_Data[denseIndex] : nullptr;
+	}
+
+	bool Contains(SlotHandle handle) const { return m_Index.Find(handle) != SlotIndex::INVALID_INDEX; }
+	SlotHandle GetHandle(uint32_t denseIndex) const { return m_Index.GetHandle(denseIndex); }
+
+	void Clear() {
+		for (uint32_t i = 0; i < m_Index.Size(); ++i) {
+			m_Data[i].~T();
+		}
+		m_Index.Clear();
+	}
+
+	uint32_t Size() const { return m_Index.Size(); }
+	bool Empty() const { return m_Index.Size() == 0; }
+
+	T* Data() { return m_Data; }
+	const T* Data() const { return m_Data; }
+	T* begin() { return m_Data; }
+	T* end() { return m_Data + m_Index.Size(); }
+	const T* begin() const { return m_Data; }
+	const T* end() const { return m_Data + m_Index.Size(); }
+
+	SlotMap(const SlotMap&) = delete;
+	SlotMap& operator=(const SlotMap&) = delete;
+
+private:
+	static constexpr size_t ALIGNMENT = alignof(T) > EDGE_SIMD_ALIGNMENT ? alignof(T) : EDGE_SIMD_ALIGNMENT;
+
+	SlotIndex m_Index;
+	T* m_Data;
+
+	bool Grow(uint32_t capacity) {
+		T* data = static_cast<T*>(m_Index.AllocateArray(sizeof(T) * capacity, ALIGNMENT));
+		if (!data || !m_Index.Reserve(capacity)) {
+			m_Index.FreeArray(data);
+			return false;
+		}
+
+		for (uint32_t i = 0; i < m_Index.Size(); ++i) {
+			new(&data[i]) T(std::move(m_Data[i]));
+			m_Data[i].~T();
+		}
+		m_Index.FreeArray(m_Data);
+		m_Data = data;
+		return true;
+	}
+};
+
+// Structure-of-arrays slot map - one packed array per field
+// Every field array starts on EDGE_SIMD_ALIGNMENT and its capacity is a multiple of 16, so batch
+// systems can stream a single field with full vector loads past Size() up to the capacity.
+template<typename... Fields>
+class SoASlotMap {
+public:
+	static constexpr size_t FIELD_COUNT = sizeof...(Fields);
+
+	template<size_t I>
+	using FieldType = typename std::tuple_element<I, std::tuple<Fields...>>::type;
+
+	explicit SoASlotMap(uint32_t capacity = 0, IAllocator* allocator = nullptr, MemoryTag tag = MemoryTag::NoTag)
+		: m_Index(allocator, tag), m_Arrays() {
+		if (capacity) {
+			Grow((capacity + 15) & ~15u, std::index_sequence_for<Fields...>());
+		}
+	}
+
+	~SoASlotMap() {
+		Clear();
+		FreeArrays(std::index_sequence_for<Fields...>());
+	}
+
+	template<typename... Args>
+	SlotHandle Insert(Args&&... values) {
+		static_assert(sizeof...(Args) == FIELD_COUNT, "Insert takes one value per field");
+
+		if (m_Index.Size() == m_Index.Capacity() && !Grow(m_Index.NextCapacity(), std::index_sequence_for<Fields...>())) {
+			return SlotHandle();
+		}
+
+		SlotHandle handle = m_Index.Insert();
+		Construct(m_Index.Size() - 1, std::index_sequence_for<Fields...>(), std::forward<Args>(values)...);
+		return handle;
+	}
+
+	bool Remove(SlotHandle handle) {
+		const uint32_t denseIndex = m_Index.Remove(handle);
+		if (denseIndex == SlotIndex::INVALID_INDEX) {
+			return false;
+		}
+
+		MoveAndDestroy(denseIndex, m_Index.Size(), std::index_sequence_for<Fields...>());
+		return true;
+	}
+
+	template<size_t I>
+	FieldType<I>* Get(SlotHandle handle) {
+		const uint32_t denseIndex = m_Index.Find(handle);
+		return denseIndex != SlotIndex::INVALID_INDEX ? &std::get<I>(m_Arrays)[denseIndex] : nullptr;
+	}
+
+	// Packed array of field I, Size() elements long
+	template<size_t I>
+	FieldType<I>* Data() { return std::get<I>(m_Arrays); }
+
+	template<size_t I>
+	const FieldType<I>* Data() const { return std::get<I>(m_Arrays); }
+
+	bool Contains(SlotHandle handle) const { return m_Index.Find(handle) != SlotIndex::INVALID_INDEX; }
+	SlotHandle GetHandle(uint32_t denseIndex) const { return m_Index.GetHandle(denseIndex); }
+
+	void Clear() {
+		DestroyRange(0, m_Index.Size(), std::index_sequence_for<Fields...>());
+		m_Index.Clear();
+	}
+
+	uint32_t Size() const { return m_Index.Size(); }
+	uint32_t Capacity() const { return m_Index.Capacity(); }
+	bool Empty() const { return m_Index.Size() == 0; }
+
+	SoASlotMap(const SoASlotMap&) = delete;
+	SoASlotMap& operator=(const SoASlotMap&) = delete;
+
+private:
+	SlotIndex m_Index;
+	std::tuple<Fields*...> m_Arrays;
+
+	template<typename F>
+	static constexpr size_t FieldAlignment() {
+		return alignof(F) > EDGE_SIMD_ALIGNMENT ? alignof(F) : EDGE_SIMD_ALIGNMENT;
+	}
+
+	template<size_t... I>
+	bool Grow(uint32_t capacity, std::index_sequence<I...>) {
+		std::tuple<Fields*...> arrays(static_cast<Fields*>(
+			m_Index.AllocateArray(sizeof(Fields) * capacity, FieldAlignment<Fields>()))...);
+
+		const bool allocated = ((std::get<I>(arrays) != nullptr) && ...);
+		if (!allocated || !m_Index.Reserve(capacity)) {
+			(m_Index.FreeArray(std::get<I>(arrays)), ...);
+			return false;
+		}
+
+		const uint32_t size = m_Index.Size();
+		(Relocate(std::get<I>(m_Arrays), std::get<I>(arrays), size), ...);
+		(m_Index.FreeArray(std::get<I>(m_Arrays)), ...);
+		m_Arrays = arrays;
+		return true;
+	}
+
+	template<typename F>
+	static void Relocate(F* from, F* to, uint32_t count) {
+		for (uint32_t i = 0; i < count; ++i) {
+			new(&to[i]) F(std::move(from[i]));
+			from[i].~F();
+		}
+	}
+
+	template<typename F>
+	static void DestroyField(F& field) {
+		field.~F();
+	}
+
+	template<size_t... I, typename... Args>
+	void Construct(uint32_t denseIndex, std::index_sequence<I...>, Args&&... values) {
+		(new(&std::get<I>(m_Arrays)[denseIndex]) FieldType<I>(std::forward<Args>(values)), ...);
+	}
+
+	template<size_t... I>
+	void MoveAndDestroy(uint32_t denseIndex, uint32_t last, std::index_sequence<I...>) {
+		if (denseIndex != last) {
+			((std::get<I>(m_Arrays)[denseIndex] = std::move(std::get<I>(m_Arrays)[last])), ...);
+		}
+		(DestroyField(std::get<I>(m_Arrays)[last]), ...);
+	}
+
+	template<size_t... I>
+	void DestroyRange(uint32_t first, uint32_t last, std::index_sequence<I...>) {
+		for (uint32_t i = first; i < last; ++i) {
+			(DestroyField(std::get<I>(m_Arrays)[i]), ...);
+		}
+	}
+
+	template<size_t... I>
+	void FreeArrays(std::index_sequence<I...>) {
+		(m_Index.FreeArray(std::get<I>(m_Arrays)), ...);
+	}
+};
+
+END_NS_MEMORY
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_SLOT_MAP_
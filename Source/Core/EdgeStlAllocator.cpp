@@ -0,0 +1,121 @@
+/*
+ * EdgeStlAllocator.cpp
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Standard library adaptors for the memory system.
+ *
+ */
+
+#include "EdgeStlAllocator.h"
+
+#if EDGE_HAS_PMR
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+//==================================================================================================
+// AllocatorResource Implementation
+//==================================================================================================
+
+AllocatorResource::AllocatorResource(IAllocator* allocator, MemoryTag tag)
+	: m_Allocator(allocator), m_Tag(tag) {
+}
+
+void* AllocatorResource::do_allocate(size_t bytes, size_t alignment) {
+	void* ptr = nullptr;
+	if (m_Allocator) {
+		ptr = m_Allocator->Allocate(bytes, m_Tag, alignment);
+		if (ptr) {
+			RecordTaggedUse(m_Tag, bytes);
+		}
+	}
+	else {
+		ptr = AllocateTagged(bytes, m_Tag, alignment);
+	}
+
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void AllocatorResource::do_deallocate(void* ptr, size_t bytes, size_t alignment) {
+	if (!ptr) {
+		return;
+	}
+
+	if (m_Allocator) {
+		ReleaseTaggedUse(m_Tag, bytes);
+		m_Allocator->Free(ptr, bytes, alignment);
+	}
+	else {
+		memory::Free(ptr, bytes, alignment);
+	}
+}
+
+bool AllocatorResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	if (this == &other) {
+		return true;
+	}
+
+	const AllocatorResource* resource = dynamic_cast<const AllocatorResource*>(&other);
+	return resource && resource->m_Allocator == m_Allocator;
+}
+
+//==================================================================================================
+// PoolResource Implementation
+//==================================================================================================
+
+PoolResource::PoolResource(PoolAllocator& pool, MemoryTag tag, std::pmr::memory_resource* upstream)
+	: m_Pool(pool), m_Tag(tag), m_Upstream(upstream) {
+	EDGE_ASSERT(upstream != nullptr, "PoolResource needs an upstream resource");
+}
+
+bool PoolResource::FitsPool(size_t bytes, size_t alignment) const {
+	return bytes <= m_Pool.GetElementSize() && alignment <= m_Pool.GetElementAlignment();
+}
+
+void* PoolResource::do_allocate(size_t bytes, size_t alignment) {
+	if (!FitsPool(bytes, alignment)) {
+		return m_Upstream->allocate(bytes, alignment);
+	}
+
+	// The pool tracks its own element stats, record the tag so the use shows up per tag
+	void* ptr = m_Pool.Allocate(bytes, m_Tag, alignment);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	RecordTaggedUse(m_Tag, m_Pool.GetElementSize());
+	return ptr;
+}
+
+void PoolResource::do_deallocate(void* ptr, size_t bytes, size_t alignment) {
+	if (!ptr) {
+		return;
+	}
+
+	if (!FitsPool(bytes, alignment)) {
+		m_Upstream->deallocate(ptr, bytes, alignment);
+		return;
+	}
+
+	ReleaseTaggedUse(m_Tag, m_Pool.GetElementSize());
+	m_Pool.Free(ptr, bytes, alignment);
+}
+
+bool PoolResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	if (this == &other) {
+		return true;
+	}
+
+	const PoolResource* resource = dynamic_cast<const PoolResource*>(&other);
+	return resource && &resource->m_Pool == &m_Pool && resource->m_Upstream->is_equal(*m_Upstream);
+}
+
+END_NS_MEMORY
+END_NS_EDGE
+
+#endif // EDGE_HAS_PMR
@@ -0,0 +1,174 @@
+/*
+ * EdgeStlAllocator.h
+ *
+ * Grant Abernathy
+ *
+ * 10-14-2026
+ *
+ * Standard library adaptors for the memory system.
+ *
+ * Responsibilities:
+ * - Provide an std::allocator compatible adaptor over IAllocator,
+ * - Provide std::pmr::memory_resource bridges over IAllocator and PoolAllocator,
+ * - And carry a MemoryTag through to the stats of every container allocation.
+ */
+
+#ifndef INC_EDGE_CORE_STL_ALLOCATOR_
+#define INC_EDGE_CORE_STL_ALLOCATOR_
+
+#include "EdgeMemory.h"
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define EDGE_HAS_PMR 1
+#endif
+#endif
+
+#ifndef EDGE_HAS_PMR
+#define EDGE_HAS_PMR 0
+#endif
+
+BEGIN_NS_EDGE
+BEGIN_NS_MEMORY
+
+// STL allocator - routes container storage to an IAllocator, or to the global functions when null
+// A default constructed adaptor takes the current allocator and tag of the calling thread's
+// MemoryScope. The tag goes to the allocator with every request. Memory from a non-global allocator is also
+// recorded with RecordTaggedUse, so arena-backed containers show up in GetTagStats.
+// The allocator travels with the container on copy, move and swap, so a container filled from an
+// arena never hands its storage to a different one.
+template<typename T>
+class StlAllocator {
+public:
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+	using is_always_equal = std::false_type;
+
+	StlAllocator() noexcept : m_Allocator(GetCurrentAllocator()), m_Tag(GetCurrentTag()) {}
+	explicit StlAllocator(MemoryTag tag) noexcept : m_Allocator(GetCurrentAllocator()), m_Tag(tag) {}
+	explicit StlAllocator(IAllocator* allocator, MemoryTag tag = MemoryTag::NoTag) noexcept : m_Allocator(allocator), m_Tag(tag) {}
+
+	template<typename U>
+	StlAllocator(const StlAllocator<U>& other) noexcept : m_Allocator(other.GetAllocator()), m_Tag(other.GetTag()) {}
+
+	T* allocate(size_t count) {
+		if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+			throw std::bad_array_new_length();
+		}
+
+		const size_t size = count * sizeof(T);
+		void* ptr = nullptr;
+		if (m_Allocator) {
+			ptr = m_Allocator->Allocate(size, m_Tag, alignof(T));
+			if (ptr) {
+				RecordTaggedUse(m_Tag, size);
+			}
+		}
+		else {
+			ptr = AllocateTagged(size, m_Tag, alignof(T));
+		}
+
+		// Containers have no way to handle a null result
+		if (!ptr) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, size_t count) noexcept {
+		if (!ptr) {
+			return;
+		}
+
+		// Containers always know the size, pass it on so no header needs reading
+		const size_t size = count * sizeof(T);
+		if (m_Allocator) {
+			ReleaseTaggedUse(m_Tag, size);
+			m_Allocator->Free(ptr, size, alignof(T));
+		}
+		else {
+			memory::Free(ptr, size, alignof(T));
+		}
+	}
+
+	IAllocator* GetAllocator() const noexcept { return m_Allocator; }
+	MemoryTag GetTag() const noexcept { return m_Tag; }
+
+private:
+	IAllocator* m_Allocator;
+	MemoryTag m_Tag;
+};
+
+// Storage from one can be freed through the other when both use the same allocator
+template<typename T, typename U>
+bool operator==(const StlAllocator<T>& a, const StlAllocator<U>& b) noexcept {
+	return a.GetAllocator() == b.GetAllocator();
+}
+
+template<typename T, typename U>
+bool operator!=(const StlAllocator<T>& a, const StlAllocator<U>& b) noexcept {
+	return !(a == b);
+}
+
+// Containers over the memory system
+template<typename T>
+using Vector = std::vector<T, StlAllocator<T>>;
+using String = std::basic_string<char, std::char_traits<char>, StlAllocator<char>>;
+
+#if EDGE_HAS_PMR
+// Memory resource over an IAllocator, or over the global functions when null
+// LinearAllocator makes this a monotonic arena resource, deallocate is a no-op there.
+class AllocatorResource : public std::pmr::memory_resource {
+public:
+	explicit AllocatorResource(IAllocator* allocator = nullptr, MemoryTag tag = MemoryTag::NoTag);
+
+	IAllocator* GetAllocator() const { return m_Allocator; }
+	MemoryTag GetTag() const { return m_Tag; }
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+	IAllocator* m_Allocator;
+	MemoryTag m_Tag;
+};
+
+// Memory resource over a PoolAllocator for node-based containers
+// Requests that fit an element go to the pool, anything larger or more aligned, like the bucket
+// array of an unordered_map, goes to the upstream resource.
+class PoolResource : public std::pmr::memory_resource {
+public:
+	PoolResource(PoolAllocator& pool, MemoryTag tag = MemoryTag::NoTag,
+		std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+	PoolAllocator& GetPool() const { return m_Pool; }
+	MemoryTag GetTag() const { return m_Tag; }
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+	PoolAllocator& m_Pool;
+	MemoryTag m_Tag;
+	std::pmr::memory_resource* m_Upstream;
+
+	bool FitsPool(size_t bytes, size_t alignment) const;
+};
+#endif // EDGE_HAS_PMR
+
+END_NS_MEMORY
+END_NS_EDGE
+
+#endif // INC_EDGE_CORE_STL_ALLOCATOR_